@@ -12,8 +12,8 @@
  *  message sent, a packet sequence number is incremented.
  *  
  *
- *  @version    1.0.00
- *  @date       04 Feb 2013
+ *  @version    1.0.01
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  assumptions
@@ -27,6 +27,10 @@
  *
  *  revision history
  *  ================
+ *  ver 1.0.01 : 16 Oct 2026
+ *  - uses the protocol instance returned by ProtocolInit
+ *  - selects the node role in the protocol setup information
+ *  - TransferComplete takes the payload length as an unsigned int
  *  ver 1.0.00 : 04 Feb 2013
  *  - initial release
  */
@@ -98,8 +102,9 @@ struct sPacket
  *  Note: Please refer to API.h for more information on the TransferComplete
  *  callback for an End Point node.
  */
-unsigned char TransferComplete(unsigned char *data,
-                               unsigned char length);
+unsigned char TransferComplete(bool dataRequest,
+                               unsigned char *data,
+                               unsigned int length);
 
 // -----------------------------------------------------------------------------
 /**
@@ -111,19 +116,25 @@ unsigned char TransferComplete(unsigned char *data,
  *  protocol with required parameters. The End Point node role has the following
  *  parameters [optional parameters are marked with an asterix (*)].
  *        
- *  { channel_list, pan_id, local_address, Backup(*), TransferComplete(*) }
+ *  { role, channel_list, pan_id, local_address, Backup(*), LinkRequest(*), 
+ *    TransferComplete(*) }
  *
  *  Note: Parameters marked with the asterix (*) may be assigned "NULL" if they
  *  are not needed.
  */
 static const struct sProtocolSetupInfo gProtocolSetupInfo = {
+  eProtocolRoleEndPoint,    // Node role
   { PROTOCOL_CHANNEL_LIST },// Physical channel list
   { 0x01 },                 // Physical address PAN identifier
   { 0x02 },                 // Physical address
   NULL,                     // Protocol Backup callback (not used)
+  NULL,                     // Protocol Link Request callback (Gateway only)
   TransferComplete          // Protocol Data Transfer Complete callback
 };
 
+// Protocol instance (assigned by ProtocolInit)
+static struct sProtocol *gProtocol = NULL;
+
 static struct sPacket gPacketTx = {
   0x00,                     // Set the initial sequence number value to 0
   "Hello"                   // Set the initial payload to a "Hello" string
@@ -136,8 +147,9 @@ static struct sPacket gPacketRx = {
 
 // -----------------------------------------------------------------------------
 
-unsigned char TransferComplete(unsigned char *data,
-                               unsigned char length)
+unsigned char TransferComplete(bool dataRequest,
+                               unsigned char *data,
+                               unsigned int length)
 {
   // Cast the received data pointer to a packet structure pointer so that it may
   // be accessed using the structure member notation.
@@ -170,7 +182,8 @@ bool PlatformInit(void)
   
   // Attempt to initialize protocol hardware and information using the provided
   // setup structure data.
-  if (!ProtocolInit(&gProtocolSetupInfo))
+  gProtocol = ProtocolInit(&gProtocolSetupInfo);
+  if (gProtocol == NULL)
   {
     return false;
   }
@@ -194,9 +207,9 @@ int main(void)
   // Setup hardware and protocol.
   PlatformInit();
   
-  while (!ProtocolStatusPhyAddressInfo().connected)
+  while (!ProtocolStatusPhyAddressInfo(gProtocol).connected)
   {
-    if (!ProtocolConnect(NULL, 0))
+    if (!ProtocolConnect(gProtocol, NULL, 0))
     {
       // Put the microcontroller into a low power state (sleep). Remain here
       // until the ISR wakes up the processor.
@@ -207,7 +220,7 @@ int main(void)
   while (true)
   {
     // Perform a data transfer of the packet.
-    if (!ProtocolTransfer((unsigned char*)&gPacketTx, sizeof(struct sPacket)))
+    if (!ProtocolTransfer(gProtocol, (unsigned char*)&gPacketTx, sizeof(struct sPacket)))
     {
       // Put the microcontroller into a low power state (sleep). Remain here
       // until the ISR wakes up the processor.
@@ -220,7 +233,7 @@ int main(void)
      *  sequence number until the protocol is ready. This prevents incrementing
      *  the sequence number more than once between transmissions.
      */
-    if (!ProtocolBusy())
+    if (!ProtocolBusy(gProtocol))
     {
       // Increment the sequence number for the next transmission.
       gPacketTx.seqNum++;
@@ -254,7 +267,7 @@ __interrupt void GDO0Isr(void)
    *  internally. It is important that the application does not clear the GDO0
    *  event in this ISR.
    */
-  ProtocolEngine(event);
+  ProtocolEngine(gProtocol, event);
 
   // Wake up the microcontroller to continue normal operation upon exiting the
   // ISR.
@@ -272,7 +285,7 @@ __interrupt void TimerIsr()
 {
   // Notify the protocol of a timer interrupt. The protocol uses this interrupt
   // as a tick to increment any counters that are actively running.
-  ProtocolEngineTick();
+  ProtocolEngineTick(gProtocol);
   
   // Wake up the microcontroller to continue normal operation upon exiting the
   // ISR.
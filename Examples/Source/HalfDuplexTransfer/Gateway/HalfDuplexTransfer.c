@@ -11,8 +11,8 @@
  *  example. Receives packets from the End Point node(s) and responds to them,
  *  if necessary.
  *
- *  @version    1.0.00
- *  @date       04 Feb 2013
+ *  @version    1.0.01
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  assumptions
@@ -26,6 +26,10 @@
  *
  *  revision history
  *  ================
+ *  ver 1.0.01 : 16 Oct 2026
+ *  - uses the protocol instance returned by ProtocolInit
+ *  - selects the node role in the protocol setup information
+ *  - TransferComplete takes the payload length as an unsigned int
  *  ver 1.0.00 : 04 Feb 2013
  *  - initial release
  */
@@ -108,7 +112,7 @@ bool LinkRequest(unsigned char *data, unsigned char length);
  */
 unsigned char TransferComplete(bool dataRequest,
                                unsigned char *data,
-                               unsigned char length);
+                               unsigned int length);
 
 // -----------------------------------------------------------------------------
 /**
@@ -120,19 +124,25 @@ unsigned char TransferComplete(bool dataRequest,
  *  protocol with required parameters. The Gateway node role has the following
  *  parameters [optional parameters are marked with an asterix (*)].
  *        
- *  { channel_list, pan_id, local_address, LinkRequest(*), TransferComplete(*) }
+ *  { role, channel_list, pan_id, local_address, Backup(*), LinkRequest(*), 
+ *    TransferComplete(*) }
  *
  *  Note: Parameters marked with the asterix (*) may be assigned "NULL" if they
  *  are not needed.
  */
 static const struct sProtocolSetupInfo gProtocolSetupInfo = {
+  eProtocolRoleGateway,     // Node role
   { PROTOCOL_CHANNEL_LIST },// Physical channel list
   { 0x01 },                 // Physical address PAN identifier
   { 0x01 },                 // Physical address
+  NULL,                     // Protocol Backup callback (End Point only)
   LinkRequest,              // Protocol Link Request callback
   TransferComplete          // Protocol Data Transfer Complete callback
 };
 
+// Protocol instance (assigned by ProtocolInit)
+static struct sProtocol *gProtocol = NULL;
+
 static struct sPacket gPacketRx = {
   0x00,                     // Set the initial sequence number value to 0
   ""                        // Set the initial payload to an empty string
@@ -161,7 +171,7 @@ bool LinkRequest(unsigned char *data, unsigned char length)
 
 unsigned char TransferComplete(bool dataRequest,
                                unsigned char *data,
-                               unsigned char length)
+                               unsigned int length)
 {
   // Cast the received data pointer to a packet structure pointer so that it may
   // be accessed using the structure member notation.
@@ -176,7 +186,7 @@ unsigned char TransferComplete(bool dataRequest,
   if (dataRequest)
   {
     // Provide any available data in a "data request" response transfer.
-    ProtocolLoadDataResponse((unsigned char*)&gPacketTx, sizeof(struct sPacket));
+    ProtocolLoadDataResponse(gProtocol, (unsigned char*)&gPacketTx, sizeof(struct sPacket));
     
     // Increment the sequence number for the next transmission.
     gPacketTx.seqNum++;
@@ -204,7 +214,8 @@ bool PlatformInit(void)
   
   // Attempt to initialize protocol hardware and information using the provided
   // setup structure data.
-  if (!ProtocolInit(&gProtocolSetupInfo))
+  gProtocol = ProtocolInit(&gProtocolSetupInfo);
+  if (gProtocol == NULL)
   {
     return false;
   }
@@ -259,5 +270,5 @@ __interrupt void GDO0Isr(void)
    *  internally. It is important that the application does not clear the GDO0
    *  event in this ISR.
    */
-  ProtocolEngine(event);
+  ProtocolEngine(gProtocol, event);
 }
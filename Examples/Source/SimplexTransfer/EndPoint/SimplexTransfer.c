@@ -11,8 +11,8 @@
  *  API call. For each message sent, a packet sequence number is incremented.
  *  
  *
- *  @version    1.0.00
- *  @date       04 Feb 2013
+ *  @version    1.0.01
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  assumptions
@@ -25,6 +25,9 @@
  *
  *  revision history
  *  ================
+ *  ver 1.0.01 : 16 Oct 2026
+ *  - uses the protocol instance returned by ProtocolInit
+ *  - selects the node role in the protocol setup information
  *  ver 1.0.00 : 04 Feb 2013
  *  - initial release
  */
@@ -90,19 +93,25 @@ struct sPacket
  *  protocol with required parameters. The End Point node role has the following
  *  parameters [optional parameters are marked with an asterix (*)].
  *        
- *  { channel_list, pan_id, local_address, Backup(*), TransferComplete(*) }
+ *  { role, channel_list, pan_id, local_address, Backup(*), LinkRequest(*), 
+ *    TransferComplete(*) }
  *
  *  Note: Parameters marked with the asterix (*) may be assigned "NULL" if they
  *  are not needed.
  */
 static const struct sProtocolSetupInfo gProtocolSetupInfo = {
+  eProtocolRoleEndPoint,    // Node role
   { PROTOCOL_CHANNEL_LIST },// Physical channel list
   { 0x01 },                 // Physical address PAN identifier
   { 0x02 },                 // Physical address
   NULL,                     // Protocol Backup callback (not used)
+  NULL,                     // Protocol Link Request callback (Gateway only)
   NULL                      // Protocol Data Transfer Complete callback (not used)
 };
 
+// Protocol instance (assigned by ProtocolInit)
+static struct sProtocol *gProtocol = NULL;
+
 static struct sPacket gPacket = {
   0x00,                     // Set the initial sequence number value to 0
   "Hello"                   // Set the initial payload to a "Hello" string
@@ -129,7 +138,8 @@ bool PlatformInit(void)
   
   // Attempt to initialize protocol hardware and information using the provided
   // setup structure data.
-  if (!ProtocolInit(&gProtocolSetupInfo))
+  gProtocol = ProtocolInit(&gProtocolSetupInfo);
+  if (gProtocol == NULL)
   {
     return false;
   }
@@ -156,7 +166,7 @@ int main(void)
   while (true)
   {
     // Perform a simple transfer of the packet.
-    if (!ProtocolSimpleTransfer((unsigned char*)&gPacket, sizeof(struct sPacket)))
+    if (!ProtocolSimpleTransfer(gProtocol, (unsigned char*)&gPacket, sizeof(struct sPacket)))
     {
       // Put the microcontroller into a low power state (sleep). Remain here
       // until the ISR wakes up the processor.
@@ -169,7 +179,7 @@ int main(void)
      *  sequence number until the protocol is ready. This prevents incrementing
      *  the sequence number more than once between transmissions.
      */
-    if (!ProtocolBusy())
+    if (!ProtocolBusy(gProtocol))
     {
       // Increment the sequence number for the next transmission.
       gPacket.seqNum++;
@@ -203,7 +213,7 @@ __interrupt void GDO0Isr(void)
    *  internally. It is important that the application does not clear the GDO0
    *  event in this ISR.
    */
-  ProtocolEngine(event);
+  ProtocolEngine(gProtocol, event);
 
   // Wake up the microcontroller to continue normal operation upon exiting the
   // ISR.
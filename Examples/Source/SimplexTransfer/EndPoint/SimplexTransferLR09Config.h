@@ -12,8 +12,8 @@
  *  SimplexTransferLR09Config.h - provides End Point node configuration details 
  *  for the protocol.
  *
- *  @version    1.0.00
- *  @date       16 Jan 2013
+ *  @version    1.0.01
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  Note: This file should be preincluded into the project. Please see your
@@ -86,7 +86,6 @@
  *  Protocol characteristics
  */
 
-#define PROTOCOL_ENDPOINT                       // Node role
 #define PROTOCOL_CHANNEL_LIST               0   // Physical channel list (comma seperated)
 #define PROTOCOL_CHANNEL_LIST_SIZE          1   // Physical channel list size
 #define PROTOCOL_PHYADDRESS_PANID_SIZE      1   // Physical address PAN identifier size
@@ -11,8 +11,8 @@
  *  example. Receives packets from the Simplex End Point node(s) and stores it
  *  in a local packet.
  *
- *  @version    1.0.00
- *  @date       04 Feb 2013
+ *  @version    1.0.01
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  assumptions
@@ -26,6 +26,10 @@
  *  
  *  revision history
  *  ================
+ *  ver 1.0.01 : 16 Oct 2026
+ *  - uses the protocol instance returned by ProtocolInit
+ *  - selects the node role in the protocol setup information
+ *  - TransferComplete takes the payload length as an unsigned int
  *  ver 1.0.00 : 04 Feb 2013
  *  - initial release
  */
@@ -97,7 +101,7 @@ struct sPacket
  */
 unsigned char TransferComplete(bool dataRequest,
                                unsigned char *data,
-                               unsigned char length);
+                               unsigned int length);
 
 // -----------------------------------------------------------------------------
 /**
@@ -109,19 +113,25 @@ unsigned char TransferComplete(bool dataRequest,
  *  protocol with required parameters. The Gateway node role has the following
  *  parameters [optional parameters are marked with an asterix (*)].
  *        
- *  { channel_list, pan_id, local_address, LinkRequest(*), TransferComplete(*) }
+ *  { role, channel_list, pan_id, local_address, Backup(*), LinkRequest(*), 
+ *    TransferComplete(*) }
  *
  *  Note: Parameters marked with the asterix (*) may be assigned "NULL" if they
  *  are not needed.
  */
 static const struct sProtocolSetupInfo gProtocolSetupInfo = {
+  eProtocolRoleGateway,     // Node role
   { PROTOCOL_CHANNEL_LIST },// Physical channel list
   { 0x01 },                 // Physical address PAN identifier
   { 0x01 },                 // Physical address
+  NULL,                     // Protocol Backup callback (End Point only)
   NULL,                     // Protocol Link Request callback (not used)
   TransferComplete          // Protocol Data Transfer Complete callback
 };
 
+// Protocol instance (assigned by ProtocolInit)
+static struct sProtocol *gProtocol = NULL;
+
 static struct sPacket gPacket = {
   0x00,                     // Set the initial sequence number value to 0
   ""                        // Set the initial payload to an empty string
@@ -131,7 +141,7 @@ static struct sPacket gPacket = {
 
 unsigned char TransferComplete(bool dataRequest,
                                unsigned char *data,
-                               unsigned char length)
+                               unsigned int length)
 {
   // Cast the received data pointer to a packet structure pointer so that it may
   // be accessed using the structure member notation.
@@ -164,7 +174,8 @@ bool PlatformInit(void)
   
   // Attempt to initialize protocol hardware and information using the provided
   // setup structure data.
-  if (!ProtocolInit(&gProtocolSetupInfo))
+  gProtocol = ProtocolInit(&gProtocolSetupInfo);
+  if (gProtocol == NULL)
   {
     return false;
   }
@@ -226,7 +237,7 @@ __interrupt void GDO0Isr(void)
    *  internally. It is important that the application does not clear the GDO0
    *  event in this ISR.
    */
-  ProtocolEngine(event);
+  ProtocolEngine(gProtocol, event);
 }
 
 // Note: No hardware timer interrupt required for this example because the 
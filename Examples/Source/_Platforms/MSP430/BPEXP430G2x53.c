@@ -11,8 +11,8 @@
  *		in conjunction with an MSP430G2x53 microcontroller. Hardware pins are mapped
  *		based on the EXP430G2 development platform.
  *
- *  @version    1.0.00
- *  @date       08 Oct 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  assumptions
@@ -27,6 +27,11 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added A110x2500SpiReadv (SPI scatter read)
+ *  - added the A110x2500Gdo2* interface (PROTOCOL_USE_STREAMING)
+ *  - GDO2 must share the port of GDO0; the GDOx events are taken from one 
+ *  port's interrupt flags
  *  ver 1.0.00 : 08 Oct 2012
  *  - initial release
  */
@@ -105,6 +110,7 @@
 // GDO0
 #if defined( RF_GDO0_1 )
 // GDO0 selection position 1 (default) - P2.6
+#define RF_GDO0_PORT      2
 #define RF_GDO0           (0x0040u)
 #define RF_GDO0_IN        P2IN
 #define RF_GDO0_DIR       P2DIR
@@ -115,6 +121,7 @@
 #define RF_GDO0_SEL2      P2SEL2
 #elif defined( RF_GDO0_2 )
 // GDO0 selection position 2 - P1.3
+#define RF_GDO0_PORT      1
 #define RF_GDO0           (0x0008u)
 #define RF_GDO0_IN        P1IN
 #define RF_GDO0_DIR       P1DIR
@@ -125,6 +132,7 @@
 #define RF_GDO0_SEL2      P1SEL2
 #elif defined( RF_GDO0_3 )
 // GDO0 selection position 3 - P1.1
+#define RF_GDO0_PORT      1
 #define RF_GDO0           (0x0002u)
 #define RF_GDO0_IN        P1IN
 #define RF_GDO0_DIR       P1DIR
@@ -137,6 +145,42 @@
 #error "Board Error 0102: GDO0 selection invalid. Please select GDO0 position 1, 2, or 3."
 #endif
 
+// GDO2 (FIFO thresholds)
+#if defined( PROTOCOL_USE_STREAMING )
+#if defined( RF_GDO2_1 )
+// GDO2 selection position 1 (default) - P2.0
+#define RF_GDO2_PORT      2
+#define RF_GDO2           (0x0001u)
+#define RF_GDO2_IN        P2IN
+#define RF_GDO2_DIR       P2DIR
+#define RF_GDO2_IE        P2IE
+#define RF_GDO2_IES       P2IES
+#define RF_GDO2_IFG       P2IFG
+#define RF_GDO2_SEL       P2SEL
+#define RF_GDO2_SEL2      P2SEL2
+#elif defined( RF_GDO2_2 )
+// GDO2 selection position 2 - P1.0 (shared with LED1 on the LaunchPad; 
+// remove jumper J5 P1.0)
+#define RF_GDO2_PORT      1
+#define RF_GDO2           (0x0001u)
+#define RF_GDO2_IN        P1IN
+#define RF_GDO2_DIR       P1DIR
+#define RF_GDO2_IE        P1IE
+#define RF_GDO2_IES       P1IES
+#define RF_GDO2_IFG       P1IFG
+#define RF_GDO2_SEL       P1SEL
+#define RF_GDO2_SEL2      P1SEL2
+#else
+#error "Board Error 0104: GDO2 selection invalid. Please select GDO2 position 1 or 2."
+#endif
+
+// The application passes the interrupt flags of a single port to the protocol
+// engine (e.g. P2IFG); A110x2500Gdo2Event tests the GDO2 bit of those flags.
+#if (RF_GDO2_PORT != RF_GDO0_PORT)
+#error "Board Error 0105: GDO2 must be on the same port as GDO0. Please select GDO2 position 1 with GDO0 position 1, or GDO2 position 2 with GDO0 position 2 or 3."
+#endif
+#endif
+
 /**
  *  Timer control
  */
@@ -248,6 +292,53 @@ void A110x2500SpiRead(unsigned char address,
   P1SEL2 &= ~RF_SPI_MISO;
 }
 
+unsigned char A110x2500SpiReadv(unsigned char address,
+                                const struct sCC1101Segment *segment,
+                                unsigned char count)
+{
+  register volatile unsigned char i;    // Buffer iterator
+  unsigned char j;                      // Buffer offset
+  unsigned char status;                 // Chip status byte
+  
+  // Change MISO pin to SPI.
+  P1SEL |= RF_SPI_MISO;
+  P1SEL2 |= RF_SPI_MISO;
+  
+  RF_SPI_CSN_OUT &= ~RF_SPI_CSN;
+  // Look for CHIP_RDYn from radio.
+  while (RF_SPI_MISO_IN & RF_SPI_MISO);
+
+  // Write the address/command byte; the radio returns its status byte.
+  IFG2 &= ~UCB0RXIFG;
+  UCB0TXBUF = address;
+  while (!(IFG2 & UCB0RXIFG));
+  status = UCB0RXBUF;
+
+  // Write dummy byte(s) and read response(s) into each buffer in turn; CSn is
+  // held low so that the burst access continues.
+  while (count--)
+  {
+    for (i = 0, j = 0; i < segment->length; i++, j++)
+    {
+      while (!(IFG2 & UCB0TXIFG));
+      UCB0TXBUF = 0xFF;
+      while (!(IFG2 & UCB0RXIFG));
+      *(segment->data+j) = UCB0RXBUF;
+    }
+    segment++;
+  }
+
+  // Wait for operation to complete.
+  while(UCB0STAT & UCBUSY);
+  RF_SPI_CSN_OUT |= RF_SPI_CSN;
+  
+  // Change MISO pin to general purpose output (LED use if available).
+  P1SEL &= ~RF_SPI_MISO;
+  P1SEL2 &= ~RF_SPI_MISO;
+  
+  return status;
+}
+
 void A110x2500SpiWrite(unsigned char address,
 											 const unsigned char *buffer,
 											 unsigned char count)
@@ -334,6 +425,58 @@ void A110x2500Gdo0Enable(bool en)
   }
 }
 
+#if defined( PROTOCOL_USE_STREAMING )
+void A110x2500Gdo2Init()
+{
+  RF_GDO2_DIR &= ~RF_GDO2;
+  RF_GDO2_IES &= ~RF_GDO2;
+  RF_GDO2_IFG &= ~RF_GDO2;
+  RF_GDO2_SEL &= ~RF_GDO2;
+  RF_GDO2_SEL2 &= ~RF_GDO2;
+}
+
+bool A110x2500Gdo2Event(unsigned char event)
+{
+  if (RF_GDO2 & event)
+  {
+    // Clear GDO2 event.
+    RF_GDO2_IFG &= ~RF_GDO2;
+    return true;
+  }
+  return false;
+}
+
+void A110x2500Gdo2WaitForAssert()
+{
+  RF_GDO2_IES &= ~RF_GDO2;
+}
+
+void A110x2500Gdo2WaitForDeassert()
+{
+  RF_GDO2_IES |= RF_GDO2;
+}
+
+enum eCC1101GdoState A110x2500Gdo2GetState()
+{
+  return (RF_GDO2_IES & RF_GDO2) 
+    ? eCC1101GdoStateWaitForDeassert
+      : eCC1101GdoStateWaitForAssert;
+}
+
+void A110x2500Gdo2Enable(bool en)
+{
+  RF_GDO2_IFG &= ~RF_GDO2;
+  if (en)
+  {
+    RF_GDO2_IE |= RF_GDO2;
+  }
+  else
+  {
+    RF_GDO2_IE &= ~RF_GDO2;
+  }
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Hardware Timer
 
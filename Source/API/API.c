@@ -9,8 +9,8 @@
  *
  *  API.c - protocol Application Programming Interface (API).
  *
- *  @version  1.0.01
- *  @date     18 Oct 2012
+ *  @version  1.1.00
+ *  @date     16 Oct 2026
  *  @author   BPB, air@anaren.com
  *
  *  assumptions
@@ -27,6 +27,27 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added ProtocolSubmit
+ *  - added ProtocolTransferv and ProtocolSimpleTransferv; the message segments
+ *  are copied into Physical data segments rather than cast to them
+ *  - added ProtocolReleaseBuffer
+ *  - added ProtocolProcess
+ *  - added protocol instances (sProtocol); every operation takes the instance
+ *  it applies to
+ *  - the node role is taken from the setup information at run time
+ *  - added ProtocolStatusCounters and ProtocolClearCounters
+ *  - ProtocolSimpleTransfer and ProtocolTransfer send large messages as 
+ *  fragments (FrameSendMessage); the frame scheduler ticks with the Physical 
+ *  timer
+ *  - acknowledgements are requested by End Points set up to acknowledge
+ *  - added ProtocolPost (Gateway downlink mailboxes)
+ *  - added ProtocolAggregate (record aggregation)
+ *  - ProtocolConnect sends link requests through FrameConnect (join control)
+ *  - added ProtocolMulticast, ProtocolGroupAdd and ProtocolGroupRemove 
+ *  (broadcast and group downlink)
+ *  - the payload codecs are selected from the setup information
+ *  - the network key is taken from the setup information (link security)
  *  ver 1.0.01 : 18 Oct 2012
  *  - updated internal documentation; comments revised
  *  ver 1.0.00 : 21 Sep 2012
@@ -42,16 +63,103 @@
  *  Defines, enumerations, and structure definitions
  */
 
+// Role of an initialized instance
+#define ProtocolIsEndPoint(protocol)  ((protocol)->setup->role == eProtocolRoleEndPoint)
+
+/**
+ *  sProtocol - protocol instance. Holds every layer's information for one 
+ *  physical device (radio module).
+ */
+struct sProtocol
+{
+  const struct sProtocolSetupInfo *setup;   // Setup used to initialize the instance
+  struct sFrameScheduler frame;             // MAC scheduler information
+  struct sPhyAddressInfo phyAddress;        // Local node addressing information
+  struct sPhyDevice phy;                    // Physical device and data stream
+};
+
 // -----------------------------------------------------------------------------
 /**
  *  Global data
  */
 
+// Protocol instances
+static struct sProtocol gProtocol[PROTOCOL_MAX_INSTANCES];
+
 // -----------------------------------------------------------------------------
 /**
  *  Private interface
  */
 
+/**
+ *  ProtocolGetInstance - get the instance associated with the setup 
+ *  information. An instance is reused if it was initialized with the same 
+ *  setup information before.
+ *
+ *    @param  setup   Setup information of the instance.
+ *
+ *    @return Location of the instance, or NULL if every instance is in use.
+ */
+struct sProtocol* ProtocolGetInstance(const struct sProtocolSetupInfo *setup)
+{
+  struct sProtocol *protocol = NULL;
+  unsigned char i;
+  
+  for (i = 0; i < PROTOCOL_MAX_INSTANCES; i++)
+  {
+    if (gProtocol[i].setup == setup)
+    {
+      return &gProtocol[i];
+    }
+    else if ((gProtocol[i].setup == NULL) && (protocol == NULL))
+    {
+      protocol = &gProtocol[i];
+    }
+  }
+  
+  if (protocol != NULL)
+  {
+    protocol->setup = setup;
+  }
+  
+  return protocol;
+}
+
+/**
+ *  ProtocolSendv - send a message described by a list of segments. The 
+ *  segment descriptors (not the message) are copied into the data segments 
+ *  of the Frame layer.
+ *
+ *    @param  protocol      Protocol instance.
+ *    @param  dataRequest   Request data from the receiving node.
+ *    @param  segment       List of segments that make up the message.
+ *    @param  count         Number of segments in the list.
+ *
+ *    @return Success of the operation.
+ */
+bool ProtocolSendv(struct sProtocol *protocol,
+                   bool dataRequest,
+                   const struct sProtocolSegment *segment,
+                   unsigned char count)
+{
+  struct sPhyDataSegment stream[PROTOCOL_FRAME_MAX_SEGMENTS];
+  unsigned char i;
+  
+  if (count > PROTOCOL_FRAME_MAX_SEGMENTS)
+  {
+    // Error: too many message segments.
+    return false;
+  }
+  
+  for (i = 0; i < count; i++)
+  {
+    stream[i].data = segment[i].data;
+    stream[i].length = segment[i].length;
+  }
+  
+  return FrameSendv(&protocol->frame, eFrameTypeData, dataRequest, stream, count);
+}
+
 // -----------------------------------------------------------------------------
 /**
  *  Public interface
@@ -60,110 +168,172 @@
 // -----------------------------------------------------------------------------
 // Protocol configuration
 
-bool ProtocolInit(const struct sProtocolSetupInfo *setup)
+struct sProtocol* ProtocolInit(const struct sProtocolSetupInfo *setup)
 {
+  struct sProtocol *protocol;
+  
   if (setup == NULL)
   {
-    return false;
+    return NULL;
+  }
+  
+  // A Gateway MUST BE assigned a PAN identifier (see PhyAddressInit).
+  if ((setup->role == eProtocolRoleGateway) 
+      && PhyAddressIsBroadcast(setup->panId, PROTOCOL_PHYADDRESS_PANID_SIZE))
+  {
+    return NULL;
+  }
+  
+  protocol = ProtocolGetInstance(setup);
+  if (protocol == NULL)
+  {
+    return NULL;
   }
   
-  // Setup the Physical layer.
-  PhyInit(FrameDisassemble, FrameAssemble);
-  PhySetChannel(setup->channel[0]);
-  PhyTimerInit(NULL);
+  // Setup the Physical layer. The frame scheduler is the context of every
+  // Physical layer callback.
+  if (!PhyInit(&protocol->phy, 
+               setup->binding, 
+               &protocol->frame, 
+               FrameDisassemble, 
+               FrameAssemble))
+  {
+    return NULL;
+  }
+  PhySetChannel(&protocol->phy, setup->channel[0]);
+  PhyTimerInit(&protocol->phy, FrameTick);
   
-	// Setup the Data Link layer.
-  #if defined( PROTOCOL_ENDPOINT )
+  // Setup the Data Link layer. Only an End Point times out while waiting for
+  // a response.
   #if defined( PROTOCOL_USE_RX_TIMEOUT )
-  PhySyncTimerInit(FrameTimeout);
+  PhySyncTimerInit(&protocol->phy, 
+                   ProtocolIsEndPoint(protocol) ? FrameTimeout : NULL);
+  #endif
+  PhyAddressInit(&protocol->phyAddress, 
+                 &protocol->phy, 
+                 setup->panId, 
+                 setup->address, 
+                 ProtocolIsEndPoint(protocol) ? setup->Backup : NULL);
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  FrameTxQueueInit(&protocol->frame, setup->SubmitComplete);
   #endif
-  PhyAddressInit(setup->panId, setup->address, setup->Backup);
-  FrameInit(setup->TransferComplete);
-  #elif defined( PROTOCOL_GATEWAY )
-  PhyAddressInit(setup->panId, setup->address, NULL);
-  FrameInit(setup->TransferComplete, setup->LinkRequest);
+  #if defined( PROTOCOL_USE_MAILBOX )
+  FrameMailboxInit(&protocol->frame, setup->PostComplete);
   #endif
+  #if defined( PROTOCOL_USE_ACK )
+  FrameAckInit(&protocol->frame, 
+               ProtocolIsEndPoint(protocol) && setup->acknowledge, 
+               setup->AckComplete);
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  FrameCodecInit(&protocol->frame, setup->codecs);
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  FrameSecurityInit(&protocol->frame, setup->key);
+  #endif
+  FrameInit(&protocol->frame, 
+            &protocol->phyAddress, 
+            &protocol->phy, 
+            ProtocolIsEndPoint(protocol) ? FRAME_CONTROL_MODE_ENDPOINT : FRAME_CONTROL_MODE_GATEWAY,
+            setup->TransferComplete, 
+            setup->LinkRequest);
   
-  PhyEnable();
+  PhyEnable(&protocol->phy);
   
-  return true;
+  return protocol;
 }
 
 // -----------------------------------------------------------------------------
 // Protocol status information
 
-struct sProtocolPhyAddressInfo ProtocolStatusPhyAddressInfo()
+struct sProtocolPhyAddressInfo ProtocolStatusPhyAddressInfo(struct sProtocol *protocol)
 {
   struct sProtocolPhyAddressInfo phyAddressInfo;
   
-  memcpy(phyAddressInfo.panId, PhyAddressGetLocalInfo()->panId, PROTOCOL_PHYADDRESS_PANID_SIZE);
-  #if defined( PROTOCOL_ENDPOINT)
-  phyAddressInfo.connected = PhyAddressLinkExists();
-  #endif
+  memcpy(phyAddressInfo.panId, PhyAddressGetLocalInfo(&protocol->phyAddress)->panId, PROTOCOL_PHYADDRESS_PANID_SIZE);
+  phyAddressInfo.connected = PhyAddressLinkExists(&protocol->phyAddress);
   
   return phyAddressInfo;
 }
 
-struct sProtocolFrameInfo ProtocolStatusFrameInfo()
+struct sProtocolFrameInfo ProtocolStatusFrameInfo(struct sProtocol *protocol)
 {
   struct sProtocolFrameInfo frameInfo;
   
-  memcpy(frameInfo.srcAddr, FrameGetInfo()->header.srcAddr, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
-  frameInfo.seqNumber = FrameGetInfo()->header.seqNumber;
+  memcpy(frameInfo.srcAddr, FrameGetInfo(&protocol->frame)->header.srcAddr, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  frameInfo.seqNumber = FrameGetInfo(&protocol->frame)->header.seqNumber;
   
   return frameInfo;
 }
   
-const struct sProtocolPhysicalInfo* ProtocolStatusPhysicalInfo()
+const struct sProtocolPhysicalInfo* ProtocolStatusPhysicalInfo(struct sProtocol *protocol)
 {
-  return (struct sProtocolPhysicalInfo*)PhyGetDataStreamStatus();
+  return (struct sProtocolPhysicalInfo*)PhyGetDataStreamStatus(&protocol->phy);
 }
 
-bool ProtocolBusy()
+bool ProtocolBusy(struct sProtocol *protocol)
 {
-  return FrameBusy();
+  return FrameBusy(&protocol->frame);
+}
+
+const struct sProtocolCounters* ProtocolStatusCounters(struct sProtocol *protocol)
+{
+  return (const struct sProtocolCounters*)FrameGetCounters(&protocol->frame);
+}
+
+void ProtocolClearCounters(struct sProtocol *protocol)
+{
+  PROTOCOL_CRITICAL_SECTION(FrameClearCounters(&protocol->frame));
 }
 
 // -----------------------------------------------------------------------------
 // Protocol operations
 
-#if defined( PROTOCOL_ENDPOINT )
-bool ProtocolConnect(const unsigned char *txData, unsigned char length)
+bool ProtocolConnect(struct sProtocol *protocol,
+                     const unsigned char *txData, 
+                     unsigned char length)
 {
-  if (!PhyAddressLinkExists())
+  if (!ProtocolIsEndPoint(protocol))
   {
-    FrameSend(eFrameTypeLinkRequest, true, (unsigned char*)txData, length);
+    return false;
+  }
+  
+  if (!PhyAddressLinkExists(&protocol->phyAddress))
+  {
+    FrameConnect(&protocol->frame, (unsigned char*)txData, length);
     return false;
   }
   
   return true;
 }
-#endif
 
-#if defined( PROTOCOL_ENDPOINT )
-void ProtocolDisconnect()
+void ProtocolDisconnect(struct sProtocol *protocol)
 {
-  PhyAddressLinkDestroy();
+  if (ProtocolIsEndPoint(protocol))
+  {
+    PhyAddressLinkDestroy(&protocol->phyAddress);
+  }
 }
-#endif
 
-#if defined( PROTOCOL_ENDPOINT )
-bool ProtocolSimpleTransfer(const unsigned char *txData, unsigned char length)
+bool ProtocolSimpleTransfer(struct sProtocol *protocol,
+                            const unsigned char *txData, 
+                            unsigned int length)
 {
-  if (FrameSend(eFrameTypeData, false, (unsigned char*)txData, length))
+  if (ProtocolIsEndPoint(protocol)
+      && FrameSendMessage(&protocol->frame, false, (unsigned char*)txData, length))
   {
     return true;
   }
   return false;
 }
-#endif
 
-#if defined( PROTOCOL_ENDPOINT )
-bool ProtocolTransfer(const unsigned char *txData, unsigned char txLength)
+bool ProtocolTransfer(struct sProtocol *protocol,
+                      const unsigned char *txData, 
+                      unsigned int txLength)
 {
-  if (PhyAddressLinkExists())
+  if (ProtocolIsEndPoint(protocol) && PhyAddressLinkExists(&protocol->phyAddress))
   {
-    if (FrameSend(eFrameTypeData, true, (unsigned char*)txData, txLength))
+    if (FrameSendMessage(&protocol->frame, true, (unsigned char*)txData, txLength))
     {
       return true;
     }
@@ -171,25 +341,168 @@ bool ProtocolTransfer(const unsigned char *txData, unsigned char txLength)
   
   return false;
 }
+
+bool ProtocolSimpleTransferv(struct sProtocol *protocol,
+                             const struct sProtocolSegment *segment, 
+                             unsigned char count)
+{
+  if (ProtocolIsEndPoint(protocol))
+  {
+    return ProtocolSendv(protocol, false, segment, count);
+  }
+  
+  return false;
+}
+
+bool ProtocolTransferv(struct sProtocol *protocol,
+                       const struct sProtocolSegment *segment, 
+                       unsigned char count)
+{
+  if (ProtocolIsEndPoint(protocol) && PhyAddressLinkExists(&protocol->phyAddress))
+  {
+    return ProtocolSendv(protocol, true, segment, count);
+  }
+  
+  return false;
+}
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+unsigned char ProtocolSubmit(struct sProtocol *protocol,
+                             const unsigned char *txData, 
+                             unsigned char txLength,
+                             bool dataRequest)
+{
+  unsigned char handle = PROTOCOL_TX_HANDLE_INVALID;
+  
+  // A standard transfer requires a connection (see ProtocolTransfer).
+  if (ProtocolIsEndPoint(protocol)
+      && (!dataRequest || PhyAddressLinkExists(&protocol->phyAddress)))
+  {
+    PROTOCOL_CRITICAL_SECTION(handle = FrameSubmit(&protocol->frame, dataRequest, (unsigned char*)txData, txLength));
+  }
+  
+  return handle;
+}
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+bool ProtocolAggregate(struct sProtocol *protocol,
+                       const unsigned char *txData, 
+                       unsigned char txLength)
+{
+  bool added = false;
+  
+  if (ProtocolIsEndPoint(protocol))
+  {
+    PROTOCOL_CRITICAL_SECTION(added = FrameAggregate(&protocol->frame, txData, txLength));
+  }
+  
+  return added;
+}
 #endif
 
-#if defined( PROTOCOL_GATEWAY )
-void ProtocolLoadDataResponse(unsigned char *txData,
+#if defined( PROTOCOL_USE_MULTICAST )
+bool ProtocolMulticast(struct sProtocol *protocol,
+                       const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                       unsigned char *txData, 
+                       unsigned char txLength)
+{
+  bool sent = false;
+  
+  if (!ProtocolIsEndPoint(protocol))
+  {
+    PROTOCOL_CRITICAL_SECTION(sent = FrameMulticast(&protocol->frame, group, txData, txLength));
+  }
+  
+  return sent;
+}
+
+bool ProtocolGroupAdd(struct sProtocol *protocol,
+                      const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE])
+{
+  bool added = false;
+  
+  if (ProtocolIsEndPoint(protocol))
+  {
+    PROTOCOL_CRITICAL_SECTION(added = FrameGroupAdd(&protocol->frame, group));
+  }
+  
+  return added;
+}
+
+bool ProtocolGroupRemove(struct sProtocol *protocol,
+                         const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE])
+{
+  bool removed = false;
+  
+  if (ProtocolIsEndPoint(protocol))
+  {
+    PROTOCOL_CRITICAL_SECTION(removed = FrameGroupRemove(&protocol->frame, group));
+  }
+  
+  return removed;
+}
+#endif
+
+void ProtocolLoadDataResponse(struct sProtocol *protocol,
+                              unsigned char *txData,
                               unsigned char txLength)
 {
-  FrameSetDataResponse(txData, txLength);
+  if (!ProtocolIsEndPoint(protocol))
+  {
+    FrameSetDataResponse(&protocol->frame, txData, txLength);
+  }
+}
+
+#if defined( PROTOCOL_USE_MAILBOX )
+unsigned char ProtocolPost(struct sProtocol *protocol,
+                           const unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                           const unsigned char *txData, 
+                           unsigned char txLength)
+{
+  unsigned char handle = PROTOCOL_MAIL_HANDLE_INVALID;
+  
+  if (!ProtocolIsEndPoint(protocol))
+  {
+    PROTOCOL_CRITICAL_SECTION(handle = FramePost(&protocol->frame, address, (unsigned char*)txData, txLength));
+  }
+  
+  return handle;
+}
+#endif
+
+#if defined( PROTOCOL_USE_RX_POOL )
+bool ProtocolReleaseBuffer(struct sProtocol *protocol,
+                           unsigned char *payload)
+{
+  bool released = false;
+  
+  PROTOCOL_CRITICAL_SECTION(released = FrameReleaseBuffer(&protocol->frame, payload));
+  
+  return released;
 }
 #endif
 
 // -----------------------------------------------------------------------------
 // Protocol interrupt service routine operations
 
-unsigned char ProtocolEngine(volatile unsigned char event)
+unsigned char ProtocolEngine(struct sProtocol *protocol, 
+                             volatile unsigned char event)
+{
+  return PhySyncEopIsr(&protocol->phy, event);
+}
+
+void ProtocolEngineTick(struct sProtocol *protocol)
 {
-  return PhySyncEopIsr(event);
+  PhyTimerIsr(&protocol->phy);
 }
 
-void ProtocolEngineTick()
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+// -----------------------------------------------------------------------------
+// Protocol deferred processing
+
+unsigned char ProtocolProcess(struct sProtocol *protocol)
 {
-  PhyTimerIsr();
+  return PhyProcess(&protocol->phy);
 }
+#endif
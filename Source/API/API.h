@@ -11,8 +11,8 @@
  *
  *  API.h - protocol Application Programming Interface (API).
  *
- *  @version  1.0.01
- *  @date     18 Oct 2012
+ *  @version  1.1.00
+ *  @date     16 Oct 2026
  *  @author   BPB, air@anaren.com
  *
  *  assumptions
@@ -26,12 +26,58 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added ProtocolSubmit, an asynchronous transfer queue (PROTOCOL_USE_TX_QUEUE)
+ *  - added ProtocolTransferv and ProtocolSimpleTransferv (gather transfers)
+ *  - added ProtocolReleaseBuffer for loaned receive buffers (PROTOCOL_USE_RX_POOL)
+ *  - added ProtocolProcess, deferred processing from the main loop 
+ *  (PROTOCOL_USE_DEFERRED_PROCESSING)
+ *  - added protocol instances; ProtocolInit returns the instance (sProtocol)
+ *  that every other operation takes, so that several radio modules may be 
+ *  driven at the same time (PROTOCOL_MAX_INSTANCES)
+ *  - the node role is selected at run time (sProtocolSetupInfo.role) instead of
+ *  by PROTOCOL_ENDPOINT/PROTOCOL_GATEWAY; both roles share one setup structure
+ *  and one TransferComplete signature
+ *  - added ProtocolStatusCounters and ProtocolClearCounters; optional receive 
+ *  latency statistics (PROTOCOL_USE_LATENCY_COUNTERS)
+ *  - ProtocolSimpleTransfer and ProtocolTransfer accept messages larger than a
+ *  frame; they are sent as fragments and reassembled by the receiver 
+ *  (PROTOCOL_USE_SEGMENTATION)
+ *  - TransferComplete reports the payload length as an unsigned int
+ *  - added acknowledged transfers with automatic retransmission 
+ *  (PROTOCOL_USE_ACK, sProtocolSetupInfo.acknowledge and AckComplete)
+ *  - added optional listen-before-talk channel access with random backoff 
+ *  (PROTOCOL_USE_CSMA); a queued transfer completes with 
+ *  PROTOCOL_TX_STATUS_CHANNEL_BUSY if the channel stays busy
+ *  - a Gateway delivers a transfer sent again by an End Point only once 
+ *  (PROTOCOL_USE_DUPLICATE_FILTER); a data request sent again is answered 
+ *  with the same response
+ *  - a Gateway with an endpoint table drops the frames of a new End Point 
+ *  while every entry holds an established link (rxDropTable, 
+ *  PROTOCOL_USE_ENDPOINT_TABLE)
+ *  - added ProtocolPost; a Gateway answers data requests with the messages 
+ *  posted for the requesting End Point (PROTOCOL_USE_MAILBOX)
+ *  - an End Point told that more posted messages are waiting requests them 
+ *  before it goes back to low power mode
+ *  - transfer completion status values (PROTOCOL_TX_STATUS_x) no longer 
+ *  depend on the transfer queue
+ *  - added ProtocolAggregate; small records are gathered into one frame and 
+ *  delivered one by one to TransferComplete (PROTOCOL_USE_AGGREGATION)
+ *  - added beacon counters for the TDMA superframe (PROTOCOL_USE_TDMA)
+ *  - ProtocolConnect backs off between link requests and honours the retry 
+ *  time of a Gateway that defers it (PROTOCOL_USE_JOIN_CONTROL)
+ *  - added ProtocolMulticast, ProtocolGroupAdd and ProtocolGroupRemove; a 
+ *  Gateway sends to every End Point or to a group (PROTOCOL_USE_MULTICAST)
+ *  - added payload codecs (sProtocolSetupInfo.codecs); an End Point encodes 
+ *  its transfers with the codecs its Gateway decodes (PROTOCOL_USE_CODEC)
+ *  - added link security (sProtocolSetupInfo.key); the frames of a link are 
+ *  encrypted and authenticated with AES-128 CCM* (PROTOCOL_USE_SECURITY)
  *  ver 1.0.01 : 18 Oct 2012
  *  - updated internal documentation; comments revised
  *  ver 1.0.00 : 21 Sep 2012
  *  - initial release
  */
-#define API_INFO "API 1.0.01"
+#define API_INFO "API 1.1.00"
 
 #ifndef bool
 #define bool unsigned char
@@ -58,13 +104,70 @@
 #define PROTOCOL_PHYSICAL_STATUS_CRC    (0x0080u)
 #define PROTOCOL_PHYSICAL_STATUS_LQI    (0x007Fu)
 
-#if defined( PROTOCOL_ENDPOINT )    
+#if defined( PROTOCOL_USE_TX_QUEUE )
+// Transfer queue handles (see ProtocolSubmit)
+#define PROTOCOL_TX_HANDLE_INVALID      (0x00u)
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+// Downlink message handles (see ProtocolPost)
+#define PROTOCOL_MAIL_HANDLE_INVALID    (0x00u)
+#endif
+
+// Transfer completion status (see SubmitComplete and PostComplete)
+#define PROTOCOL_TX_STATUS_SUCCESS      (0x00u)
+#define PROTOCOL_TX_STATUS_TIMEOUT      (0x01u)
+#define PROTOCOL_TX_STATUS_ERROR        (0x02u)
+#define PROTOCOL_TX_STATUS_NO_ACK       (0x03u)
+#define PROTOCOL_TX_STATUS_CHANNEL_BUSY (0x04u)
+
+#if defined( PROTOCOL_USE_CODEC )
+// Payload codecs (see sProtocolSetupInfo.codecs)
+#define PROTOCOL_CODEC_DELTA            (0x02u)
+#define PROTOCOL_CODEC_LZ               (0x04u)
+#endif
+
+/**
+ *  sProtocol - protocol instance (one per radio module). Returned by 
+ *  ProtocolInit; its content is private to the protocol.
+ */
+struct sProtocol;
+
+/**
+ *  sPhyBinding - hardware interfaces (SPI, GDOx, etc.) used by a radio module.
+ *  Defined by the Physical bridge implementation (e.g. A110x2500PhyBridge.h).
+ */
+struct sPhyBinding;
+
+/**
+ *  sProtocolSegment - a contiguous part of a message. A message may be described
+ *  by a list of segments which are sent, in order, without being copied into a
+ *  single buffer first.
+ */
+struct sProtocolSegment
+{
+  const unsigned char *data;      // Location of the segment
+  unsigned char length;           // Number of bytes in the segment
+};
+
+/**
+ *  eProtocolRole - role of the local node in the network. The role is chosen 
+ *  when the protocol is initialized (see sProtocolSetupInfo).
+ */
+enum eProtocolRole
+{
+  eProtocolRoleEndPoint = 0,      // End Point; links to and transfers with a Gateway
+  eProtocolRoleGateway  = 1       // Gateway; accepts links and serves End Points
+};
+
 /**
- *  sProtocolSetupInfo - setup information used to initialize the protocol. For
- *  an End Point node, { channel, panId, address } are required parameters.
+ *  sProtocolSetupInfo - setup information used to initialize the protocol. 
+ *  { role, channel, panId, address, TransferComplete } are required parameters
+ *  for every node. A Gateway also requires LinkRequest.
  */
 struct sProtocolSetupInfo
 {
+  enum eProtocolRole role;
   unsigned char channel[PROTOCOL_CHANNEL_LIST_SIZE];
   // Physical addressing setup
   unsigned char panId[PROTOCOL_PHYADDRESS_PANID_SIZE];
@@ -80,8 +183,8 @@ struct sProtocolSetupInfo
    *  be paired with a Gateway. A Gateway does not store link information of 
    *  other nodes and does not store any remote addresses.
    *
-   *  Note: It is assumed that the required information is stored in the
-   *  following order,
+   *  Note: End Point only (may be NULL). It is assumed that the required 
+   *  information is stored in the following order,
    *
    *      For End Point:
    *       -----------------------------------------------------------------
@@ -99,31 +202,12 @@ struct sProtocolSetupInfo
    *    @return Success of the operation.
    */
   bool(*Backup)(bool read, unsigned char *data, unsigned char size);
-  /**
-   *  TransferComplete - notification of a transfer complete event. Allows the
-   *  application to read an incoming message and act on it.
-   *
-   *    @param  payload     Data being received.
-   *    @param  length      Number of bytes in the payload.
-   *
-   *    @return Status message (application use only).
-   */
-  unsigned char(*TransferComplete)(unsigned char *payload, unsigned char length);
-};
-#elif defined( PROTOCOL_GATEWAY )
-/**
- *  sProtocolSetupInfo - setup information used to initialize the protocol. For
- *  a Gateway node, { channel, panId, address } are required parameters.
- */
-struct sProtocolSetupInfo
-{
-  unsigned char channel[PROTOCOL_CHANNEL_LIST_SIZE];
-  unsigned char panId[PROTOCOL_PHYADDRESS_PANID_SIZE];
-  unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];
   /**
    *  LinkRequest - notification of a link request event. Allows the application 
    *  to read the optional request payload and accept/deny the request.
    *
+   *  Note: Gateway only (ignored by an End Point).
+   *
    *    @param  payload   May contain an optional link request message.
    *    @param  length    Number of bytes in the payload.
    *
@@ -135,17 +219,94 @@ struct sProtocolSetupInfo
    *  TransferComplete - notification of a transfer complete event. Allows the
    *  application to read an incoming message and act on it.
    *
-   *    @param  dataRequest Data requested indicator.
-   *    @param  payload     Data being received.
+   *    @param  dataRequest Data requested indicator. Always false for an End 
+   *                        Point.
+   *    @param  payload     Data being received. A message reassembled from 
+   *                        fragments is only valid until the callback returns
+   *                        (it is not a loaned receive buffer).
    *    @param  length      Number of bytes in the payload.
    *
    *    @return Status message (application use only).
    */
   unsigned char(*TransferComplete)(bool dataRequest, 
                                    unsigned char *payload, 
-                                   unsigned char length);
+                                   unsigned int length);
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  /**
+   *  SubmitComplete - notification that a transfer queued with ProtocolSubmit
+   *  has completed. The transfer's buffer may be reused from this point on.
+   *
+   *  Note: End Point only (may be NULL for a Gateway).
+   *
+   *    @param  handle      Handle returned by ProtocolSubmit.
+   *    @param  status      Completion status (PROTOCOL_TX_STATUS_x). A half 
+   *                        duplex transfer only succeeds once its response has
+   *                        been received.
+   */
+  void(*SubmitComplete)(unsigned char handle, unsigned char status);
+  #endif
+  /**
+   *  binding - hardware interfaces used by the radio module of this instance.
+   *  If NULL, the default interfaces of the Physical bridge are used.
+   */
+  const struct sPhyBinding *binding;
+  #if defined( PROTOCOL_USE_ACK )
+  /**
+   *  acknowledge - request a link-layer acknowledgement for every transfer 
+   *  (End Point only). A transfer that is not acknowledged is sent again, up 
+   *  to PROTOCOL_ACK_MAX_RETRIES times, after a random backoff. The data must 
+   *  remain unchanged until the transfer completes.
+   */
+  bool acknowledge;
+  /**
+   *  AckComplete - final status of an acknowledged transfer (End Point only; 
+   *  may be NULL). Invoked before TransferComplete reports the completion of
+   *  an acknowledged transfer. An unacknowledged transfer does not complete 
+   *  (a queued one completes with PROTOCOL_TX_STATUS_NO_ACK).
+   *
+   *    @param  acknowledged  The transfer was acknowledged by the Gateway.
+   */
+  void(*AckComplete)(bool acknowledged);
+  #endif
+  #if defined( PROTOCOL_USE_MAILBOX )
+  /**
+   *  PostComplete - notification that a message posted with ProtocolPost has
+   *  been sent (or dropped). The message's buffer may be reused from this 
+   *  point on.
+   *
+   *  Note: Gateway only (may be NULL for an End Point).
+   *
+   *    @param  handle      Handle returned by ProtocolPost.
+   *    @param  status      Completion status (PROTOCOL_TX_STATUS_x).
+   */
+  void(*PostComplete)(unsigned char handle, unsigned char status);
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  /**
+   *  codecs - payload codecs (PROTOCOL_CODEC_x, 0 for none). A Gateway 
+   *  decodes the codecs selected and tells every End Point it links. An End 
+   *  Point encodes its single frame transfers with the codecs both ends 
+   *  selected whenever that makes them shorter: Delta codes a message against
+   *  the previous one of the same length (at most 
+   *  PROTOCOL_CODEC_REFERENCE_LENGTH bytes), LZ against a static dictionary.
+   *  A message the Gateway cannot decode is not passed to TransferComplete; 
+   *  a decoded message is only valid until the callback returns.
+   */
+  unsigned char codecs;
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  /**
+   *  key - network key (16 bytes, NULL for none), shared by the Gateway and 
+   *  its End Points. Each link gets its own key, derived from the network 
+   *  key when the link is established; the frames of the link are then 
+   *  encrypted and authenticated, and a frame that is not authentic or older
+   *  than the last one accepted is dropped. Link requests and messages to 
+   *  every End Point or to a group are not secured. The key is not copied; 
+   *  it must remain valid.
+   */
+  const unsigned char *key;
+  #endif
 };
-#endif
 
 /**
  *  sProtocolStatusInfo - protocol status information that is available for the
@@ -167,9 +328,7 @@ struct sProtocolStatusInfo
     struct sProtocolPhyAddressInfo
     {
       unsigned char panId[PROTOCOL_PHYADDRESS_PANID_SIZE];  // Personal Area Network (PAN) identifier
-      #if defined( PROTOCOL_ENDPOINT )
-      bool connected;                                       // Connection status
-      #endif
+      bool connected;                                       // Connection status (End Point only)
     } phyAddressInfo;
     /**
      *  sProtocolFrameInfo - Data Link layer MAC frame information that is
@@ -180,6 +339,87 @@ struct sProtocolStatusInfo
       unsigned char srcAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];  // Source of the payload
       unsigned char seqNumber;                                  // Frame sequence number
     } frameInfo;
+    /**
+     *  sProtocolCounters - Data Link layer statistics. The counters are always
+     *  maintained and wrap around.
+     */
+    struct sProtocolCounters
+    {
+      unsigned int txFrames;        // Frames sent
+      unsigned int txBusy;          // Transfers rejected; the protocol was busy
+      unsigned int rxFrames;        // Frames received and accepted
+      unsigned int rxLengthErrors;  // Messages too short to be a frame
+      unsigned int rxCrcErrors;     // Messages received with an invalid CRC
+      unsigned int rxDropMode;      // Frames dropped; sent by a node of the wrong role
+      unsigned int rxDropAddress;   // Frames dropped; destined for another node
+      unsigned int rxDropPanId;     // Frames dropped; destined for another PAN
+      unsigned int rxTimeouts;      // Responses that did not arrive in time
+      unsigned int linkAccepted;    // Link requests accepted (Gateway)
+      unsigned int linkDenied;      // Link requests denied (Gateway)
+      #if defined( PROTOCOL_USE_SEGMENTATION )
+      unsigned int rxFragmentDrops; // Fragments dropped; out of sequence or no buffer
+      unsigned int rxFragmentCrcErrors; // Reassembled messages with an invalid CRC
+      unsigned int rxFragmentTimeouts;  // Reassemblies abandoned; fragment overdue
+      #endif
+      #if defined( PROTOCOL_USE_ACK )
+      unsigned int txRetries;       // Frames sent again; no acknowledgement
+      unsigned int txAckFailures;   // Frames never acknowledged
+      unsigned int txAcks;          // Acknowledgements sent (Gateway)
+      #endif
+      #if defined( PROTOCOL_USE_CSMA )
+      unsigned int txCcaBusy;       // Channel found busy before a transmission
+      unsigned int txChannelFailures; // Frames dropped; channel busy after every backoff
+      #endif
+      #if defined( PROTOCOL_USE_DUPLICATE_FILTER )
+      unsigned int rxDuplicates;    // Frames dropped; already received (Gateway)
+      #endif
+      #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+      unsigned int rxDropTable;     // Frames dropped; new End Point and every 
+                                    // entry linked (Gateway)
+      #endif
+      #if defined( PROTOCOL_USE_AGGREGATION )
+      unsigned int txRecords;       // Records sent in aggregate frames
+      unsigned int rxRecords;       // Records received in aggregate frames
+      unsigned int rxRecordErrors;  // Aggregate frames with a malformed record
+      #endif
+      #if defined( PROTOCOL_USE_TDMA )
+      unsigned int txBeacons;       // Beacons sent (Gateway)
+      unsigned int rxBeacons;       // Beacons received (End Point)
+      unsigned int rxBeaconMisses;  // Beacons expected but not received (End Point)
+      #endif
+      #if defined( PROTOCOL_USE_JOIN_CONTROL )
+      unsigned int linkDeferred;    // Link requests deferred (sent by a Gateway, 
+                                    // received by an End Point)
+      #endif
+      #if defined( PROTOCOL_USE_MULTICAST )
+      unsigned int txMulticasts;    // Broadcast and group messages sent (Gateway)
+      unsigned int rxMulticasts;    // Broadcast and group messages received (End Point)
+      #endif
+      #if defined( PROTOCOL_USE_CODEC )
+      unsigned int txEncoded;       // Transfers sent encoded (End Point)
+      unsigned int txCodecSaved;    // Payload bytes saved by encoding (End Point)
+      unsigned int rxDecoded;       // Encoded transfers received (Gateway)
+      unsigned int rxCodecErrors;   // Transfers that could not be decoded (Gateway)
+      #endif
+      #if defined( PROTOCOL_USE_SECURITY )
+      unsigned int txSecured;       // Frames sent secured
+      unsigned int rxAuthErrors;    // Frames dropped; not secured or not authentic
+      unsigned int rxReplays;       // Frames dropped; older than the last one accepted
+      #endif
+      #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+      /**
+       *  sProtocolLatency - time from the end of a received message (GDO0 
+       *  edge) to the TransferComplete callback, in MCU_TIMESTAMP ticks.
+       */
+      struct sProtocolLatency
+      {
+        unsigned int min;           // Shortest latency
+        unsigned int max;           // Longest latency
+        unsigned int average;       // Average latency
+        unsigned int samples;       // Number of samples in the average
+      } latency;
+      #endif
+    } counters;
   } dataLink;
   
   /**
@@ -217,12 +457,17 @@ struct sProtocolStatusInfo
  *  ProtocolInit - initialize the protocol structures and available hardware
  *  (e.g. communication and timer peripheral).
  *
+ *  Each setup structure initializes its own instance of the protocol. Up to 
+ *  PROTOCOL_MAX_INSTANCES instances (radio modules) may be initialized; 
+ *  calling this function again with the same setup structure re-initializes 
+ *  the same instance.
+ *
  *    @param  setup   Setup information required to properly initialize the
  *                    protocol.
  *
- *    @return Success of initializing the protocol.
+ *    @return Protocol instance, or NULL if initialization failed.
  */
-bool ProtocolInit(const struct sProtocolSetupInfo *setup);
+struct sProtocol* ProtocolInit(const struct sProtocolSetupInfo *setup);
 
 // -----------------------------------------------------------------------------
 // Protocol status information
@@ -231,105 +476,363 @@ bool ProtocolInit(const struct sProtocolSetupInfo *setup);
  *  ProtocolStatusPhyAddressInfo - get the Data Link layer physical addressing
  *  information for the last message.
  *
+ *    @param  protocol  Protocol instance.
+ *
  *    @return Physical address information associated with the last message.
  */
-struct sProtocolPhyAddressInfo ProtocolStatusPhyAddressInfo(void);
+struct sProtocolPhyAddressInfo ProtocolStatusPhyAddressInfo(struct sProtocol *protocol);
 
 /**
  *  ProtocolStatusFrameInfo - get the Data Link layer MAC frame information for
  *  the last message.
  *
+ *    @param  protocol  Protocol instance.
+ *
  *    @return Frame information associated with the last message.
  */
-struct sProtocolFrameInfo ProtocolStatusFrameInfo(void);
+struct sProtocolFrameInfo ProtocolStatusFrameInfo(struct sProtocol *protocol);
 
 /**
  *  ProtocolStatusPhysicalInfo - get the Physical layer status information for
  *  the last message.
  *
+ *    @param  protocol  Protocol instance.
+ *
  *    @return Physical information associated with the last message.
  */
-const struct sProtocolPhysicalInfo* ProtocolStatusPhysicalInfo(void);
+const struct sProtocolPhysicalInfo* ProtocolStatusPhysicalInfo(struct sProtocol *protocol);
 
 /**
  *  ProtocolBusy - inidicates if the protocol is currently busy or ready for the
  *  next operation.
  *
+ *    @param  protocol  Protocol instance.
+ *
  *    @return   If true, the protocol is busy performing an operation. If false,
  *              the protocol is ready.
  */
-bool ProtocolBusy(void);
+bool ProtocolBusy(struct sProtocol *protocol);
+
+/**
+ *  ProtocolStatusCounters - get the Data Link layer statistics.
+ *
+ *    @param  protocol  Protocol instance.
+ *
+ *    @return Statistics gathered since the protocol was initialized or the 
+ *            counters were last cleared.
+ */
+const struct sProtocolCounters* ProtocolStatusCounters(struct sProtocol *protocol);
+
+/**
+ *  ProtocolClearCounters - clear the Data Link layer statistics.
+ *
+ *    @param  protocol  Protocol instance.
+ */
+void ProtocolClearCounters(struct sProtocol *protocol);
 
 // -----------------------------------------------------------------------------
 // Protocol operations
 
 /**
  *  ProtocolConnect - attempts to connect the local node to a remote node.
+ *  With PROTOCOL_USE_JOIN_CONTROL, no link request is sent until the backoff 
+ *  of the previous one, or the retry time given by the Gateway, has elapsed.
  *
  *  Note: This function is only applicable to nodes that perform two-way 
  *  communication and may only be called on an End Point node.
  *
+ *    @param  protocol    Protocol instance.
  *    @param  txData      Data to be transferred during the connection attempt.
  *    @param  txLength    Number of data bytes to transfer.
  *
  *    @return Success of the operation.
  */
-bool ProtocolConnect(const unsigned char *txData, unsigned char length);
+bool ProtocolConnect(struct sProtocol *protocol,
+                     const unsigned char *txData, unsigned char length);
 
 /**
  *  ProtocolDisconnect - disconnects local node from a remote node.
  *
  *  Note: This function is only applicable to nodes that perform two-way 
  *  communication and may only be called on an End Point node.
+ *
+ *    @param  protocol  Protocol instance.
  */
-void ProtocolDisconnect(void);
+void ProtocolDisconnect(struct sProtocol *protocol);
 
 /**
  *  ProtocolSimpleTransfer - initiates a simple protocol data transfer. This
  *  function can be used as a "brute force" mechanism for transferring a 
  *  message; no connection is required.
  *
- *  Note: This function is only supported by End Point nodes!
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *  Note: A message that does not fit in one frame is sent as fragments when
+ *  PROTOCOL_USE_SEGMENTATION is defined (PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH 
+ *  bytes max). The data must remain unchanged until the transfer completes.
  *
+ *    @param  protocol    Protocol instance.
  *    @param  txData      Data to be transferred.
  *    @param  txLength    Number of data bytes to transfer.
  *
  *    @return Success of the operation.
  */
-bool ProtocolSimpleTransfer(const unsigned char *txData, unsigned char length);
+bool ProtocolSimpleTransfer(struct sProtocol *protocol,
+                            const unsigned char *txData, unsigned int length);
 
 /**
  *  ProtocolTransfer - initiates a standard protocol data transfer.
  *
- *  Note: This function is only supported by End Point nodes!
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
  *
  *  Note: If an End Point is not connected to a Gateway node the provided data 
  *  will not be transferred until a connection exists. Be sure to ALWAYS call 
  *  Connect before attempting to use this function.
  *
+ *  Note: Large messages are sent as fragments (see ProtocolSimpleTransfer).
+ *  The data request is sent with the last fragment.
+ *
+ *    @param  protocol    Protocol instance.
  *    @param  txData      Data to be transferred.
  *    @param  txLength    Number of data bytes to transfer.
  *
  *    @return Success of the operation.
  */
-bool ProtocolTransfer(const unsigned char *txData, unsigned char txLength);
+bool ProtocolTransfer(struct sProtocol *protocol,
+                      const unsigned char *txData, unsigned int txLength);
+
+/**
+ *  ProtocolSimpleTransferv - same as ProtocolSimpleTransfer, but the message is
+ *  gathered from a list of segments (e.g. a header and a separate buffer of 
+ *  readings).
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  segment     List of message segments.
+ *    @param  count       Number of segments in the list.
+ *
+ *    @return Success of the operation.
+ */
+bool ProtocolSimpleTransferv(struct sProtocol *protocol,
+                             const struct sProtocolSegment *segment, 
+                             unsigned char count);
+
+/**
+ *  ProtocolTransferv - same as ProtocolTransfer, but the message is gathered
+ *  from a list of segments (e.g. a header and a separate buffer of readings).
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  segment     List of message segments.
+ *    @param  count       Number of segments in the list.
+ *
+ *    @return Success of the operation.
+ */
+bool ProtocolTransferv(struct sProtocol *protocol,
+                       const struct sProtocolSegment *segment, 
+                       unsigned char count);
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+/**
+ *  ProtocolSubmit - queues a protocol data transfer. Queued transfers are sent 
+ *  back-to-back, in order, as soon as the protocol is ready; the caller does 
+ *  not need to wait for ProtocolBusy to clear between transfers.
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *  Note: The data is not copied. The buffer must remain unchanged until the
+ *  SubmitComplete callback reports the handle returned by this function.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  txData      Data to be transferred.
+ *    @param  txLength    Number of data bytes to transfer.
+ *    @param  dataRequest If true, perform a standard transfer (see 
+ *                        ProtocolTransfer); a connection is required. 
+ *                        Otherwise, perform a simple transfer (see 
+ *                        ProtocolSimpleTransfer).
+ *
+ *    @return Handle of the transfer or PROTOCOL_TX_HANDLE_INVALID if the 
+ *            transfer could not be queued.
+ */
+unsigned char ProtocolSubmit(struct sProtocol *protocol,
+                             const unsigned char *txData, 
+                             unsigned char txLength,
+                             bool dataRequest);
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+/**
+ *  ProtocolAggregate - adds a record to the next aggregate transfer. Records 
+ *  are gathered, each with a one byte length prefix, and sent together in one 
+ *  simple transfer once the next record would not fit or 
+ *  PROTOCOL_AGGREGATE_LATENCY milliseconds after the first record was added.
+ *  The receiver reports each record with its own TransferComplete callback.
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *  Note: The data is copied; the buffer may be reused as soon as this 
+ *  function returns. A received record is only valid for the duration of its
+ *  TransferComplete callback (it is never loaned; see ProtocolReleaseBuffer).
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  txData      Record to be transferred.
+ *    @param  txLength    Number of record bytes (1 to 
+ *                        PROTOCOL_AGGREGATE_LENGTH - 1).
+ *
+ *    @return Whether the record was added (true) or not (false: the record is
+ *            too large, or the gathered records could not be sent yet to make
+ *            room for it).
+ */
+bool ProtocolAggregate(struct sProtocol *protocol,
+                       const unsigned char *txData, 
+                       unsigned char txLength);
+#endif
+
+#if defined( PROTOCOL_USE_MULTICAST )
+/**
+ *  ProtocolMulticast - sends a simple transfer to every End Point or to the 
+ *  End Points of a group. The transfer is not acknowledged. With 
+ *  PROTOCOL_USE_TDMA it is carried by the next beacon, which every End Point 
+ *  wakes up for; TransferComplete reports once the beacon has been sent. 
+ *  Otherwise it is sent at once and only reaches End Points whose receiver is
+ *  on.
+ *
+ *  Note: This function is only supported by Gateway nodes! It fails on an 
+ *  End Point node.
+ *
+ *  Note: The data is not copied; the buffer must not be modified until the 
+ *  TransferComplete callback. A received group transfer is reported by the 
+ *  TransferComplete callback of the End Point like any other; with 
+ *  PROTOCOL_USE_TDMA it is only valid for the duration of the callback (it is
+ *  never loaned; see ProtocolReleaseBuffer).
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  group       Group address, or NULL to reach every End Point.
+ *    @param  txData      Data to be transferred.
+ *    @param  txLength    Number of data bytes.
+ *
+ *    @return Whether the transfer was started (true) or not (false: the 
+ *            protocol is busy, a transfer already waits for the beacon, or 
+ *            the data does not fit in one frame).
+ */
+bool ProtocolMulticast(struct sProtocol *protocol,
+                       const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                       unsigned char *txData, 
+                       unsigned char txLength);
+
+/**
+ *  ProtocolGroupAdd - makes the local node accept the transfers sent to a 
+ *  group. Every End Point accepts the transfers sent to every End Point.
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  group       Group address.
+ *
+ *    @return Whether the local node belongs to the group (true) or not 
+ *            (false: PROTOCOL_MULTICAST_GROUPS groups are already joined, or
+ *            the address is the broadcast address).
+ */
+bool ProtocolGroupAdd(struct sProtocol *protocol,
+                      const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]);
+
+/**
+ *  ProtocolGroupRemove - stops the local node from accepting the transfers 
+ *  sent to a group.
+ *
+ *  Note: This function is only supported by End Point nodes! It fails on a
+ *  Gateway node.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  group       Group address.
+ *
+ *    @return Whether the local node belonged to the group (true) or not 
+ *            (false).
+ */
+bool ProtocolGroupRemove(struct sProtocol *protocol,
+                         const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]);
+#endif
 
 /**
  *  ProtocolLoadDataResponse - loads a response to a data request into the 
  *  protocol transmission buffer. 
  *
- *  Note: This function is only supported by Gateway nodes!
+ *  Note: This function is only supported by Gateway nodes! It has no effect
+ *  on an End Point node.
  *
  *  Note: This function should be used in conjunction with data requests only!
  *  When a remote node requests data, load any new available data using this
  *  function.
  *
+ *    @param  protocol    Protocol instance.
  *    @param  txData      Data to be transferred in a response message.
  *    @param  txLength    Number of data bytes to transfer.
  */
-void ProtocolLoadDataResponse(unsigned char *txData,
+void ProtocolLoadDataResponse(struct sProtocol *protocol,
+                              unsigned char *txData,
                               unsigned char txLength);
 
+#if defined( PROTOCOL_USE_MAILBOX )
+/**
+ *  ProtocolPost - posts a message for an End Point. The message is sent as 
+ *  the response to the next data request of the End Point, unless a response 
+ *  is loaded with ProtocolLoadDataResponse during that request's 
+ *  TransferComplete callback. The messages of an End Point are sent in the 
+ *  order they were posted; they may be posted at any time, even before the 
+ *  End Point has been heard.
+ *
+ *  Note: While messages are left, every frame sent to the End Point says so.
+ *  The End Point then keeps sending empty data requests (TransferComplete 
+ *  reports them with a length of 0) until its mailbox is empty.
+ *
+ *  Note: This function is only supported by Gateway nodes! It fails on an End
+ *  Point node.
+ *
+ *  Note: The data is not copied. The buffer must remain unchanged until the
+ *  PostComplete callback reports the handle returned by this function.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  address     Address of the End Point.
+ *    @param  txData      Data to be transferred in a response message.
+ *    @param  txLength    Number of data bytes to transfer.
+ *
+ *    @return Handle of the message or PROTOCOL_MAIL_HANDLE_INVALID if the 
+ *            message could not be posted.
+ */
+unsigned char ProtocolPost(struct sProtocol *protocol,
+                           const unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                           const unsigned char *txData, 
+                           unsigned char txLength);
+#endif
+
+#if defined( PROTOCOL_USE_RX_POOL )
+/**
+ *  ProtocolReleaseBuffer - returns a loaned receive buffer to the protocol.
+ *
+ *  When the receive buffer pool is enabled, every payload passed to the 
+ *  TransferComplete callback is loaned to the application and may be used
+ *  after the callback returns (e.g. from the main loop). It MUST be returned
+ *  with this function once the application is done with it. The protocol keeps
+ *  receiving into the other buffers of the pool in the meantime.
+ *
+ *    @param  protocol    Protocol instance.
+ *    @param  payload     Payload location passed to TransferComplete.
+ *
+ *    @return Success of the operation.
+ */
+bool ProtocolReleaseBuffer(struct sProtocol *protocol,
+                           unsigned char *payload);
+#endif
+
 // -----------------------------------------------------------------------------
 // Protocol interrupt service routine operations
 
@@ -339,19 +842,53 @@ void ProtocolLoadDataResponse(unsigned char *txData,
  *  Note: It is assumed that this function is called inside an interrupt service
  *  routine where global interrupts are DISABLED. The protocol engine will 
  *  reenable global interrupts when it is ready to do so.
+ *
+ *  Note: If the GDO0 pins of several instances share an interrupt vector, call
+ *  this function for each of them with the same event.
  *  
- *    @param  event   
+ *    @param  protocol  Protocol instance.
+ *    @param  event     
  *
  *    @return 
  */
-unsigned char ProtocolEngine(volatile unsigned char event);
+unsigned char ProtocolEngine(struct sProtocol *protocol,
+                             volatile unsigned char event);
 
 /**
  *  ProtocolEngineTick - main operations system tick.
  *
  *  Note: The Physical Bridge requires a 16-bit hardware timer with at least a 
  *  1ms tick rate. The tick rate should be calculated as 1ms + crystal error %.
+ *
+ *  Note: The hardware timer is shared by every instance. Call this function 
+ *  for each instance on every tick.
+ *
+ *    @param  protocol  Protocol instance.
  */
-void ProtocolEngineTick(void);
+void ProtocolEngineTick(struct sProtocol *protocol);
+
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+// -----------------------------------------------------------------------------
+// Protocol deferred processing
+
+/**
+ *  ProtocolProcess - performs the protocol work recorded by ProtocolEngine and
+ *  ProtocolEngineTick.
+ *
+ *  In deferred processing mode, ProtocolEngine and ProtocolEngineTick only
+ *  record the event in a ring and return without re-enabling global 
+ *  interrupts; the interrupt service routine should then wake the main loop
+ *  (ProtocolEngine returns a non-zero value when an event was recorded). All
+ *  callbacks (e.g. TransferComplete) are invoked from this function.
+ *
+ *  Note: This function must be called from the main loop, never from an
+ *  interrupt service routine.
+ *
+ *    @param  protocol  Protocol instance.
+ *
+ *    @return Status message from the last callback (application use only).
+ */
+unsigned char ProtocolProcess(struct sProtocol *protocol);
+#endif
 
 #endif  /* API_H */
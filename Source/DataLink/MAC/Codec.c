@@ -0,0 +1,551 @@
+/**
+ *  ----------------------------------------------------------------------------
+ *  Copyright (c) 2012-13, Anaren Microwave, Inc.
+ *
+ *  For more information on licensing, please see Anaren Microwave, Inc's
+ *  end user software licensing agreement: EULA.txt.
+ *
+ *  ----------------------------------------------------------------------------
+ *
+ *  Codec.c - Data Link layer payload codecs.
+ *
+ *  @version    1.0.00
+ *  @date       16 Oct 2026
+ *  @author     BPB, air@anaren.com
+ *
+ *  For details on the interface, please see Codec.h.
+ *
+ *  assumptions
+ *  ===========
+ *  Same as Codec.h assumptions
+ *
+ *  file dependency
+ *  ===============
+ *  string.h : defines the function "memcpy" that is used for copying literal
+ *  runs
+ *  Codec.h : provides interface function prototypes and global definitions
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#include <string.h>   // memcpy
+#include "Codec.h"
+
+// -----------------------------------------------------------------------------
+/**
+ *  Defines, enumerations, and structure definitions
+ */
+
+/**
+ *  Static LZ dictionary (at most CODEC_LZ_MAX_OFFSET bytes are reachable). The
+ *  default suits binary readings; an application with text payloads defines
+ *  its own, e.g. the keys of its records:
+ *
+ *    #define PROTOCOL_CODEC_DICTIONARY { 't', 'e', 'm', 'p', '=', ... }
+ */
+#ifndef PROTOCOL_CODEC_DICTIONARY
+#if defined( TEST_CODEC )
+// Keys of the text records of the test stub
+#define PROTOCOL_CODEC_DICTIONARY { 't', '=', ',', 'h', '=', ',', 'p', '=', '1', '0' }
+#else
+#define PROTOCOL_CODEC_DICTIONARY { 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF }
+#endif
+#endif
+
+// Number of bytes coded as one delta word
+#define CODEC_DELTA_WORD_LENGTH 2
+
+// A delta word takes at most three varint bytes (7 bits each)
+#define CODEC_VARINT_BITS       7
+#define CODEC_VARINT_MORE       0x80u
+#define CODEC_VARINT_MAX_SHIFT  14
+
+// -----------------------------------------------------------------------------
+/**
+ *  Global data
+ */
+
+// LZ dictionary, placed ahead of every message
+static const unsigned char gCodecDictionary[] = PROTOCOL_CODEC_DICTIONARY;
+
+#define CODEC_DICTIONARY_LENGTH (sizeof(gCodecDictionary))
+
+// -----------------------------------------------------------------------------
+/**
+ *  Private interface
+ */
+
+/**
+ *  CodecDeltaWord - read a delta word. The last word of a message of odd
+ *  length is a single byte.
+ *
+ *    @param  data      Message.
+ *    @param  index     Position of the word.
+ *    @param  length    Number of message bytes.
+ *
+ *    @return Value of the word.
+ */
+unsigned int CodecDeltaWord(const unsigned char *data,
+                            unsigned char index,
+                            unsigned char length)
+{
+  unsigned int word = data[index];
+  
+  if ((index + 1) < length)
+  {
+    word |= (unsigned int)data[index + 1] << 8;
+  }
+  
+  return word;
+}
+
+/**
+ *  CodecLzWindow - read a byte of the LZ window: the dictionary followed by
+ *  the bytes of the message processed so far.
+ *
+ *    @param  data      Message.
+ *    @param  position  Position in the window.
+ *
+ *    @return Value of the byte.
+ */
+unsigned char CodecLzWindow(const unsigned char *data,
+                            unsigned int position)
+{
+  if (position < CODEC_DICTIONARY_LENGTH)
+  {
+    return gCodecDictionary[position];
+  }
+  
+  return data[position - CODEC_DICTIONARY_LENGTH];
+}
+
+/**
+ *  CodecLzLiterals - write a literal run.
+ *
+ *    @param  literal   First byte of the run.
+ *    @param  run       Number of bytes in the run (0 to CODEC_LZ_MAX_LITERAL).
+ *    @param  out       Encoded message.
+ *    @param  n         Number of bytes already encoded.
+ *    @param  size      Size of the encoded message buffer.
+ *
+ *    @return Number of bytes encoded with the run, or 0 if they do not fit in
+ *            the buffer.
+ */
+unsigned int CodecLzLiterals(const unsigned char *literal,
+                             unsigned char run,
+                             unsigned char *out,
+                             unsigned int n,
+                             unsigned char size)
+{
+  if (run == 0)
+  {
+    return n;
+  }
+  
+  if ((n + 1 + run) > size)
+  {
+    return 0;
+  }
+  
+  out[n++] = run - 1;
+  memcpy(&out[n], literal, run);
+  
+  return n + run;
+}
+
+// -----------------------------------------------------------------------------
+/**
+ *  Public interface
+ */
+
+unsigned char CodecDeltaEncode(const unsigned char *reference,
+                               const unsigned char *data,
+                               unsigned char length,
+                               unsigned char *out,
+                               unsigned char size)
+{
+  unsigned char n = 0;
+  unsigned char i;
+  
+  for (i = 0; i < length; i += CODEC_DELTA_WORD_LENGTH)
+  {
+    unsigned int delta = (CodecDeltaWord(data, i, length) - CodecDeltaWord(reference, i, length)) & 0xFFFFu;
+    
+    // Zig-zag: small differences of either sign become small numbers.
+    unsigned int zigzag = ((delta << 1) ^ ((delta & 0x8000u) ? 0xFFFFu : 0)) & 0xFFFFu;
+    
+    while (zigzag >= CODEC_VARINT_MORE)
+    {
+      if (n >= size)
+      {
+        return 0;
+      }
+      out[n++] = (unsigned char)(zigzag | CODEC_VARINT_MORE);
+      zigzag >>= CODEC_VARINT_BITS;
+    }
+    if (n >= size)
+    {
+      return 0;
+    }
+    out[n++] = (unsigned char)zigzag;
+  }
+  
+  return n;
+}
+
+unsigned char CodecDeltaDecode(const unsigned char *reference,
+                               unsigned char length,
+                               const unsigned char *in,
+                               unsigned char inLength,
+                               unsigned char *out)
+{
+  unsigned char n = 0;
+  unsigned char i;
+  
+  for (i = 0; i < length; i += CODEC_DELTA_WORD_LENGTH)
+  {
+    unsigned int zigzag = 0;
+    unsigned char shift = 0;
+    unsigned int word;
+    unsigned char byte;
+    
+    do
+    {
+      if ((n >= inLength) || (shift > CODEC_VARINT_MAX_SHIFT))
+      {
+        // Error: the encoded message is truncated or malformed.
+        return 0;
+      }
+      byte = in[n++];
+      zigzag |= (unsigned int)(byte & ~CODEC_VARINT_MORE) << shift;
+      shift += CODEC_VARINT_BITS;
+    } while (byte & CODEC_VARINT_MORE);
+    zigzag &= 0xFFFFu;
+    
+    word = CodecDeltaWord(reference, i, length) + ((zigzag >> 1) ^ ((zigzag & 0x0001u) ? 0xFFFFu : 0));
+    out[i] = (unsigned char)word;
+    if ((i + 1) < length)
+    {
+      out[i + 1] = (unsigned char)(word >> 8);
+    }
+  }
+  
+  // Every encoded byte must have been used.
+  return (n == inLength) ? length : 0;
+}
+
+unsigned char CodecLzEncode(const unsigned char *data,
+                            unsigned char length,
+                            unsigned char *out,
+                            unsigned char size)
+{
+  unsigned int n = 0;         // Number of encoded bytes
+  unsigned char run = 0;      // Number of literal bytes waiting to be written
+  unsigned int i = 0;
+  
+  while (i < length)
+  {
+    unsigned int position = CODEC_DICTIONARY_LENGTH + i;
+    unsigned char best = 0;
+    unsigned char bestOffset = 0;
+    unsigned int offset;
+    
+    // Find the longest match. It may run into the bytes it copies.
+    for (offset = 1; (offset <= CODEC_LZ_MAX_OFFSET) && (offset <= position); offset++)
+    {
+      unsigned char match = 0;
+      
+      while (((i + match) < length)
+             && (match < CODEC_LZ_MAX_MATCH)
+             && (CodecLzWindow(data, position + match - offset) == data[i + match]))
+      {
+        match++;
+      }
+      
+      if (match > best)
+      {
+        best = match;
+        bestOffset = (unsigned char)offset;
+      }
+    }
+    
+    if (best >= CODEC_LZ_MIN_MATCH)
+    {
+      n = CodecLzLiterals(&data[i - run], run, out, n, size);
+      if ((run > 0) && (n == 0))
+      {
+        return 0;
+      }
+      run = 0;
+      
+      if ((n + 2) > size)
+      {
+        return 0;
+      }
+      out[n++] = CODEC_LZ_MATCH | (best - CODEC_LZ_MIN_MATCH);
+      out[n++] = bestOffset;
+      i += best;
+    }
+    else
+    {
+      run++;
+      i++;
+      if (run == CODEC_LZ_MAX_LITERAL)
+      {
+        n = CodecLzLiterals(&data[i - run], run, out, n, size);
+        if (n == 0)
+        {
+          return 0;
+        }
+        run = 0;
+      }
+    }
+  }
+  
+  n = CodecLzLiterals(&data[i - run], run, out, n, size);
+  
+  return (unsigned char)n;
+}
+
+unsigned char CodecLzDecode(const unsigned char *in,
+                            unsigned char inLength,
+                            unsigned char *out,
+                            unsigned char size)
+{
+  unsigned int n = 0;
+  unsigned int i = 0;
+  
+  while (i < inLength)
+  {
+    unsigned char token = in[i++];
+    unsigned int count = (token & CODEC_LZ_LENGTH);
+    
+    if (token & CODEC_LZ_MATCH)
+    {
+      unsigned int offset;
+      
+      count += CODEC_LZ_MIN_MATCH;
+      if (i >= inLength)
+      {
+        // Error: the offset is missing.
+        return 0;
+      }
+      offset = in[i++];
+      if ((offset == 0)
+          || (offset > (CODEC_DICTIONARY_LENGTH + n))
+          || ((n + count) > size))
+      {
+        // Error: the match is outside of the window or the buffer.
+        return 0;
+      }
+      
+      // Copy byte by byte; the match may run into the bytes it copies.
+      while (count-- > 0)
+      {
+        out[n] = CodecLzWindow(out, CODEC_DICTIONARY_LENGTH + n - offset);
+        n++;
+      }
+    }
+    else
+    {
+      count += 1;
+      if (((i + count) > inLength) || ((n + count) > size))
+      {
+        // Error: the run is truncated or does not fit in the buffer.
+        return 0;
+      }
+      memcpy(&out[n], &in[i], count);
+      i += count;
+      n += count;
+    }
+  }
+  
+  return (unsigned char)n;
+}
+
+// -----------------------------------------------------------------------------
+/**
+ *  Test stub - benchmark of the codecs.
+ */
+
+/**
+ *  To test this module, define the following in your compiler preprocessor
+ *  definitions: "TEST_CODEC".
+ *
+ *  It is strongly suggested that you leave the test stub in this source file.
+ *  This stub will allow you to easily test your implementation using unit tests
+ *  defined and by adding more to suit your application needs.
+ */
+#ifdef TEST_CODEC
+
+/**
+ *  Test Example - round trip, compression ratio and cost of each codec on
+ *  synthetic sensor telemetry: slowly varying 16-bit readings and text 
+ *  records ("t=21,h=55,p=1013").
+ *
+ *  @version    1.0.00
+ *  @date       16 Oct 2026
+ *  @author     BPB, air@anaren.com
+ *  @platform   Host (any hosted C compiler); the source builds unchanged for
+ *              the MSP430 if CODEC_TEST_CYCLES reads a timer clocked by MCLK
+ *
+ *  assumptions
+ *  ===========
+ *  - CODEC_TEST_CYCLES() returns a free-running cycle count. The default
+ *  reads the time stamp counter on x86 and clock() elsewhere (in which case
+ *  the cost is reported in clock ticks rather than cycles).
+ *
+ *  file dependency
+ *  ===============
+ *  stdio.h : defines the function "printf" used to report the results
+ *  time.h : defines the function "clock" (default cycle count)
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#include <stdio.h>
+#include <time.h>
+
+#ifndef CODEC_TEST_CYCLES
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#include <x86intrin.h>
+#define CODEC_TEST_CYCLES()     ((unsigned long long)__rdtsc())
+#else
+#define CODEC_TEST_CYCLES()     ((unsigned long long)clock())
+#endif
+#endif
+
+#define CODEC_TEST_MESSAGES     1000    // Messages per case
+#define CODEC_TEST_LENGTH       16      // Bytes per message (8 readings)
+
+/**
+ *  sCodecTestCase - codec and telemetry benchmarked together.
+ */
+struct sCodecTestCase
+{
+  const char *name;
+  unsigned char id;
+  void(*Sample)(unsigned char *message, unsigned int step);
+};
+
+// -----------------------------------------------------------------------------
+
+/**
+ *  CodecTestSample - fill a message with the next readings: eight channels
+ *  drifting by a few counts per message around different levels.
+ */
+void CodecTestSample(unsigned char *message,
+                     unsigned int step)
+{
+  static unsigned int seed = 1;
+  unsigned char i;
+  
+  for (i = 0; i < CODEC_TEST_LENGTH; i += 2)
+  {
+    unsigned int value;
+    
+    seed = (seed * 25173u) + 13849u;
+    value = (unsigned int)(i * 300u) + ((step * (i + 1)) & 0x3Fu) + ((seed >> 8) & 0x07u);
+    message[i] = (unsigned char)value;
+    message[i + 1] = (unsigned char)(value >> 8);
+  }
+}
+
+/**
+ *  CodecTestRecord - fill a message with the next text record, padded with 
+ *  spaces.
+ */
+void CodecTestRecord(unsigned char *message,
+                     unsigned int step)
+{
+  char record[CODEC_TEST_LENGTH + 1];
+  
+  memset(record, ' ', sizeof(record));
+  snprintf(record, sizeof(record), "t=%u,h=%u,p=10%02u", 
+           20u + ((step / 50u) % 5u), 40u + ((step / 20u) % 30u), step % 30u);
+  record[strlen(record)] = ' ';
+  memcpy(message, record, CODEC_TEST_LENGTH);
+}
+
+static const struct sCodecTestCase gCodecTestCase[] = {
+  { "delta/readings", CODEC_ID_DELTA, CodecTestSample },
+  { "lz/readings",    CODEC_ID_LZ,    CodecTestSample },
+  { "delta/records",  CODEC_ID_DELTA, CodecTestRecord },
+  { "lz/records",     CODEC_ID_LZ,    CodecTestRecord }
+};
+
+int main(void)
+{
+  unsigned char reference[CODEC_TEST_LENGTH];
+  unsigned char message[CODEC_TEST_LENGTH];
+  unsigned char encoded[CODEC_TEST_LENGTH];
+  unsigned char decoded[CODEC_TEST_LENGTH];
+  unsigned char c;
+  int failures = 0;
+  
+  for (c = 0; c < (sizeof(gCodecTestCase) / sizeof(gCodecTestCase[0])); c++)
+  {
+    unsigned char id = gCodecTestCase[c].id;
+    unsigned long raw = 0;
+    unsigned long sent = 0;
+    unsigned long long encodeCycles = 0;
+    unsigned long long decodeCycles = 0;
+    unsigned int step;
+    
+    gCodecTestCase[c].Sample(reference, 0);
+    for (step = 1; step <= CODEC_TEST_MESSAGES; step++)
+    {
+      unsigned long long start;
+      unsigned char length;
+      
+      gCodecTestCase[c].Sample(message, step);
+      
+      // The message is sent as is if the codec does not shorten it.
+      start = CODEC_TEST_CYCLES();
+      length = (id == CODEC_ID_DELTA)
+               ? CodecDeltaEncode(reference, message, CODEC_TEST_LENGTH, encoded, CODEC_TEST_LENGTH - 1)
+               : CodecLzEncode(message, CODEC_TEST_LENGTH, encoded, CODEC_TEST_LENGTH - 1);
+      encodeCycles += CODEC_TEST_CYCLES() - start;
+      
+      raw += CODEC_TEST_LENGTH;
+      if (length == 0)
+      {
+        sent += CODEC_TEST_LENGTH;
+      }
+      else
+      {
+        unsigned char n;
+        
+        sent += length;
+        start = CODEC_TEST_CYCLES();
+        n = (id == CODEC_ID_DELTA)
+            ? CodecDeltaDecode(reference, CODEC_TEST_LENGTH, encoded, length, decoded)
+            : CodecLzDecode(encoded, length, decoded, CODEC_TEST_LENGTH);
+        decodeCycles += CODEC_TEST_CYCLES() - start;
+        
+        if ((n != CODEC_TEST_LENGTH) || (memcmp(decoded, message, CODEC_TEST_LENGTH) != 0))
+        {
+          failures++;
+        }
+      }
+      
+      memcpy(reference, message, CODEC_TEST_LENGTH);
+    }
+    
+    printf("%-14s ratio %.3f (%lu of %lu bytes), encode %.1f, decode %.1f cycles/byte\n",
+           gCodecTestCase[c].name,
+           (double)sent / raw, sent, raw,
+           (double)encodeCycles / raw,
+           (double)decodeCycles / raw);
+  }
+  
+  printf("%s (%d round trip failures)\n", (failures == 0) ? "PASS" : "FAIL", failures);
+  
+  return (failures == 0) ? 0 : 1;
+}
+
+#endif  /* TEST_CODEC */
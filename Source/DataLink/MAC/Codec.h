@@ -0,0 +1,167 @@
+#ifndef CODEC_H
+#define CODEC_H
+/**
+ *  ----------------------------------------------------------------------------
+ *  Copyright (c) 2012-13, Anaren Microwave, Inc.
+ *
+ *  For more information on licensing, please see Anaren Microwave, Inc's
+ *  end user software licensing agreement: EULA.txt.
+ *
+ *  ----------------------------------------------------------------------------
+ *
+ *  Codec.h - Data Link layer payload codecs.
+ *
+ *  @version  1.0.00
+ *  @date     16 Oct 2026
+ *  @author   BPB, air@anaren.com
+ *
+ *  A codec shortens a message before it is sent. Two codecs are provided:
+ *
+ *  - Delta: the message is coded against a reference message of the same
+ *  length (usually the previous one). Each 16-bit word (least significant
+ *  byte first) is sent as the zig-zag varint of its difference to the
+ *  reference; slowly varying readings take one byte per word.
+ *  - LZ: repeated strings are replaced by a reference to an earlier copy in
+ *  the message or in a static dictionary (PROTOCOL_CODEC_DICTIONARY).
+ *
+ *  The codecs use no memory besides the caller's buffers and the constant
+ *  dictionary. An encoder fails rather than produce a message longer than the
+ *  output buffer; the message is then sent as is.
+ *
+ *  assumptions
+ *  ===========
+ *  - "NULL" is not a valid argument for pointer parameters unless the function
+ *  definition explicitly states that it is.
+ *  - Both ends of a link use the same dictionary.
+ *
+ *  file dependency
+ *  ===============
+ *  none
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#define CODEC_INFO "CODEC 1.0.00"
+
+#ifndef bool
+#define bool unsigned char
+#endif
+
+#ifndef true
+#define true 1
+#endif
+
+#ifndef false
+#define false 0
+#endif
+
+// -----------------------------------------------------------------------------
+/**
+ *  Defines, enumerations, and structure definitions
+ */
+
+#ifndef NULL
+#define NULL  (void*)0
+#endif
+
+// Codec identifiers
+#define CODEC_ID_NONE           0x00u   // Message sent as is
+#define CODEC_ID_DELTA          0x01u   // Zig-zag varint differences to a reference
+#define CODEC_ID_LZ             0x02u   // LZ with a static dictionary
+
+// Codec sets (one bit per codec identifier)
+#define CODEC_SET(id)           (1u << (id))
+#define CODEC_SET_DELTA         CODEC_SET(CODEC_ID_DELTA)
+#define CODEC_SET_LZ            CODEC_SET(CODEC_ID_LZ)
+
+/**
+ *  LZ tokens. A literal run is followed by its bytes; a match copies bytes
+ *  from an earlier position of the dictionary followed by the message (offset
+ *  1 is the byte just decoded).
+ *
+ *    literal run:  | 0 | length - 1 (7) | bytes... |
+ *    match:        | 1 | length - CODEC_LZ_MIN_MATCH (7) | offset (8) |
+ */
+#define CODEC_LZ_MATCH          0x80u
+#define CODEC_LZ_LENGTH         0x7Fu
+#define CODEC_LZ_MIN_MATCH      3
+#define CODEC_LZ_MAX_MATCH      (CODEC_LZ_LENGTH + CODEC_LZ_MIN_MATCH)
+#define CODEC_LZ_MAX_LITERAL    (CODEC_LZ_LENGTH + 1)
+#define CODEC_LZ_MAX_OFFSET     0xFFu
+
+// -----------------------------------------------------------------------------
+/**
+ *  Public interface
+ */
+
+/**
+ *  CodecDeltaEncode - encode a message as the differences to a reference
+ *  message of the same length.
+ *
+ *    @param  reference Reference message.
+ *    @param  data      Message to encode.
+ *    @param  length    Number of message bytes.
+ *    @param  out       Encoded message.
+ *    @param  size      Size of the encoded message buffer.
+ *
+ *    @return Number of encoded bytes, or 0 if they do not fit in the buffer.
+ */
+unsigned char CodecDeltaEncode(const unsigned char *reference,
+                               const unsigned char *data,
+                               unsigned char length,
+                               unsigned char *out,
+                               unsigned char size);
+
+/**
+ *  CodecDeltaDecode - decode a message encoded by CodecDeltaEncode.
+ *
+ *    @param  reference Reference message the message was encoded against.
+ *    @param  length    Number of reference message bytes.
+ *    @param  in        Encoded message.
+ *    @param  inLength  Number of encoded bytes.
+ *    @param  out       Decoded message (length bytes).
+ *
+ *    @return Number of decoded bytes (length), or 0 if the encoded message is
+ *            malformed.
+ */
+unsigned char CodecDeltaDecode(const unsigned char *reference,
+                               unsigned char length,
+                               const unsigned char *in,
+                               unsigned char inLength,
+                               unsigned char *out);
+
+/**
+ *  CodecLzEncode - encode a message with LZ and the static dictionary.
+ *  Matches are searched greedily over the whole window.
+ *
+ *    @param  data      Message to encode.
+ *    @param  length    Number of message bytes.
+ *    @param  out       Encoded message.
+ *    @param  size      Size of the encoded message buffer.
+ *
+ *    @return Number of encoded bytes, or 0 if they do not fit in the buffer.
+ */
+unsigned char CodecLzEncode(const unsigned char *data,
+                            unsigned char length,
+                            unsigned char *out,
+                            unsigned char size);
+
+/**
+ *  CodecLzDecode - decode a message encoded by CodecLzEncode.
+ *
+ *    @param  in        Encoded message.
+ *    @param  inLength  Number of encoded bytes.
+ *    @param  out       Decoded message.
+ *    @param  size      Size of the decoded message buffer.
+ *
+ *    @return Number of decoded bytes, or 0 if the encoded message is
+ *            malformed or does not fit in the buffer.
+ */
+unsigned char CodecLzDecode(const unsigned char *in,
+                            unsigned char inLength,
+                            unsigned char *out,
+                            unsigned char size);
+
+#endif  /* CODEC_H */
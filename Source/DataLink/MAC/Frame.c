@@ -10,8 +10,8 @@
  *  Frame.c - Data Link layer Media Access Control (MAC) framing and scheduling 
  *  sub layer.
  *
- *  @version    1.0.01
- *  @date       17 Sep 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  For details on the interface, please see Frame.h.
@@ -24,29 +24,143 @@
  *  ===============
  *  string.h : defines the functions "memcpy" that is used for copying addresses
  *  Frame.h : provides interface function prototypes and global definitions
+ *  Codec.h : payload codecs (PROTOCOL_USE_CODEC)
+ *  Security.h : AES-128 and CCM* (PROTOCOL_USE_SECURITY, through Frame.h)
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - the scheduler is supplied by the caller (one per protocol instance) 
+ *  instead of being a file-scope singleton
+ *  - added an optional transmit queue serviced back-to-back by the scheduler
+ *  - added FrameSendv; the payload is streamed to the Physical layer in place
+ *  - added an optional pool of receive buffers loaned to the application
+ *  - End Point and Gateway behaviours are both built in and selected at run 
+ *  time by the scheduler's mode
+ *  - added scheduler counters and optional receive latency statistics
+ *  - added FrameSendMessage; optional segmentation of large messages into 
+ *  fragments and per-source reassembly aged by FrameTick
+ *  - added optional link-layer acknowledgements; unacknowledged frames are sent
+ *  again after a randomized exponential backoff
+ *  - added optional CSMA-CA; a frame refused on a busy channel is sent again 
+ *  after a random backoff timed by FrameTick
+ *  - a Gateway drops frames it has already received from the same source 
+ *  (PROTOCOL_USE_DUPLICATE_FILTER); a data request sent again is answered 
+ *  with a copy of the last data response
+ *  - a Gateway records every End Point it hears in the endpoint table and 
+ *  numbers the frames of each link separately (PROTOCOL_USE_ENDPOINT_TABLE); 
+ *  a new End Point is dropped while the table holds only established links
+ *  - a Gateway answers data requests with the messages posted for the 
+ *  requesting End Point (PROTOCOL_USE_MAILBOX)
+ *  - an End Point stays awake and requests data while its Gateway signals 
+ *  pending messages (FRAME_CONTROL_PENDING)
+ *  - added aggregation of small records into one Aggregate frame 
+ *  (PROTOCOL_USE_AGGREGATION, FrameAggregate)
+ *  - added compressed headers on established links; the receiver restores 
+ *  the full header before filtering (PROTOCOL_USE_COMPRESSED_HEADER)
+ *  - added the TDMA superframe; a Gateway beacons and assigns slots, an End 
+ *  Point holds its frames for its slot and wakes only for the beacon 
+ *  (PROTOCOL_USE_TDMA)
+ *  - added FrameConnect; link requests back off and a Gateway defers those 
+ *  beyond its admission rate (PROTOCOL_USE_JOIN_CONTROL)
+ *  - added Gateway broadcast and group downlink; with TDMA the message rides 
+ *  the beacon (PROTOCOL_USE_MULTICAST)
+ *  - the scheduler tracks whether the receiver is waiting for a frame 
+ *  (listening) in every configuration
+ *  - added payload codecs; an End Point encodes its messages against the 
+ *  last one or a dictionary and a Gateway decodes them (PROTOCOL_USE_CODEC)
+ *  - added AES-128 CCM* link security with replay protection 
+ *  (PROTOCOL_USE_SECURITY)
+ *  - an End Point sending a data request keeps its receiver on from the end 
+ *  of the transmission (PROTOCOL_USE_TURNAROUND)
+ *  - a Gateway draws its first key seed from the receiver noise and never 
+ *  issues a seed twice; seeds no longer share the Gateway's frame counter
+ *  - an End Point only accepts a link request response that answers its 
+ *  pending link request (challenge) and is authenticated under the network 
+ *  key, and refuses the key seed of the link it last had
  *  ver 1.0.01 : 16 Oct 2012
  *  - updated internal documentation; comments revised
  *  - added a test example (stub) to perform various frame operations
  *  ver 1.0.00 : 17 Sep 2012
  *  - initial release
  */
-#include <string.h>   // memcpy
+#include <string.h>   // memcpy, memmove, memset
 #include "Frame.h"
+#if defined( PROTOCOL_USE_CODEC )
+#include "Codec.h"
+#endif
 
 // -----------------------------------------------------------------------------
 /**
  *  Defines, enumerations, and structure definitions
  */
 
+// Role of the local node
+#define FrameIsGateway(scheduler)   ((scheduler)->mode == FRAME_CONTROL_MODE_GATEWAY)
+
+// An acknowledgement is owed to the sender of the last received frame
+#if defined( PROTOCOL_USE_ACK )
+#define FrameAckOwed(scheduler)     ((scheduler)->ack.owed)
+#else
+#define FrameAckOwed(scheduler)     false
+#endif
+
+// The last received frame has already been received
+#if !defined( PROTOCOL_USE_DUPLICATE_FILTER )
+#define FrameDuplicate(scheduler)   false
+#endif
+
+// Header and footer bytes of the last received frame; restoring its full header
+#if !defined( PROTOCOL_USE_COMPRESSED_HEADER )
+#define FrameOverheadLength(scheduler, length)  FRAME_OVERHEAD_LENGTH
+#define FrameExpand(scheduler, length)          true
+#endif
+
+// The last received frame is a beacon; the frame being sent waits for its slot
+#if !defined( PROTOCOL_USE_TDMA )
+#define FrameIsBeacon(scheduler)    false
+#define FrameTdmaHold(scheduler)    false
+#endif
+
+// The last received frame was sent to every End Point or to a group
+#if !defined( PROTOCOL_USE_MULTICAST )
+#define FrameIsMulticast(scheduler) false
+#endif
+
+// Codec header bytes of the data frames sent by the local node; sending a 
+// message through the codecs
+#if defined( PROTOCOL_USE_CODEC )
+#define FrameCodecLength(scheduler) (FrameIsGateway(scheduler) ? 0 : FRAME_CODEC_HEADER_LENGTH)
+#else
+#define FrameCodecLength(scheduler) 0
+#define FrameCodecSend(scheduler, dataRequest, payload, length) \
+  FrameSend(scheduler, eFrameTypeData, dataRequest, payload, length)
+#endif
+
+// Bytes added to the payload of the frames sent by the local node; the last 
+// received frame repeats the last one accepted from its link
+#if defined( PROTOCOL_USE_SECURITY )
+#define FrameSecurityLength(scheduler)  (((scheduler)->security.key != NULL) ? FRAME_SECURITY_LENGTH : 0)
+#define FrameReplayed(scheduler)        ((scheduler)->security.replayed)
+#else
+#define FrameSecurityLength(scheduler)  0
+#define FrameReplayed(scheduler)        false
+#endif
+
+// Keeping the data response sent; answering a data request sent again
+#if !defined( PROTOCOL_USE_DUPLICATE_FILTER ) && !defined( PROTOCOL_USE_SECURITY )
+#define FrameResponseKeep(scheduler, payload, length)
+#define FrameResponseResend(scheduler)
+#endif
+
+// First data stream segment of the payload (see FrameSendv)
+#define FRAME_PAYLOAD_SEGMENT       (1 + FRAME_LINK_SEGMENTS)
+
 // -----------------------------------------------------------------------------
 /**
  *  Global data
  */
 
-static struct sFrameScheduler gFrameScheduler;  // MAC scheduler information
 
 // -----------------------------------------------------------------------------
 /**
@@ -56,87 +170,260 @@ static struct sFrameScheduler gFrameScheduler;  // MAC scheduler information
 // -----------------------------------------------------------------------------
 // Frame operations
 
-void FrameBuild(enum eFrameType type,
+/**
+ *  FrameBuild - build the frame header. The payload is not copied; it is sent
+ *  directly from the caller's buffers.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  type        Type of frame being constructed.
+ *    @param  dataRequest Data request (0:simplex, 1:half duplex).
+ *    @param  length      Number of payload bytes.
+ */
+void FrameBuild(struct sFrameScheduler *scheduler,
+                enum eFrameType type,
                 bool dataRequest,
-                unsigned char *payload,
                 unsigned char length)
 {
-  static unsigned char seqNumber = 0;
-
+  unsigned char *seqNumber = &scheduler->seqNumber;
+  
   // Update frame destination and source.
-  PhyAddressCopy(gFrameScheduler.frame.header.panId,
-                 PhyAddressGetLocalInfo()->panId,
+  PhyAddressCopy(scheduler->frame.header.panId,
+                 PhyAddressGetLocalInfo(scheduler->phyAddress)->panId,
                  PROTOCOL_PHYADDRESS_PANID_SIZE);
-  #if defined( PROTOCOL_ENDPOINT )
-  // End Point can only transmit to its remote address (Gateway node).
-  PhyAddressCopy(gFrameScheduler.frame.header.destAddr, 
-                 PhyAddressGetLocalInfo()->remote, 
-                 PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
-  #elif defined( PROTOCOL_GATEWAY )
-  // Gateway can respond to nodes that contacted it (simply swap the destination
-  // and source addresses).
-  PhyAddressCopy(gFrameScheduler.frame.header.destAddr,
-                 gFrameScheduler.frame.header.srcAddr,
-                 PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
-  #endif
-  PhyAddressCopy(gFrameScheduler.frame.header.srcAddr,
-                 PhyAddressGetLocalInfo()->address,
+  if (FrameIsGateway(scheduler))
+  {
+    // Gateway can respond to nodes that contacted it (simply swap the 
+    // destination and source addresses).
+    PhyAddressCopy(scheduler->frame.header.destAddr,
+                   scheduler->rx->header.srcAddr,
+                   PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+    #if defined( PROTOCOL_USE_TDMA )
+    // A beacon is sent to every node.
+    if (scheduler->tdma.beacon)
+    {
+      memset(scheduler->frame.header.destAddr, 
+             PHY_ADDRESS_BROADCAST, 
+             PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+    }
+    #endif
+    #if defined( PROTOCOL_USE_MULTICAST )
+    // A group message is sent to the group address.
+    if (scheduler->multicast.sending)
+    {
+      PhyAddressCopy(scheduler->frame.header.destAddr,
+                     scheduler->multicast.dest,
+                     PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+    }
+    #endif
+  }
+  else
+  {
+    // End Point can only transmit to its remote address (Gateway node).
+    PhyAddressCopy(scheduler->frame.header.destAddr, 
+                   PhyAddressGetLocalInfo(scheduler->phyAddress)->remote, 
+                   PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  }
+  PhyAddressCopy(scheduler->frame.header.srcAddr,
+                 PhyAddressGetLocalInfo(scheduler->phyAddress)->address,
                  PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
   
-  gFrameScheduler.frame.header.control &= ~FRAME_CONTROL_TYPE;
-  gFrameScheduler.frame.header.control |= type;
-  gFrameScheduler.frame.header.control &= ~FRAME_CONTROL_DATA_REQ;
+  scheduler->frame.header.control &= ~FRAME_CONTROL_TYPE;
+  scheduler->frame.header.control |= type;
+  scheduler->frame.header.control &= ~FRAME_CONTROL_DATA_REQ;
   if (dataRequest)
   {
-    gFrameScheduler.frame.header.control |= FRAME_CONTROL_DATA_REQ;
+    scheduler->frame.header.control |= FRAME_CONTROL_DATA_REQ;
+  }
+  scheduler->frame.header.control &= ~FRAME_CONTROL_MODE;
+  scheduler->frame.header.control |= scheduler->mode;
+  scheduler->frame.header.control &= ~(FRAME_CONTROL_ACK_REQ | FRAME_CONTROL_ACK | FRAME_CONTROL_PENDING);
+  #if defined( PROTOCOL_USE_ACK )
+  // The acknowledgement owed to the last sender is carried by this frame.
+  if (scheduler->ack.owed)
+  {
+    scheduler->ack.owed = false;
+    scheduler->counters.txAcks++;
+    scheduler->frame.header.control |= FRAME_CONTROL_ACK;
+  }
+  // Only an End Point requests acknowledgements, and never for link requests.
+  if (scheduler->ack.enable 
+      && !FrameIsGateway(scheduler) 
+      && (type != eFrameTypeLinkRequest))
+  {
+    scheduler->frame.header.control |= FRAME_CONTROL_ACK_REQ;
+  }
+  #endif
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  // A Gateway takes the link identifier from the endpoint table (below).
+  scheduler->txLink = PHY_ADDRESS_LINK_NONE;
+  if (!FrameIsGateway(scheduler) && PhyAddressLinkExists(scheduler->phyAddress))
+  {
+    scheduler->txLink = scheduler->link;
   }
-  #if defined( PROTOCOL_ENDPOINT )
-  gFrameScheduler.frame.header.control &= ~FRAME_CONTROL_MODE;
-  #elif defined( PROTOCOL_GATEWAY )
-  gFrameScheduler.frame.header.control |= FRAME_CONTROL_MODE;
   #endif
-  gFrameScheduler.frame.header.seqNumber = seqNumber++;
+  #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+  // A Gateway numbers the frames of each link separately.
+  if (FrameIsGateway(scheduler))
+  {
+    struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(scheduler->phyAddress, 
+                                                                  scheduler->frame.header.destAddr);
     
-  // Copy the payload into the internal frame buffer.
-  gFrameScheduler.length = length;
-  memcpy(&gFrameScheduler.frame.payload, payload, length);
+    if (endPoint != NULL)
+    {
+      seqNumber = &endPoint->txSeqNumber;
+      #if defined( PROTOCOL_USE_MAILBOX )
+      // More messages are waiting for the End Point.
+      if (endPoint->mailbox != PHY_ADDRESS_ENDPOINT_NONE)
+      {
+        scheduler->frame.header.control |= FRAME_CONTROL_PENDING;
+      }
+      #endif
+      #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+      // Only an End Point that compresses its own headers is known to hold 
+      // its link identifier.
+      if (endPoint->flags & PHY_ADDRESS_ENDPOINT_FLAG_COMPRESSED)
+      {
+        scheduler->txLink = endPoint->link;
+      }
+      #endif
+    }
+  }
+  #endif
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  // The addresses of an established link are replaced by its link identifier;
+  // link requests always carry them.
+  scheduler->frame.header.control &= ~FRAME_CONTROL_COMPRESSED;
+  if ((type != eFrameTypeLinkRequest) && (scheduler->txLink != PHY_ADDRESS_LINK_NONE))
+  {
+    scheduler->frame.header.control |= FRAME_CONTROL_COMPRESSED;
+  }
+  #endif
+  scheduler->frame.header.seqNumber = (*seqNumber)++;
+  
+  scheduler->length = length;
+}
+
+#if defined( PROTOCOL_USE_MULTICAST )
+/**
+ *  FrameGroupFind - find a group the local node belongs to.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *    @param  group      Group address.
+ *
+ *    @return Index of the group, or FRAME_MULTICAST_GROUP_NONE if the local 
+ *            node does not belong to it.
+ */
+unsigned char FrameGroupFind(struct sFrameScheduler *scheduler,
+                             const unsigned char group[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  unsigned char i;
+  
+  for (i = 0; i < scheduler->multicast.groups; i++)
+  {
+    if (PhyAddressCompare(scheduler->multicast.group[i], group, PHY_ADDRESS_ADDRESS_SIZE) == 0)
+    {
+      return i;
+    }
+  }
+  
+  return FRAME_MULTICAST_GROUP_NONE;
+}
+
+/**
+ *  FrameGroupMember - check if the local node accepts the frames sent to an 
+ *  address other than its own.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *    @param  group      Broadcast or group address.
+ *
+ *    @return Whether the frames are accepted (true) or not (false).
+ */
+bool FrameGroupMember(struct sFrameScheduler *scheduler,
+                      const unsigned char group[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  return PhyAddressIsBroadcast(group, PHY_ADDRESS_ADDRESS_SIZE)
+         || (FrameGroupFind(scheduler, group) != FRAME_MULTICAST_GROUP_NONE);
+}
+
+/**
+ *  FrameIsMulticast - check if the last received frame was sent to every End
+ *  Point or to a group of the local node. Link requests are only accepted 
+ *  from the Gateway when addressed to the local node (or as beacons).
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Whether the frame is a group message (true) or not (false).
+ */
+bool FrameIsMulticast(struct sFrameScheduler *scheduler)
+{
+  return !FrameIsGateway(scheduler)
+         && ((scheduler->rx->header.control & FRAME_CONTROL_TYPE) != eFrameTypeLinkRequest)
+         && FrameGroupMember(scheduler, scheduler->rx->header.destAddr);
+}
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+/**
+ *  FrameIsBeacon - check if the last received frame is a beacon of the 
+ *  Gateway the local node is linked to.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Whether the frame is a beacon (true) or not (false).
+ */
+bool FrameIsBeacon(struct sFrameScheduler *scheduler)
+{
+  return ((scheduler->rx->header.control & FRAME_CONTROL_TYPE) == eFrameTypeLinkRequest)
+         && PhyAddressIsBroadcast(scheduler->rx->header.destAddr, PHY_ADDRESS_ADDRESS_SIZE)
+         && PhyAddressLinkExists(scheduler->phyAddress)
+         && (PhyAddressCompare(PhyAddressGetLocalInfo(scheduler->phyAddress)->remote,
+                               scheduler->rx->header.srcAddr,
+                               PHY_ADDRESS_ADDRESS_SIZE) == 0);
 }
+#endif
 
 /**
  *  FrameEndPointValidate - validate the incoming frame. Check if the frame was
  *  destined for the local node and that it meets all the addressing 
  *  requirements to be considered a valid frame.
  *
+ *    @param  scheduler Frame scheduler.
  *    @param  destPan   Incoming frame destination PAN identifer.
  *    @param  destAddr  Incoming frame destination address.
  *
  *    @return Success of validating the incoming frame. If the frame is valid,
               return true. Otherwise return false.
  */
-#if defined( PROTOCOL_ENDPOINT )
-bool FrameEndPointValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
+bool FrameEndPointValidate(struct sFrameScheduler *scheduler,
+                           unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
                            unsigned char destAddr[PHY_ADDRESS_ADDRESS_SIZE])
 {
-  const struct sPhyAddressLocal* local = PhyAddressGetLocalInfo();
+  const struct sPhyAddressLocal* local = PhyAddressGetLocalInfo(scheduler->phyAddress);
   
   // Verify that the received frame was intended for the local node.
   // Was the received link request from a Gateway node?
-  if ((gFrameScheduler.frame.header.control & FRAME_CONTROL_MODE) != FRAME_CONTROL_MODE_GATEWAY)
+  if ((scheduler->rx->header.control & FRAME_CONTROL_MODE) != FRAME_CONTROL_MODE_GATEWAY)
   {
+    scheduler->counters.rxDropMode++;
     return false;
   }
   
-  // Verify destination address.
-  if (PhyAddressCompare(local->address, destAddr, PHY_ADDRESS_ADDRESS_SIZE) != 0)
+  // Verify destination address. The beacons of the Gateway are sent to every
+  // node, its group messages to every node or to a group.
+  if ((PhyAddressCompare(local->address, destAddr, PHY_ADDRESS_ADDRESS_SIZE) != 0)
+      && !FrameIsBeacon(scheduler)
+      && !FrameIsMulticast(scheduler))
   {
+    scheduler->counters.rxDropAddress++;
     return false;
   }
   
   // Verify PAN identifier.
   if (PhyAddressCompare(local->panId, destPan, PHY_ADDRESS_PANID_SIZE) != 0)
   {
-    if ((gFrameScheduler.frame.header.control & FRAME_CONTROL_TYPE) != eFrameTypeLinkRequest)
+    if ((scheduler->rx->header.control & FRAME_CONTROL_TYPE) != eFrameTypeLinkRequest)
     {
+      scheduler->counters.rxDropPanId++;
       return false;
     }
     else
@@ -148,8 +435,9 @@ bool FrameEndPointValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
        *  is fixed, disallow any PAN identifier except ones that are in the 
        *  local node's PAN.
        */
-      if (PhyAddressLinkExists() || local->fixed)
+      if (PhyAddressLinkExists(scheduler->phyAddress) || local->fixed)
       {
+        scheduler->counters.rxDropPanId++;
         return false;
       }
     }
@@ -157,26 +445,27 @@ bool FrameEndPointValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
 
   return true;
 }
-#endif
 
 /**
  *  FrameGatewayValidate - 
  *
+ *    @param  scheduler  Frame scheduler.
  *    @param  destPan
  *    @param  destAddr
  *
  *    @return 
  */
-#if defined( PROTOCOL_GATEWAY )
-bool FrameGatewayValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
+bool FrameGatewayValidate(struct sFrameScheduler *scheduler,
+                          unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
                           unsigned char destAddr[PHY_ADDRESS_ADDRESS_SIZE])
 {
-  const struct sPhyAddressLocal* local = PhyAddressGetLocalInfo();
+  const struct sPhyAddressLocal* local = PhyAddressGetLocalInfo(scheduler->phyAddress);
   
   // Verify that the received frame was intended for the local node.
   // Was the received link request from a Gateway node?
-  if ((gFrameScheduler.frame.header.control & FRAME_CONTROL_MODE) != FRAME_CONTROL_MODE_ENDPOINT)
+  if ((scheduler->rx->header.control & FRAME_CONTROL_MODE) != FRAME_CONTROL_MODE_ENDPOINT)
   {
+    scheduler->counters.rxDropMode++;
     return false;
   }
   
@@ -186,6 +475,7 @@ bool FrameGatewayValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
     // A Gateway may accept a message to the broadcast address.
     if (!PhyAddressIsBroadcast(destAddr, PHY_ADDRESS_ADDRESS_SIZE))
     {
+      scheduler->counters.rxDropAddress++;
       return false;
     }
   }
@@ -193,10 +483,11 @@ bool FrameGatewayValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
   // Verify PAN identifier.
   if (PhyAddressCompare(local->panId, destPan, PHY_ADDRESS_PANID_SIZE) != 0)
   {
-    if (gFrameScheduler.frame.header.control != eFrameTypeLinkRequest)
+    if (scheduler->rx->header.control != eFrameTypeLinkRequest)
     {
       if (!PhyAddressIsBroadcast(destPan, PHY_ADDRESS_PANID_SIZE))
       {
+        scheduler->counters.rxDropPanId++;
         return false;
       }
     }
@@ -205,6 +496,7 @@ bool FrameGatewayValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
       // Check if the address is to the broadcast PAN identifier.
       if (!PhyAddressIsBroadcast(destPan, PHY_ADDRESS_PANID_SIZE))
       {
+        scheduler->counters.rxDropPanId++;
         return false;
       }
     }
@@ -212,255 +504,3372 @@ bool FrameGatewayValidate(unsigned char destPan[PHY_ADDRESS_PANID_SIZE],
 
   return true;
 }
-#endif
-
-// -----------------------------------------------------------------------------
-// Frame scheduler operations
 
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
 /**
- *  FrameSchedulerData - scheduler operation to process all incoming data
- *  frames.
+ *  FrameOverheadLength - number of header and footer bytes of the last 
+ *  received frame. The control byte is at the same place in both header 
+ *  formats.
  *
- *    @return Status message from callee (currently not being used for frame 
- *            use).
+ *    @param  scheduler Frame scheduler.
+ *    @param  length    Number of bytes received.
+ *
+ *    @return Overhead of the frame in bytes.
  */
-unsigned char FrameSchedulerData(void)
-{ 
-  // Pass the payload (without frame header and footer) up to the next layer.
-  if (gFrameScheduler.FrameComplete != NULL)
+unsigned char FrameOverheadLength(struct sFrameScheduler *scheduler,
+                                  unsigned char length)
+{
+  if ((length > PROTOCOL_PHYADDRESS_PANID_SIZE)
+      && (scheduler->rx->header.control & FRAME_CONTROL_COMPRESSED))
   {
-    #if defined( PROTOCOL_GATEWAY )
-    bool dataRequest = (gFrameScheduler.frame.header.control & FRAME_CONTROL_DATA_REQ) >> 1;
-    #endif
-    unsigned char statusMessage = 0;
-    
-    gFrameScheduler.frame.header.control &= ~FRAME_CONTROL_DATA_REQ;
-    
-    #if defined( PROTOCOL_ENDPOINT )
-    statusMessage = gFrameScheduler.FrameComplete(gFrameScheduler.frame.payload, 
-                                                  gFrameScheduler.length);
-    #elif defined( PROTOCOL_GATEWAY )
-    statusMessage = gFrameScheduler.FrameComplete(dataRequest,
-                                                  gFrameScheduler.frame.payload, 
-                                                  gFrameScheduler.length);
-    #endif
-    
-    #if defined( PROTOCOL_GATEWAY )
-    // Send data back to the requesting node, if required.
-    if (dataRequest && (gFrameScheduler.dataResponse.length > 0))
-    {
-      // Send a data response.
-      PhyEnable();
-      FrameSend(eFrameTypeData, 
-                dataRequest, 
-                gFrameScheduler.dataResponse.payload, 
-                gFrameScheduler.dataResponse.length);
-    }
-    #endif
-
-    // Return user callback status message.
-    return statusMessage;
+    return FRAME_COMPRESSED_OVERHEAD_LENGTH;
   }
   
-  return 0;
+  return FRAME_OVERHEAD_LENGTH;
 }
 
 /**
- *  FrameSchedulerLinkRequest - scheduler operation to process all incoming link 
- *  requests.
+ *  FrameExpand - restore the full header of a frame received with a 
+ *  compressed header. The payload is moved behind the addresses, which are 
+ *  taken from the link the identifier stands for.
  *
- *    @return Status message from callee (currently not being used for frame 
- *            use).
+ *    @param  scheduler Frame scheduler.
+ *    @param  length    Number of bytes received; updated to the length of the
+ *                      frame with its full header.
+ *
+ *    @return Success of restoring the header (always true for a full header).
+ *            The frame is dropped if its link is not known to the local node.
  */
-unsigned char FrameSchedulerLinkRequest(void)
+bool FrameExpand(struct sFrameScheduler *scheduler,
+                 unsigned char *length)
 {
-  #if defined( PROTOCOL_ENDPOINT )
-  // An End Point will receive a link request response if the link request was
-  // approved.
-  PhyAddressLinkEstablish(gFrameScheduler.frame.header.panId,
-                          gFrameScheduler.frame.header.srcAddr);
-  #elif defined( PROTOCOL_GATEWAY )
-  if ((gFrameScheduler.frame.header.control & FRAME_CONTROL_MODE) == FRAME_CONTROL_MODE_ENDPOINT)
+  const struct sPhyAddressLocal *local = PhyAddressGetLocalInfo(scheduler->phyAddress);
+  struct sFrame *rx = scheduler->rx;
+  unsigned char payloadLength = *length - FRAME_COMPRESSED_OVERHEAD_LENGTH;
+  unsigned char link;
+  
+  if (!(rx->header.control & FRAME_CONTROL_COMPRESSED))
   {
-    bool accept = true;     // Default behavior: accept all incoming requests
+    return true;
+  }
+  
+  if (payloadLength > PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH)
+  {
+    scheduler->counters.rxLengthErrors++;
+    return false;
+  }
+  
+  // The link identifier takes the place of the destination address.
+  link = rx->header.destAddr[0];
+  if (FrameIsGateway(scheduler))
+  {
+    struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFindLink(scheduler->phyAddress, link);
     
-    // A Gateway node will verify the link request and send a link request 
-    // response if the link request has been approved.
-    if (gFrameScheduler.LinkRequest != NULL)
+    if (endPoint == NULL)
     {
-      accept = gFrameScheduler.LinkRequest(gFrameScheduler.frame.payload, 
-                                           gFrameScheduler.length);
+      scheduler->counters.rxDropAddress++;
+      return false;
     }
-    
-    if (accept)
+    memmove(rx->payload, &rx->header.destAddr[FRAME_HEADER_LINK_LENGTH], payloadLength);
+    PhyAddressCopy(rx->header.srcAddr, endPoint->address, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  }
+  else
+  {
+    // An End Point only accepts its own link identifier.
+    if ((link == PHY_ADDRESS_LINK_NONE) 
+        || (link != scheduler->link)
+        || !PhyAddressLinkExists(scheduler->phyAddress))
     {
-      // The link request has been accepted. Provide a response to the remote
-      // node.
-      PhyEnable();
-      FrameSend(eFrameTypeLinkRequest, false, NULL, 0);
+      scheduler->counters.rxDropAddress++;
+      return false;
     }
+    memmove(rx->payload, &rx->header.destAddr[FRAME_HEADER_LINK_LENGTH], payloadLength);
+    PhyAddressCopy(rx->header.srcAddr, local->remote, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
   }
-  #endif
-
-  return 0;
+  PhyAddressCopy(rx->header.destAddr, local->address, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  
+  *length = payloadLength + FRAME_OVERHEAD_LENGTH;
+  return true;
 }
+#endif
 
-// -----------------------------------------------------------------------------
+#if defined( PROTOCOL_USE_DUPLICATE_FILTER )
 /**
- *  Public interface
+ *  FrameDuplicate - check the sequence number of the received frame against 
+ *  the last one received from the same source (Gateway only). A link request
+ *  forgets the source; its sequence numbers start again.
+ *
+ *  Note: An End Point only sends a frame again if it was not acknowledged, so
+ *  a duplicate always repeats the last frame received from its source.
+ *
+ *    @param  scheduler Frame scheduler.
+ *
+ *    @return True if the frame has already been received.
  */
-
-// -----------------------------------------------------------------------------
-// Frame configuration
-
-#if defined( PROTOCOL_ENDPOINT )
-void FrameInit(unsigned char(*FrameComplete)(unsigned char*, unsigned char))
-#elif defined( PROTOCOL_GATEWAY )
-void FrameInit(unsigned char(*FrameComplete)(bool, unsigned char*, unsigned char),
-               bool(*LinkRequest)(unsigned char *payload, unsigned char length))
-#endif
-{
-  gFrameScheduler.FrameComplete = FrameComplete;
-  #if defined( PROTOCOL_GATEWAY )
-  gFrameScheduler.LinkRequest = LinkRequest;
-  #endif
-  // By default, an End Point will be in low power mode and a Gateway will be
-  // in listen mode.
-  FrameIdle();
-}
-
-struct sFrame* FrameGetInfo()
-{
-  return &gFrameScheduler.frame;
-}
-                 
-#if defined( PROTOCOL_GATEWAY )
-void FrameSetDataResponse(unsigned char *payload, 
-                          unsigned char length)
+bool FrameDuplicate(struct sFrameScheduler *scheduler)
 {
-  gFrameScheduler.dataResponse.payload = payload;
-  gFrameScheduler.dataResponse.length = length;
+  struct sFrameDuplicate *entry;
+  unsigned char hash = 0;
+  unsigned char i;
+  
+  if (!FrameIsGateway(scheduler))
+  {
+    return false;
+  }
+  
+  for (i = 0; i < PROTOCOL_PHYADDRESS_ADDRESS_SIZE; i++)
+  {
+    hash ^= scheduler->rx->header.srcAddr[i];
+  }
+  entry = &scheduler->duplicate[hash & (PROTOCOL_DUPLICATE_CACHE_SIZE - 1)];
+  
+  if ((scheduler->rx->header.control & FRAME_CONTROL_TYPE) == eFrameTypeLinkRequest)
+  {
+    entry->valid = false;
+    return false;
+  }
+  
+  if (entry->valid 
+      && (PhyAddressCompare(entry->srcAddr, 
+                            scheduler->rx->header.srcAddr, 
+                            PROTOCOL_PHYADDRESS_ADDRESS_SIZE) == 0))
+  {
+    if (entry->seqNumber == scheduler->rx->header.seqNumber)
+    {
+      scheduler->counters.rxDuplicates++;
+      return true;
+    }
+  }
+  else
+  {
+    PhyAddressCopy(entry->srcAddr, 
+                   scheduler->rx->header.srcAddr, 
+                   PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+    entry->valid = true;
+  }
+  entry->seqNumber = scheduler->rx->header.seqNumber;
+  
+  return false;
 }
 #endif
 
-// -----------------------------------------------------------------------------
-// Frame basic operations
-
-void FrameIdle()
+#if defined( PROTOCOL_USE_DUPLICATE_FILTER ) || defined( PROTOCOL_USE_SECURITY )
+/**
+ *  FrameResponseKeep - keep a copy of the data response just sent for the 
+ *  last received data request (Gateway only). A response longer than the 
+ *  copy is not kept.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  payload   Location of the response payload.
+ *    @param  length    Number of bytes in the payload.
+ */
+void FrameResponseKeep(struct sFrameScheduler *scheduler,
+                       const unsigned char *payload,
+                       unsigned char length)
 {
-  #if defined( PROTOCOL_ENDPOINT )
-  PhyLowPowerMode();
-  #elif defined( PROTOCOL_GATEWAY )
-  PhyDisable();
-  FrameListen();
-  #endif
+  struct sFrameResponseCopy *copy = &scheduler->lastResponse;
+  
+  if (length > PROTOCOL_RESPONSE_COPY_LENGTH)
+  {
+    return;
+  }
+  
+  PhyAddressCopy(copy->destAddr, 
+                 scheduler->frame.header.destAddr, 
+                 PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  copy->seqNumber = scheduler->rx->header.seqNumber;
+  copy->length = length;
+  memcpy(copy->payload, payload, length);
+  copy->valid = true;
 }
 
-bool FrameListen()
+/**
+ *  FrameResponseResend - answer a data request received again with the copy
+ *  of its response (Gateway only). The response was lost; the End Point has 
+ *  not received its acknowledgement either. A request whose response is not 
+ *  kept is only acknowledged (see FrameAssemble).
+ *
+ *    @param  scheduler Frame scheduler.
+ */
+void FrameResponseResend(struct sFrameScheduler *scheduler)
 {
-  if (!gFrameScheduler.busy)
+  struct sFrameResponseCopy *copy = &scheduler->lastResponse;
+  
+  if (FrameIsGateway(scheduler)
+      && (scheduler->rx->header.control & FRAME_CONTROL_DATA_REQ)
+      && copy->valid
+      && (copy->seqNumber == scheduler->rx->header.seqNumber)
+      && (PhyAddressCompare(copy->destAddr, 
+                            scheduler->rx->header.srcAddr, 
+                            PROTOCOL_PHYADDRESS_ADDRESS_SIZE) == 0))
   {
-    gFrameScheduler.busy = true;
-    PhyReceiverOn((unsigned char*)&gFrameScheduler.frame);
-    
-    return true;
+    PhyEnable(scheduler->phy);
+    FrameSend(scheduler, eFrameTypeData, true, copy->payload, copy->length);
   }
-  
-  return false;
 }
+#endif
 
-bool FrameSend(enum eFrameType type,
-               bool dataRequest,
-               unsigned char *payload, 
-               unsigned char length)
+#if defined( PROTOCOL_USE_RX_POOL )
+/**
+ *  FrameRxPoolGet - get a receive buffer that is not loaned out.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Location of a free receive buffer, or NULL if every buffer in the
+ *            pool is loaned out.
+ */
+struct sFrame* FrameRxPoolGet(struct sFrameScheduler *scheduler)
 {
-  if (!gFrameScheduler.busy)
+  unsigned char i;
+  
+  for (i = 0; i < PROTOCOL_RX_POOL_SIZE; i++)
   {
-    // Build the frame.
-    FrameBuild(type, dataRequest, payload, length);
-
-    // Transmit the frame.
-    if ((length + FRAME_OVERHEAD_LENGTH) <= PROTOCOL_DATASTREAM_MAX_SIZE)
-    {
-      if (PhyTransmit((unsigned char*)&gFrameScheduler.frame,
-                      length + FRAME_OVERHEAD_LENGTH))
-      {
-        // The frame scheduler is only busy if the physical layer has accepted
-        // to transmit the frame.
-        gFrameScheduler.busy = true;
-        return true;
-      }
-      else
-      {
-        // Error: physical layer was unable to perform the transmission.
-        return false;
-      }
-    }
-    else
+    if (!scheduler->rxPool.loaned[i])
     {
-      // Error: Segmentation is not currently supported. Size of the frame is
-      // too large.
-      return false;
+      return &scheduler->rxPool.frame[i];
     }
   }
   
-  // Error: the frame scheduler is currently busy.
-  return false;
+  return NULL;
 }
 
-// -----------------------------------------------------------------------------
-// Frame scheduling operations
-
-bool FrameBusy()
+/**
+ *  FrameRxPoolLoan - loan a receive buffer out to the layer above.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  frame     Receive buffer being loaned.
+ */
+void FrameRxPoolLoan(struct sFrameScheduler *scheduler,
+                     struct sFrame *frame)
 {
-  return gFrameScheduler.busy;
+  scheduler->rxPool.loaned[frame - scheduler->rxPool.frame] = true;
 }
+#endif
 
-unsigned char FrameAssemble(unsigned char *payload, unsigned char length)
-{            
-  gFrameScheduler.busy = false;
-
-  // Clear the size of the buffer for the next RX or TX payload.
-  gFrameScheduler.length = 0;
-  #if defined( PROTOCOL_GATEWAY )
-  FrameSetDataResponse(NULL, 0);
-  #endif
-    
+#if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+/**
+ *  FrameLatencySample - add the time elapsed since the last data stream ended
+ *  to the latency statistics.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameLatencySample(struct sFrameScheduler *scheduler)
+{
+  struct sFrameLatency *latency = &scheduler->counters.latency;
+  unsigned int sample = PROTOCOL_TIMESTAMP() - PhyGetDataStreamTimestamp(scheduler->phy);
+  
+  if ((latency->samples == 0) || (sample < latency->min))
+  {
+    latency->min = sample;
+  }
+  if (sample > latency->max)
+  {
+    latency->max = sample;
+  }
+  
+  // Halve the history before the sample count overflows; the average is kept.
+  if (latency->samples == 0xFFFFu)
+  {
+    latency->samples >>= 1;
+    scheduler->counters.latencySum >>= 1;
+  }
+  latency->samples++;
+  scheduler->counters.latencySum += sample;
+  latency->average = (unsigned int)(scheduler->counters.latencySum / latency->samples);
+}
+#endif
+
+#if defined( PROTOCOL_USE_SEGMENTATION )
+/**
+ *  FrameCrc16 - calculate the CRC-16 (CCITT, polynomial 0x1021) of a message.
+ *
+ *    @param  data    Location of the message.
+ *    @param  length  Number of bytes in the message.
+ *
+ *    @return CRC-16 of the message (initial value 0xFFFF).
+ */
+unsigned int FrameCrc16(const unsigned char *data,
+                        unsigned int length)
+{
+  unsigned int crc = 0xFFFFu;
+  unsigned char i;
+  
+  while (length-- > 0)
+  {
+    crc ^= (unsigned int)(*data++) << 8;
+    for (i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000u) ? ((crc << 1) ^ 0x1021u) : (crc << 1);
+      crc &= 0xFFFFu;
+    }
+  }
+  
+  return crc;
+}
+
+/**
+ *  FrameReassemblyGet - get the reassembly buffer of a source.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  srcAddr   Source of the fragment.
+ *    @param  start     The fragment starts a message; a free buffer is used 
+ *                      if the source has none.
+ *
+ *    @return Location of the reassembly buffer, or NULL if none is available.
+ */
+struct sFrameReassembly* FrameReassemblyGet(struct sFrameScheduler *scheduler,
+                                            const unsigned char *srcAddr,
+                                            bool start)
+{
+  struct sFrameReassembly *reassembly = NULL;
+  unsigned char i;
+  
+  for (i = 0; i < PROTOCOL_SEGMENT_BUFFERS; i++)
+  {
+    if (scheduler->reassembly[i].active)
+    {
+      if (PhyAddressCompare(scheduler->reassembly[i].srcAddr, 
+                            srcAddr, 
+                            PROTOCOL_PHYADDRESS_ADDRESS_SIZE) == 0)
+      {
+        return &scheduler->reassembly[i];
+      }
+    }
+    else if (start && (reassembly == NULL))
+    {
+      reassembly = &scheduler->reassembly[i];
+    }
+  }
+  
+  return reassembly;
+}
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+/**
+ *  FrameCodecSend - send a message as one data frame, encoded if both ends 
+ *  use a codec that makes it shorter. A Delta message is coded against the 
+ *  last reference sent, unless a key message is due; an LZ message against 
+ *  the dictionary. The reference is only updated once the frame is accepted.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  dataRequest Data request (0:simplex, 1:half duplex).
+ *    @param  payload     Message.
+ *    @param  length      Number of message bytes.
+ *
+ *    @return True if the frame is being sent.
+ */
+bool FrameCodecSend(struct sFrameScheduler *scheduler,
+                    bool dataRequest,
+                    unsigned char *payload,
+                    unsigned char length)
+{
+  struct sFrameCodec *codec = &scheduler->codec;
+  unsigned char codecs = codec->enabled & codec->accepted;
+  unsigned char id = CODEC_ID_NONE;
+  unsigned char generation = FRAME_CODEC_GENERATION_NONE;
+  unsigned char *data = payload;
+  unsigned char size = length;
+  
+  // The codec buffer may still hold the frame being sent.
+  if (!scheduler->busy && !FrameIsGateway(scheduler) 
+      && (length > 0) && (length <= PROTOCOL_CODEC_MAX_LENGTH))
+  {
+    unsigned char encoded = 0;
+    
+    // A short message becomes the next reference.
+    if (length <= PROTOCOL_CODEC_REFERENCE_LENGTH)
+    {
+      generation = FRAME_CODEC_NEXT_GENERATION(codec->generation);
+    }
+    
+    // An encoded message must be shorter than the message itself.
+    if ((codecs & CODEC_SET_DELTA) && (codec->keyCount > 0) && (codec->length == length))
+    {
+      id = CODEC_ID_DELTA;
+      encoded = CodecDeltaEncode(codec->reference, payload, length, codec->buffer, length - 1);
+    }
+    if ((encoded == 0) && (codecs & CODEC_SET_LZ))
+    {
+      id = CODEC_ID_LZ;
+      encoded = CodecLzEncode(payload, length, codec->buffer, length - 1);
+    }
+    if (encoded > 0)
+    {
+      data = codec->buffer;
+      size = encoded;
+    }
+    else
+    {
+      id = CODEC_ID_NONE;
+    }
+  }
+  
+  codec->next = FRAME_CODEC_HEADER(id, generation);
+  if (!FrameSend(scheduler, eFrameTypeData, dataRequest, data, size))
+  {
+    codec->next = FRAME_CODEC_HEADER(CODEC_ID_NONE, FRAME_CODEC_GENERATION_NONE);
+    return false;
+  }
+  
+  if (id != CODEC_ID_NONE)
+  {
+    scheduler->counters.txEncoded++;
+    scheduler->counters.txCodecSaved += length - size;
+  }
+  if (generation != FRAME_CODEC_GENERATION_NONE)
+  {
+    memcpy(codec->reference, payload, length);
+    codec->length = length;
+    codec->generation = generation;
+    codec->keyCount = (id == CODEC_ID_DELTA) ? (codec->keyCount - 1) : (PROTOCOL_CODEC_KEY_INTERVAL - 1);
+  }
+  
+  return true;
+}
+
+/**
+ *  FrameCodecDecode - remove the codec header of the data frame received from
+ *  an End Point and decode its payload. The receive buffer holds a message 
+ *  sent as is; the codec buffer holds a decoded message. A message that is 
+ *  short enough becomes the reference of the End Point.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Message (scheduler->length bytes), or NULL if it cannot be 
+ *            decoded.
+ */
+unsigned char* FrameCodecDecode(struct sFrameScheduler *scheduler)
+{
+  struct sFrameCodec *codec = &scheduler->codec;
+  struct sPhyAddressEndPoint *endPoint;
+  unsigned char *payload = scheduler->rx->payload;
+  unsigned char *encoded = &payload[FRAME_CODEC_HEADER_LENGTH];
+  unsigned char header;
+  unsigned char generation;
+  unsigned char length = 0;
+  bool valid = false;
+  
+  // Only the data frames of an End Point carry a codec header.
+  if (((scheduler->rx->header.control & FRAME_CONTROL_MODE) != FRAME_CONTROL_MODE_ENDPOINT)
+      || (scheduler->length < FRAME_CODEC_HEADER_LENGTH))
+  {
+    return payload;
+  }
+  
+  header = payload[0];
+  generation = header & FRAME_CODEC_GENERATION;
+  scheduler->length -= FRAME_CODEC_HEADER_LENGTH;
+  endPoint = PhyAddressEndPointFind(scheduler->phyAddress, scheduler->rx->header.srcAddr);
+  
+  switch (header >> FRAME_CODEC_ID_SHIFT)
+  {
+  case CODEC_ID_NONE:
+    memmove(payload, encoded, scheduler->length);
+    length = scheduler->length;
+    valid = true;
+    break;
+  case CODEC_ID_DELTA:
+    // The message was coded against the previous reference of the End Point.
+    if ((codec->enabled & CODEC_SET_DELTA) 
+        && (endPoint != NULL) 
+        && (endPoint->codecLength > 0)
+        && (generation == FRAME_CODEC_NEXT_GENERATION(endPoint->codecGeneration)))
+    {
+      payload = codec->buffer;
+      length = CodecDeltaDecode(endPoint->codecReference, 
+                                endPoint->codecLength, 
+                                encoded, 
+                                scheduler->length, 
+                                payload);
+      valid = (length > 0);
+    }
+    break;
+  case CODEC_ID_LZ:
+    if (codec->enabled & CODEC_SET_LZ)
+    {
+      payload = codec->buffer;
+      length = CodecLzDecode(encoded, scheduler->length, payload, PROTOCOL_CODEC_MAX_LENGTH);
+      valid = (length > 0);
+    }
+    break;
+  default:
+    break;
+  }
+  
+  if (!valid)
+  {
+    // Error: unknown codec, missing reference or malformed message.
+    scheduler->counters.rxCodecErrors++;
+    return NULL;
+  }
+  
+  if (payload == codec->buffer)
+  {
+    scheduler->counters.rxDecoded++;
+  }
+  scheduler->length = length;
+  
+  if ((endPoint != NULL) && (generation != FRAME_CODEC_GENERATION_NONE) 
+      && (length <= PROTOCOL_CODEC_REFERENCE_LENGTH))
+  {
+    memcpy(endPoint->codecReference, payload, length);
+    endPoint->codecLength = length;
+    endPoint->codecGeneration = generation;
+  }
+  
+  return payload;
+}
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+/**
+ *  FrameSecurityCounter - write a frame counter or key seed, most significant
+ *  byte first.
+ *
+ *    @param  data      Location of the counter.
+ *    @param  counter   Counter.
+ */
+void FrameSecurityCounter(unsigned char *data,
+                          unsigned long counter)
+{
+  data[0] = (unsigned char)(counter >> 24);
+  data[1] = (unsigned char)(counter >> 16);
+  data[2] = (unsigned char)(counter >> 8);
+  data[3] = (unsigned char)counter;
+}
+
+/**
+ *  FrameSecurityReadCounter - read a frame counter, key seed or challenge, 
+ *  most significant byte first.
+ *
+ *    @param  data      Location of the counter.
+ *
+ *    @return Counter.
+ */
+unsigned long FrameSecurityReadCounter(const unsigned char *data)
+{
+  return ((unsigned long)data[0] << 24)
+         | ((unsigned long)data[1] << 16)
+         | ((unsigned long)data[2] << 8)
+         | data[3];
+}
+
+/**
+ *  FrameSecurityNonce - build the CCM* nonce of a frame.
+ *
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  address   Source address of the frame.
+ *    @param  counter   Frame counter of the frame.
+ */
+void FrameSecurityNonce(unsigned char *nonce,
+                        const unsigned char *address,
+                        unsigned long counter)
+{
+  memset(nonce, 0, FRAME_SECURITY_NONCE_ADDRESS);
+  memcpy(nonce, address, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  FrameSecurityCounter(&nonce[FRAME_SECURITY_NONCE_ADDRESS], counter);
+  nonce[FRAME_SECURITY_NONCE_ADDRESS + FRAME_SECURITY_COUNTER_LENGTH] = FRAME_SECURITY_LEVEL;
+}
+
+/**
+ *  FrameSecurityDerive - derive the key of a link: the network key encrypts 
+ *  the key seed followed by the End Point and Gateway addresses. The key 
+ *  schedule is used to do so.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  seed      Key seed (FRAME_SECURITY_SEED_LENGTH bytes).
+ *    @param  endPoint  Address of the End Point.
+ *    @param  gateway   Address of the Gateway.
+ *    @param  key       Link key (SECURITY_KEY_LENGTH bytes).
+ */
+void FrameSecurityDerive(struct sFrameScheduler *scheduler,
+                         const unsigned char *seed,
+                         const unsigned char *endPoint,
+                         const unsigned char *gateway,
+                         unsigned char *key)
+{
+  struct sFrameSecurity *security = &scheduler->security;
+  
+  memset(key, 0, SECURITY_KEY_LENGTH);
+  memcpy(key, seed, FRAME_SECURITY_SEED_LENGTH);
+  memcpy(&key[FRAME_SECURITY_SEED_LENGTH], endPoint, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  memcpy(&key[FRAME_SECURITY_SEED_LENGTH + PROTOCOL_PHYADDRESS_ADDRESS_SIZE], 
+         gateway, 
+         PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  SecurityExpandKey(&security->schedule, security->key);
+  SecurityEncryptBlock(&security->schedule, key);
+  security->cached = NULL;
+}
+
+/**
+ *  FrameSecurityResponse - append the MIC of a link request response 
+ *  (Gateway) or check it (End Point). The network key authenticates the 
+ *  response payload; the nonce is the Gateway address and the challenge of the
+ *  link request answered. The key schedule is used to do so; an End Point must
+ *  derive its link key again.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  gateway   Address of the Gateway.
+ *    @param  response  Response payload followed by its MIC 
+ *                      (FRAME_LINK_RESPONSE_SIZE bytes).
+ *
+ *    @return True if the MIC has been appended or is authentic.
+ */
+bool FrameSecurityResponse(struct sFrameScheduler *scheduler,
+                           const unsigned char *gateway,
+                           unsigned char *response)
+{
+  struct sFrameSecurity *security = &scheduler->security;
+  unsigned char nonce[SECURITY_NONCE_LENGTH];
+  
+  FrameSecurityNonce(nonce, gateway, FrameSecurityReadCounter(security->challenge));
+  SecurityExpandKey(&security->schedule, security->key);
+  security->cached = NULL;
+  
+  if (FrameIsGateway(scheduler))
+  {
+    SecurityCcmEncrypt(&security->schedule, 
+                       nonce, 
+                       response, 
+                       FRAME_LINK_RESPONSE_LENGTH, 
+                       NULL, 
+                       0, 
+                       &response[FRAME_LINK_RESPONSE_MIC], 
+                       PROTOCOL_SECURITY_MIC_LENGTH);
+    return true;
+  }
+  
+  security->linked = false;
+  return SecurityCcmDecrypt(&security->schedule, 
+                            nonce, 
+                            response, 
+                            FRAME_LINK_RESPONSE_LENGTH, 
+                            NULL, 
+                            0, 
+                            &response[FRAME_LINK_RESPONSE_MIC], 
+                            PROTOCOL_SECURITY_MIC_LENGTH);
+}
+
+/**
+ *  FrameSecurityLink - get the key of the link with a remote node. A Gateway
+ *  expands the key of an End Point only if it is not already in the key 
+ *  schedule.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  address   Address of the remote node.
+ *    @param  counter   Lowest new frame counter of the remote node (may be 
+ *                      NULL).
+ *
+ *    @return Key schedule of the link, or NULL if the link has no key.
+ */
+const struct sSecurityKey* FrameSecurityLink(struct sFrameScheduler *scheduler,
+                                             const unsigned char *address,
+                                             unsigned long **counter)
+{
+  struct sFrameSecurity *security = &scheduler->security;
+  struct sPhyAddressEndPoint *endPoint;
+  
+  if (!FrameIsGateway(scheduler))
+  {
+    if (counter != NULL)
+    {
+      *counter = &security->rxCounter;
+    }
+    return security->linked ? &security->schedule : NULL;
+  }
+  
+  endPoint = PhyAddressEndPointFind(scheduler->phyAddress, address);
+  if ((endPoint == NULL) || !(endPoint->flags & PHY_ADDRESS_ENDPOINT_FLAG_SECURE))
+  {
+    return NULL;
+  }
+  if (security->cached != endPoint)
+  {
+    SecurityExpandKey(&security->schedule, endPoint->securityKey);
+    security->cached = endPoint;
+  }
+  if (counter != NULL)
+  {
+    *counter = &endPoint->securityCounter;
+  }
+  
+  return &security->schedule;
+}
+
+/**
+ *  FrameSecured - check whether a frame being sent is secured. Link requests 
+ *  (and their responses and beacons) and group messages are sent as is.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  type      Type of the frame.
+ *
+ *    @return True if the frame is secured.
+ */
+bool FrameSecured(struct sFrameScheduler *scheduler,
+                  enum eFrameType type)
+{
+  if ((scheduler->security.key == NULL) || (type == eFrameTypeLinkRequest))
+  {
+    return false;
+  }
+  #if defined( PROTOCOL_USE_MULTICAST )
+  if (scheduler->multicast.sending)
+  {
+    return false;
+  }
+  #endif
+  
+  return true;
+}
+
+/**
+ *  FrameSecure - encrypt the payload of the frame being sent and append its 
+ *  frame counter and MIC. The payload segments of the data stream are 
+ *  gathered into the security buffer, which replaces them.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  stream    Data stream of the frame.
+ *    @param  count     Number of data stream segments.
+ *    @param  length    Number of secured payload bytes.
+ *
+ *    @return True if the frame has been secured. False if the link has no key,
+ *            the secured payload is too long or the frame counters are used 
+ *            up.
+ */
+bool FrameSecure(struct sFrameScheduler *scheduler,
+                 struct sPhyDataSegment *stream,
+                 unsigned char *count,
+                 unsigned int length)
+{
+  struct sFrameSecurity *security = &scheduler->security;
+  const struct sSecurityKey *key;
+  unsigned char nonce[SECURITY_NONCE_LENGTH];
+  unsigned char n = 0;
+  unsigned char i;
+  
+  key = FrameSecurityLink(scheduler, scheduler->frame.header.destAddr, NULL);
+  if ((key == NULL) 
+      || (length > PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH)
+      || (security->txCounter == FRAME_SECURITY_COUNTER_MAX))
+  {
+    return false;
+  }
+  
+  for (i = FRAME_PAYLOAD_SEGMENT; i < *count; i++)
+  {
+    if (stream[i].length > 0)
+    {
+      memcpy(&security->buffer[n], stream[i].data, stream[i].length);
+      n += stream[i].length;
+    }
+  }
+  
+  // The MIC covers the full frame header, including the security bit.
+  scheduler->frame.header.control |= FRAME_CONTROL_SECURE;
+  FrameSecurityCounter(&security->buffer[n], security->txCounter);
+  FrameSecurityNonce(nonce, scheduler->frame.header.srcAddr, security->txCounter);
+  security->txCounter++;
+  SecurityCcmEncrypt(key, 
+                     nonce, 
+                     (unsigned char*)&scheduler->frame.header, 
+                     FRAME_HEADER_LENGTH, 
+                     security->buffer, 
+                     n, 
+                     &security->buffer[n + FRAME_SECURITY_COUNTER_LENGTH], 
+                     PROTOCOL_SECURITY_MIC_LENGTH);
+  
+  stream[FRAME_PAYLOAD_SEGMENT].data = security->buffer;
+  stream[FRAME_PAYLOAD_SEGMENT].length = n + FRAME_SECURITY_LENGTH;
+  *count = FRAME_PAYLOAD_SEGMENT + 1;
+  scheduler->counters.txSecured++;
+  
+  return true;
+}
+
+/**
+ *  FrameUnsecure - authenticate and decrypt the frame received, in place. A 
+ *  frame of a secured link must be secured; its frame counter must not be 
+ *  older than that of the last frame accepted from the link. The last frame 
+ *  accepted may be received again if its acknowledgement was lost; it is then
+ *  flagged as replayed.
+ *
+ *    @param  scheduler Frame scheduler.
+ *
+ *    @return True if the frame is accepted (scheduler->length is then the 
+ *            number of plain text payload bytes).
+ */
+bool FrameUnsecure(struct sFrameScheduler *scheduler)
+{
+  struct sFrameSecurity *security = &scheduler->security;
+  struct sFrame *rx = scheduler->rx;
+  const struct sSecurityKey *key = NULL;
+  unsigned long *next = NULL;
+  unsigned long counter;
+  unsigned char nonce[SECURITY_NONCE_LENGTH];
+  unsigned char length;
+  bool required = (security->key != NULL)
+                  && ((rx->header.control & FRAME_CONTROL_TYPE) != eFrameTypeLinkRequest)
+                  && !FrameIsMulticast(scheduler);
+  
+  security->replayed = false;
+  if (!(rx->header.control & FRAME_CONTROL_SECURE))
+  {
+    if (required)
+    {
+      // Error: the frame should have been secured.
+      scheduler->counters.rxAuthErrors++;
+      return false;
+    }
+    return true;
+  }
+  
+  if (required && (scheduler->length >= FRAME_SECURITY_LENGTH))
+  {
+    key = FrameSecurityLink(scheduler, rx->header.srcAddr, &next);
+  }
+  if (key == NULL)
+  {
+    // Error: the frame cannot be secured or the link has no key.
+    scheduler->counters.rxAuthErrors++;
+    return false;
+  }
+  
+  length = scheduler->length - FRAME_SECURITY_LENGTH;
+  counter = ((unsigned long)rx->payload[length] << 24)
+            | ((unsigned long)rx->payload[length + 1] << 16)
+            | ((unsigned long)rx->payload[length + 2] << 8)
+            | rx->payload[length + 3];
+  if ((counter == FRAME_SECURITY_COUNTER_MAX) || ((counter + 1) < *next))
+  {
+    // Error: the frame is older than the last one accepted.
+    scheduler->counters.rxReplays++;
+    return false;
+  }
+  
+  FrameSecurityNonce(nonce, rx->header.srcAddr, counter);
+  if (!SecurityCcmDecrypt(key, 
+                          nonce, 
+                          (unsigned char*)&rx->header, 
+                          FRAME_HEADER_LENGTH, 
+                          rx->payload, 
+                          length, 
+                          &rx->payload[length + FRAME_SECURITY_COUNTER_LENGTH], 
+                          PROTOCOL_SECURITY_MIC_LENGTH))
+  {
+    // Error: the frame is not authentic.
+    scheduler->counters.rxAuthErrors++;
+    return false;
+  }
+  
+  if ((counter + 1) == *next)
+  {
+    security->replayed = true;
+  }
+  *next = counter + 1;
+  scheduler->length = length;
+  
+  return true;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Frame scheduler operations
+
+#if defined( PROTOCOL_USE_MAILBOX )
+/**
+ *  FrameMailComplete - the message being sent has completed. Return it to the
+ *  pool and notify the caller of its final status.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  status    Completion status (FRAME_TX_STATUS_x).
+ */
+void FrameMailComplete(struct sFrameScheduler *scheduler,
+                       unsigned char status)
+{
+  struct sFrameMailbox *mailbox = &scheduler->mailbox;
+  struct sFrameMail *mail = &mailbox->mail[mailbox->sending];
+  
+  mail->next = mailbox->free;
+  mailbox->free = mailbox->sending;
+  mailbox->sending = PHY_ADDRESS_ENDPOINT_NONE;
+  
+  if (mailbox->PostComplete != NULL)
+  {
+    mailbox->PostComplete(mail->handle, status);
+  }
+}
+
+/**
+ *  FrameMailSend - send the oldest message posted for the node that requested
+ *  data, if any. A message the physical layer refuses stays in the mailbox.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameMailSend(struct sFrameScheduler *scheduler)
+{
+  struct sFrameMailbox *mailbox = &scheduler->mailbox;
+  struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(scheduler->phyAddress, 
+                                                                scheduler->rx->header.srcAddr);
+  unsigned char index;
+  
+  if ((endPoint == NULL) || (endPoint->mailbox == PHY_ADDRESS_ENDPOINT_NONE))
+  {
+    return;
+  }
+  
+  // The message leaves the End Point's queue before the frame is built; the
+  // frame signals whether more messages are left (FrameBuild).
+  index = endPoint->mailbox;
+  endPoint->mailbox = mailbox->mail[index].next;
+  PhyEnable(scheduler->phy);
+  if (FrameSend(scheduler, eFrameTypeData, 
+                true, 
+                mailbox->mail[index].payload, 
+                mailbox->mail[index].length))
+  {
+    mailbox->sending = index;
+    FrameResponseKeep(scheduler, 
+                      mailbox->mail[index].payload, 
+                      mailbox->mail[index].length);
+  }
+  else
+  {
+    endPoint->mailbox = index;
+  }
+}
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+/**
+ *  FrameAggregateSend - send the records gathered so far in one Aggregate 
+ *  frame. Records added from then on are gathered in the other buffer.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Whether the frame was accepted (true) or not (false: nothing to 
+ *            send, the previous Aggregate frame or another frame is still 
+ *            being sent).
+ */
+bool FrameAggregateSend(struct sFrameScheduler *scheduler)
+{
+  struct sFrameAggregator *aggregator = &scheduler->aggregator;
+  
+  if (aggregator->sending || (aggregator->length == 0))
+  {
+    return false;
+  }
+  
+  if (!FrameSend(scheduler, eFrameTypeAggregate, 
+                 false, 
+                 aggregator->buffer[aggregator->fill], 
+                 aggregator->length))
+  {
+    return false;
+  }
+  
+  scheduler->counters.txRecords += aggregator->count;
+  aggregator->sending = true;
+  aggregator->fill ^= 1;
+  aggregator->length = 0;
+  aggregator->count = 0;
+  aggregator->timeout = 0;
+  
+  return true;
+}
+#endif
+
+#if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_JOIN_CONTROL )
+/**
+ *  FrameRandom - draw the next value of the backoff generator. The generator 
+ *  is a 16 bit Galois LFSR (taps 16, 14, 13, 11) seeded from the local 
+ *  address.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Pseudo-random value (never zero).
+ */
+unsigned int FrameRandom(struct sFrameScheduler *scheduler)
+{
+  unsigned int lfsr = scheduler->retry.random;
+  
+  lfsr = (lfsr >> 1) ^ ((lfsr & 0x0001u) ? 0xB400u : 0x0000u);
+  scheduler->retry.random = lfsr;
+  
+  return lfsr;
+}
+#endif
+
+#if defined( PROTOCOL_USE_JOIN_CONTROL )
+/**
+ *  FrameJoinBackoff - hold off the next link request for a random time drawn
+ *  from a window that starts after a delay.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  delay     Milliseconds before the window starts.
+ *    @param  window    Width of the window in milliseconds.
+ */
+void FrameJoinBackoff(struct sFrameScheduler *scheduler,
+                      unsigned int delay,
+                      unsigned int window)
+{
+  unsigned long timeout = (unsigned long)delay + (FrameRandom(scheduler) % window) + 1;
+  
+  scheduler->join.timeout = (timeout > 0xFFFFu) ? 0xFFFFu : (unsigned int)timeout;
+  PhyTimerStart(scheduler->phy);
+}
+
+/**
+ *  FrameJoinDefer - admission control of the link request just received. An 
+ *  End Point beyond the admission rate is sent a link request response that 
+ *  tells it when to ask again: in the first period with room left after the
+ *  End Points deferred before it. An End Point already linked (its response 
+ *  was lost) is always admitted.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Whether the link request was deferred (true) or admitted (false).
+ */
+bool FrameJoinDefer(struct sFrameScheduler *scheduler)
+{
+  struct sFrameJoin *join = &scheduler->join;
+  struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(scheduler->phyAddress, 
+                                                                scheduler->rx->header.srcAddr);
+  unsigned long retry;
+  unsigned char length = FRAME_LINK_RESPONSE_LENGTH;
+  
+  if ((endPoint != NULL) && (endPoint->state == ePhyAddressLinkEstablished))
+  {
+    return false;
+  }
+  
+  if (join->timeout == 0)
+  {
+    // A new admission period starts (see FrameTick).
+    join->timeout = PROTOCOL_JOIN_PERIOD;
+    join->admitted = 0;
+    PhyTimerStart(scheduler->phy);
+  }
+  
+  if (join->admitted < PROTOCOL_JOIN_ADMIT)
+  {
+    join->admitted++;
+    return false;
+  }
+  
+  retry = join->timeout + ((unsigned long)(join->backlog / PROTOCOL_JOIN_ADMIT) * PROTOCOL_JOIN_PERIOD);
+  if (retry > 0xFFFFu)
+  {
+    retry = 0xFFFFu;
+  }
+  if (join->backlog < 0xFFFFu)
+  {
+    join->backlog++;
+  }
+  
+  scheduler->counters.linkDeferred++;
+  scheduler->linkResponse[FRAME_LINK_RESPONSE_LINK] = PHY_ADDRESS_LINK_NONE;
+  scheduler->linkResponse[FRAME_LINK_RESPONSE_SLOT] = PHY_ADDRESS_SLOT_NONE;
+  scheduler->linkResponse[FRAME_LINK_RESPONSE_RETRY] = (unsigned char)(retry >> 8);
+  scheduler->linkResponse[FRAME_LINK_RESPONSE_RETRY + 1] = (unsigned char)retry;
+  #if defined( PROTOCOL_USE_CODEC )
+  scheduler->linkResponse[FRAME_LINK_RESPONSE_CODECS] = 0;
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  FrameSecurityCounter(&scheduler->linkResponse[FRAME_LINK_RESPONSE_SEED], 0);
+  if (scheduler->security.key != NULL)
+  {
+    FrameSecurityResponse(scheduler, 
+                          PhyAddressGetLocalInfo(scheduler->phyAddress)->address, 
+                          scheduler->linkResponse);
+    length = FRAME_LINK_RESPONSE_SIZE;
+  }
+  #endif
+  PhyEnable(scheduler->phy);
+  FrameSend(scheduler, eFrameTypeLinkRequest, false, 
+            scheduler->linkResponse, 
+            length);
+  
+  return true;
+}
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+/**
+ *  FrameTdmaListen - turn the receiver on for the beacon. Waiting for the 
+ *  beacon does not keep the scheduler busy; frames may still be sent.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameTdmaListen(struct sFrameScheduler *scheduler)
+{
+  bool busy = scheduler->busy;
+  
+  scheduler->busy = false;
+  FrameListen(scheduler);
+  scheduler->busy = busy;
+}
+
+/**
+ *  FrameTdmaSync - a beacon has been received. The superframe is timed from 
+ *  its end. An End Point without a slot has no use for the timing.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameTdmaSync(struct sFrameScheduler *scheduler)
+{
+  struct sFrameTdma *tdma = &scheduler->tdma;
+  
+  scheduler->counters.rxBeacons++;
+  if (tdma->slot == PHY_ADDRESS_SLOT_NONE)
+  {
+    return;
+  }
+  
+  tdma->synced = true;
+  tdma->window = false;
+  tdma->misses = 0;
+  tdma->clock = 0;
+  PhyTimerStart(scheduler->phy);
+}
+
+/**
+ *  FrameTdmaHold - hold the frame being sent until the slot of the local 
+ *  node; it is then sent from the retry data stream (see FrameTdmaTick). Only
+ *  an End Point that knows the superframe timing holds its frames.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Whether the frame is held (true) or must be sent at once (false).
+ */
+bool FrameTdmaHold(struct sFrameScheduler *scheduler)
+{
+  if (FrameIsGateway(scheduler) || !scheduler->tdma.synced)
+  {
+    return false;
+  }
+  
+  scheduler->tdma.waiting = true;
+  scheduler->busy = true;
+  FrameIdle(scheduler);
+  
+  return true;
+}
+
+/**
+ *  FrameTdmaBeacon - send the beacon that starts the next superframe. The 
+ *  beacon takes precedence over listening for a frame.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameTdmaBeacon(struct sFrameScheduler *scheduler)
+{
+  struct sPhyDataSegment segment[2];
+  unsigned char count = 0;
+  
+  #if defined( PROTOCOL_USE_MULTICAST )
+  // The beacon carries the group message waiting for it.
+  if (scheduler->multicast.waiting)
+  {
+    segment[0].data = scheduler->multicast.dest;
+    segment[0].length = FRAME_MULTICAST_GROUP_LENGTH;
+    segment[1].data = scheduler->multicast.payload;
+    segment[1].length = scheduler->multicast.length;
+    count = 2;
+  }
+  #endif
+  
+  scheduler->busy = false;
+  scheduler->listening = false;
+  scheduler->tdma.beacon = true;
+  PhyEnable(scheduler->phy);
+  if (!FrameSendv(scheduler, eFrameTypeLinkRequest, false, segment, count))
+  {
+    // The beacon is sent on the next tick.
+    scheduler->tdma.beacon = false;
+    FrameIdle(scheduler);
+  }
+}
+#endif
+
+/**
+ *  FrameSchedulerRespond - send the loaded data response back to the node that
+ *  requested data, if required.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  dataRequest The incoming message requested data.
+ */
+void FrameSchedulerRespond(struct sFrameScheduler *scheduler,
+                           bool dataRequest)
+{
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER ) || defined( PROTOCOL_USE_SECURITY )
+  // The response to the previous data request is no longer needed.
+  if (dataRequest)
+  {
+    scheduler->lastResponse.valid = false;
+  }
+  #endif
+  
+  if (dataRequest && (scheduler->dataResponse.length > 0))
+  {
+    // Send a data response.
+    PhyEnable(scheduler->phy);
+    if (FrameSend(scheduler, eFrameTypeData, 
+                  dataRequest, 
+                  scheduler->dataResponse.payload, 
+                  scheduler->dataResponse.length))
+    {
+      FrameResponseKeep(scheduler, 
+                        scheduler->dataResponse.payload, 
+                        scheduler->dataResponse.length);
+    }
+  }
+  #if defined( PROTOCOL_USE_MAILBOX )
+  else if (dataRequest)
+  {
+    // Send a message posted for the requesting node.
+    FrameMailSend(scheduler);
+  }
+  #endif
+}
+
+/**
+ *  FrameSchedulerData - scheduler operation to process all incoming data
+ *  frames.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Status message from callee (currently not being used for frame 
+ *            use).
+ */
+unsigned char FrameSchedulerData(struct sFrameScheduler *scheduler)
+{ 
+  // Pass the payload (without frame header and footer) up to the next layer.
+  if (scheduler->FrameComplete != NULL)
+  {
+    bool dataRequest = false;
+    unsigned char statusMessage = 0;
+    unsigned char *payload = scheduler->rx->payload;
+    
+    // Only a Gateway may be requested data.
+    if (FrameIsGateway(scheduler))
+    {
+      dataRequest = (scheduler->rx->header.control & FRAME_CONTROL_DATA_REQ) >> 1;
+    }
+    
+    scheduler->rx->header.control &= ~FRAME_CONTROL_DATA_REQ;
+    
+    #if defined( PROTOCOL_USE_CODEC )
+    // A message that cannot be decoded is dropped; a data request is still 
+    // answered.
+    if (FrameIsGateway(scheduler))
+    {
+      payload = FrameCodecDecode(scheduler);
+      if (payload == NULL)
+      {
+        FrameSchedulerRespond(scheduler, dataRequest);
+        return 0;
+      }
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_RX_POOL )
+    // The payload is loaned to the callee until it is released. A decoded 
+    // message is only valid during the callback.
+    if (payload == scheduler->rx->payload)
+    {
+      FrameRxPoolLoan(scheduler, scheduler->rx);
+    }
+    
+    // No response is required; a Gateway receives the next frame into another
+    // buffer while the callee holds this one.
+    if (FrameIsGateway(scheduler) && !dataRequest && !FrameAckOwed(scheduler))
+    {
+      FrameListen(scheduler);
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+    FrameLatencySample(scheduler);
+    #endif
+    statusMessage = scheduler->FrameComplete(dataRequest,
+                                             payload, 
+                                             scheduler->length);
+    
+    // Send data back to the requesting node, if required.
+    FrameSchedulerRespond(scheduler, dataRequest);
+
+    // Return user callback status message.
+    return statusMessage;
+  }
+  
+  return 0;
+}
+
+/**
+ *  FrameSchedulerLinkRequest - scheduler operation to process all incoming link 
+ *  requests.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Status message from callee (currently not being used for frame 
+ *            use).
+ */
+unsigned char FrameSchedulerLinkRequest(struct sFrameScheduler *scheduler)
+{
+  if (!FrameIsGateway(scheduler))
+  {
+    #if defined( PROTOCOL_USE_TDMA )
+    // A beacon only carries the superframe timing.
+    if (FrameIsBeacon(scheduler))
+    {
+      FrameTdmaSync(scheduler);
+      #if defined( PROTOCOL_USE_MULTICAST )
+      // The beacon carries a message for every End Point or for a group. The
+      // message is only valid during the callback.
+      if ((scheduler->length > FRAME_MULTICAST_GROUP_LENGTH)
+          && FrameGroupMember(scheduler, scheduler->rx->payload))
+      {
+        scheduler->counters.rxMulticasts++;
+        if (scheduler->FrameComplete != NULL)
+        {
+          return scheduler->FrameComplete(false, 
+                                          &scheduler->rx->payload[FRAME_MULTICAST_GROUP_LENGTH], 
+                                          scheduler->length - FRAME_MULTICAST_GROUP_LENGTH);
+        }
+      }
+      #endif
+      return 0;
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_SECURITY )
+    // With a network key, only an authentic response to the pending link 
+    // request is accepted; a response replayed or forged is dropped.
+    if (scheduler->security.key != NULL)
+    {
+      if (!scheduler->security.linking 
+          || (scheduler->length < FRAME_LINK_RESPONSE_SIZE)
+          || !FrameSecurityResponse(scheduler, 
+                                    scheduler->rx->header.srcAddr, 
+                                    scheduler->rx->payload))
+      {
+        scheduler->counters.rxAuthErrors++;
+        return 0;
+      }
+      scheduler->security.linking = false;
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_JOIN_CONTROL )
+    // The Gateway deferred the link request. Ask again once the retry time has
+    // passed, at a random point of the admission period that follows.
+    if (scheduler->length >= FRAME_LINK_RESPONSE_LENGTH)
+    {
+      unsigned int retry = ((unsigned int)scheduler->rx->payload[FRAME_LINK_RESPONSE_RETRY] << 8)
+                           | scheduler->rx->payload[FRAME_LINK_RESPONSE_RETRY + 1];
+      
+      if (retry > 0)
+      {
+        scheduler->counters.linkDeferred++;
+        FrameJoinBackoff(scheduler, retry, PROTOCOL_JOIN_PERIOD);
+        return 0;
+      }
+    }
+    scheduler->join.attempt = 0;
+    scheduler->join.timeout = 0;
+    #endif
+    
+    #if defined( PROTOCOL_USE_SECURITY )
+    // The frame counters of a link start over. The seed of the link the End 
+    // Point last had is refused; earlier seeds are only kept out by the 
+    // challenge (a response answers one link request) and by the Gateway, 
+    // which does not issue a seed twice while it runs.
+    if (scheduler->security.key != NULL)
+    {
+      unsigned long seed = FrameSecurityReadCounter(&scheduler->rx->payload[FRAME_LINK_RESPONSE_SEED]);
+      
+      if (scheduler->security.seedUsed && (seed == scheduler->security.seed))
+      {
+        scheduler->counters.rxReplays++;
+        return 0;
+      }
+      scheduler->security.seed = seed;
+      scheduler->security.seedUsed = true;
+    }
+    #endif
+    
+    // An End Point will receive a link request response if the link request 
+    // was approved.
+    PhyAddressLinkEstablish(scheduler->phyAddress,
+                            scheduler->rx->header.panId,
+                            scheduler->rx->header.srcAddr);
+    #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+    // The response carries the link identifier assigned by the Gateway.
+    scheduler->link = PHY_ADDRESS_LINK_NONE;
+    if (scheduler->length >= FRAME_LINK_RESPONSE_LENGTH)
+    {
+      scheduler->link = scheduler->rx->payload[FRAME_LINK_RESPONSE_LINK];
+    }
+    #endif
+    #if defined( PROTOCOL_USE_CODEC )
+    // And the codecs the Gateway decodes. The references start over.
+    scheduler->codec.accepted = 0;
+    if (scheduler->length >= FRAME_LINK_RESPONSE_LENGTH)
+    {
+      scheduler->codec.accepted = scheduler->rx->payload[FRAME_LINK_RESPONSE_CODECS];
+    }
+    scheduler->codec.length = 0;
+    scheduler->codec.keyCount = 0;
+    #endif
+    #if defined( PROTOCOL_USE_SECURITY )
+    // And the seed of the link key. The frames of the link are secured from 
+    // now on.
+    scheduler->security.linked = false;
+    if ((scheduler->security.key != NULL) 
+        && (scheduler->length >= FRAME_LINK_RESPONSE_LENGTH))
+    {
+      unsigned char key[SECURITY_KEY_LENGTH];
+      
+      FrameSecurityDerive(scheduler, 
+                          &scheduler->rx->payload[FRAME_LINK_RESPONSE_SEED], 
+                          PhyAddressGetLocalInfo(scheduler->phyAddress)->address, 
+                          scheduler->rx->header.srcAddr, 
+                          key);
+      SecurityExpandKey(&scheduler->security.schedule, key);
+      scheduler->security.linked = true;
+      scheduler->security.rxCounter = 0;
+    }
+    #endif
+    #if defined( PROTOCOL_USE_TDMA )
+    // It also carries the slot of the local node. The slot is used once the 
+    // first beacon has been heard; the End Point listens until then.
+    scheduler->tdma.slot = PHY_ADDRESS_SLOT_NONE;
+    if ((scheduler->length >= FRAME_LINK_RESPONSE_LENGTH)
+        && (scheduler->rx->payload[FRAME_LINK_RESPONSE_SLOT] < PROTOCOL_TDMA_SLOTS))
+    {
+      scheduler->tdma.slot = scheduler->rx->payload[FRAME_LINK_RESPONSE_SLOT];
+    }
+    scheduler->tdma.synced = false;
+    scheduler->tdma.window = (scheduler->tdma.slot != PHY_ADDRESS_SLOT_NONE);
+    #endif
+  }
+  else if ((scheduler->rx->header.control & FRAME_CONTROL_MODE) == FRAME_CONTROL_MODE_ENDPOINT)
+  {
+    bool accept = true;     // Default behavior: accept all incoming requests
+    #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+    struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(scheduler->phyAddress, 
+                                                                  scheduler->rx->header.srcAddr);
+    #endif
+    
+    #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+    // The endpoint table had no room for the End Point (every entry is linked
+    // or holds mail). It is denied; the Gateway could not serve its link.
+    if (endPoint == NULL)
+    {
+      scheduler->counters.linkDenied++;
+      return 0;
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_SECURITY )
+    // With a network key, the challenge of the End Point ends the link 
+    // request; the response answers it.
+    if (scheduler->security.key != NULL)
+    {
+      if (scheduler->length < FRAME_SECURITY_CHALLENGE_LENGTH)
+      {
+        scheduler->counters.rxAuthErrors++;
+        return 0;
+      }
+      scheduler->length -= FRAME_SECURITY_CHALLENGE_LENGTH;
+      memcpy(scheduler->security.challenge, 
+             &scheduler->rx->payload[scheduler->length], 
+             FRAME_SECURITY_CHALLENGE_LENGTH);
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_JOIN_CONTROL )
+    // Too many link requests have been admitted lately.
+    if (FrameJoinDefer(scheduler))
+    {
+      return 0;
+    }
+    #endif
+    
+    // A Gateway node will verify the link request and send a link request 
+    // response if the link request has been approved.
+    if (scheduler->LinkRequest != NULL)
+    {
+      accept = scheduler->LinkRequest(scheduler->rx->payload, 
+                                      scheduler->length);
+    }
+    
+    if (accept)
+    {
+      unsigned char *response = NULL;   // Response payload
+      unsigned char length = 0;
+      
+      // The link request has been accepted. Provide a response to the remote
+      // node.
+      scheduler->counters.linkAccepted++;
+      #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+      endPoint->state = ePhyAddressLinkEstablished;
+      #if defined( PROTOCOL_USE_COMPRESSED_HEADER ) || defined( PROTOCOL_USE_TDMA ) \
+          || defined( PROTOCOL_USE_JOIN_CONTROL ) || defined( PROTOCOL_USE_CODEC ) \
+          || defined( PROTOCOL_USE_SECURITY )
+      // The response tells the End Point its link identifier, slot, the 
+      // codecs decoded and the seed of its link key.
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_LINK] = PHY_ADDRESS_LINK_NONE;
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_SLOT] = PHY_ADDRESS_SLOT_NONE;
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_RETRY] = 0;
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_RETRY + 1] = 0;
+      #if defined( PROTOCOL_USE_CODEC )
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_CODECS] = scheduler->codec.enabled;
+      endPoint->codecLength = 0;
+      #endif
+      #if defined( PROTOCOL_USE_SECURITY )
+      FrameSecurityCounter(&scheduler->linkResponse[FRAME_LINK_RESPONSE_SEED], 0);
+      endPoint->flags &= ~PHY_ADDRESS_ENDPOINT_FLAG_SECURE;
+      if ((scheduler->security.key != NULL) && !scheduler->security.seeded)
+      {
+        // The first seed comes from the receiver noise, so that seeds are
+        // not issued again after a reset.
+        scheduler->security.seed = PhyGetEntropy(scheduler->phy);
+        scheduler->security.seeds = FRAME_SECURITY_COUNTER_MAX;
+        scheduler->security.seeded = true;
+      }
+      if ((scheduler->security.key != NULL) 
+          && (scheduler->security.seeds > 0))
+      {
+        scheduler->security.seeds--;
+        FrameSecurityCounter(&scheduler->linkResponse[FRAME_LINK_RESPONSE_SEED], 
+                             scheduler->security.seed++);
+        FrameSecurityDerive(scheduler, 
+                            &scheduler->linkResponse[FRAME_LINK_RESPONSE_SEED], 
+                            endPoint->address, 
+                            PhyAddressGetLocalInfo(scheduler->phyAddress)->address, 
+                            endPoint->securityKey);
+        endPoint->securityCounter = 0;
+        endPoint->flags |= PHY_ADDRESS_ENDPOINT_FLAG_SECURE;
+      }
+      #endif
+      #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_LINK] = PhyAddressEndPointLink(scheduler->phyAddress, endPoint);
+      #endif
+      #if defined( PROTOCOL_USE_TDMA )
+      scheduler->linkResponse[FRAME_LINK_RESPONSE_SLOT] = PhyAddressEndPointSlot(scheduler->phyAddress, 
+                                                                                 endPoint, 
+                                                                                 PROTOCOL_TDMA_SLOTS);
+      #endif
+      response = scheduler->linkResponse;
+      length = FRAME_LINK_RESPONSE_LENGTH;
+      #if defined( PROTOCOL_USE_SECURITY )
+      if (scheduler->security.key != NULL)
+      {
+        FrameSecurityResponse(scheduler, 
+                              PhyAddressGetLocalInfo(scheduler->phyAddress)->address, 
+                              response);
+        length = FRAME_LINK_RESPONSE_SIZE;
+      }
+      #endif
+      #endif
+      #endif
+      PhyEnable(scheduler->phy);
+      FrameSend(scheduler, eFrameTypeLinkRequest, false, response, length);
+    }
+    else
+    {
+      scheduler->counters.linkDenied++;
+    }
+  }
+
+  return 0;
+}
+
+#if defined( PROTOCOL_USE_SEGMENTATION )
+/**
+ *  FrameSchedulerFragment - scheduler operation to process all incoming 
+ *  fragments. The fragments of a message must arrive in order; the message is
+ *  passed up to the next layer once its last fragment has been received and 
+ *  its CRC is valid.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Status message from callee (currently not being used for frame 
+ *            use).
+ */
+unsigned char FrameSchedulerFragment(struct sFrameScheduler *scheduler)
+{
+  struct sFrameFragmentHeader *header = (struct sFrameFragmentHeader*)scheduler->rx->payload;
+  struct sFrameReassembly *reassembly;
+  unsigned char statusMessage = 0;
+  unsigned int size;
+  unsigned int crc;
+  
+  reassembly = FrameReassemblyGet(scheduler, 
+                                  scheduler->rx->header.srcAddr, 
+                                  (header->index == 0));
+  if ((reassembly == NULL) || (scheduler->length <= FRAME_FRAGMENT_HEADER_LENGTH))
+  {
+    // Error: no reassembly buffer available or the fragment is empty.
+    scheduler->counters.rxFragmentDrops++;
+    return 0;
+  }
+  size = scheduler->length - FRAME_FRAGMENT_HEADER_LENGTH;
+  
+  // The first fragment (re)starts the reassembly of its source's message.
+  if (header->index == 0)
+  {
+    PhyAddressCopy(reassembly->srcAddr, 
+                   scheduler->rx->header.srcAddr, 
+                   PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+    reassembly->tag = header->tag;
+    reassembly->next = 0;
+    reassembly->length = 0;
+    reassembly->active = true;
+  }
+  
+  // A fragment sent again because its acknowledgement was lost has already 
+  // been added. It is acknowledged again (see FrameAssemble); the reassembly 
+  // goes on.
+  if ((header->index != 0)
+      && (header->tag == reassembly->tag)
+      && ((header->index + 1) == reassembly->next))
+  {
+    if (!FrameAckOwed(scheduler))
+    {
+      FrameListen(scheduler);
+    }
+    return 0;
+  }
+  
+  // Abandon the message if a fragment is missing or the message is too large.
+  if ((header->tag != reassembly->tag)
+      || (header->index != reassembly->next)
+      || (header->index >= header->count)
+      || ((reassembly->length + size) > sizeof(reassembly->message)))
+  {
+    reassembly->active = false;
+    scheduler->counters.rxFragmentDrops++;
+    return 0;
+  }
+  
+  memcpy(&reassembly->message[reassembly->length], 
+         &scheduler->rx->payload[FRAME_FRAGMENT_HEADER_LENGTH], 
+         size);
+  reassembly->length += size;
+  reassembly->next++;
+  
+  if (reassembly->next < header->count)
+  {
+    // Keep listening for the next fragment (see FrameTick), unless the 
+    // fragment must be acknowledged first.
+    reassembly->timeout = PROTOCOL_SEGMENT_TIMEOUT;
+    PhyTimerStart(scheduler->phy);
+    if (!FrameAckOwed(scheduler))
+    {
+      FrameListen(scheduler);
+    }
+    return 0;
+  }
+  
+  // The last fragment has been received. Check the message CRC.
+  reassembly->timeout = 0;
+  if (reassembly->length < FRAME_FRAGMENT_CRC_LENGTH)
+  {
+    crc = 0;
+    scheduler->counters.rxFragmentCrcErrors++;
+  }
+  else
+  {
+    reassembly->length -= FRAME_FRAGMENT_CRC_LENGTH;
+    crc = ((unsigned int)reassembly->message[reassembly->length] << 8)
+          | reassembly->message[reassembly->length + 1];
+    
+    if (crc != FrameCrc16(reassembly->message, reassembly->length))
+    {
+      scheduler->counters.rxFragmentCrcErrors++;
+    }
+    else if (scheduler->FrameComplete != NULL)
+    {
+      bool dataRequest = false;
+      
+      // Only a Gateway may be requested data (with the last fragment).
+      if (FrameIsGateway(scheduler))
+      {
+        dataRequest = (scheduler->rx->header.control & FRAME_CONTROL_DATA_REQ) >> 1;
+      }
+      
+      // The message is only valid for the duration of the callback.
+      statusMessage = scheduler->FrameComplete(dataRequest,
+                                               reassembly->message, 
+                                               reassembly->length);
+      FrameSchedulerRespond(scheduler, dataRequest);
+    }
+  }
+  reassembly->active = false;
+  
+  return statusMessage;
+}
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+/**
+ *  FrameSchedulerAggregate - scheduler operation to process all incoming 
+ *  Aggregate frames. Each record is passed up to the next layer on its own; 
+ *  a malformed record ends the frame.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Status message from callee (currently not being used for frame 
+ *            use).
+ */
+unsigned char FrameSchedulerAggregate(struct sFrameScheduler *scheduler)
+{
+  unsigned char statusMessage = 0;
+  unsigned char index = 0;
+  
+  #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+  FrameLatencySample(scheduler);
+  #endif
+  while (index < scheduler->length)
+  {
+    unsigned char length = scheduler->rx->payload[index];
+    
+    index += FRAME_AGGREGATE_PREFIX_LENGTH;
+    if ((length == 0) || (length > (scheduler->length - index)))
+    {
+      scheduler->counters.rxRecordErrors++;
+      break;
+    }
+    
+    // The record is only valid for the duration of the callback; it is not 
+    // loaned from the receive buffer pool.
+    scheduler->counters.rxRecords++;
+    if (scheduler->FrameComplete != NULL)
+    {
+      statusMessage = scheduler->FrameComplete(false, 
+                                               &scheduler->rx->payload[index], 
+                                               length);
+    }
+    index += length;
+  }
+  
+  return statusMessage;
+}
+#endif
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+/**
+ *  FrameTxQueueComplete - retire the oldest request in the transmit queue and
+ *  notify the caller of its final status.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  status    Completion status (FRAME_TX_STATUS_x).
+ */
+void FrameTxQueueComplete(struct sFrameScheduler *scheduler,
+                          unsigned char status)
+{
+  struct sFrameTxQueue *queue = &scheduler->txQueue;
+  unsigned char handle = queue->request[queue->head].handle;
+  
+  queue->active = false;
+  queue->head = (queue->head + 1) % PROTOCOL_TX_QUEUE_SIZE;
+  queue->count--;
+  
+  if (queue->SubmitComplete != NULL)
+  {
+    queue->SubmitComplete(handle, status);
+  }
+}
+
+/**
+ *  FrameTxQueueService - send the oldest request in the transmit queue if the
+ *  scheduler is free. A request the physical layer refuses is retired with an
+ *  error so that it cannot stall the queue.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return True if a queued request is being serviced.
+ */
+bool FrameTxQueueService(struct sFrameScheduler *scheduler)
+{
+  struct sFrameTxQueue *queue = &scheduler->txQueue;
+  
+  while (!queue->active && (queue->count > 0) && !scheduler->busy)
+  {
+    struct sFrameTxRequest *request = &queue->request[queue->head];
+    
+    if (FrameCodecSend(scheduler, 
+                       request->dataRequest, 
+                       request->payload, 
+                       request->length))
+    {
+      queue->active = true;
+    }
+    else
+    {
+      FrameTxQueueComplete(scheduler, FRAME_TX_STATUS_ERROR);
+    }
+  }
+  
+  return queue->active;
+}
+#endif
+
+/**
+ *  FrameSchedulerNext - the current operation has finished. Send the next 
+ *  queued frame (if any) or perform the scheduler's idle operation.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameSchedulerNext(struct sFrameScheduler *scheduler)
+{
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  struct sFrameTxQueue *queue = &scheduler->txQueue;
+  #endif
+  
+  #if defined( PROTOCOL_USE_TDMA )
+  // A frame waiting for the slot of the local node keeps the scheduler busy.
+  if (scheduler->tdma.waiting)
+  {
+    scheduler->busy = true;
+    FrameIdle(scheduler);
+    return;
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK )
+  // Keep listening for the acknowledgement of the frame just sent.
+  if (scheduler->ack.active)
+  {
+    FrameListen(scheduler);
+    return;
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  if (queue->active)
+  {
+    // Keep listening for the response to the outstanding data request.
+    if (queue->request[queue->head].dataRequest)
+    {
+      FrameListen(scheduler);
+    }
+    return;
+  }
+  
+  if (FrameTxQueueService(scheduler))
+  {
+    return;
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_MAILBOX )
+  // Stay awake and request the messages the Gateway holds for the local node.
+  if (scheduler->mailbox.pending)
+  {
+    scheduler->mailbox.pending = false;
+    if (FrameSend(scheduler, eFrameTypeData, true, NULL, 0))
+    {
+      return;
+    }
+  }
+  #endif
+  
+  FrameIdle(scheduler);
+}
+
+#if defined( PROTOCOL_USE_SEGMENTATION )
+/**
+ *  FrameSegmentSend - send the next fragment of the message being segmented.
+ *  The message CRC follows the message data; the last fragment carries the 
+ *  data request.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Success of the fragment being sent.
+ */
+bool FrameSegmentSend(struct sFrameScheduler *scheduler)
+{
+  struct sFrameSegmenter *segmenter = &scheduler->segmenter;
+  struct sPhyDataSegment segment[3];
+  unsigned int total = segmenter->length + FRAME_FRAGMENT_CRC_LENGTH;
+  unsigned int end = segmenter->offset + FRAME_FRAGMENT_DATA_LENGTH;
+  unsigned char count = 1;
+  
+  if (end > total)
+  {
+    end = total;
+  }
+  
+  segment[0].data = (unsigned char*)&segmenter->header;
+  segment[0].length = FRAME_FRAGMENT_HEADER_LENGTH;
+  
+  // Message data carried by the fragment.
+  if (segmenter->offset < segmenter->length)
+  {
+    segment[count].data = &segmenter->payload[segmenter->offset];
+    segment[count].length = (unsigned char)(((end < segmenter->length) ? end : segmenter->length) - segmenter->offset);
+    count++;
+  }
+  
+  // Message CRC bytes carried by the fragment.
+  if (end > segmenter->length)
+  {
+    unsigned int crcOffset = (segmenter->offset > segmenter->length) ? (segmenter->offset - segmenter->length) : 0;
+    
+    segment[count].data = &segmenter->crc[crcOffset];
+    segment[count].length = (unsigned char)(end - segmenter->length - crcOffset);
+    count++;
+  }
+  
+  if (FrameSendv(scheduler, 
+                 eFrameTypeFragment, 
+                 segmenter->dataRequest && (end == total), 
+                 segment, 
+                 count))
+  {
+    segmenter->offset = end;
+    return true;
+  }
+  
+  return false;
+}
+
+/**
+ *  FrameSegmentStart - start sending a message as fragments.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  dataRequest Data request sent with the last fragment.
+ *    @param  payload     Location of the message.
+ *    @param  length      Number of bytes in the message.
+ *
+ *    @return Success of the first fragment being sent.
+ */
+bool FrameSegmentStart(struct sFrameScheduler *scheduler,
+                       bool dataRequest,
+                       unsigned char *payload,
+                       unsigned int length)
+{
+  struct sFrameSegmenter *segmenter = &scheduler->segmenter;
+  unsigned int crc;
+  
+  if (scheduler->busy || segmenter->active)
+  {
+    // Error: the frame scheduler is currently busy.
+    scheduler->counters.txBusy++;
+    return false;
+  }
+  
+  if (length > PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH)
+  {
+    // Error: the message is too large.
+    return false;
+  }
+  
+  crc = FrameCrc16(payload, length);
+  segmenter->payload = payload;
+  segmenter->length = length;
+  segmenter->offset = 0;
+  segmenter->crc[0] = (unsigned char)(crc >> 8);
+  segmenter->crc[1] = (unsigned char)crc;
+  segmenter->dataRequest = dataRequest;
+  segmenter->header.tag++;
+  segmenter->header.index = 0;
+  segmenter->header.count = (unsigned char)((length + FRAME_FRAGMENT_CRC_LENGTH + FRAME_FRAGMENT_DATA_LENGTH - 1) / FRAME_FRAGMENT_DATA_LENGTH);
+  
+  // The segmenter is active before the first fragment completes.
+  segmenter->active = true;
+  if (!FrameSegmentSend(scheduler))
+  {
+    segmenter->active = false;
+    return false;
+  }
+  
+  return true;
+}
+
+/**
+ *  FrameSegmentNext - a fragment has been sent. Send the next fragment of the 
+ *  message, if any.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return True if the transmission has been handled; false once the last 
+ *            fragment has been sent and the message is complete.
+ */
+bool FrameSegmentNext(struct sFrameScheduler *scheduler)
+{
+  struct sFrameSegmenter *segmenter = &scheduler->segmenter;
+  
+  if (segmenter->offset >= (segmenter->length + FRAME_FRAGMENT_CRC_LENGTH))
+  {
+    segmenter->active = false;
+    return false;
+  }
+  
+  segmenter->header.index++;
+  if (!FrameSegmentSend(scheduler))
+  {
+    // Error: the fragment could not be sent; the message is abandoned.
+    segmenter->active = false;
+    FrameSchedulerNext(scheduler);
+  }
+  
+  return true;
+}
+#endif
+
+/**
+ *  FrameTransmitted - the frame just sent has completed (and has been 
+ *  acknowledged, if requested). Send the next fragment, listen for the 
+ *  response to a data request or complete the transfer.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  response  A response to a data request is still expected.
+ *
+ *    @return Status message from callee (currently not being used for frame 
+ *            use).
+ */
+unsigned char FrameTransmitted(struct sFrameScheduler *scheduler,
+                               bool response)
+{
+  unsigned char statusMessage = 0;
+  
+  #if defined( PROTOCOL_USE_MAILBOX )
+  if (scheduler->mailbox.sending != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    FrameMailComplete(scheduler, FRAME_TX_STATUS_SUCCESS);
+  }
+  #endif
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  // The buffer just sent may be filled again.
+  scheduler->aggregator.sending = false;
+  #endif
+  
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  // Send the remaining fragments of the message before completing it.
+  if (scheduler->segmenter.active && FrameSegmentNext(scheduler))
+  {
+    return 0;
+  }
+  #endif
+
+  // Check if the data transfer requires a response.
+  if (response && (scheduler->frame.header.control & FRAME_CONTROL_DATA_REQ))
+  {
+    // Begin listening for a response (data or data + ACK). Filter on the 
+    // destination address of the frame just sent.
+    if (!FrameListen(scheduler))
+    {
+      FrameIdle(scheduler);
+    }
+    return 0;
+  }
+  
+  // Clear the size of the buffer for the next RX or TX payload.
+  scheduler->length = 0;
+
+  // Invoke the data complete callback.
+  if (scheduler->FrameComplete != NULL)
+  {
+    statusMessage = scheduler->FrameComplete(false, NULL, 0);
+  }
+  
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  if (scheduler->txQueue.active)
+  {
+    FrameTxQueueComplete(scheduler, FRAME_TX_STATUS_SUCCESS);
+  }
+  #endif
+  
+  FrameSchedulerNext(scheduler);
+  
+  return statusMessage;
+}
+
+/**
+ *  FrameTransmit - hand a frame to the physical layer. With CSMA-CA, a frame 
+ *  refused on a busy channel is sent again after a random number of backoff 
+ *  slots (see FrameTick); the backoff window doubles with every backoff.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  stream    Data stream of the frame (header first).
+ *    @param  count     Number of segments in the data stream.
+ *
+ *    @return FRAME_TX_STATUS_SUCCESS if the frame was sent or will be sent 
+ *            after a backoff, otherwise the reason of the failure.
+ */
+unsigned char FrameTransmit(struct sFrameScheduler *scheduler,
+                            const struct sPhyDataSegment *stream,
+                            unsigned char count)
+{
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  // The response to a data request may follow the request immediately; the 
+  // radio enters RX on its own once the request is sent.
+  PhySetTurnaround(scheduler->phy, 
+                   !FrameIsGateway(scheduler) 
+                   && (stream[0].data[FRAME_HEADER_CONTROL_OFFSET] & FRAME_CONTROL_DATA_REQ));
+  #endif
+  
+  if (PhyTransmitv(scheduler->phy, stream, count))
+  {
+    scheduler->counters.txFrames++;
+    return FRAME_TX_STATUS_SUCCESS;
+  }
+  
+  #if defined( PROTOCOL_USE_CSMA )
+  if (PhyChannelBusy(scheduler->phy))
+  {
+    scheduler->counters.txCcaBusy++;
+    
+    if (scheduler->csma.backoffs < PROTOCOL_CSMA_MAX_BACKOFFS)
+    {
+      unsigned char exponent = PROTOCOL_CSMA_MIN_BE + scheduler->csma.backoffs;
+      
+      if (exponent > PROTOCOL_CSMA_MAX_BE)
+      {
+        exponent = PROTOCOL_CSMA_MAX_BE;
+      }
+      
+      // The frame is sent again from the retry data stream.
+      scheduler->csma.backoffs++;
+      scheduler->csma.timeout = (FrameRandom(scheduler) % (1u << exponent)) * PROTOCOL_CSMA_SLOT + 1;
+      scheduler->csma.active = true;
+      PhyTimerStart(scheduler->phy);
+      return FRAME_TX_STATUS_SUCCESS;
+    }
+    
+    // Error: the channel was busy after every backoff.
+    scheduler->counters.txChannelFailures++;
+    return FRAME_TX_STATUS_CHANNEL_BUSY;
+  }
+  #endif
+  
+  // Error: physical layer was unable to perform the transmission.
+  return FRAME_TX_STATUS_ERROR;
+}
+
+#if defined( PROTOCOL_USE_ACK )
+/**
+ *  FrameAckBackoff - draw a random backoff for the next retransmission. The 
+ *  window doubles with every retry.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Backoff in milliseconds.
+ */
+unsigned int FrameAckBackoff(struct sFrameScheduler *scheduler)
+{
+  return FrameRandom(scheduler) % ((unsigned int)PROTOCOL_ACK_BACKOFF << scheduler->ack.attempt);
+}
+
+/**
+ *  FrameAckComplete - the frame waiting for its acknowledgement has either 
+ *  been acknowledged or exhausted its retries.
+ *
+ *    @param  scheduler     Frame scheduler.
+ *    @param  acknowledged  The frame was acknowledged.
+ */
+void FrameAckComplete(struct sFrameScheduler *scheduler,
+                      bool acknowledged)
+{
+  scheduler->ack.active = false;
+  
+  if (!acknowledged)
+  {
+    scheduler->counters.txAckFailures++;
+  }
+  
+  if (scheduler->ack.AckComplete != NULL)
+  {
+    scheduler->ack.AckComplete(acknowledged);
+  }
+}
+#endif
+
+#if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_TDMA )
+/**
+ *  FrameSendFailed - a frame accepted by FrameSendv could not be sent again 
+ *  (busy channel or no acknowledgement) or in its slot. The frame is dropped and the 
+ *  scheduler moves on.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  status    Reason of the failure (FRAME_TX_STATUS_x).
+ */
+void FrameSendFailed(struct sFrameScheduler *scheduler,
+                     unsigned char status)
+{
+  #if !defined( PROTOCOL_USE_TX_QUEUE ) && !defined( PROTOCOL_USE_MAILBOX )
+  // Only the senders of queued frames and mail are told the reason.
+  (void)status;
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK )
+  if (scheduler->ack.active)
+  {
+    FrameAckComplete(scheduler, false);
+  }
+  #endif
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  // The rest of the message is abandoned.
+  scheduler->segmenter.active = false;
+  #endif
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  if (scheduler->txQueue.active)
+  {
+    FrameTxQueueComplete(scheduler, status);
+  }
+  #endif
+  #if defined( PROTOCOL_USE_MAILBOX )
+  if (scheduler->mailbox.sending != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    FrameMailComplete(scheduler, status);
+  }
+  #endif
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  // The records of a dropped Aggregate frame are lost.
+  scheduler->aggregator.sending = false;
+  #endif
+  #if defined( PROTOCOL_USE_TDMA )
+  scheduler->tdma.beacon = false;
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  // The Gateway may have missed the reference; the next message is a key.
+  scheduler->codec.keyCount = 0;
+  #endif
+  
+  scheduler->busy = false;
+  FrameSchedulerNext(scheduler);
+}
+#endif
+
+#if defined( PROTOCOL_USE_ACK )
+
+/**
+ *  FrameAckTimeout - the frame has not been acknowledged in time. Send it 
+ *  again, or give up once every retry has been used.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameAckTimeout(struct sFrameScheduler *scheduler)
+{
+  unsigned char status = FRAME_TX_STATUS_NO_ACK;
+  
+  if (scheduler->ack.attempt < PROTOCOL_ACK_MAX_RETRIES)
+  {
+    scheduler->ack.attempt++;
+    #if defined( PROTOCOL_USE_CSMA )
+    scheduler->csma.backoffs = 0;
+    #endif
+    
+    // The frame header and payload are unchanged; the receiver sees the same
+    // sequence number. It is sent again in the next slot of the local node.
+    status = FrameTdmaHold(scheduler) ? FRAME_TX_STATUS_SUCCESS 
+                                      : FrameTransmit(scheduler, scheduler->retry.stream, scheduler->retry.count);
+    if (status == FRAME_TX_STATUS_SUCCESS)
+    {
+      scheduler->counters.txRetries++;
+      return;
+    }
+  }
+  
+  // Error: the frame was not acknowledged.
+  FrameSendFailed(scheduler, status);
+}
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+/**
+ *  FrameTdmaTick - advance the superframe by one millisecond. A Gateway sends
+ *  the beacon once every slot has passed. An End Point sends the frame held 
+ *  for its slot and wakes up ahead of the beacon; the timing is lost after
+ *  PROTOCOL_TDMA_MAX_MISSES beacons are missed in a row.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameTdmaTick(struct sFrameScheduler *scheduler)
+{
+  struct sFrameTdma *tdma = &scheduler->tdma;
+  bool send = false;
+  
+  if (!tdma->synced)
+  {
+    return;
+  }
+  
+  if (FrameIsGateway(scheduler))
+  {
+    // The beacon is late rather than cutting short a frame being sent.
+    if (tdma->clock < FRAME_TDMA_BEACON_TIME)
+    {
+      tdma->clock++;
+    }
+    else if (!scheduler->busy || scheduler->listening)
+    {
+      FrameTdmaBeacon(scheduler);
+    }
+    return;
+  }
+  
+  tdma->clock++;
+  if (tdma->waiting && (tdma->clock == FRAME_TDMA_SLOT_START(tdma->slot)))
+  {
+    send = true;
+  }
+  else if (tdma->clock == (FRAME_TDMA_BEACON_TIME - PROTOCOL_TDMA_GUARD))
+  {
+    tdma->window = true;
+    if (!scheduler->busy || tdma->waiting)
+    {
+      FrameIdle(scheduler);
+    }
+  }
+  else if (tdma->clock >= (FRAME_TDMA_BEACON_TIME + PROTOCOL_TDMA_SLOT_LENGTH))
+  {
+    // The beacon was missed. The superframe is timed from when it was due.
+    scheduler->counters.rxBeaconMisses++;
+    tdma->clock = PROTOCOL_TDMA_SLOT_LENGTH;
+    if (++tdma->misses < PROTOCOL_TDMA_MAX_MISSES)
+    {
+      tdma->window = false;
+      if (!scheduler->busy || tdma->waiting)
+      {
+        FrameIdle(scheduler);
+      }
+    }
+    else
+    {
+      // Keep listening for the beacon; frames are sent at once meanwhile.
+      tdma->synced = false;
+      send = tdma->waiting;
+    }
+  }
+  
+  if (send)
+  {
+    unsigned char status;
+    
+    tdma->waiting = false;
+    status = FrameTransmit(scheduler, scheduler->retry.stream, scheduler->retry.count);
+    if (status != FRAME_TX_STATUS_SUCCESS)
+    {
+      FrameSendFailed(scheduler, status);
+    }
+  }
+}
+#endif
+
+// -----------------------------------------------------------------------------
+/**
+ *  Public interface
+ */
+
+// -----------------------------------------------------------------------------
+// Frame configuration
+
+void FrameInit(struct sFrameScheduler *scheduler,
+               struct sPhyAddressInfo *phyAddress,
+               struct sPhyDevice *phy,
+               unsigned char mode,
+               unsigned char(*FrameComplete)(bool, unsigned char*, unsigned int),
+               bool(*LinkRequest)(unsigned char *payload, unsigned char length))
+{
+  scheduler->mode = mode & FRAME_CONTROL_MODE;
+  scheduler->phyAddress = phyAddress;
+  scheduler->phy = phy;
+  scheduler->busy = false;
+  scheduler->listening = false;
+  scheduler->seqNumber = 0;
+  FrameClearCounters(scheduler);
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  scheduler->link = PHY_ADDRESS_LINK_NONE;
+  scheduler->txLink = PHY_ADDRESS_LINK_NONE;
+  #endif
+  scheduler->FrameComplete = FrameComplete;
+  #if defined( PROTOCOL_USE_RX_POOL )
+  {
+    unsigned char i;
+    
+    for (i = 0; i < PROTOCOL_RX_POOL_SIZE; i++)
+    {
+      scheduler->rxPool.loaned[i] = false;
+    }
+    scheduler->rxPool.starved = false;
+    scheduler->rx = &scheduler->rxPool.frame[0];
+  }
+  #else
+  scheduler->rx = &scheduler->frame;
+  #endif
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  {
+    unsigned char i;
+    
+    for (i = 0; i < PROTOCOL_SEGMENT_BUFFERS; i++)
+    {
+      scheduler->reassembly[i].active = false;
+    }
+    scheduler->segmenter.active = false;
+    scheduler->segmenter.header.tag = 0;
+  }
+  #endif
+  #if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_JOIN_CONTROL )
+  {
+    const unsigned char *address = PhyAddressGetLocalInfo(phyAddress)->address;
+    unsigned char i;
+    
+    // Seed the backoff generator from the local address so that nodes which 
+    // collided do not retry in step. The LFSR state must not be zero.
+    scheduler->retry.random = 0xACE1u;
+    for (i = 0; i < PROTOCOL_PHYADDRESS_ADDRESS_SIZE; i++)
+    {
+      scheduler->retry.random = (scheduler->retry.random << 3) ^ (scheduler->retry.random >> 13) ^ address[i];
+    }
+    scheduler->retry.random &= 0xFFFFu;
+    if (scheduler->retry.random == 0)
+    {
+      scheduler->retry.random = 0xACE1u;
+    }
+  }
+  #endif
+  #if defined( PROTOCOL_USE_CSMA )
+  scheduler->csma.active = false;
+  #endif
+  #if defined( PROTOCOL_USE_ACK )
+  scheduler->ack.active = false;
+  scheduler->ack.owed = false;
+  #endif
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER )
+  {
+    unsigned char i;
+    
+    for (i = 0; i < PROTOCOL_DUPLICATE_CACHE_SIZE; i++)
+    {
+      scheduler->duplicate[i].valid = false;
+    }
+  }
+  #endif
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER ) || defined( PROTOCOL_USE_SECURITY )
+  scheduler->lastResponse.valid = false;
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  scheduler->codec.accepted = 0;
+  scheduler->codec.next = FRAME_CODEC_HEADER(CODEC_ID_NONE, FRAME_CODEC_GENERATION_NONE);
+  scheduler->codec.header = scheduler->codec.next;
+  scheduler->codec.generation = FRAME_CODEC_GENERATION_NONE;
+  scheduler->codec.keyCount = 0;
+  scheduler->codec.length = 0;
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  scheduler->security.txCounter = 0;
+  scheduler->security.seed = 0;
+  scheduler->security.seeds = 0;
+  scheduler->security.seeded = false;
+  scheduler->security.seedUsed = false;
+  scheduler->security.linking = false;
+  memset(scheduler->security.challenge, 0, FRAME_SECURITY_CHALLENGE_LENGTH);
+  scheduler->security.rxCounter = 0;
+  scheduler->security.linked = false;
+  scheduler->security.replayed = false;
+  scheduler->security.cached = NULL;
+  #endif
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  scheduler->aggregator.fill = 0;
+  scheduler->aggregator.length = 0;
+  scheduler->aggregator.count = 0;
+  scheduler->aggregator.sending = false;
+  scheduler->aggregator.timeout = 0;
+  #endif
+  #if defined( PROTOCOL_USE_TDMA )
+  // A Gateway starts beaconing at once; an End Point waits for a slot.
+  scheduler->tdma.synced = FrameIsGateway(scheduler);
+  scheduler->tdma.beacon = false;
+  scheduler->tdma.window = false;
+  scheduler->tdma.waiting = false;
+  scheduler->tdma.slot = PHY_ADDRESS_SLOT_NONE;
+  scheduler->tdma.misses = 0;
+  scheduler->tdma.clock = 0;
+  if (FrameIsGateway(scheduler))
+  {
+    PhyTimerStart(phy);
+  }
+  #endif
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  scheduler->join.attempt = 0;
+  scheduler->join.admitted = 0;
+  scheduler->join.backlog = 0;
+  scheduler->join.timeout = 0;
+  #endif
+  #if defined( PROTOCOL_USE_MULTICAST )
+  scheduler->multicast.groups = 0;
+  scheduler->multicast.sending = false;
+  #if defined( PROTOCOL_USE_TDMA )
+  scheduler->multicast.waiting = false;
+  #endif
+  #endif
+  scheduler->LinkRequest = LinkRequest;
+  FrameSetDataResponse(scheduler, NULL, 0);
+  // By default, an End Point will be in low power mode and a Gateway will be
+  // in listen mode.
+  FrameIdle(scheduler);
+}
+
+struct sFrame* FrameGetInfo(struct sFrameScheduler *scheduler)
+{
+  return scheduler->rx;
+}
+
+const struct sFrameCounters* FrameGetCounters(struct sFrameScheduler *scheduler)
+{
+  return &scheduler->counters;
+}
+
+void FrameClearCounters(struct sFrameScheduler *scheduler)
+{
+  memset(&scheduler->counters, 0, sizeof(scheduler->counters));
+}
+                 
+void FrameSetDataResponse(struct sFrameScheduler *scheduler,
+                          unsigned char *payload, 
+                          unsigned char length)
+{
+  scheduler->dataResponse.payload = payload;
+  scheduler->dataResponse.length = length;
+}
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+void FrameTxQueueInit(struct sFrameScheduler *scheduler,
+                      void(*SubmitComplete)(unsigned char, unsigned char))
+{
+  scheduler->txQueue.head = 0;
+  scheduler->txQueue.count = 0;
+  scheduler->txQueue.nextHandle = FRAME_TX_HANDLE_INVALID;
+  scheduler->txQueue.active = false;
+  scheduler->txQueue.SubmitComplete = SubmitComplete;
+}
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+void FrameMailboxInit(struct sFrameScheduler *scheduler,
+                      void(*PostComplete)(unsigned char, unsigned char))
+{
+  struct sFrameMailbox *mailbox = &scheduler->mailbox;
+  unsigned char i;
+  
+  // Every message is free.
+  for (i = 0; i < PROTOCOL_MAILBOX_SIZE; i++)
+  {
+    mailbox->mail[i].next = i + 1;
+  }
+  mailbox->mail[PROTOCOL_MAILBOX_SIZE - 1].next = PHY_ADDRESS_ENDPOINT_NONE;
+  mailbox->free = 0;
+  mailbox->sending = PHY_ADDRESS_ENDPOINT_NONE;
+  mailbox->nextHandle = FRAME_MAIL_HANDLE_INVALID;
+  mailbox->pending = false;
+  mailbox->PostComplete = PostComplete;
+}
+#endif
+
+#if defined( PROTOCOL_USE_ACK )
+void FrameAckInit(struct sFrameScheduler *scheduler,
+                  bool enable,
+                  void(*AckComplete)(bool))
+{
+  scheduler->ack.enable = enable;
+  scheduler->ack.active = false;
+  scheduler->ack.owed = false;
+  scheduler->ack.AckComplete = AckComplete;
+}
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+void FrameCodecInit(struct sFrameScheduler *scheduler,
+                    unsigned char codecs)
+{
+  scheduler->codec.enabled = codecs & (CODEC_SET_DELTA | CODEC_SET_LZ);
+}
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+void FrameSecurityInit(struct sFrameScheduler *scheduler,
+                       const unsigned char *key)
+{
+  scheduler->security.key = key;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Frame basic operations
+
+void FrameIdle(struct sFrameScheduler *scheduler)
+{
+  if (FrameIsGateway(scheduler))
+  {
+    PhyDisable(scheduler->phy);
+    FrameListen(scheduler);
+  }
+  else
+  {
+    #if defined( PROTOCOL_USE_TDMA )
+    // An End Point listens while it waits for a beacon.
+    if (scheduler->tdma.window)
+    {
+      FrameTdmaListen(scheduler);
+      return;
+    }
+    #endif
+    PhyLowPowerMode(scheduler->phy);
+  }
+}
+
+bool FrameListen(struct sFrameScheduler *scheduler)
+{
+  if (!scheduler->busy)
+  {
+    #if defined( PROTOCOL_USE_RX_POOL )
+    struct sFrame *frame = FrameRxPoolGet(scheduler);
+    
+    if (frame == NULL)
+    {
+      // Every receive buffer is loaned out. The receiver is turned on again 
+      // once a buffer is released.
+      scheduler->rxPool.starved = true;
+      return false;
+    }
+    #else
+    struct sFrame *frame = &scheduler->frame;
+    #endif
+    
+    scheduler->busy = true;
+    scheduler->listening = true;
+    PhyReceiverOn(scheduler->phy, (unsigned char*)frame);
+    
+    return true;
+  }
+  
+  return false;
+}
+
+bool FrameSend(struct sFrameScheduler *scheduler,
+               enum eFrameType type,
+               bool dataRequest,
+               unsigned char *payload, 
+               unsigned char length)
+{
+  struct sPhyDataSegment segment;
+  
+  segment.data = payload;
+  segment.length = length;
+  
+  return FrameSendv(scheduler, type, dataRequest, &segment, 1);
+}
+
+bool FrameSendv(struct sFrameScheduler *scheduler,
+                enum eFrameType type,
+                bool dataRequest,
+                const struct sPhyDataSegment *segment,
+                unsigned char count)
+{
+  if (!scheduler->busy)
+  {
+    struct sPhyDataSegment stream[PROTOCOL_FRAME_MAX_SEGMENTS + FRAME_HEADER_SEGMENTS];
+    unsigned int length = 0;
+    unsigned char i;
+    #if defined( PROTOCOL_USE_SECURITY )
+    bool secure;
+    #endif
+    
+    if (count > PROTOCOL_FRAME_MAX_SEGMENTS)
+    {
+      // Error: too many payload segments.
+      return false;
+    }
+    
+    // The frame header is the first segment of the data stream, followed by
+    // the payload segments.
+    stream[0].data = (unsigned char*)&scheduler->frame.header;
+    stream[0].length = FRAME_HEADER_LENGTH;
+    for (i = 0; i < count; i++)
+    {
+      stream[i + FRAME_HEADER_SEGMENTS] = segment[i];
+      length += segment[i].length;
+    }
+    count += FRAME_HEADER_SEGMENTS;
+    
+    #if defined( PROTOCOL_USE_CODEC )
+    // The data frames of an End Point start with the codec header (see 
+    // FrameCodecSend).
+    scheduler->codec.header = scheduler->codec.next;
+    scheduler->codec.next = FRAME_CODEC_HEADER(CODEC_ID_NONE, FRAME_CODEC_GENERATION_NONE);
+    stream[FRAME_HEADER_SEGMENTS - 1].data = &scheduler->codec.header;
+    stream[FRAME_HEADER_SEGMENTS - 1].length = 0;
+    if ((type == eFrameTypeData) && !FrameIsGateway(scheduler))
+    {
+      stream[FRAME_HEADER_SEGMENTS - 1].length = FRAME_CODEC_HEADER_LENGTH;
+      length += FRAME_CODEC_HEADER_LENGTH;
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_SECURITY )
+    // A secured payload is followed by its frame counter and MIC.
+    secure = FrameSecured(scheduler, type);
+    if (secure)
+    {
+      length += FRAME_SECURITY_LENGTH;
+    }
+    #endif
+
+    // Transmit the frame.
+    if ((length + FRAME_OVERHEAD_LENGTH) <= PROTOCOL_DATASTREAM_MAX_SIZE)
+    {
+      // Build the frame.
+      FrameBuild(scheduler, type, dataRequest, (unsigned char)length);
+      
+      #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+      // A compressed header is sent up to the sequence number, followed by the
+      // link identifier (an empty segment for a full header).
+      stream[1].data = &scheduler->txLink;
+      stream[1].length = 0;
+      if (scheduler->frame.header.control & FRAME_CONTROL_COMPRESSED)
+      {
+        stream[0].length = FRAME_HEADER_COMPRESSED_LENGTH - FRAME_HEADER_LINK_LENGTH;
+        stream[1].length = FRAME_HEADER_LINK_LENGTH;
+      }
+      #endif
+      
+      #if defined( PROTOCOL_USE_SECURITY )
+      scheduler->frame.header.control &= ~FRAME_CONTROL_SECURE;
+      if (secure && !FrameSecure(scheduler, stream, &count, length))
+      {
+        // Error: the frame cannot be secured.
+        return false;
+      }
+      #endif
+      
+      #if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_TDMA )
+      // Keep the data stream; it is sent again if the channel is busy or 
+      // until it is acknowledged, or sent later in the slot of the local node.
+      scheduler->retry.header = scheduler->frame.header;
+      memcpy(scheduler->retry.stream, stream, count * sizeof(stream[0]));
+      scheduler->retry.stream[0].data = (unsigned char*)&scheduler->retry.header;
+      scheduler->retry.count = count;
+      #endif
+      #if defined( PROTOCOL_USE_CSMA )
+      scheduler->csma.backoffs = 0;
+      #endif
+      #if defined( PROTOCOL_USE_ACK )
+      if (!FrameIsGateway(scheduler) 
+          && (scheduler->frame.header.control & FRAME_CONTROL_ACK_REQ))
+      {
+        scheduler->ack.attempt = 0;
+        scheduler->ack.timeout = 0;
+        scheduler->ack.active = true;
+      }
+      #endif
+      
+      if (FrameTdmaHold(scheduler) 
+          || (FrameTransmit(scheduler, stream, count) == FRAME_TX_STATUS_SUCCESS))
+      {
+        // The frame scheduler is only busy if the physical layer has accepted
+        // to transmit the frame (or it is backing off a busy channel, or 
+        // holding the frame for its slot).
+        scheduler->busy = true;
+        return true;
+      }
+      else
+      {
+        // Error: physical layer was unable to perform the transmission.
+        #if defined( PROTOCOL_USE_ACK )
+        scheduler->ack.active = false;
+        #endif
+        return false;
+      }
+    }
+    else
+    {
+      // Error: the frame is too large. Larger messages must be sent through
+      // FrameSendMessage, which sends them as fragments.
+      return false;
+    }
+  }
+  
+  // Error: the frame scheduler is currently busy.
+  scheduler->counters.txBusy++;
+  return false;
+}
+
+bool FrameConnect(struct sFrameScheduler *scheduler,
+                  unsigned char *payload,
+                  unsigned char length)
+{
+  struct sPhyDataSegment segment[2];
+  unsigned char count = 1;
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  struct sFrameJoin *join = &scheduler->join;
+  unsigned char exponent;
+  
+  // Wait for the backoff of the last link request to elapse.
+  if (join->timeout > 0)
+  {
+    return false;
+  }
+  #endif
+  
+  segment[0].data = payload;
+  segment[0].length = length;
+  #if defined( PROTOCOL_USE_SECURITY )
+  // A new challenge follows the payload, so that no earlier response answers
+  // this link request. The first one comes from the receiver noise. No 
+  // challenge is drawn while the scheduler is busy (the link request would be
+  // refused).
+  if ((scheduler->security.key != NULL) && !scheduler->busy)
+  {
+    if (!scheduler->security.seeded)
+    {
+      FrameSecurityCounter(scheduler->security.challenge, PhyGetEntropy(scheduler->phy));
+      scheduler->security.seeded = true;
+    }
+    else
+    {
+      FrameSecurityCounter(scheduler->security.challenge, 
+                           FrameSecurityReadCounter(scheduler->security.challenge) + 1);
+    }
+    segment[1].data = scheduler->security.challenge;
+    segment[1].length = FRAME_SECURITY_CHALLENGE_LENGTH;
+    count = 2;
+  }
+  #endif
+  
+  if (!FrameSendv(scheduler, eFrameTypeLinkRequest, true, segment, count))
+  {
+    return false;
+  }
+  #if defined( PROTOCOL_USE_SECURITY )
+  scheduler->security.linking = true;
+  #endif
+  
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  // The backoff window doubles with every link request left unanswered.
+  exponent = (join->attempt < PROTOCOL_JOIN_MAX_BE) ? join->attempt : PROTOCOL_JOIN_MAX_BE;
+  FrameJoinBackoff(scheduler, 0, (unsigned int)PROTOCOL_JOIN_BACKOFF << exponent);
+  if (join->attempt < 0xFF)
+  {
+    join->attempt++;
+  }
+  #endif
+  
+  return true;
+}
+
+bool FrameSendMessage(struct sFrameScheduler *scheduler,
+                      bool dataRequest,
+                      unsigned char *payload,
+                      unsigned int length)
+{
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  // The message does not fit in one frame (or in the receiver's frame buffer).
+  if (((length + FrameCodecLength(scheduler) + FrameSecurityLength(scheduler)) > PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH)
+      || ((length + FrameCodecLength(scheduler) + FrameSecurityLength(scheduler) + FRAME_OVERHEAD_LENGTH) > PROTOCOL_DATASTREAM_MAX_SIZE))
+  {
+    return FrameSegmentStart(scheduler, dataRequest, payload, length);
+  }
+  #else
+  if ((length + FrameCodecLength(scheduler) + FrameSecurityLength(scheduler) + FRAME_OVERHEAD_LENGTH) > PROTOCOL_DATASTREAM_MAX_SIZE)
+  {
+    // Error: the message does not fit in one frame.
+    return false;
+  }
+  #endif
+  
+  return FrameCodecSend(scheduler, dataRequest, payload, (unsigned char)length);
+}
+
+#if defined( PROTOCOL_USE_RX_POOL )
+bool FrameReleaseBuffer(struct sFrameScheduler *scheduler,
+                        unsigned char *payload)
+{
+  unsigned char i;
+  
+  for (i = 0; i < PROTOCOL_RX_POOL_SIZE; i++)
+  {
+    if (payload == scheduler->rxPool.frame[i].payload)
+    {
+      scheduler->rxPool.loaned[i] = false;
+      
+      // Resume the operation that could not get a receive buffer.
+      if (scheduler->rxPool.starved && !scheduler->busy)
+      {
+        scheduler->rxPool.starved = false;
+        FrameSchedulerNext(scheduler);
+      }
+      return true;
+    }
+  }
+  
+  // Error: the payload does not belong to the receive buffer pool.
+  return false;
+}
+#endif
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+unsigned char FrameSubmit(struct sFrameScheduler *scheduler,
+                          bool dataRequest,
+                          unsigned char *payload,
+                          unsigned char length)
+{
+  struct sFrameTxQueue *queue = &scheduler->txQueue;
+  struct sFrameTxRequest *request;
+  unsigned char handle;
+  
+  if ((queue->count >= PROTOCOL_TX_QUEUE_SIZE)
+      || ((length + FrameCodecLength(scheduler) + FrameSecurityLength(scheduler) + FRAME_OVERHEAD_LENGTH) > PROTOCOL_DATASTREAM_MAX_SIZE))
+  {
+    return FRAME_TX_HANDLE_INVALID;
+  }
+  
+  // Handles wrap around but never take the invalid value.
+  if (++queue->nextHandle == FRAME_TX_HANDLE_INVALID)
+  {
+    ++queue->nextHandle;
+  }
+  handle = queue->nextHandle;
+  
+  request = &queue->request[(queue->head + queue->count) % PROTOCOL_TX_QUEUE_SIZE];
+  request->handle = handle;
+  request->dataRequest = dataRequest;
+  request->payload = payload;
+  request->length = length;
+  queue->count++;
+  
+  // Send the request right away if the scheduler is free.
+  FrameTxQueueService(scheduler);
+  
+  return handle;
+}
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+unsigned char FramePost(struct sFrameScheduler *scheduler,
+                        const unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                        unsigned char *payload,
+                        unsigned char length)
+{
+  struct sFrameMailbox *mailbox = &scheduler->mailbox;
+  struct sPhyAddressEndPoint *endPoint;
+  struct sFrameMail *mail;
+  unsigned char *link;
+  unsigned char index;
+  
+  if (!FrameIsGateway(scheduler)
+      || (mailbox->free == PHY_ADDRESS_ENDPOINT_NONE)
+      || ((length + FrameSecurityLength(scheduler) + FRAME_OVERHEAD_LENGTH) > PROTOCOL_DATASTREAM_MAX_SIZE))
+  {
+    return FRAME_MAIL_HANDLE_INVALID;
+  }
+  
+  // The End Point may not have been heard yet.
+  endPoint = PhyAddressEndPointAdd(scheduler->phyAddress, address);
+  if (endPoint == NULL)
+  {
+    return FRAME_MAIL_HANDLE_INVALID;
+  }
+  
+  // Handles wrap around but never take the invalid value.
+  if (++mailbox->nextHandle == FRAME_MAIL_HANDLE_INVALID)
+  {
+    ++mailbox->nextHandle;
+  }
+  
+  index = mailbox->free;
+  mail = &mailbox->mail[index];
+  mailbox->free = mail->next;
+  mail->handle = mailbox->nextHandle;
+  mail->payload = payload;
+  mail->length = length;
+  mail->next = PHY_ADDRESS_ENDPOINT_NONE;
+  
+  // The message is queued behind the End Point's other messages.
+  link = &endPoint->mailbox;
+  while (*link != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    link = &mailbox->mail[*link].next;
+  }
+  *link = index;
+  
+  return mail->handle;
+}
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+bool FrameAggregate(struct sFrameScheduler *scheduler,
+                    const unsigned char *payload,
+                    unsigned char length)
+{
+  struct sFrameAggregator *aggregator = &scheduler->aggregator;
+  unsigned char *record;
+  
+  if ((length == 0) || (length > (PROTOCOL_AGGREGATE_LENGTH - FRAME_AGGREGATE_PREFIX_LENGTH)))
+  {
+    // Error: the record does not fit in an Aggregate frame.
+    return false;
+  }
+  
+  // Send the records gathered so far if this one does not fit with them.
+  if ((aggregator->length + FRAME_AGGREGATE_PREFIX_LENGTH + length) > PROTOCOL_AGGREGATE_LENGTH)
+  {
+    if (!FrameAggregateSend(scheduler))
+    {
+      return false;
+    }
+  }
+  
+  record = &aggregator->buffer[aggregator->fill][aggregator->length];
+  record[0] = length;
+  memcpy(&record[FRAME_AGGREGATE_PREFIX_LENGTH], payload, length);
+  aggregator->length += FRAME_AGGREGATE_PREFIX_LENGTH + length;
+  aggregator->count++;
+  
+  // The latency budget starts with the first record of the frame.
+  if (aggregator->timeout == 0)
+  {
+    aggregator->timeout = PROTOCOL_AGGREGATE_LATENCY;
+    PhyTimerStart(scheduler->phy);
+  }
+  
+  return true;
+}
+#endif
+
+#if defined( PROTOCOL_USE_MULTICAST )
+bool FrameMulticast(struct sFrameScheduler *scheduler,
+                    const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                    unsigned char *payload,
+                    unsigned char length)
+{
+  struct sFrameMulticast *multicast = &scheduler->multicast;
+  
+  if (!FrameIsGateway(scheduler))
+  {
+    // Error: only a Gateway sends group messages.
+    return false;
+  }
+  
+  if (group != NULL)
+  {
+    PhyAddressCopy(multicast->dest, group, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  }
+  else
+  {
+    memset(multicast->dest, PHY_ADDRESS_BROADCAST, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  }
+  
+  #if defined( PROTOCOL_USE_TDMA )
+  // The message waits for the next beacon; End Points only wake up for it.
+  if (multicast->waiting
+      || ((FRAME_MULTICAST_GROUP_LENGTH + length + FRAME_OVERHEAD_LENGTH) > PROTOCOL_DATASTREAM_MAX_SIZE))
+  {
+    // Error: a message is already waiting or the message does not fit.
+    return false;
+  }
+  
+  multicast->payload = payload;
+  multicast->length = length;
+  multicast->waiting = true;
+  
+  return true;
+  #else
+  // Listening for a frame gives way to the message; anything else does not.
+  if (scheduler->busy && !scheduler->listening)
+  {
+    scheduler->counters.txBusy++;
+    return false;
+  }
+  
+  scheduler->busy = false;
+  scheduler->listening = false;
+  multicast->sending = true;
+  PhyEnable(scheduler->phy);
+  if (!FrameSend(scheduler, eFrameTypeData, false, payload, length))
+  {
+    multicast->sending = false;
+    FrameIdle(scheduler);
+    return false;
+  }
+  multicast->sending = false;
+  scheduler->counters.txMulticasts++;
+  
+  return true;
+  #endif
+}
+
+bool FrameGroupAdd(struct sFrameScheduler *scheduler,
+                   const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE])
+{
+  struct sFrameMulticast *multicast = &scheduler->multicast;
+  
+  if (FrameGroupFind(scheduler, group) != FRAME_MULTICAST_GROUP_NONE)
+  {
+    return true;
+  }
+  
+  // Every End Point accepts the broadcast address.
+  if (PhyAddressIsBroadcast(group, PROTOCOL_PHYADDRESS_ADDRESS_SIZE)
+      || (multicast->groups >= PROTOCOL_MULTICAST_GROUPS))
+  {
+    return false;
+  }
+  
+  PhyAddressCopy(multicast->group[multicast->groups], group, PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  multicast->groups++;
+  
+  return true;
+}
+
+bool FrameGroupRemove(struct sFrameScheduler *scheduler,
+                      const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE])
+{
+  struct sFrameMulticast *multicast = &scheduler->multicast;
+  unsigned char i = FrameGroupFind(scheduler, group);
+  
+  if (i == FRAME_MULTICAST_GROUP_NONE)
+  {
+    return false;
+  }
+  
+  // The last group takes the place of the one removed.
+  multicast->groups--;
+  if (i != multicast->groups)
+  {
+    PhyAddressCopy(multicast->group[i], 
+                   multicast->group[multicast->groups], 
+                   PROTOCOL_PHYADDRESS_ADDRESS_SIZE);
+  }
+  
+  return true;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Frame scheduling operations
+
+bool FrameBusy(struct sFrameScheduler *scheduler)
+{
+  return scheduler->busy;
+}
+
+unsigned char FrameAssemble(void *context, 
+                            unsigned char *payload, 
+                            unsigned char length)
+{            
+  struct sFrameScheduler *scheduler = (struct sFrameScheduler*)context;
+  
+  scheduler->busy = false;
+  scheduler->listening = false;
+  scheduler->rx = (struct sFrame*)payload;
+
+  // Clear the size of the buffer for the next RX or TX payload.
+  scheduler->length = 0;
+  FrameSetDataResponse(scheduler, NULL, 0);
+    
   // Is the received message at least the size of the frame overhead and is the
   // CRC valid?
-  if (length >= FRAME_OVERHEAD_LENGTH 
-      && (PhyGetDataStreamStatus()->status & PROTOCOL_DATASTREAM_FOOTER_CRC))
+  if (length < FrameOverheadLength(scheduler, length))
+  {
+    scheduler->counters.rxLengthErrors++;
+  }
+  else if (!(PhyGetDataStreamStatus(scheduler->phy)->status & PROTOCOL_DATASTREAM_FOOTER_CRC))
+  {
+    scheduler->counters.rxCrcErrors++;
+  }
+  else if (!FrameExpand(scheduler, &length))
+  {
+    // The frame has been dropped (see FrameExpand).
+  }
+  else
   {
-    gFrameScheduler.length = length - FRAME_OVERHEAD_LENGTH;
+    bool valid;
+    
+    scheduler->length = length - FRAME_OVERHEAD_LENGTH;
     
     // Filter the incoming frame.
-    #if defined( PROTOCOL_ENDPOINT)
-    if (FrameEndPointValidate(gFrameScheduler.frame.header.panId,
-                              gFrameScheduler.frame.header.destAddr))
-    #elif defined( PROTOCOL_GATEWAY )
-    if (FrameGatewayValidate(gFrameScheduler.frame.header.panId,
-                             gFrameScheduler.frame.header.destAddr))  
+    if (FrameIsGateway(scheduler))
+    {
+      valid = FrameGatewayValidate(scheduler,
+                                   scheduler->rx->header.panId,
+                                   scheduler->rx->header.destAddr);
+    }
+    else
+    {
+      valid = FrameEndPointValidate(scheduler,
+                                    scheduler->rx->header.panId,
+                                    scheduler->rx->header.destAddr);
+    }
+    
+    #if defined( PROTOCOL_USE_SECURITY )
+    // The frames of a secured link must be authentic and new.
+    if (valid)
+    {
+      valid = FrameUnsecure(scheduler);
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+    // A Gateway keeps track of every End Point it hears. A new End Point is 
+    // dropped while the table holds only established links (see 
+    // PhyAddressEndPointAdd).
+    if (valid && FrameIsGateway(scheduler))
+    {
+      struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointUpdate(scheduler->phyAddress, 
+                                                                      scheduler->rx->header.srcAddr);
+      
+      if (endPoint == NULL)
+      {
+        scheduler->counters.rxDropTable++;
+        valid = false;
+      }
+      else
+      {
+        endPoint->rxSeqNumber = scheduler->rx->header.seqNumber;
+        endPoint->flags &= ~(PHY_ADDRESS_ENDPOINT_FLAG_ACK | PHY_ADDRESS_ENDPOINT_FLAG_COMPRESSED);
+        if (scheduler->rx->header.control & FRAME_CONTROL_ACK_REQ)
+        {
+          endPoint->flags |= PHY_ADDRESS_ENDPOINT_FLAG_ACK;
+        }
+        #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+        if (scheduler->rx->header.control & FRAME_CONTROL_COMPRESSED)
+        {
+          endPoint->flags |= PHY_ADDRESS_ENDPOINT_FLAG_COMPRESSED;
+        }
+        #endif
+      }
+    }
     #endif
+    
+    if (valid)
     {
       unsigned char statusMessage = 0;
+      #if defined( PROTOCOL_USE_TX_QUEUE )
+      bool response = false;
+      #endif
+      
+      scheduler->counters.rxFrames++;
+      
+      #if defined( PROTOCOL_USE_MULTICAST )
+      if (FrameIsMulticast(scheduler))
+      {
+        scheduler->counters.rxMulticasts++;
+      }
+      #endif
+      
+      #if defined( PROTOCOL_USE_MAILBOX )
+      // The Gateway holds more messages for the local node; its group messages
+      // do not tell.
+      if (!FrameIsGateway(scheduler) && !FrameIsMulticast(scheduler))
+      {
+        scheduler->mailbox.pending = (scheduler->rx->header.control & FRAME_CONTROL_PENDING) != 0;
+      }
+      #endif
+      
+      #if defined( PROTOCOL_USE_ACK )
+      // Is this the acknowledgement of the frame just sent? It comes from the
+      // frame's destination (any node if it was broadcast).
+      if (scheduler->ack.active
+          && (scheduler->rx->header.control & FRAME_CONTROL_ACK)
+          && (PhyAddressIsBroadcast(scheduler->retry.header.destAddr, PROTOCOL_PHYADDRESS_ADDRESS_SIZE)
+              || (PhyAddressCompare(scheduler->rx->header.srcAddr, 
+                                    scheduler->retry.header.destAddr, 
+                                    PROTOCOL_PHYADDRESS_ADDRESS_SIZE) == 0)))
+      {
+        FrameAckComplete(scheduler, true);
+        
+        // An acknowledgement on its own completes the transfer; one that is
+        // piggybacked on a data response is processed as a response.
+        if (((scheduler->rx->header.control & FRAME_CONTROL_TYPE) == eFrameTypeData)
+            && (scheduler->length == 0))
+        {
+          return FrameTransmitted(scheduler, false);
+        }
+      }
+      
+      // The sender requests an acknowledgement. It is piggybacked on the data
+      // response, if one is sent. Only End Points request acknowledgements 
+      // (with compressed headers the bit is FRAME_CONTROL_PENDING in the 
+      // frames of a Gateway).
+      if (FrameIsGateway(scheduler)
+          && (scheduler->rx->header.control & FRAME_CONTROL_ACK_REQ)
+          && ((scheduler->rx->header.control & FRAME_CONTROL_TYPE) != eFrameTypeLinkRequest))
+      {
+        scheduler->ack.owed = true;
+      }
+      #endif
 
-      switch (gFrameScheduler.frame.header.control & FRAME_CONTROL_TYPE)
+      // A frame sent again is acknowledged again (see below) but only 
+      // delivered once. A data request sent again is answered with the same 
+      // response; the acknowledgement rides on it.
+      if (FrameDuplicate(scheduler) || FrameReplayed(scheduler))
+      {
+        FrameResponseResend(scheduler);
+      }
+      else
+      {
+        switch (scheduler->rx->header.control & FRAME_CONTROL_TYPE)
+        {
+        case eFrameTypeData:
+          #if defined( PROTOCOL_USE_TX_QUEUE )
+          // A data frame received while a queued data request is outstanding is
+          // its response, unless it is a group message. This is checked before
+          // the callback may reuse the receive buffer.
+          response = scheduler->txQueue.active
+                     && scheduler->txQueue.request[scheduler->txQueue.head].dataRequest
+                     && !FrameIsMulticast(scheduler);
+          #endif
+          statusMessage = FrameSchedulerData(scheduler);
+          #if defined( PROTOCOL_USE_TX_QUEUE )
+          if (response)
+          {
+            FrameTxQueueComplete(scheduler, FRAME_TX_STATUS_SUCCESS);
+          }
+          #endif
+          break;
+        case eFrameTypeLinkRequest:
+          statusMessage = FrameSchedulerLinkRequest(scheduler);
+          break;
+        #if defined( PROTOCOL_USE_SEGMENTATION )
+        case eFrameTypeFragment:
+          statusMessage = FrameSchedulerFragment(scheduler);
+          break;
+        #endif
+        #if defined( PROTOCOL_USE_AGGREGATION )
+        case eFrameTypeAggregate:
+          statusMessage = FrameSchedulerAggregate(scheduler);
+          break;
+        #endif
+        default:
+          break;
+        }
+      }
+      
+      #if defined( PROTOCOL_USE_ACK )
+      // Acknowledge the frame right away if no response carried the 
+      // acknowledgement.
+      if (scheduler->ack.owed)
       {
-      case eFrameTypeData:
-        statusMessage = FrameSchedulerData();
-        break;
-      case eFrameTypeLinkRequest:
-        statusMessage = FrameSchedulerLinkRequest();
-        break;
-      default:
-        break;
+        if (!scheduler->busy)
+        {
+          PhyEnable(scheduler->phy);
+          FrameSend(scheduler, eFrameTypeData, false, NULL, 0);
+        }
+        scheduler->ack.owed = false;
       }
+      #endif
       
       // Check if the protocol is performing a data response to the last
       // incoming message before going into an IDLE state.
-      if (!gFrameScheduler.busy)
+      if (!scheduler->busy)
       {
-        FrameIdle();
+        FrameSchedulerNext(scheduler);
       }
       
       return statusMessage;
@@ -473,58 +3882,192 @@ unsigned char FrameAssemble(unsigned char *payload, unsigned char length)
    *  of invalid length was received or a frame with an invalid CRC was 
    *  received.
    */
-  FrameIdle();
+  FrameSchedulerNext(scheduler);
   
   return 0;
 }
 
-unsigned char FrameDisassemble()
+unsigned char FrameDisassemble(void *context)
 {
-  gFrameScheduler.busy = false;
-
-  // Check if the data transfer requires a response.
-  if (gFrameScheduler.frame.header.control & FRAME_CONTROL_DATA_REQ)
-  {
-    // Begin listening for a response (data or data + ACK). Filter on the 
-    // destination address of the frame just sent.
-    FrameListen();
-    return 0;
-  }
-  else
+  struct sFrameScheduler *scheduler = (struct sFrameScheduler*)context;
+  
+  scheduler->busy = false;
+  
+  #if defined( PROTOCOL_USE_TDMA )
+  // The superframe is timed from the end of the beacon.
+  if (scheduler->tdma.beacon)
   {
-    // Check if the data transfer was a simplex.
-    if (!(gFrameScheduler.frame.header.control & FRAME_CONTROL_DATA_REQ))
+    scheduler->tdma.beacon = false;
+    scheduler->tdma.clock = 0;
+    scheduler->counters.txBeacons++;
+    #if defined( PROTOCOL_USE_MULTICAST )
+    // The group message carried by the beacon has been sent.
+    if (scheduler->multicast.waiting)
     {
-      unsigned char statusMessage = 0;
-      
-      // Clear the size of the buffer for the next RX or TX payload.
-      gFrameScheduler.length = 0;
-    
-      // Invoke the data complete callback.
-      if (gFrameScheduler.FrameComplete != NULL)
+      scheduler->multicast.waiting = false;
+      scheduler->counters.txMulticasts++;
+      if (scheduler->FrameComplete != NULL)
       {
-        #if defined( PROTOCOL_ENDPOINT )
-        statusMessage = gFrameScheduler.FrameComplete(NULL, 0);
-        #elif defined( PROTOCOL_GATEWAY )
-        statusMessage = gFrameScheduler.FrameComplete(false, NULL, 0);
-        #endif
+        scheduler->FrameComplete(false, NULL, 0);
       }
-      
-      FrameIdle();
-      
-      return statusMessage;
     }
+    #endif
+    FrameSchedulerNext(scheduler);
+    return 0;
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK )
+  // Nothing completes once an acknowledgement on its own has been sent.
+  if ((scheduler->frame.header.control & FRAME_CONTROL_ACK)
+      && ((scheduler->frame.header.control & FRAME_CONTROL_TYPE) == eFrameTypeData)
+      && (scheduler->length == 0))
+  {
+    FrameSchedulerNext(scheduler);
+    return 0;
+  }
+  
+  // Listen for the acknowledgement; the frame is sent again if it does not 
+  // arrive in time (see FrameTick).
+  if (scheduler->ack.active)
+  {
+    scheduler->ack.timeout = PROTOCOL_ACK_TIMEOUT + FrameAckBackoff(scheduler);
+    PhyTimerStart(scheduler->phy);
+    FrameListen(scheduler);
+    return 0;
   }
+  #endif
+  
+  return FrameTransmitted(scheduler, true);
+}
 
-  FrameIdle();
+unsigned char FrameTimeout(void *context)
+{
+  struct sFrameScheduler *scheduler = (struct sFrameScheduler*)context;
+  
+  #if defined( PROTOCOL_USE_ACK )
+  // The wait for an acknowledgement is timed by FrameTick.
+  if (scheduler->ack.active)
+  {
+    return 0;
+  }
+  #endif
+  
+  scheduler->busy = false;
+  scheduler->listening = false;
+  scheduler->counters.rxTimeouts++;
+  
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  // The response to the outstanding data request did not arrive in time.
+  if (scheduler->txQueue.active)
+  {
+    FrameTxQueueComplete(scheduler, FRAME_TX_STATUS_TIMEOUT);
+  }
+  #endif
   
+  FrameSchedulerNext(scheduler);
   return 0;
 }
 
-unsigned char FrameTimeout()
+unsigned char FrameTick(void *context)
 {
-  gFrameScheduler.busy = false;
-  FrameIdle();
+  struct sFrameScheduler *scheduler = (struct sFrameScheduler*)context;
+  bool pending = false;
+  
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  {
+    unsigned char i;
+    
+    // Abandon the reassemblies whose next fragment is overdue.
+    for (i = 0; i < PROTOCOL_SEGMENT_BUFFERS; i++)
+    {
+      struct sFrameReassembly *reassembly = &scheduler->reassembly[i];
+      
+      if (reassembly->active && (reassembly->timeout > 0))
+      {
+        if (--reassembly->timeout == 0)
+        {
+          reassembly->active = false;
+          scheduler->counters.rxFragmentTimeouts++;
+        }
+        else
+        {
+          pending = true;
+        }
+      }
+    }
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_CSMA )
+  // Assess the channel again once the backoff has elapsed.
+  if (scheduler->csma.active && (--scheduler->csma.timeout == 0))
+  {
+    unsigned char status;
+    
+    scheduler->csma.active = false;
+    status = FrameTransmit(scheduler, scheduler->retry.stream, scheduler->retry.count);
+    if (status != FRAME_TX_STATUS_SUCCESS)
+    {
+      FrameSendFailed(scheduler, status);
+    }
+  }
+  pending |= scheduler->csma.active;
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK )
+  // The timeout only runs while listening for the acknowledgement.
+  if (scheduler->ack.active && (scheduler->ack.timeout > 0))
+  {
+    if (--scheduler->ack.timeout == 0)
+    {
+      FrameAckTimeout(scheduler);
+    }
+  }
+  pending |= scheduler->ack.active;
+  #endif
+  
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  // Send the gathered records once the oldest has waited long enough; try 
+  // again on the next tick while the scheduler is busy.
+  if ((scheduler->aggregator.timeout > 0) && (--scheduler->aggregator.timeout == 0))
+  {
+    if (!FrameAggregateSend(scheduler))
+    {
+      scheduler->aggregator.timeout = 1;
+    }
+  }
+  pending |= (scheduler->aggregator.timeout > 0);
+  #endif
+  
+  #if defined( PROTOCOL_USE_TDMA )
+  FrameTdmaTick(scheduler);
+  pending |= scheduler->tdma.synced;
+  #endif
+  
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  // A Gateway keeps counting periods until every deferred End Point is due.
+  if ((scheduler->join.timeout > 0) && (--scheduler->join.timeout == 0) 
+      && FrameIsGateway(scheduler))
+  {
+    struct sFrameJoin *join = &scheduler->join;
+    
+    join->backlog = (join->backlog > PROTOCOL_JOIN_ADMIT) ? (join->backlog - PROTOCOL_JOIN_ADMIT) : 0;
+    join->admitted = 0;
+    if (join->backlog > 0)
+    {
+      join->timeout = PROTOCOL_JOIN_PERIOD;
+    }
+  }
+  pending |= (scheduler->join.timeout > 0);
+  #endif
+  
+  // The tick is no longer required.
+  if (!pending)
+  {
+    PhyTimerStop(scheduler->phy);
+  }
+  
   return 0;
 }
 
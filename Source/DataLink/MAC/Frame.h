@@ -12,8 +12,8 @@
  *  Frame.h - Data Link layer Media Access Control (MAC) framing and scheduling 
  *  sub layer.
  *
- *  @version    1.0.01
- *  @date       16 Oct 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  This module defines the structure of a frame and a scheduler for the Data
@@ -33,18 +33,82 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added an optional transmit queue (PROTOCOL_USE_TX_QUEUE)
+ *  - added FrameSendv; payloads are no longer copied into the frame buffer
+ *  - added an optional pool of loaned receive buffers (PROTOCOL_USE_RX_POOL)
+ *  - every operation takes the frame scheduler (sFrameScheduler) it applies 
+ *  to; the scheduler refers to its own addressing information and physical 
+ *  device
+ *  - the node role is held by the scheduler (mode) and selected by FrameInit;
+ *  End Point and Gateway behaviours are both built in
+ *  - added scheduler counters (sFrameCounters) and optional receive latency
+ *  statistics (PROTOCOL_USE_LATENCY_COUNTERS)
+ *  - added FrameSendMessage; messages larger than a frame are sent as 
+ *  sequenced fragments and reassembled per source (PROTOCOL_USE_SEGMENTATION)
+ *  - FrameComplete reports the payload length as an unsigned int
+ *  - added FrameTick, the scheduler's millisecond tick
+ *  - added link-layer acknowledgements with automatic retransmission and 
+ *  randomized exponential backoff (PROTOCOL_USE_ACK, FrameAckInit)
+ *  - added CSMA-CA channel access; a frame refused on a busy channel is sent 
+ *  again after a random number of backoff slots (PROTOCOL_USE_CSMA)
+ *  - transmit status values (FRAME_TX_STATUS_x) no longer depend on the 
+ *  transmit queue
+ *  - added a Gateway cache of the last sequence number received from each 
+ *  source; frames sent again are dropped (PROTOCOL_USE_DUPLICATE_FILTER)
+ *  - a data request sent again is answered with a copy of the last data 
+ *  response (sFrameResponseCopy, PROTOCOL_RESPONSE_COPY_LENGTH)
+ *  - added Gateway downlink mailboxes; messages posted for an End Point are 
+ *  sent in order as responses to its data requests (PROTOCOL_USE_MAILBOX, 
+ *  FrameMailboxInit, FramePost)
+ *  - a Gateway sets FRAME_CONTROL_PENDING while more messages wait for the 
+ *  End Point; the End Point keeps requesting data until none are left
+ *  - added aggregation; small records are packed with a length prefix into 
+ *  one Aggregate frame, sent when full or when the latency budget expires 
+ *  (PROTOCOL_USE_AGGREGATION, FrameAggregate)
+ *  - added compressed headers; frames of an established link carry a link 
+ *  identifier assigned by the Gateway instead of the addresses 
+ *  (PROTOCOL_USE_COMPRESSED_HEADER, FRAME_CONTROL_COMPRESSED)
+ *  - with compressed headers only, the control byte and sequence number 
+ *  follow the PAN identifier and FRAME_CONTROL_PENDING shares its bit with 
+ *  FRAME_CONTROL_ACK_REQ (only a Gateway sets the former and only an End 
+ *  Point the latter); the wire format is unchanged without the option
+ *  - added FRAME_HEADER_CONTROL_OFFSET
+ *  - added a beacon-driven TDMA superframe; a Gateway beacons and assigns 
+ *  slots in its link request responses, an End Point holds its frames for 
+ *  its slot and wakes only for the beacon (PROTOCOL_USE_TDMA)
+ *  - added FrameConnect; optional join control spaces the link requests of 
+ *  an End Point by a randomized exponential backoff and lets a Gateway defer
+ *  link requests beyond its admission rate with a retry time in the response 
+ *  (PROTOCOL_USE_JOIN_CONTROL)
+ *  - added Gateway broadcast and group downlink; an End Point also accepts 
+ *  frames sent to every node or to a group it belongs to 
+ *  (PROTOCOL_USE_MULTICAST, FrameMulticast, FrameGroupAdd, FrameGroupRemove)
+ *  - added payload codecs negotiated per link; data frames of an End Point 
+ *  carry a codec header and the Gateway decodes them before FrameComplete 
+ *  (PROTOCOL_USE_CODEC, FrameCodecInit)
+ *  - added AES-128 CCM* link security; frames of a linked node carry a frame 
+ *  counter and a MIC, and are encrypted with a key derived for each link 
+ *  (PROTOCOL_USE_SECURITY, FRAME_CONTROL_SECURE, FrameSecurityInit)
+ *  - the frame buffer must hold the largest data stream with 
+ *  PROTOCOL_USE_STREAMING
+ *  - an End Point's receiver is turned on by the radio itself when a data 
+ *  request has been sent (PROTOCOL_USE_TURNAROUND)
+ *  - key seeds of a Gateway start from the receiver noise instead of zero 
+ *  after each reset (sFrameSecurity.seed)
+ *  - link requests carry a challenge and their responses a MIC under the 
+ *  network key (FRAME_SECURITY_CHALLENGE_LENGTH, FRAME_LINK_RESPONSE_MIC)
  *  ver 1.0.01 : 16 Oct 2012
  *  - updated internal documentation; comments revised
  *  ver 1.0.00 : 17 Sep 2012
  *  - initial release
  */
-#define FRAME_INFO "FRAME 1.0.01"
+#define FRAME_INFO "FRAME 1.1.00"
 
 #include "PhyBridge.h"
 #include "PhyAddress.h"
-
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_GATEWAY )
-#error "Frame Error: End Point and Gateway roles cannot be defined at the same time."
+#if defined( PROTOCOL_USE_SECURITY )
+#include "Security.h"
 #endif
 
 // -----------------------------------------------------------------------------
@@ -58,12 +122,92 @@
 
 #define FRAME_HEADER_ADDRESS_LENGTH PROTOCOL_PHYADDRESS_PANID_SIZE + (2 * PROTOCOL_PHYADDRESS_ADDRESS_SIZE)
 #define FRAME_HEADER_LENGTH         FRAME_HEADER_ADDRESS_LENGTH + 2
+
+// Data stream offset of the control byte (see sFrame)
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+#define FRAME_HEADER_CONTROL_OFFSET PROTOCOL_PHYADDRESS_PANID_SIZE
+#else
+#define FRAME_HEADER_CONTROL_OFFSET (FRAME_HEADER_ADDRESS_LENGTH)
+#endif
 #define FRAME_FOOTER_LENGTH         0
 #define FRAME_OVERHEAD_LENGTH       (FRAME_HEADER_LENGTH + FRAME_FOOTER_LENGTH)
 
+#if defined( PROTOCOL_USE_STREAMING )
+// A received data stream is moved straight into the frame buffer.
+#if (FRAME_OVERHEAD_LENGTH + PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH) < PROTOCOL_DATASTREAM_MAX_SIZE
+#error "Frame Error: PROTOCOL_USE_STREAMING requires PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH to hold PHY_MAX_DATASTREAM_SIZE bytes less FRAME_OVERHEAD_LENGTH."
+#endif
+#endif
+
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_COMPRESSED_HEADER requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+// A compressed header ends with a link identifier instead of the addresses
+#define FRAME_HEADER_LINK_LENGTH    1
+#define FRAME_HEADER_COMPRESSED_LENGTH (FRAME_HEADER_LENGTH - (2 * PROTOCOL_PHYADDRESS_ADDRESS_SIZE) + FRAME_HEADER_LINK_LENGTH)
+#define FRAME_COMPRESSED_OVERHEAD_LENGTH (FRAME_HEADER_COMPRESSED_LENGTH + FRAME_FOOTER_LENGTH)
+
+// Data stream segment of the link identifier
+#define FRAME_LINK_SEGMENTS         1
+#else
+#define FRAME_LINK_SEGMENTS         0
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+#define FRAME_CODEC_SEGMENTS        1
+#else
+#define FRAME_CODEC_SEGMENTS        0
+#endif
+
+// Data stream segments ahead of the payload (header, link identifier and 
+// codec header)
+#define FRAME_HEADER_SEGMENTS       (1 + FRAME_LINK_SEGMENTS + FRAME_CODEC_SEGMENTS)
+
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER ) || defined( PROTOCOL_USE_TDMA ) \
+    || defined( PROTOCOL_USE_JOIN_CONTROL ) || defined( PROTOCOL_USE_CODEC ) \
+    || defined( PROTOCOL_USE_SECURITY )
+/**
+ *  Link request response payload (Gateway to End Point). A field the Gateway 
+ *  does not use holds PHY_ADDRESS_LINK_NONE, PHY_ADDRESS_SLOT_NONE or 0. A 
+ *  non-zero retry time (milliseconds, most significant byte first) defers the
+ *  link request instead of accepting it. The codecs are the set the Gateway 
+ *  decodes (CODEC_SET_x). The link key is derived from the key seed (most 
+ *  significant byte first). A Gateway draws its first seed from the receiver 
+ *  noise and counts up from there; it never issues a seed twice, and seeds do
+ *  not start over when it is reset. With a network key, a MIC follows (see 
+ *  FRAME_SECURITY_CHALLENGE_LENGTH).
+ *
+ *    | link identifier (1) | superframe slot (1) | retry time (2) | codecs (1) |
+ *    | key seed (4) | MIC (PROTOCOL_SECURITY_MIC_LENGTH) |
+ */
+#define FRAME_LINK_RESPONSE_LINK    0
+#define FRAME_LINK_RESPONSE_SLOT    1
+#define FRAME_LINK_RESPONSE_RETRY   2
+#define FRAME_LINK_RESPONSE_CODECS  4
+#define FRAME_LINK_RESPONSE_SEED    5
+#define FRAME_LINK_RESPONSE_LENGTH  9
+#if defined( PROTOCOL_USE_SECURITY )
+#define FRAME_LINK_RESPONSE_MIC     FRAME_LINK_RESPONSE_LENGTH
+#define FRAME_LINK_RESPONSE_SIZE    (FRAME_LINK_RESPONSE_LENGTH + PROTOCOL_SECURITY_MIC_LENGTH)
+#else
+#define FRAME_LINK_RESPONSE_SIZE    FRAME_LINK_RESPONSE_LENGTH
+#endif
+#endif
+
+// Maximum number of payload segments accepted by FrameSendv
+#ifndef PROTOCOL_FRAME_MAX_SEGMENTS
+#define PROTOCOL_FRAME_MAX_SEGMENTS 4
+#endif
+
 #define FRAME_CONTROL_TYPE_MASK         0xC0u
 #define FRAME_CONTROL_SECURE_MASK       0x20u
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+#define FRAME_CONTROL_COMPRESSED_MASK   0x10u
+#else
 #define FRAME_CONTROL_PENDING_MASK      0x10u
+#endif
 #define FRAME_CONTROL_ACKREQUEST_MASK   0x08u
 #define FRAME_CONTROL_ACK_MASK          0x04u
 #define FRAME_CONTROL_DATAREQUEST_MASK  0x02u
@@ -81,17 +225,182 @@
 enum eFrameType
 {
   eFrameTypeData        = 0x00u,        // Data frame
-  eFrameTypeLinkRequest = 0x40u         // Link request frame
+  eFrameTypeLinkRequest = 0x40u,        // Link request frame
+  eFrameTypeFragment    = 0x80u,        // Fragment of a larger message
+  eFrameTypeAggregate   = 0xC0u         // Several length prefixed records
 };
 
 #define FRAME_CONTROL_TYPE              0xC0u
 #define FRAME_CONTROL_SECURE            0x20u
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+// Compressed header wire format: the pending flag gives its bit up to the 
+// compressed flag and shares one with the acknowledgement request.
+#define FRAME_CONTROL_COMPRESSED        0x10u
+#define FRAME_CONTROL_ACK_REQ           0x08u   // End Point frames
+#define FRAME_CONTROL_PENDING           0x08u   // Gateway frames
+#else
 #define FRAME_CONTROL_PENDING           0x10u
 #define FRAME_CONTROL_ACK_REQ           0x08u
+#endif
 #define FRAME_CONTROL_ACK               0x04u
 #define FRAME_CONTROL_DATA_REQ          0x02u
 #define FRAME_CONTROL_MODE              0x01u
 
+#if defined( PROTOCOL_USE_SECURITY )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_SECURITY requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+#ifndef PROTOCOL_SECURITY_MIC_LENGTH
+#define PROTOCOL_SECURITY_MIC_LENGTH    4     // Default bytes of the MIC
+#endif
+
+#if (PROTOCOL_SECURITY_MIC_LENGTH != 4) && (PROTOCOL_SECURITY_MIC_LENGTH != 8) \
+    && (PROTOCOL_SECURITY_MIC_LENGTH != 16)
+#error "Frame Error: PROTOCOL_SECURITY_MIC_LENGTH must be 4, 8 or 16."
+#endif
+
+/**
+ *  Secured payload (FRAME_CONTROL_SECURE). The payload is encrypted; the MIC 
+ *  authenticates it and the full frame header. The frame counter (most 
+ *  significant byte first) of a node only increases; a receiver drops a frame
+ *  older than the last one it accepted from the same link.
+ *
+ *    | payload (n) | frame counter (4) | MIC (PROTOCOL_SECURITY_MIC_LENGTH) |
+ *
+ *  The CCM* nonce is the source address (padded with zeros to 8 bytes), the 
+ *  frame counter and the security level (IEEE 802.15.4 ENC-MIC-x).
+ */
+#define FRAME_SECURITY_SEED_LENGTH      4
+#define FRAME_SECURITY_COUNTER_LENGTH   4
+#define FRAME_SECURITY_LENGTH           (FRAME_SECURITY_COUNTER_LENGTH + PROTOCOL_SECURITY_MIC_LENGTH)
+#define FRAME_SECURITY_COUNTER_MAX      0xFFFFFFFFul
+#define FRAME_SECURITY_NONCE_ADDRESS    8
+#define FRAME_SECURITY_LEVEL            ((PROTOCOL_SECURITY_MIC_LENGTH == 4) ? 0x05u : \
+                                         (PROTOCOL_SECURITY_MIC_LENGTH == 8) ? 0x06u : 0x07u)
+
+/**
+ *  Link request challenge. With a network key, an End Point appends a 
+ *  challenge (most significant byte first) to its link request payload; it 
+ *  never uses a challenge twice. The MIC of the response authenticates the 
+ *  response payload under the network key; its CCM* nonce is the Gateway 
+ *  address and the challenge, so a response only answers the link request 
+ *  that carried it.
+ *
+ *    | link request payload (n) | challenge (4) |
+ */
+#define FRAME_SECURITY_CHALLENGE_LENGTH 4
+
+// The key seed and both addresses of a link make up one block.
+#if (FRAME_SECURITY_SEED_LENGTH + (2 * PROTOCOL_PHYADDRESS_ADDRESS_SIZE)) > SECURITY_BLOCK_LENGTH
+#error "Frame Error: PROTOCOL_USE_SECURITY requires addresses of at most 6 bytes."
+#endif
+#else
+#define FRAME_SECURITY_LENGTH           0
+#endif
+
+#if defined( PROTOCOL_USE_SEGMENTATION )
+#ifndef PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH
+#define PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH 256   // Default largest message (bytes)
+#endif
+
+#ifndef PROTOCOL_SEGMENT_BUFFERS
+#define PROTOCOL_SEGMENT_BUFFERS        1     // Default number of reassembly buffers
+#endif
+
+#ifndef PROTOCOL_SEGMENT_TIMEOUT
+#define PROTOCOL_SEGMENT_TIMEOUT        500   // Default time between fragments (ms)
+#endif
+
+// Fragment layout: [tag][index][count] followed by the fragment data. The last
+// fragment ends with a CRC-16 of the whole message.
+#define FRAME_FRAGMENT_HEADER_LENGTH    3
+#define FRAME_FRAGMENT_CRC_LENGTH       2
+#define FRAME_FRAGMENT_DATA_LENGTH      (PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH - FRAME_FRAGMENT_HEADER_LENGTH - FRAME_SECURITY_LENGTH)
+
+#if FRAME_FRAGMENT_DATA_LENGTH < 1
+#error "Frame Error: PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH is too small to carry fragments."
+#endif
+
+#if (PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH + FRAME_FRAGMENT_CRC_LENGTH) > (255 * FRAME_FRAGMENT_DATA_LENGTH)
+#error "Frame Error: PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH requires more than 255 fragments."
+#endif
+
+// A fragment is sent as its header, data and CRC segments (see FrameSendv).
+#if PROTOCOL_FRAME_MAX_SEGMENTS < 3
+#error "Frame Error: PROTOCOL_USE_SEGMENTATION requires PROTOCOL_FRAME_MAX_SEGMENTS of at least 3."
+#endif
+#endif
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+#ifndef PROTOCOL_TX_QUEUE_SIZE
+#define PROTOCOL_TX_QUEUE_SIZE          4     // Default number of queued frames
+#endif
+
+// Transmit queue handles
+#define FRAME_TX_HANDLE_INVALID         0x00u
+#endif
+
+// Transmit status
+#define FRAME_TX_STATUS_SUCCESS         0x00u // Sent (and response received if requested)
+#define FRAME_TX_STATUS_TIMEOUT         0x01u // No response to a data request
+#define FRAME_TX_STATUS_ERROR           0x02u // Physical layer refused the frame
+#define FRAME_TX_STATUS_NO_ACK          0x03u // Not acknowledged after every retry
+#define FRAME_TX_STATUS_CHANNEL_BUSY    0x04u // Channel busy after every backoff
+
+#if defined( PROTOCOL_USE_ACK )
+#ifndef PROTOCOL_ACK_MAX_RETRIES
+#define PROTOCOL_ACK_MAX_RETRIES        3     // Default retransmissions of a frame
+#endif
+
+#ifndef PROTOCOL_ACK_TIMEOUT
+#define PROTOCOL_ACK_TIMEOUT            100   // Default wait for an acknowledgement (ms)
+#endif
+
+#ifndef PROTOCOL_ACK_BACKOFF
+#define PROTOCOL_ACK_BACKOFF            16    // Default backoff window of the first retry (ms)
+#endif
+
+// The backoff window doubles with every retry.
+#if (PROTOCOL_ACK_MAX_RETRIES < 0) || (PROTOCOL_ACK_MAX_RETRIES > 8)
+#error "Frame Error: PROTOCOL_ACK_MAX_RETRIES must be between 0 and 8."
+#endif
+
+#if (PROTOCOL_ACK_BACKOFF < 1) || ((PROTOCOL_ACK_BACKOFF << PROTOCOL_ACK_MAX_RETRIES) > 0x7FFF)
+#error "Frame Error: PROTOCOL_ACK_BACKOFF is out of range."
+#endif
+
+#if (PROTOCOL_ACK_TIMEOUT < 1) || ((PROTOCOL_ACK_TIMEOUT + (PROTOCOL_ACK_BACKOFF << PROTOCOL_ACK_MAX_RETRIES)) > 0xFFFF)
+#error "Frame Error: PROTOCOL_ACK_TIMEOUT is out of range."
+#endif
+#endif
+
+#if defined( PROTOCOL_USE_CSMA )
+#ifndef PROTOCOL_CSMA_MAX_BACKOFFS
+#define PROTOCOL_CSMA_MAX_BACKOFFS      4     // Default backoffs before a frame is dropped
+#endif
+
+#ifndef PROTOCOL_CSMA_MIN_BE
+#define PROTOCOL_CSMA_MIN_BE            2     // Default backoff exponent of the first backoff
+#endif
+
+#ifndef PROTOCOL_CSMA_MAX_BE
+#define PROTOCOL_CSMA_MAX_BE            5     // Default largest backoff exponent
+#endif
+
+#ifndef PROTOCOL_CSMA_SLOT
+#define PROTOCOL_CSMA_SLOT              2     // Default backoff slot (ms)
+#endif
+
+#if (PROTOCOL_CSMA_MIN_BE > PROTOCOL_CSMA_MAX_BE) || (PROTOCOL_CSMA_MAX_BE > 8)
+#error "Frame Error: PROTOCOL_CSMA_MIN_BE and PROTOCOL_CSMA_MAX_BE must satisfy MIN_BE <= MAX_BE <= 8."
+#endif
+
+#if (PROTOCOL_CSMA_SLOT < 1) || ((PROTOCOL_CSMA_SLOT << PROTOCOL_CSMA_MAX_BE) > 0x7FFF)
+#error "Frame Error: PROTOCOL_CSMA_SLOT is out of range."
+#endif
+#endif
+
 /**
  *  sFrame - represents a Data Link layer frame.
  *
@@ -103,15 +412,33 @@ enum eFrameType
  *    Bytes:    n           n           n        1        1           n
  *
  *    Field Information:
- *      PAN ID      Personal Area Network (PAN) identifier.
+ *      PAN ID      Personal Area Network (PAN) identifier. Its lowest byte is
+ *                  the first byte of the data stream (hardware filtering).
  *      Destination Frame destination address.
  *      Source      Frame source address.
  *      Control     Frame control information. This includes type, security,
- *                  segmentation, acknowledgements, and data request. This
+ *                  pending messages, acknowledgements, and data request. This
  *                  information is used by the scheduler.
  *      Sequence    Sequence number.
  *      Payload     Message being encapsulated in the frame.
  *  
+ *  Compressed headers (PROTOCOL_USE_COMPRESSED_HEADER) use another wire 
+ *  format; every node of the network must be built with the option or 
+ *  without it. The control byte and sequence number follow the PAN 
+ *  identifier, so that a receiver finds FRAME_CONTROL_COMPRESSED in either 
+ *  header,
+ *  
+ *           --------------------------------------------------------------
+ *          | PAN ID | Control | Sequence | Destination | Source | Payload |
+ *           --------------------------------------------------------------
+ *    Bytes:    n         1          1           n           n        n
+ *  
+ *  and a frame with FRAME_CONTROL_COMPRESSED set carries a link identifier (1
+ *  byte) in place of the Destination and Source fields. The link identifier 
+ *  is assigned by the Gateway when it accepts the link request of an End 
+ *  Point; both nodes know the addresses it stands for. The receiver restores
+ *  the full header before the frame is processed.
+ *  
  *  Note: The PAN ID, Destination, Source, and Payload sizes are configurable.
  */
 struct sFrame
@@ -122,8 +449,10 @@ struct sFrame
   struct sFrameHeader
   {
     unsigned char panId[PROTOCOL_PHYADDRESS_PANID_SIZE];
+    #if !defined( PROTOCOL_USE_COMPRESSED_HEADER )
     unsigned char destAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]; // Destination for the payload
     unsigned char srcAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];  // Source of the payload
+    #endif
     /**
      *  sFrameControl - control information used by the scheduler to determine
      *  different actions that need to be made for incoming and outgoing frames.
@@ -132,14 +461,21 @@ struct sFrame
 //    {
 //      enum eFrameType type  : 2;    // Type of frame message
 //      bool secure           : 1;    // Security-enabled frame
-//      bool pending          : 1;    // Frame is pending
-//      bool ackRequest       : 1;    // Acknowledgement request
+//      bool pending          : 1;    // Frame is pending (compressed header 
+//                                    // if PROTOCOL_USE_COMPRESSED_HEADER)
+//      bool ackRequest       : 1;    // Acknowledgement request (End Point),
+//                                    // frame is pending (Gateway, 
+//                                    // PROTOCOL_USE_COMPRESSED_HEADER)
 //      bool ack              : 1;    // Acknowledgement
 //      bool dataRequest      : 1;    // Data request (0:simplex, 1:half duplex)
 //      bool mode             : 1;    // Mode of the local node (0:End Point, 1:Gateway)
 //    } control;
     unsigned char control;          // Control information
     unsigned char seqNumber;        // Frame sequence number
+    #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+    unsigned char destAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]; // Destination for the payload
+    unsigned char srcAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];  // Source of the payload
+    #endif
   } header;
   unsigned char payload[PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH]; // Frame payload buffer
 };
@@ -156,20 +492,666 @@ struct sFrameDataResponse
   unsigned char length;     // Number of bytes in the response
 };
 
+/**
+ *  sFrameCounters - scheduler statistics. Every counter wraps around.
+ *
+ *  Note: The layout of this structure must match sProtocolCounters (API.h).
+ */
+struct sFrameCounters
+{
+  unsigned int txFrames;          // Frames accepted by the Physical layer
+  unsigned int txBusy;            // Frames rejected; the scheduler was busy
+  unsigned int rxFrames;          // Frames received and validated
+  unsigned int rxLengthErrors;    // Data streams shorter than a frame header
+  unsigned int rxCrcErrors;       // Data streams received with an invalid CRC
+  unsigned int rxDropMode;        // Frames dropped; sent by a node of the wrong role
+  unsigned int rxDropAddress;     // Frames dropped; destined for another node
+  unsigned int rxDropPanId;       // Frames dropped; destined for another PAN
+  unsigned int rxTimeouts;        // Responses that did not arrive in time
+  unsigned int linkAccepted;      // Link requests accepted (Gateway)
+  unsigned int linkDenied;        // Link requests denied (Gateway)
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  unsigned int rxFragmentDrops;   // Fragments dropped; out of sequence or no buffer
+  unsigned int rxFragmentCrcErrors; // Reassembled messages with an invalid CRC
+  unsigned int rxFragmentTimeouts;  // Reassemblies abandoned; fragment overdue
+  #endif
+  #if defined( PROTOCOL_USE_ACK )
+  unsigned int txRetries;         // Frames sent again; no acknowledgement
+  unsigned int txAckFailures;     // Frames never acknowledged
+  unsigned int txAcks;            // Acknowledgements sent (alone or piggybacked)
+  #endif
+  #if defined( PROTOCOL_USE_CSMA )
+  unsigned int txCcaBusy;         // Clear channel assessments that found the channel busy
+  unsigned int txChannelFailures; // Frames dropped; channel busy after every backoff
+  #endif
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER )
+  unsigned int rxDuplicates;      // Frames dropped; already received (Gateway)
+  #endif
+  #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+  unsigned int rxDropTable;       // Frames dropped; new End Point and no entry 
+                                  // to replace (Gateway)
+  #endif
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  unsigned int txRecords;         // Records sent in aggregate frames
+  unsigned int rxRecords;         // Records received in aggregate frames
+  unsigned int rxRecordErrors;    // Aggregate frames with a malformed record
+  #endif
+  #if defined( PROTOCOL_USE_TDMA )
+  unsigned int txBeacons;         // Beacons sent (Gateway)
+  unsigned int rxBeacons;         // Beacons received (End Point)
+  unsigned int rxBeaconMisses;    // Beacons expected but not received (End Point)
+  #endif
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  unsigned int linkDeferred;      // Link requests deferred (sent by a Gateway, 
+                                  // received by an End Point)
+  #endif
+  #if defined( PROTOCOL_USE_MULTICAST )
+  unsigned int txMulticasts;      // Broadcast and group messages sent (Gateway)
+  unsigned int rxMulticasts;      // Broadcast and group messages received (End Point)
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  unsigned int txEncoded;         // Messages sent encoded (End Point)
+  unsigned int txCodecSaved;      // Payload bytes saved by encoding (End Point)
+  unsigned int rxDecoded;         // Encoded messages received (Gateway)
+  unsigned int rxCodecErrors;     // Messages that could not be decoded (Gateway)
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  unsigned int txSecured;         // Frames sent secured
+  unsigned int rxAuthErrors;      // Frames dropped; not secured or not authentic
+  unsigned int rxReplays;         // Frames dropped; older than the last one accepted
+  #endif
+  
+  #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+  /**
+   *  sFrameLatency - time from the GDO0 edge ending a data stream to the 
+   *  FrameComplete callback (PROTOCOL_TIMESTAMP ticks).
+   */
+  struct sFrameLatency
+  {
+    unsigned int min;             // Shortest latency
+    unsigned int max;             // Longest latency
+    unsigned int average;         // Average latency
+    unsigned int samples;         // Number of samples in the average
+  } latency;
+  unsigned long latencySum;       // Sum of the samples in the average
+  #endif
+};
+
+#if defined( PROTOCOL_USE_SEGMENTATION )
+/**
+ *  sFrameFragmentHeader - header carried at the start of every fragment 
+ *  payload.
+ */
+struct sFrameFragmentHeader
+{
+  unsigned char tag;        // Message tag (same for every fragment of a message)
+  unsigned char index;      // Fragment index, starting at 0
+  unsigned char count;      // Number of fragments in the message
+};
+
+/**
+ *  sFrameSegmenter - message being sent as fragments.
+ *
+ *  Note: The message is not copied. The buffer belongs to the frame scheduler
+ *  until the last fragment has been sent.
+ */
+struct sFrameSegmenter
+{
+  unsigned char *payload;   // Location of the message
+  unsigned int length;      // Number of bytes in the message
+  unsigned int offset;      // Message and CRC bytes sent so far
+  unsigned char crc[FRAME_FRAGMENT_CRC_LENGTH]; // Message CRC-16
+  struct sFrameFragmentHeader header; // Header of the current fragment
+  bool dataRequest;         // Data request sent with the last fragment
+  bool active;              // Fragments remain to be sent
+};
+
+/**
+ *  sFrameReassembly - message being reassembled from the fragments of one 
+ *  source.
+ */
+struct sFrameReassembly
+{
+  bool active;              // Reassembly in progress
+  unsigned char srcAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]; // Source of the message
+  unsigned char tag;        // Message tag
+  unsigned char next;       // Index of the next expected fragment
+  unsigned int length;      // Message and CRC bytes received so far
+  unsigned int timeout;     // Milliseconds left to receive the next fragment
+  unsigned char message[PROTOCOL_SEGMENT_MAX_MESSAGE_LENGTH + FRAME_FRAGMENT_CRC_LENGTH];
+};
+#endif
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+/**
+ *  sFrameTxRequest - a data frame waiting in the transmit queue.
+ *
+ *  Note: The payload is not copied. The buffer belongs to the frame scheduler 
+ *  until the request completes.
+ */
+struct sFrameTxRequest
+{
+  unsigned char handle;     // Request handle returned to the caller
+  bool dataRequest;         // Data request (0:simplex, 1:half duplex)
+  unsigned char *payload;   // Location of the payload buffer
+  unsigned char length;     // Number of bytes in the payload
+};
+
+/**
+ *  sFrameTxQueue - bounded queue of data frames sent back-to-back by the frame 
+ *  scheduler.
+ */
+struct sFrameTxQueue
+{
+  struct sFrameTxRequest request[PROTOCOL_TX_QUEUE_SIZE];
+  unsigned char head;       // Index of the oldest request
+  unsigned char count;      // Number of requests in the queue
+  unsigned char nextHandle; // Handle assigned to the next request
+  bool active;              // The oldest request is being serviced
+  
+  /**
+   *  SubmitComplete - a queued request has completed.
+   *
+   *    @param  handle  Handle of the request.
+   *    @param  status  Completion status (FRAME_TX_STATUS_x).
+   */
+  void(*SubmitComplete)(unsigned char handle, unsigned char status);
+};
+#endif
+
+#if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_TDMA ) \
+    || defined( PROTOCOL_USE_JOIN_CONTROL )
+/**
+ *  sFrameRetry - last frame sent, kept so that it can be sent again (busy 
+ *  channel or no acknowledgement) or later (slot of the local node).
+ *
+ *  Note: The payload is not copied. It is sent again from the caller's 
+ *  buffers.
+ */
+struct sFrameRetry
+{
+  struct sFrameHeader header; // Header of the frame (the frame buffer also receives)
+  struct sPhyDataSegment stream[PROTOCOL_FRAME_MAX_SEGMENTS + FRAME_HEADER_SEGMENTS]; // Frame sent
+  unsigned char count;      // Number of segments in the frame
+  unsigned int random;      // Backoff pseudo-random generator state (LFSR)
+};
+#endif
+
+#if defined( PROTOCOL_USE_CSMA )
+/**
+ *  sFrameCsma - CSMA-CA channel access state.
+ */
+struct sFrameCsma
+{
+  bool active;              // Backing off before the channel is assessed again
+  unsigned char backoffs;   // Backoffs of the frame so far
+  unsigned int timeout;     // Milliseconds left in the backoff
+};
+#endif
+
+#if defined( PROTOCOL_USE_ACK )
+/**
+ *  sFrameAck - link-layer acknowledgement state.
+ */
+struct sFrameAck
+{
+  bool enable;              // Request an acknowledgement for every data frame
+  bool active;              // A frame is waiting for its acknowledgement
+  bool owed;                // An acknowledgement is owed to the last sender
+  unsigned char attempt;    // Retransmissions of the frame so far
+  unsigned int timeout;     // Milliseconds left before the frame is sent again
+  
+  /**
+   *  AckComplete - final status of a frame that requested an acknowledgement.
+   *
+   *    @param  acknowledged  The frame was acknowledged.
+   */
+  void(*AckComplete)(bool acknowledged);
+};
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_MAILBOX requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+#ifndef PROTOCOL_MAILBOX_SIZE
+#define PROTOCOL_MAILBOX_SIZE 4         // Default number of downlink messages held
+#endif
+
+#if (PROTOCOL_MAILBOX_SIZE < 1) || (PROTOCOL_MAILBOX_SIZE > 254)
+#error "Frame Error: PROTOCOL_MAILBOX_SIZE must be from 1 to 254."
+#endif
+
+// Downlink message handles
+#define FRAME_MAIL_HANDLE_INVALID       0x00u
+
+/**
+ *  sFrameMail - a downlink message waiting for a data request from its End 
+ *  Point.
+ *
+ *  Note: The payload is not copied. The buffer belongs to the frame scheduler 
+ *  until the message completes.
+ */
+struct sFrameMail
+{
+  unsigned char handle;     // Message handle returned to the caller
+  unsigned char *payload;   // Location of the payload buffer
+  unsigned char length;     // Number of bytes in the payload
+  unsigned char next;       // Next message for the same End Point (or free list)
+};
+
+/**
+ *  sFrameMailbox - pool of downlink messages. The messages of each End Point 
+ *  are queued in order from its endpoint table entry 
+ *  (sPhyAddressEndPoint.mailbox). Every frame a Gateway sends to an End Point
+ *  with queued messages carries FRAME_CONTROL_PENDING; the End Point then 
+ *  sends data requests (empty data frames) until the bit is clear.
+ */
+struct sFrameMailbox
+{
+  struct sFrameMail mail[PROTOCOL_MAILBOX_SIZE];
+  unsigned char free;       // First message not in use
+  unsigned char sending;    // Message being sent (PHY_ADDRESS_ENDPOINT_NONE if none)
+  unsigned char nextHandle; // Handle assigned to the next message
+  bool pending;             // The Gateway holds messages for the local node (End Point)
+  
+  /**
+   *  PostComplete - a posted message has completed.
+   *
+   *    @param  handle  Handle of the message.
+   *    @param  status  Completion status (FRAME_TX_STATUS_x).
+   */
+  void(*PostComplete)(unsigned char handle, unsigned char status);
+};
+#endif
+
+#if defined( PROTOCOL_USE_DUPLICATE_FILTER )
+#ifndef PROTOCOL_DUPLICATE_CACHE_SIZE
+#define PROTOCOL_DUPLICATE_CACHE_SIZE 8 // Default number of sources remembered
+#endif
+
+#if (PROTOCOL_DUPLICATE_CACHE_SIZE < 1) || (PROTOCOL_DUPLICATE_CACHE_SIZE > 128) \
+    || (PROTOCOL_DUPLICATE_CACHE_SIZE & (PROTOCOL_DUPLICATE_CACHE_SIZE - 1))
+#error "Frame Error: PROTOCOL_DUPLICATE_CACHE_SIZE must be a power of two from 1 to 128."
+#endif
+
+/**
+ *  sFrameDuplicate - last sequence number received from a source. The cache 
+ *  is indexed by a hash of the source address; a source that hashes to an 
+ *  entry in use replaces it.
+ */
+struct sFrameDuplicate
+{
+  bool valid;               // Entry holds a source
+  unsigned char srcAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]; // Source of the frames
+  unsigned char seqNumber;  // Sequence number of the last frame received
+};
+#endif
+
+#if defined( PROTOCOL_USE_DUPLICATE_FILTER ) || defined( PROTOCOL_USE_SECURITY )
+#ifndef PROTOCOL_RESPONSE_COPY_LENGTH
+#define PROTOCOL_RESPONSE_COPY_LENGTH PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH // Default longest response kept
+#endif
+
+#if (PROTOCOL_RESPONSE_COPY_LENGTH < 1) || (PROTOCOL_RESPONSE_COPY_LENGTH > PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH)
+#error "Frame Error: PROTOCOL_RESPONSE_COPY_LENGTH must be from 1 to PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH."
+#endif
+
+/**
+ *  sFrameResponseCopy - copy of the last data response sent by a Gateway. An
+ *  End Point sends its data request again when the response carrying the 
+ *  acknowledgement was lost; the request is then answered with the copy 
+ *  instead of being delivered again. A longer response is not kept; the 
+ *  request sent again is only acknowledged.
+ */
+struct sFrameResponseCopy
+{
+  bool valid;               // A response is kept
+  unsigned char destAddr[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]; // Node that requested data
+  unsigned char seqNumber;  // Sequence number of the data request answered
+  unsigned char length;     // Number of bytes in the response
+  unsigned char payload[PROTOCOL_RESPONSE_COPY_LENGTH]; // Response payload
+};
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+#ifndef PROTOCOL_AGGREGATE_LATENCY
+#define PROTOCOL_AGGREGATE_LATENCY 100  // Default milliseconds a record may wait
+#endif
+
+#ifndef PROTOCOL_AGGREGATE_LENGTH
+#define PROTOCOL_AGGREGATE_LENGTH (PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH - FRAME_SECURITY_LENGTH) // Default aggregate payload
+#endif
+
+#if (PROTOCOL_AGGREGATE_LATENCY < 1) || (PROTOCOL_AGGREGATE_LATENCY > 0x7FFF)
+#error "Frame Error: PROTOCOL_AGGREGATE_LATENCY must be from 1 to 32767."
+#endif
+
+#if (PROTOCOL_AGGREGATE_LENGTH < 2) || (PROTOCOL_AGGREGATE_LENGTH > (PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH - FRAME_SECURITY_LENGTH))
+#error "Frame Error: PROTOCOL_AGGREGATE_LENGTH must be from 2 to PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH (less FRAME_SECURITY_LENGTH)."
+#endif
+
+/**
+ *  Aggregate payload: a sequence of records, each preceded by its length.
+ *
+ *    | length (1) | record (length) | length (1) | record (length) | ...
+ */
+#define FRAME_AGGREGATE_PREFIX_LENGTH   1
+
+/**
+ *  sFrameAggregator - records waiting to be sent in one Aggregate frame. Two 
+ *  buffers are used; records are copied into one while the other is sent.
+ */
+struct sFrameAggregator
+{
+  unsigned char buffer[2][PROTOCOL_AGGREGATE_LENGTH]; // Aggregate payloads
+  unsigned char fill;       // Index of the buffer being filled
+  unsigned char length;     // Bytes in the buffer being filled
+  unsigned char count;      // Records in the buffer being filled
+  bool sending;             // The other buffer is being sent
+  unsigned int timeout;     // Milliseconds left before the buffer is sent
+};
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_TDMA requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+#ifndef PROTOCOL_TDMA_SLOTS
+#define PROTOCOL_TDMA_SLOTS 16          // Default number of End Point slots
+#endif
+
+#ifndef PROTOCOL_TDMA_SLOT_LENGTH
+#define PROTOCOL_TDMA_SLOT_LENGTH 50    // Default milliseconds in a slot
+#endif
+
+#ifndef PROTOCOL_TDMA_GUARD
+#define PROTOCOL_TDMA_GUARD 5           // Default guard time in milliseconds
+#endif
+
+#ifndef PROTOCOL_TDMA_MAX_MISSES
+#define PROTOCOL_TDMA_MAX_MISSES 3      // Default beacons missed before the timing is lost
+#endif
+
+#if (PROTOCOL_TDMA_SLOTS < 1) || (PROTOCOL_TDMA_SLOTS > 254)
+#error "Frame Error: PROTOCOL_TDMA_SLOTS must be from 1 to 254."
+#endif
+
+#if (PROTOCOL_TDMA_GUARD < 1) || ((2 * PROTOCOL_TDMA_GUARD) >= PROTOCOL_TDMA_SLOT_LENGTH)
+#error "Frame Error: PROTOCOL_TDMA_GUARD must be at least 1 and less than half of PROTOCOL_TDMA_SLOT_LENGTH."
+#endif
+
+#if (((PROTOCOL_TDMA_SLOTS + 1) * PROTOCOL_TDMA_SLOT_LENGTH) > 0x7FFF)
+#error "Frame Error: the superframe must be at most 32767 milliseconds."
+#endif
+
+#if (PROTOCOL_TDMA_MAX_MISSES < 1) || (PROTOCOL_TDMA_MAX_MISSES > 255)
+#error "Frame Error: PROTOCOL_TDMA_MAX_MISSES must be from 1 to 255."
+#endif
+
+/**
+ *  Superframe: a beacon from the Gateway followed by PROTOCOL_TDMA_SLOTS 
+ *  slots, one per End Point. Time is counted from the end of the beacon; the 
+ *  next beacon is sent once every slot has passed.
+ *
+ *    | beacon | slot 0 | slot 1 | ... | slot n-1 | beacon | ...
+ *
+ *  An End Point sends PROTOCOL_TDMA_GUARD milliseconds into its slot and wakes
+ *  up PROTOCOL_TDMA_GUARD milliseconds ahead of the beacon. A slot must hold 
+ *  the longest frame and its response or acknowledgement; the guard time must
+ *  cover the beacon air time and the clock drift over PROTOCOL_TDMA_MAX_MISSES
+ *  superframes.
+ */
+#define FRAME_TDMA_BEACON_TIME      (PROTOCOL_TDMA_SLOTS * PROTOCOL_TDMA_SLOT_LENGTH)
+#define FRAME_TDMA_SLOT_START(slot) (((unsigned int)(slot) * PROTOCOL_TDMA_SLOT_LENGTH) + PROTOCOL_TDMA_GUARD)
+
+/**
+ *  sFrameTdma - superframe state. The beacon is a link request sent to every 
+ *  node; it has no payload.
+ */
+struct sFrameTdma
+{
+  bool synced;              // The superframe timing is known
+  bool beacon;              // The frame being sent is a beacon (Gateway)
+  bool window;              // The receiver is waiting for a beacon (End Point)
+  bool waiting;             // A frame waits for the slot (End Point)
+  unsigned char slot;       // Slot of the local node (End Point, 
+                            // PHY_ADDRESS_SLOT_NONE if none)
+  unsigned char misses;     // Beacons missed in a row (End Point)
+  unsigned int clock;       // Milliseconds since the end of the last beacon
+};
+#endif
+
+#if defined( PROTOCOL_USE_JOIN_CONTROL )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_JOIN_CONTROL requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+#ifndef PROTOCOL_JOIN_BACKOFF
+#define PROTOCOL_JOIN_BACKOFF 100       // Default first link request backoff window (ms)
+#endif
+
+#ifndef PROTOCOL_JOIN_MAX_BE
+#define PROTOCOL_JOIN_MAX_BE 6          // Default maximum backoff exponent
+#endif
+
+#ifndef PROTOCOL_JOIN_ADMIT
+#define PROTOCOL_JOIN_ADMIT 4           // Default link requests admitted per period
+#endif
+
+#ifndef PROTOCOL_JOIN_PERIOD
+#define PROTOCOL_JOIN_PERIOD 1000       // Default admission period (ms)
+#endif
+
+#if (PROTOCOL_JOIN_BACKOFF < 1) || (PROTOCOL_JOIN_MAX_BE < 0) || (PROTOCOL_JOIN_MAX_BE > 8) \
+    || ((PROTOCOL_JOIN_BACKOFF * (1L << PROTOCOL_JOIN_MAX_BE)) > 0x7FFF)
+#error "Frame Error: PROTOCOL_JOIN_BACKOFF << PROTOCOL_JOIN_MAX_BE must be from 1 to 32767 (MAX_BE <= 8)."
+#endif
+
+#if (PROTOCOL_JOIN_ADMIT < 1) || (PROTOCOL_JOIN_ADMIT > 255)
+#error "Frame Error: PROTOCOL_JOIN_ADMIT must be from 1 to 255."
+#endif
+
+#if (PROTOCOL_JOIN_PERIOD < 1) || (PROTOCOL_JOIN_PERIOD > 0x7FFF)
+#error "Frame Error: PROTOCOL_JOIN_PERIOD must be from 1 to 32767."
+#endif
+
+/**
+ *  sFrameJoin - link request pacing. An End Point backs off between link 
+ *  requests. A Gateway admits at most PROTOCOL_JOIN_ADMIT link requests per 
+ *  period and spreads the End Points it defers over the following periods.
+ */
+struct sFrameJoin
+{
+  unsigned char attempt;    // Link requests sent since the last link (End Point)
+  unsigned char admitted;   // Link requests admitted in the period (Gateway)
+  unsigned int backlog;     // Link requests deferred to later periods (Gateway)
+  unsigned int timeout;     // Milliseconds left in the backoff (End Point) or 
+                            // in the period (Gateway)
+};
+#endif
+
+#if defined( PROTOCOL_USE_MULTICAST )
+#ifndef PROTOCOL_MULTICAST_GROUPS
+#define PROTOCOL_MULTICAST_GROUPS 4     // Default number of groups of an End Point
+#endif
+
+#if (PROTOCOL_MULTICAST_GROUPS < 1) || (PROTOCOL_MULTICAST_GROUPS > 16)
+#error "Frame Error: PROTOCOL_MULTICAST_GROUPS must be from 1 to 16."
+#endif
+
+#if defined( PROTOCOL_USE_TDMA ) && (PROTOCOL_FRAME_MAX_SEGMENTS < 2)
+#error "Frame Error: PROTOCOL_USE_MULTICAST with PROTOCOL_USE_TDMA requires PROTOCOL_FRAME_MAX_SEGMENTS of at least 2."
+#endif
+
+/**
+ *  Group addresses share the address space of the nodes; a group is any 
+ *  address that the End Points of the group were told to accept. The 
+ *  broadcast address (PHY_ADDRESS_BROADCAST) reaches every End Point.
+ *
+ *  With PROTOCOL_USE_TDMA, the message is carried by the next beacon since 
+ *  End Points only wake up for it. The beacon payload is then:
+ *
+ *    | group address | message |
+ */
+#define FRAME_MULTICAST_GROUP_LENGTH    PROTOCOL_PHYADDRESS_ADDRESS_SIZE
+
+// Not a group of the local node
+#define FRAME_MULTICAST_GROUP_NONE      0xFFu
+
+/**
+ *  sFrameMulticast - broadcast and group downlink.
+ */
+struct sFrameMulticast
+{
+  unsigned char group[PROTOCOL_MULTICAST_GROUPS][PROTOCOL_PHYADDRESS_ADDRESS_SIZE];
+                            // Groups of the local node (End Point)
+  unsigned char groups;     // Number of groups (End Point)
+  unsigned char dest[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];
+                            // Group of the message being sent (Gateway)
+  bool sending;             // The frame being sent is a group message (Gateway)
+  #if defined( PROTOCOL_USE_TDMA )
+  bool waiting;             // A message waits for the beacon (Gateway)
+  unsigned char *payload;   // Message waiting for the beacon (Gateway)
+  unsigned char length;     // Number of message bytes (Gateway)
+  #endif
+};
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+#if !defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "Frame Error: PROTOCOL_USE_CODEC requires PROTOCOL_USE_ENDPOINT_TABLE."
+#endif
+
+#ifndef PROTOCOL_CODEC_KEY_INTERVAL
+#define PROTOCOL_CODEC_KEY_INTERVAL 8   // Default messages per key message
+#endif
+
+// PROTOCOL_CODEC_MAX_LENGTH and PROTOCOL_CODEC_REFERENCE_LENGTH default in 
+// PhyAddress.h; the endpoint table holds the references.
+#if (PROTOCOL_CODEC_MAX_LENGTH < 1) || (PROTOCOL_CODEC_MAX_LENGTH > 255)
+#error "Frame Error: PROTOCOL_CODEC_MAX_LENGTH must be from 1 to 255."
+#endif
+
+#if (PROTOCOL_CODEC_REFERENCE_LENGTH < 1) || (PROTOCOL_CODEC_REFERENCE_LENGTH > PROTOCOL_CODEC_MAX_LENGTH)
+#error "Frame Error: PROTOCOL_CODEC_REFERENCE_LENGTH must be from 1 to PROTOCOL_CODEC_MAX_LENGTH."
+#endif
+
+#if (PROTOCOL_CODEC_KEY_INTERVAL < 1) || (PROTOCOL_CODEC_KEY_INTERVAL > 255)
+#error "Frame Error: PROTOCOL_CODEC_KEY_INTERVAL must be from 1 to 255."
+#endif
+
+/**
+ *  Codec header, the first payload byte of every data frame of an End Point.
+ *
+ *    | codec identifier (2) | generation (6) |
+ *
+ *  A message of at most PROTOCOL_CODEC_REFERENCE_LENGTH bytes sent through 
+ *  FrameSendMessage or FrameSubmit becomes the reference of the next one; it
+ *  carries the generation of the reference (1 to 63, in turn). A Delta 
+ *  message is only decoded against the reference of the previous generation.
+ *  Every PROTOCOL_CODEC_KEY_INTERVAL-th message (and the first one after a 
+ *  link request or a failed transmission) is a key message that is not coded 
+ *  against the reference, so that a lost message is recovered from.
+ */
+#define FRAME_CODEC_HEADER_LENGTH   1
+#define FRAME_CODEC_ID_SHIFT        6
+#define FRAME_CODEC_GENERATION      0x3Fu
+#define FRAME_CODEC_GENERATION_NONE 0x00u   // Not a reference
+#define FRAME_CODEC_HEADER(id, generation)  (((id) << FRAME_CODEC_ID_SHIFT) | (generation))
+#define FRAME_CODEC_NEXT_GENERATION(generation) (((generation) % FRAME_CODEC_GENERATION) + 1)
+
+/**
+ *  sFrameCodec - payload codecs. An End Point encodes its messages with the 
+ *  codecs both ends enabled; a Gateway decodes them against the reference 
+ *  kept for each End Point (sPhyAddressEndPoint.codecReference).
+ */
+struct sFrameCodec
+{
+  unsigned char enabled;    // Codecs used (End Point) or decoded (Gateway)
+  unsigned char accepted;   // Codecs decoded by the Gateway (End Point)
+  unsigned char next;       // Codec header of the next data frame (End Point)
+  unsigned char header;     // Codec header of the frame being sent (End Point)
+  unsigned char generation; // Generation of the reference (End Point)
+  unsigned char keyCount;   // Delta messages left until the next key message
+                            // (End Point)
+  unsigned char length;     // Number of reference bytes (End Point, 0 if none)
+  unsigned char reference[PROTOCOL_CODEC_REFERENCE_LENGTH];
+                            // Last message sent (End Point)
+  unsigned char buffer[PROTOCOL_CODEC_MAX_LENGTH];
+                            // Encoded message being sent (End Point) or 
+                            // decoded message (Gateway)
+};
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+/**
+ *  sFrameSecurity - link security. The key schedule holds the key of the link
+ *  of an End Point, or of the End Point a Gateway last exchanged a secured 
+ *  frame with (the keys of a Gateway are kept in its endpoint table).
+ */
+struct sFrameSecurity
+{
+  const unsigned char *key;       // Network key (NULL if frames are not secured)
+  unsigned long txCounter;        // Frame counter of the next secured frame
+  unsigned long seed;             // Next key seed (Gateway) or seed of the last
+                                  // link (End Point)
+  unsigned long seeds;            // Number of key seeds left (Gateway)
+  bool seeded;                    // The first key seed (Gateway) or challenge 
+                                  // (End Point) has been drawn
+  bool seedUsed;                  // seed holds the seed of a link (End Point)
+  bool linking;                   // A link request is pending (End Point)
+  unsigned char challenge[FRAME_SECURITY_CHALLENGE_LENGTH];
+                                  // Challenge of the link request pending (End
+                                  // Point) or being answered (Gateway)
+  unsigned long rxCounter;        // Lowest new frame counter of the Gateway 
+                                  // (End Point)
+  bool linked;                    // The schedule holds the link key (End Point)
+  bool replayed;                  // The last frame received repeats the last one
+                                  // accepted from its link
+  struct sPhyAddressEndPoint *cached; // End Point whose key is in the schedule 
+                                  // (Gateway, NULL if none)
+  struct sSecurityKey schedule;   // Expanded link key
+  unsigned char buffer[PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH];
+                                  // Secured payload being sent
+};
+#endif
+
+#if defined( PROTOCOL_USE_RX_POOL )
+#ifndef PROTOCOL_RX_POOL_SIZE
+#define PROTOCOL_RX_POOL_SIZE 2         // Default number of receive buffers
+#endif
+
+/**
+ *  sFrameRxPool - receive buffers. A received payload is loaned to the layer
+ *  above and the receiver is turned on again using a buffer that is free.
+ */
+struct sFrameRxPool
+{
+  struct sFrame frame[PROTOCOL_RX_POOL_SIZE];   // Receive buffers
+  volatile bool loaned[PROTOCOL_RX_POOL_SIZE];  // Buffer is loaned out
+  volatile bool starved;                        // Receiver is waiting on a buffer
+};
+#endif
+
 /**
  *  sFrameScheduler - Media Access Control (MAC) scheduler information.
  */
 struct sFrameScheduler
 {
+  unsigned char mode;             // Role of the local node (FRAME_CONTROL_MODE_x)
+  
   /**
    *  FrameComplete - the frame scheduler has entered a receive completion state 
    *  for the current operation (e.g. a frame has been validated and received).
    *
    *  Note: Data requests are sent from an End Point node to a Gateway node.
-   *  Therefore, the End Point FrameComplete callback does not need a data 
-   *  request indicator; a Gateway node CANNOT request data!
+   *  Therefore, the data request indicator is always false on an End Point; a
+   *  Gateway node CANNOT request data!
    *
-   *    @param  [dataRequest] Data request indicator.
+   *    @param  dataRequest   Data request indicator.
    *    @param  payload       Location of the frame payload buffer. Contains 
    *                          data for the callee.
    *    @param  length        Number of bytes in the payload.
@@ -177,13 +1159,9 @@ struct sFrameScheduler
    *    @return Status message from callee (currently not being used for frame 
    *            use).
    */
-  #if defined( PROTOCOL_ENDPOINT )
-  unsigned char(*FrameComplete)(unsigned char *payload, 
-                                unsigned char length);
-  #elif defined( PROTOCOL_GATEWAY )
   unsigned char(*FrameComplete)(bool dataRequest, 
                                 unsigned char *payload, 
-                                unsigned char length);
+                                unsigned int length);
   
   /**
    *  LinkRequest - notification of a link request or link request status.
@@ -191,11 +1169,12 @@ struct sFrameScheduler
    *  For the Gateway, this callback will allow the application to read the
    *  request's payload and accept or deny the request. 
    *
-   *  Note: This callback does not exist for an End Point.
+   *  Note: This callback is not used by an End Point.
    *
    *    @param  payload   Location of the frame payload buffer. Contains a link
    *                      request message for the callee.
-   *    @param  length    Number of bytes in the payload.
+   *    @param  length    Number of bytes in the payload (the challenge of a 
+   *                      secured link request excluded).
    *
    *    @return Status message from callee (currently not being used for frame
    *            use).
@@ -203,16 +1182,94 @@ struct sFrameScheduler
   bool(*LinkRequest)(unsigned char *payload, unsigned char length);
   
   struct sFrameDataResponse dataResponse; // Data request response information
-  #endif
   
   // --------------------------------------------------------------------------
   // Frame scheduler resources
   
+  struct sPhyAddressInfo *phyAddress; // Addressing information
+  struct sPhyDevice *phy;         // Physical device
   volatile bool busy;             // Frame scheduler busy flag
+  volatile bool listening;        // The receiver is waiting for a frame
   volatile bool txBusy;           // Frame transmit busy flag
   volatile bool rxBusy;           // Frame receive busy flag
   struct sFrame frame;            // Frame for RX/TX
+  struct sFrame *rx;              // Last received frame
   unsigned char length;           // Frame length in bytes
+  unsigned char seqNumber;        // Next outgoing frame sequence number
+  struct sFrameCounters counters; // Scheduler statistics
+  
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  unsigned char link;             // Link identifier assigned by the Gateway (End Point)
+  unsigned char txLink;           // Link identifier of the frame being sent
+  #endif
+  
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER ) || defined( PROTOCOL_USE_TDMA ) \
+      || defined( PROTOCOL_USE_JOIN_CONTROL ) || defined( PROTOCOL_USE_CODEC ) \
+      || defined( PROTOCOL_USE_SECURITY )
+  unsigned char linkResponse[FRAME_LINK_RESPONSE_SIZE]; // Link request response payload (Gateway)
+  #endif
+  
+  #if defined( PROTOCOL_USE_RX_POOL )
+  struct sFrameRxPool rxPool;     // Loaned receive buffers
+  #endif
+  
+  #if defined( PROTOCOL_USE_TX_QUEUE )
+  struct sFrameTxQueue txQueue;   // Frames waiting to be sent
+  #endif
+  
+  #if defined( PROTOCOL_USE_MAILBOX )
+  struct sFrameMailbox mailbox;   // Downlink messages waiting for data requests
+  #endif
+  
+  #if defined( PROTOCOL_USE_SEGMENTATION )
+  struct sFrameSegmenter segmenter; // Message being sent as fragments
+  struct sFrameReassembly reassembly[PROTOCOL_SEGMENT_BUFFERS]; // Messages being received
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK ) || defined( PROTOCOL_USE_CSMA ) || defined( PROTOCOL_USE_TDMA ) \
+      || defined( PROTOCOL_USE_JOIN_CONTROL )
+  struct sFrameRetry retry;       // Frame kept for retransmission
+  #endif
+  
+  #if defined( PROTOCOL_USE_CSMA )
+  struct sFrameCsma csma;         // Channel access
+  #endif
+  
+  #if defined( PROTOCOL_USE_ACK )
+  struct sFrameAck ack;           // Link-layer acknowledgements
+  #endif
+  
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER )
+  struct sFrameDuplicate duplicate[PROTOCOL_DUPLICATE_CACHE_SIZE]; // Last frame of each source
+  #endif
+  
+  #if defined( PROTOCOL_USE_DUPLICATE_FILTER ) || defined( PROTOCOL_USE_SECURITY )
+  struct sFrameResponseCopy lastResponse; // Last data response sent (Gateway)
+  #endif
+  
+  #if defined( PROTOCOL_USE_AGGREGATION )
+  struct sFrameAggregator aggregator; // Records waiting to be sent
+  #endif
+  
+  #if defined( PROTOCOL_USE_TDMA )
+  struct sFrameTdma tdma;         // Superframe
+  #endif
+  
+  #if defined( PROTOCOL_USE_JOIN_CONTROL )
+  struct sFrameJoin join;         // Link request pacing
+  #endif
+  
+  #if defined( PROTOCOL_USE_MULTICAST )
+  struct sFrameMulticast multicast; // Broadcast and group downlink
+  #endif
+  
+  #if defined( PROTOCOL_USE_CODEC )
+  struct sFrameCodec codec;       // Payload codecs
+  #endif
+  
+  #if defined( PROTOCOL_USE_SECURITY )
+  struct sFrameSecurity security; // Link security
+  #endif
 };
 
 // -----------------------------------------------------------------------------
@@ -231,25 +1288,57 @@ struct sFrameScheduler
 /**
  *  FrameInit - initialize the frame scheduler.
  *
+ *    @param  scheduler     Frame scheduler being initialized.
+ *    @param  phyAddress    Addressing information used by the scheduler. It 
+ *                          must already be initialized.
+ *    @param  phy           Physical device used by the scheduler. It must 
+ *                          already be initialized with this scheduler as its 
+ *                          context (see FrameAssemble).
+ *    @param  mode          Role of the local node (FRAME_CONTROL_MODE_x). It
+ *                          selects the validation and scheduling behaviour.
  *    @param  FrameComplete Callback which is invoked when a frame scheduler 
  *                          receive operation is complete. It is used as a
  *                          method of providing the callee any received data.
- *    @param  [LinkRequest] Callback invoked when a link request frame is
+ *    @param  LinkRequest   Callback invoked when a link request frame is
  *                          received and validated on a Gateway. It is used as
  *                          a method of providing the callee any received link
  *                          data and a method of accepting/denying the request.
+ *                          May be NULL for an End Point.
  */
-#if defined( PROTOCOL_ENDPOINT )
-void FrameInit(unsigned char(*FrameComplete)(unsigned char*, unsigned char));
-#elif defined( PROTOCOL_GATEWAY )
-void FrameInit(unsigned char(*FrameComplete)(bool, unsigned char*, unsigned char),
+void FrameInit(struct sFrameScheduler *scheduler,
+               struct sPhyAddressInfo *phyAddress,
+               struct sPhyDevice *phy,
+               unsigned char mode,
+               unsigned char(*FrameComplete)(bool, unsigned char*, unsigned int),
                bool(*LinkRequest)(unsigned char *payload, unsigned char length));
-#endif
 
 /**
- *  FrameGetInfo - 
+ *  FrameGetInfo - get the last received frame.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Location of the last received frame.
  */
-struct sFrame* FrameGetInfo(void);
+struct sFrame* FrameGetInfo(struct sFrameScheduler *scheduler);
+
+/**
+ *  FrameGetCounters - get the scheduler statistics.
+ *
+ *    @param  scheduler  Frame scheduler.
+ *
+ *    @return Location of the scheduler counters.
+ */
+const struct sFrameCounters* FrameGetCounters(struct sFrameScheduler *scheduler);
+
+/**
+ *  FrameClearCounters - clear the scheduler statistics.
+ *
+ *  Note: It is assumed that this function is called from inside a critical
+ *  region.
+ *
+ *    @param  scheduler  Frame scheduler.
+ */
+void FrameClearCounters(struct sFrameScheduler *scheduler);
 
 /**
  *  FrameSetDataResponse - setup the data response structure with a payload
@@ -258,34 +1347,149 @@ struct sFrame* FrameGetInfo(void);
  *  Note: This is used by the Gateway role to provide a response to potential
  *  data requests originating from End Point nodes.
  *
+ *    @param  scheduler Frame scheduler.
  *    @param  payload Location of the frame payload buffer. Contains the data
  *                    response for the caller.
  *    @param  length  Number of bytes in the payload.
  */
-void FrameSetDataResponse(unsigned char *payload, 
+void FrameSetDataResponse(struct sFrameScheduler *scheduler,
+                          unsigned char *payload, 
                           unsigned char length);   
 
+#if defined( PROTOCOL_USE_TX_QUEUE )
+/**
+ *  FrameTxQueueInit - initialize the transmit queue.
+ *
+ *    @param  scheduler       Frame scheduler.
+ *    @param  SubmitComplete  Callback invoked when a queued request completes. 
+ *                            May be NULL.
+ */
+void FrameTxQueueInit(struct sFrameScheduler *scheduler,
+                      void(*SubmitComplete)(unsigned char, unsigned char));
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+/**
+ *  FrameMailboxInit - initialize the downlink mailboxes.
+ *
+ *    @param  scheduler     Frame scheduler.
+ *    @param  PostComplete  Callback invoked when a posted message completes. 
+ *                          May be NULL.
+ */
+void FrameMailboxInit(struct sFrameScheduler *scheduler,
+                      void(*PostComplete)(unsigned char, unsigned char));
+#endif
+
+#if defined( PROTOCOL_USE_ACK )
+/**
+ *  FrameAckInit - initialize link-layer acknowledgements. Must be called 
+ *  before FrameInit.
+ *
+ *  An acknowledged frame is sent with FRAME_CONTROL_ACK_REQ. The receiver 
+ *  answers with FRAME_CONTROL_ACK, piggybacked on its data response when it has
+ *  one. A frame that is not acknowledged within PROTOCOL_ACK_TIMEOUT (plus a 
+ *  random backoff that doubles with every retry) is sent again, up to 
+ *  PROTOCOL_ACK_MAX_RETRIES times.
+ *
+ *  Note: Only an End Point requests acknowledgements; link requests are never
+ *  acknowledged (the link request response serves that purpose).
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  enable      Request an acknowledgement for every data frame.
+ *    @param  AckComplete Callback invoked with the final status of every frame
+ *                        that requested an acknowledgement. May be NULL.
+ */
+void FrameAckInit(struct sFrameScheduler *scheduler,
+                  bool enable,
+                  void(*AckComplete)(bool));
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+/**
+ *  FrameCodecInit - select the payload codecs. Must be called before 
+ *  FrameInit.
+ *
+ *  A Gateway tells every End Point it links the codecs it decodes. An End 
+ *  Point encodes the messages sent through FrameSendMessage and FrameSubmit 
+ *  with the codecs both ends selected, if that makes them shorter (see 
+ *  Codec.h); other data frames are sent as is.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  codecs      Codecs used (End Point) or decoded (Gateway) 
+ *                        (CODEC_SET_x, 0 for none).
+ */
+void FrameCodecInit(struct sFrameScheduler *scheduler,
+                    unsigned char codecs);
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+/**
+ *  FrameSecurityInit - select the network key. Must be called before 
+ *  FrameInit.
+ *
+ *  With a network key, every frame is secured except link requests, their 
+ *  responses, beacons and group messages; a frame that is not secured, not 
+ *  authentic or older than the last one accepted from its link is dropped. 
+ *  The key of a link is derived from the network key, both addresses and a 
+ *  seed the Gateway sends in its link request response, so an End Point must
+ *  link again after a reset before it sends data. An End Point only accepts 
+ *  an authentic response to its pending link request, and refuses the seed of
+ *  the link it last had.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  key         Network key (SECURITY_KEY_LENGTH bytes, shared by 
+ *                        every node), or NULL to send frames as is. It must 
+ *                        remain valid while the scheduler is in use.
+ */
+void FrameSecurityInit(struct sFrameScheduler *scheduler,
+                       const unsigned char *key);
+#endif
+
+#if defined( PROTOCOL_USE_RX_POOL )
+/**
+ *  FrameReleaseBuffer - return a loaned receive buffer to the pool. If the 
+ *  receiver was waiting on a free buffer, it is turned back on.
+ *
+ *  Note: It is assumed that this function is called from inside a critical
+ *  region.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  payload Payload location passed to the FrameComplete callback.
+ *
+ *    @return Success of the operation. Fails if the payload is not part of 
+ *            the receive buffer pool.
+ */
+bool FrameReleaseBuffer(struct sFrameScheduler *scheduler,
+                        unsigned char *payload);
+#endif
+
 // -----------------------------------------------------------------------------
 // Frame basic operations
 
 /**
  *  FrameIdle - perform the scheduler's idle operation. For an End Endpoint, go 
- *  to a low power state. For a Gateway, turn on the receiver.
+ *  to a low power state (or listen while it waits for a beacon). For a 
+ *  Gateway, turn on the receiver.
+ *
+ *    @param  scheduler  Frame scheduler.
  */
-void FrameIdle(void);
+void FrameIdle(struct sFrameScheduler *scheduler);
 
 /**
  *  FrameListen - listen for an incoming frame.
  *
+ *    @param  scheduler  Frame scheduler.
+ *
  *    @return Frame scheduler busy status (operation was successful if true,
  *            else try again at a later time).
  */
-bool FrameListen(void);
+bool FrameListen(struct sFrameScheduler *scheduler);
 
 /**
  *  FrameSend - send a frame to the destination. Use FrameBuild(...) to 
  *  construct the frame.
  *
+ *    @param  scheduler Frame scheduler.
  *    @param  type      Type of frame being constructed.
  *    @param  payload   Buffer holding the frame payload.
  *    @param  length    Number of payload bytes.
@@ -293,18 +1497,209 @@ bool FrameListen(void);
  *    @return Frame scheduler busy status (operation was successful if true,
  *            else try again at a later time).
  */
-bool FrameSend(enum eFrameType type,
+bool FrameSend(struct sFrameScheduler *scheduler,
+               enum eFrameType type,
                bool dataRequest,
                unsigned char *payload, 
                unsigned char length);
 
+/**
+ *  FrameSendv - send a frame to the destination. The payload is gathered from 
+ *  a list of segments; the frame header and each segment are written to the
+ *  Physical layer in order without being copied into the frame buffer.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  type      Type of frame being constructed.
+ *    @param  segment   List of segments holding the frame payload. Each buffer
+ *                      only needs to remain valid until this function returns,
+ *                      unless the frame requests an acknowledgement or an End
+ *                      Point holds it for its slot (PROTOCOL_USE_TDMA); it is
+ *                      then sent again or later from the same buffers.
+ *    @param  count     Number of segments (PROTOCOL_FRAME_MAX_SEGMENTS max).
+ *
+ *    @return Frame scheduler busy status (operation was successful if true,
+ *            else try again at a later time).
+ */
+bool FrameSendv(struct sFrameScheduler *scheduler,
+                enum eFrameType type,
+                bool dataRequest,
+                const struct sPhyDataSegment *segment,
+                unsigned char count);
+
+/**
+ *  FrameConnect - send a link request to the Gateway. With 
+ *  PROTOCOL_USE_JOIN_CONTROL, a link request is refused until the backoff of
+ *  the previous one (or the retry time given by the Gateway) has elapsed. With
+ *  a network key, a new challenge follows the payload; the link request stays
+ *  pending until the Gateway answers it.
+ *
+ *  Note: This function should only be used on an End Point node.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  payload   Buffer holding the link request payload.
+ *    @param  length    Number of payload bytes.
+ *
+ *    @return Frame scheduler busy status (operation was successful if true,
+ *            else try again at a later time).
+ */
+bool FrameConnect(struct sFrameScheduler *scheduler,
+                  unsigned char *payload,
+                  unsigned char length);
+
+/**
+ *  FrameSendMessage - send a data message to the destination. A message that 
+ *  does not fit in one frame is sent as fragments when PROTOCOL_USE_SEGMENTATION
+ *  is defined; the receiver reassembles it before it is passed to 
+ *  FrameComplete.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  dataRequest Data request (0:simplex, 1:half duplex). A fragmented
+ *                        message requests data with its last fragment.
+ *    @param  payload     Buffer holding the message. A fragmented message must
+ *                        remain valid until the scheduler is no longer busy.
+ *    @param  length      Number of message bytes.
+ *
+ *    @return Frame scheduler busy status (operation was successful if true,
+ *            else try again at a later time).
+ */
+bool FrameSendMessage(struct sFrameScheduler *scheduler,
+                      bool dataRequest,
+                      unsigned char *payload,
+                      unsigned int length);
+
+#if defined( PROTOCOL_USE_TX_QUEUE )
+/**
+ *  FrameSubmit - add a data frame to the transmit queue. The frame is sent as
+ *  soon as the scheduler is free; queued frames are sent back-to-back.
+ *
+ *  Note: It is assumed that this function is called from inside a critical
+ *  region.
+ *
+ *    @param  scheduler   Frame scheduler.
+ *    @param  dataRequest Data request (0:simplex, 1:half duplex).
+ *    @param  payload     Buffer holding the frame payload. It must remain valid
+ *                        until the request completes.
+ *    @param  length      Number of payload bytes.
+ *
+ *    @return Handle of the request, or FRAME_TX_HANDLE_INVALID if the queue is
+ *            full or the payload is too large.
+ */
+unsigned char FrameSubmit(struct sFrameScheduler *scheduler,
+                          bool dataRequest,
+                          unsigned char *payload,
+                          unsigned char length);
+#endif
+
+#if defined( PROTOCOL_USE_MAILBOX )
+/**
+ *  FramePost - post a downlink message for an End Point (Gateway only). The 
+ *  message is sent as the response to the next data request of the End Point
+ *  that no loaded data response (FrameSetDataResponse) answers. The messages 
+ *  of an End Point are sent in the order they were posted.
+ *
+ *  Note: It is assumed that this function is called from inside a critical
+ *  region.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  address   End Point address.
+ *    @param  payload   Buffer holding the message. It must remain valid until
+ *                      the message completes.
+ *    @param  length    Number of payload bytes.
+ *
+ *    @return Handle of the message, or FRAME_MAIL_HANDLE_INVALID if the pool 
+ *            or the endpoint table is full or the payload is too large.
+ */
+unsigned char FramePost(struct sFrameScheduler *scheduler,
+                        const unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                        unsigned char *payload,
+                        unsigned char length);
+#endif
+
+#if defined( PROTOCOL_USE_AGGREGATION )
+/**
+ *  FrameAggregate - add a record to the next Aggregate frame. The record is 
+ *  copied; the frame is sent once the next record would not fit or 
+ *  PROTOCOL_AGGREGATE_LATENCY milliseconds after its first record was added. 
+ *  The receiver delivers each record through its own FrameComplete callback.
+ *
+ *  Note: It is assumed that this function is called from inside a critical
+ *  region.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  payload   Record to add.
+ *    @param  length    Number of record bytes (1 to PROTOCOL_AGGREGATE_LENGTH 
+ *                      - FRAME_AGGREGATE_PREFIX_LENGTH).
+ *
+ *    @return Whether the record was added (true) or not (false: the record 
+ *            is too large or a full frame could not be sent yet).
+ */
+bool FrameAggregate(struct sFrameScheduler *scheduler,
+                    const unsigned char *payload,
+                    unsigned char length);
+#endif
+
+#if defined( PROTOCOL_USE_MULTICAST )
+/**
+ *  FrameMulticast - send a message to every End Point or to a group of End 
+ *  Points. The message is not acknowledged. With PROTOCOL_USE_TDMA it is 
+ *  carried by the next beacon and the payload must stay valid until the 
+ *  FrameComplete callback; otherwise it is sent at once and reaches the End 
+ *  Points whose receiver is on.
+ *
+ *  Note: This function should only be used on a Gateway node. It is assumed 
+ *  that this function is called from inside a critical region.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  group     Group address, or NULL to send to every End Point.
+ *    @param  payload   Message to send.
+ *    @param  length    Number of message bytes.
+ *
+ *    @return Whether the message was sent or queued for the beacon (true) or
+ *            not (false).
+ */
+bool FrameMulticast(struct sFrameScheduler *scheduler,
+                    const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE],
+                    unsigned char *payload,
+                    unsigned char length);
+
+/**
+ *  FrameGroupAdd - accept the frames sent to a group. Every End Point accepts
+ *  the frames sent to the broadcast address.
+ *
+ *  Note: This function should only be used on an End Point node.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  group     Group address.
+ *
+ *    @return Whether the End Point belongs to the group (true) or not (false:
+ *            the group table is full or the address is the broadcast address).
+ */
+bool FrameGroupAdd(struct sFrameScheduler *scheduler,
+                   const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]);
+
+/**
+ *  FrameGroupRemove - stop accepting the frames sent to a group.
+ *
+ *  Note: This function should only be used on an End Point node.
+ *
+ *    @param  scheduler Frame scheduler.
+ *    @param  group     Group address.
+ *
+ *    @return Whether the End Point belonged to the group (true) or not (false).
+ */
+bool FrameGroupRemove(struct sFrameScheduler *scheduler,
+                      const unsigned char group[PROTOCOL_PHYADDRESS_ADDRESS_SIZE]);
+#endif
+
 // -----------------------------------------------------------------------------
 // Frame scheduling operations
 
 /**
  *  FrameBusy - 
+ *
+ *    @param  scheduler  Frame scheduler.
  */
-bool FrameBusy(void);
+bool FrameBusy(struct sFrameScheduler *scheduler);
 
 /**
  *  FrameAssemble - assemble the incoming data streams into a complete frame.
@@ -314,13 +1709,16 @@ bool FrameBusy(void);
  *  region. Physical device interrupts should be disabled when entering/exiting 
  *  this function.
  *
+ *    @param  context   Frame scheduler (registered with PhyInit).
  *    @param  dataField Buffer containing the received data field (frame).
  *    @param  length    Length of the data field.
  *
  *    @return Status message from caller (currently not being used for frame
  *            use).
  */
-unsigned char FrameAssemble(unsigned char *dataField, unsigned char length);
+unsigned char FrameAssemble(void *context, 
+                            unsigned char *dataField, 
+                            unsigned char length);
 
 /**
  *  FrameDisassemble - disassemble the outgoing frame into data streams. Once
@@ -331,10 +1729,12 @@ unsigned char FrameAssemble(unsigned char *dataField, unsigned char length);
  *  region. Physical device interrupts should be disabled when entering/exiting 
  *  this function.
  *
+ *    @param  context Frame scheduler (registered with PhyInit).
+ *
  *    @return Status message from caller (currently not being used for frame
  *            use).
  */
-unsigned char FrameDisassemble(void);
+unsigned char FrameDisassemble(void *context);
 
 /**
  *  FrameTimeout - callback that is invoked when an End Point operation times
@@ -342,9 +1742,23 @@ unsigned char FrameDisassemble(void);
  *
  *  Note: This callback only occurs on an End Point.
  *
+ *    @param  context Frame scheduler (registered with PhySyncTimerInit).
+ *
+ *    @return Status message from caller (currently not being used for frame
+ *            use).
+ */
+unsigned char FrameTimeout(void *context);
+
+/**
+ *  FrameTick - millisecond tick of the scheduler, invoked while the Physical 
+ *  timer is started (registered with PhyTimerInit). Ages the reassembly of 
+ *  fragmented messages and sends unacknowledged frames again.
+ *
+ *    @param  context Frame scheduler (registered with PhyInit).
+ *
  *    @return Status message from caller (currently not being used for frame
  *            use).
  */
-unsigned char FrameTimeout(void);
+unsigned char FrameTick(void *context);
 
 #endif  /* FRAME_H */
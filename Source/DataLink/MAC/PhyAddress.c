@@ -9,8 +9,8 @@
  *
  *  PhyAddress.c - Data Link layer physical addressing.
  *
- *  @version    1.0.00
- *  @date       17 Sep 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  For details on the interface, please see PhyAddress.h.
@@ -28,6 +28,19 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - addressing information is supplied by the caller (one per protocol 
+ *  instance) instead of being a file-scope singleton
+ *  - End Point addressing is always built in; a Gateway is a node with a fixed
+ *  PAN identifier that never links
+ *  - added the Gateway endpoint table (PROTOCOL_USE_ENDPOINT_TABLE)
+ *  - added PhyAddressEndPointAdd; End Points with an established link or 
+ *  holding downlink messages are kept in the table
+ *  - added Gateway link identifiers for compressed frame headers 
+ *  (PROTOCOL_USE_COMPRESSED_HEADER); an identifier is derived from its entry 
+ *  so that it is found without a search
+ *  - added Gateway superframe slot assignment (PROTOCOL_USE_TDMA)
+ *  - an added End Point has no codec reference (PROTOCOL_USE_CODEC)
  *  ver 1.0.00 : 17 Sep 2012
  *  - initial release
  */
@@ -44,9 +57,6 @@
  *  Global data
  */
 
-// Local node addressing information
-static struct sPhyAddressInfo gPhyAddressInfo;
-
 // -----------------------------------------------------------------------------
 /**
  *  Private interface
@@ -66,6 +76,109 @@ static struct sPhyAddressInfo gPhyAddressInfo;
 #define PhyAddressToBroadcast(addr, size)\
   memset(addr, PHY_ADDRESS_BROADCAST, size)
 
+#if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+/**
+ *  PhyAddressHash - hash bucket of an End Point address.
+ *
+ *    @param  address End Point address.
+ *
+ *    @return Hash bucket index.
+ */
+unsigned char PhyAddressHash(const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  unsigned char hash = 0;
+  unsigned char i;
+  
+  for (i = 0; i < PHY_ADDRESS_ADDRESS_SIZE; i++)
+  {
+    hash = (unsigned char)((hash * 31) + address[i]);
+  }
+  
+  return hash & (PROTOCOL_ENDPOINT_HASH_SIZE - 1);
+}
+
+/**
+ *  PhyAddressEndPointUnlink - take an entry out of the order of last frame 
+ *  received.
+ *
+ *    @param  table Endpoint table.
+ *    @param  index Entry being taken out.
+ */
+void PhyAddressEndPointUnlink(struct sPhyAddressEndPointTable *table,
+                              unsigned char index)
+{
+  struct sPhyAddressEndPoint *endPoint = &table->entry[index];
+  
+  if (endPoint->newer != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    table->entry[endPoint->newer].older = endPoint->older;
+  }
+  else
+  {
+    table->newest = endPoint->older;
+  }
+  
+  if (endPoint->older != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    table->entry[endPoint->older].newer = endPoint->newer;
+  }
+  else
+  {
+    table->oldest = endPoint->newer;
+  }
+}
+
+/**
+ *  PhyAddressEndPointSeen - make an entry the one seen most recently.
+ *
+ *    @param  table Endpoint table.
+ *    @param  index Entry seen (not in the order of last frame received).
+ */
+void PhyAddressEndPointSeen(struct sPhyAddressEndPointTable *table,
+                            unsigned char index)
+{
+  struct sPhyAddressEndPoint *endPoint = &table->entry[index];
+  
+  endPoint->newer = PHY_ADDRESS_ENDPOINT_NONE;
+  endPoint->older = table->newest;
+  if (table->newest != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    table->entry[table->newest].newer = index;
+  }
+  else
+  {
+    table->oldest = index;
+  }
+  table->newest = index;
+}
+
+/**
+ *  PhyAddressEndPointRelease - return an entry in use to the free list.
+ *
+ *    @param  table Endpoint table.
+ *    @param  index Entry being released.
+ */
+void PhyAddressEndPointRelease(struct sPhyAddressEndPointTable *table,
+                               unsigned char index)
+{
+  struct sPhyAddressEndPoint *endPoint = &table->entry[index];
+  unsigned char *link = &table->bucket[PhyAddressHash(endPoint->address)];
+  
+  // Take the entry out of its hash bucket.
+  while (*link != index)
+  {
+    link = &table->entry[*link].next;
+  }
+  *link = endPoint->next;
+  
+  PhyAddressEndPointUnlink(table, index);
+  
+  endPoint->state = ePhyAddressLinkNone;
+  endPoint->next = table->free;
+  table->free = index;
+}
+#endif
+
 // -----------------------------------------------------------------------------
 /**
  *  Public interface
@@ -74,45 +187,71 @@ static struct sPhyAddressInfo gPhyAddressInfo;
 // -----------------------------------------------------------------------------
 // Physical addressing configuration
     
-void PhyAddressInit(const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
+void PhyAddressInit(struct sPhyAddressInfo *info,
+                    struct sPhyDevice *phy,
+                    const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
                     const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE],
                     bool(*Backup)(bool read, unsigned char *data, unsigned char size))
 {
-  #if defined( PROTOCOL_ENDPOINT )
-  gPhyAddressInfo.local.fixed = false;
+  info->phy = phy;
+  
+  info->local.fixed = false;
   
   // Check if PAN identifier is set to the broadcast address. If it isn't the
   // application is using fixed addressing (PAN identifier is known).
   if (!PhyAddressIsBroadcast(panId, PHY_ADDRESS_PANID_SIZE))
   {
-    gPhyAddressInfo.local.fixed = true;
+    info->local.fixed = true;
   }
   
   // Setup backup mechanism, if provided.
-  gPhyAddressInfo.Backup = Backup;
-  #endif
+  info->Backup = Backup;
   
   // Set the local address and clear the size of the address list.
-  PhyAddressCopy(gPhyAddressInfo.local.panId,
+  PhyAddressCopy(info->local.panId,
                  panId,
                  PHY_ADDRESS_PANID_SIZE);
-  PhyAddressCopy(gPhyAddressInfo.local.address, 
+  PhyAddressCopy(info->local.address, 
                  address,
                  PHY_ADDRESS_ADDRESS_SIZE);
   
-  #if defined( PROTOCOL_ENDPOINT )
-  if (gPhyAddressInfo.local.fixed)
+  if (info->local.fixed)
   {
-  #endif  
     // Set device address for physical filtering. Physical filtering is based off
     // of the PAN identifier (lowest byte).
-    PhyEnableAddressFilter(gPhyAddressInfo.local.panId[0]);
-  #if defined( PROTOCOL_ENDPOINT )
+    PhyEnableAddressFilter(info->phy, info->local.panId[0]);
   }
   else
   {
     // Disable hardware filtering until a link is established.
-    PhyDisableAddressFilter();
+    PhyDisableAddressFilter(info->phy);
+  }
+  
+  #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+  {
+    struct sPhyAddressEndPointTable *table = &info->endPoints;
+    unsigned char i;
+    
+    // Every entry is free.
+    for (i = 0; i < PROTOCOL_ENDPOINT_TABLE_SIZE; i++)
+    {
+      table->entry[i].state = ePhyAddressLinkNone;
+      table->entry[i].next = i + 1;
+      #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+      table->entry[i].linkGeneration = 0;
+      #endif
+    }
+    table->entry[PROTOCOL_ENDPOINT_TABLE_SIZE - 1].next = PHY_ADDRESS_ENDPOINT_NONE;
+    for (i = 0; i < PROTOCOL_ENDPOINT_HASH_SIZE; i++)
+    {
+      table->bucket[i] = PHY_ADDRESS_ENDPOINT_NONE;
+    }
+    table->free = 0;
+    table->newest = PHY_ADDRESS_ENDPOINT_NONE;
+    table->oldest = PHY_ADDRESS_ENDPOINT_NONE;
+    #if defined( PROTOCOL_USE_TDMA )
+    table->lastSlot = PHY_ADDRESS_SLOT_NONE;
+    #endif
   }
   #endif
 }
@@ -120,9 +259,9 @@ void PhyAddressInit(const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
 // -----------------------------------------------------------------------------
 // Physical addressing information
 
-const struct sPhyAddressLocal* PhyAddressGetLocalInfo()
+const struct sPhyAddressLocal* PhyAddressGetLocalInfo(const struct sPhyAddressInfo *info)
 {
-  return &gPhyAddressInfo.local;
+  return &info->local;
 }
 
 bool PhyAddressIsBroadcast(const unsigned char *addr, unsigned char size)
@@ -142,11 +281,10 @@ bool PhyAddressIsBroadcast(const unsigned char *addr, unsigned char size)
 
 // Note: A link exists if the local node (an End Point) has a remote address
 // (the Gateway).
-#if defined( PROTOCOL_ENDPOINT )
-bool PhyAddressLinkExists()
+bool PhyAddressLinkExists(const struct sPhyAddressInfo *info)
 {
   // Check if a remote address exists in the local node addressing information.
-  if (!PhyAddressIsBroadcast(gPhyAddressInfo.local.remote, 
+  if (!PhyAddressIsBroadcast(info->local.remote, 
                              PHY_ADDRESS_ADDRESS_SIZE))
   {
     return true;
@@ -154,60 +292,286 @@ bool PhyAddressLinkExists()
   
   return false;
 }
-#endif
 
 // -----------------------------------------------------------------------------
 // Physical addressing operations
 
-void PhyAddressLinkEstablish(unsigned char panId[PHY_ADDRESS_PANID_SIZE],
+void PhyAddressLinkEstablish(struct sPhyAddressInfo *info,
+                             unsigned char panId[PHY_ADDRESS_PANID_SIZE],
                              unsigned char remote[PHY_ADDRESS_ADDRESS_SIZE])
 {
-  #if defined( PROTOCOL_ENDPOINT )
-  if (!gPhyAddressInfo.local.fixed)
+  if (!info->local.fixed)
   {
-    PhyAddressCopy(gPhyAddressInfo.local.panId, panId, PHY_ADDRESS_PANID_SIZE);
+    PhyAddressCopy(info->local.panId, panId, PHY_ADDRESS_PANID_SIZE);
     
     // Set device address for physical filtering. Physical filtering is based off
     // of the PAN identifier (lowest byte).
-    PhyEnableAddressFilter(gPhyAddressInfo.local.panId[0]);
+    PhyEnableAddressFilter(info->phy, info->local.panId[0]);
   }
-  PhyAddressCopy(gPhyAddressInfo.local.remote, remote, PHY_ADDRESS_ADDRESS_SIZE);
+  PhyAddressCopy(info->local.remote, remote, PHY_ADDRESS_ADDRESS_SIZE);
 
   // Store information in non-volatile backup.
-  if (gPhyAddressInfo.Backup != NULL)
+  if (info->Backup != NULL)
   {
-    gPhyAddressInfo.Backup(PHY_ADDRESS_BACKUP_WRITE, 
-                           (unsigned char*)&gPhyAddressInfo.local,
-                           sizeof(gPhyAddressInfo.local) / sizeof(struct sPhyAddressInfo));
+    info->Backup(PHY_ADDRESS_BACKUP_WRITE, 
+                 (unsigned char*)&info->local,
+                 sizeof(info->local) / sizeof(struct sPhyAddressInfo));
   }
-  #endif
 }
 
-void PhyAddressLinkDestroy()
+void PhyAddressLinkDestroy(struct sPhyAddressInfo *info)
 {
-  #if defined( PROTOCOL_ENDPOINT )
-  if (!gPhyAddressInfo.local.fixed)
+  if (!info->local.fixed)
   {
     // Set PAN identifier to broadcast address.
-    PhyAddressToBroadcast(gPhyAddressInfo.local.panId, PHY_ADDRESS_PANID_SIZE);
+    PhyAddressToBroadcast(info->local.panId, PHY_ADDRESS_PANID_SIZE);
     
     // Disable hardware filtering until a link is established.
-    PhyDisableAddressFilter();
+    PhyDisableAddressFilter(info->phy);
   }
   
   // Set remote address to broadcast address.
-  PhyAddressToBroadcast(gPhyAddressInfo.local.remote, PHY_ADDRESS_ADDRESS_SIZE);
+  PhyAddressToBroadcast(info->local.remote, PHY_ADDRESS_ADDRESS_SIZE);
 
   // Store information in non-volatile backup.
-  if (gPhyAddressInfo.Backup != NULL)
+  if (info->Backup != NULL)
   {
-    gPhyAddressInfo.Backup(PHY_ADDRESS_BACKUP_WRITE, 
-                           (unsigned char*)&gPhyAddressInfo.local,
-                           sizeof(gPhyAddressInfo.local) / sizeof(struct sPhyAddressInfo));
+    info->Backup(PHY_ADDRESS_BACKUP_WRITE, 
+                 (unsigned char*)&info->local,
+                 sizeof(info->local) / sizeof(struct sPhyAddressInfo));
   }
+}
+
+#if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+// -----------------------------------------------------------------------------
+// Gateway endpoint table operations
+
+struct sPhyAddressEndPoint* PhyAddressEndPointFind(struct sPhyAddressInfo *info,
+                                                   const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  struct sPhyAddressEndPointTable *table = &info->endPoints;
+  unsigned char index = table->bucket[PhyAddressHash(address)];
+  
+  while (index != PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    if (PhyAddressCompare(table->entry[index].address, address, PHY_ADDRESS_ADDRESS_SIZE) == 0)
+    {
+      return &table->entry[index];
+    }
+    index = table->entry[index].next;
+  }
+  
+  return NULL;
+}
+
+struct sPhyAddressEndPoint* PhyAddressEndPointAdd(struct sPhyAddressInfo *info,
+                                                  const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  struct sPhyAddressEndPointTable *table = &info->endPoints;
+  struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(info, address);
+  unsigned char hash = PhyAddressHash(address);
+  unsigned char index;
+  
+  if (endPoint != NULL)
+  {
+    return endPoint;
+  }
+  
+  // A new End Point replaces the one seen least recently if the table is 
+  // full. End Points with an established link or holding downlink messages 
+  // are kept; an unknown sender must not push out a linked End Point.
+  if (table->free == PHY_ADDRESS_ENDPOINT_NONE)
+  {
+    index = table->oldest;
+    while ((index != PHY_ADDRESS_ENDPOINT_NONE) 
+           && ((table->entry[index].state == ePhyAddressLinkEstablished)
+               || (table->entry[index].mailbox != PHY_ADDRESS_ENDPOINT_NONE)))
+    {
+      index = table->entry[index].newer;
+    }
+    
+    if (index == PHY_ADDRESS_ENDPOINT_NONE)
+    {
+      // Error: every End Point is linked or holds downlink messages.
+      return NULL;
+    }
+    PhyAddressEndPointRelease(table, index);
+  }
+  index = table->free;
+  endPoint = &table->entry[index];
+  table->free = endPoint->next;
+  
+  PhyAddressCopy(endPoint->address, address, PHY_ADDRESS_ADDRESS_SIZE);
+  endPoint->state = ePhyAddressLinkAdded;
+  endPoint->flags = 0;
+  endPoint->rxSeqNumber = 0;
+  endPoint->txSeqNumber = 0;
+  endPoint->lastSeen = 0;
+  endPoint->rssi = 0;
+  endPoint->lqi = 0;
+  endPoint->mailbox = PHY_ADDRESS_ENDPOINT_NONE;
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  endPoint->link = PHY_ADDRESS_LINK_NONE;
   #endif
+  #if defined( PROTOCOL_USE_TDMA )
+  endPoint->slot = PHY_ADDRESS_SLOT_NONE;
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  endPoint->codecGeneration = 0;
+  endPoint->codecLength = 0;
+  #endif
+  endPoint->next = table->bucket[hash];
+  table->bucket[hash] = index;
+  PhyAddressEndPointSeen(table, index);
+  
+  return endPoint;
+}
+
+struct sPhyAddressEndPoint* PhyAddressEndPointUpdate(struct sPhyAddressInfo *info,
+                                                     const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  struct sPhyAddressEndPointTable *table = &info->endPoints;
+  const struct sPhyDataStreamFooter *footer = PhyGetDataStreamStatus(info->phy);
+  struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointAdd(info, address);
+  int lqi = (footer->status & PROTOCOL_DATASTREAM_FOOTER_LQI) * PHY_ADDRESS_EWMA_SCALE;
+  int rssi = footer->rssi * PHY_ADDRESS_EWMA_SCALE;
+  unsigned char index;
+  
+  if (endPoint == NULL)
+  {
+    return NULL;
+  }
+  
+  // The averages start from the first frame received.
+  if (endPoint->state == ePhyAddressLinkAdded)
+  {
+    endPoint->state = ePhyAddressLinkSeen;
+    endPoint->rssi = rssi;
+    endPoint->lqi = lqi;
+  }
+  else
+  {
+    endPoint->rssi += (rssi - endPoint->rssi) / PHY_ADDRESS_EWMA_WEIGHT;
+    endPoint->lqi += (lqi - endPoint->lqi) / PHY_ADDRESS_EWMA_WEIGHT;
+  }
+  
+  index = (unsigned char)(endPoint - table->entry);
+  PhyAddressEndPointUnlink(table, index);
+  PhyAddressEndPointSeen(table, index);
+  
+  endPoint->lastSeen = PROTOCOL_TIMESTAMP();
+  
+  return endPoint;
 }
 
+bool PhyAddressEndPointRemove(struct sPhyAddressInfo *info,
+                              const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE])
+{
+  struct sPhyAddressEndPoint *endPoint = PhyAddressEndPointFind(info, address);
+  
+  if ((endPoint == NULL) || (endPoint->mailbox != PHY_ADDRESS_ENDPOINT_NONE))
+  {
+    return false;
+  }
+  
+  PhyAddressEndPointRelease(&info->endPoints, 
+                            (unsigned char)(endPoint - info->endPoints.entry));
+  
+  return true;
+}
+
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+unsigned char PhyAddressEndPointLink(struct sPhyAddressInfo *info,
+                                     struct sPhyAddressEndPoint *endPoint)
+{
+  unsigned char index = (unsigned char)(endPoint - info->endPoints.entry);
+  
+  // The entry's generation advances so that the identifier of an End Point 
+  // that left the table is not soon given to the next one in its entry.
+  if (endPoint->link == PHY_ADDRESS_LINK_NONE)
+  {
+    if (++endPoint->linkGeneration >= PHY_ADDRESS_LINK_GENERATIONS)
+    {
+      endPoint->linkGeneration = 0;
+    }
+    endPoint->link = (unsigned char)(1 + index 
+                                     + (PROTOCOL_ENDPOINT_TABLE_SIZE * endPoint->linkGeneration));
+  }
+  
+  return endPoint->link;
+}
+
+struct sPhyAddressEndPoint* PhyAddressEndPointFindLink(struct sPhyAddressInfo *info,
+                                                       unsigned char link)
+{
+  struct sPhyAddressEndPoint *endPoint;
+  
+  if (link == PHY_ADDRESS_LINK_NONE)
+  {
+    return NULL;
+  }
+  
+  // The identifier names the entry (see PhyAddressEndPointLink).
+  endPoint = &info->endPoints.entry[(link - 1) % PROTOCOL_ENDPOINT_TABLE_SIZE];
+  if ((endPoint->state != ePhyAddressLinkNone) && (endPoint->link == link))
+  {
+    return endPoint;
+  }
+  
+  return NULL;
+}
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+unsigned char PhyAddressEndPointSlot(struct sPhyAddressInfo *info,
+                                     struct sPhyAddressEndPoint *endPoint,
+                                     unsigned char slots)
+{
+  struct sPhyAddressEndPointTable *table = &info->endPoints;
+  unsigned char i;
+  
+  // Slots are assigned in turn, starting after the one assigned last. Unlike
+  // link identifiers, there may be fewer slots than entries.
+  for (i = 0; (i < slots) && (endPoint->slot == PHY_ADDRESS_SLOT_NONE); i++)
+  {
+    if (++table->lastSlot >= slots)
+    {
+      table->lastSlot = 0;
+    }
+    
+    if (PhyAddressEndPointFindSlot(info, table->lastSlot) == NULL)
+    {
+      endPoint->slot = table->lastSlot;
+    }
+  }
+  
+  return endPoint->slot;
+}
+
+struct sPhyAddressEndPoint* PhyAddressEndPointFindSlot(struct sPhyAddressInfo *info,
+                                                       unsigned char slot)
+{
+  struct sPhyAddressEndPointTable *table = &info->endPoints;
+  unsigned char i;
+  
+  if (slot == PHY_ADDRESS_SLOT_NONE)
+  {
+    return NULL;
+  }
+  
+  for (i = 0; i < PROTOCOL_ENDPOINT_TABLE_SIZE; i++)
+  {
+    if ((table->entry[i].state != ePhyAddressLinkNone) && (table->entry[i].slot == slot))
+    {
+      return &table->entry[i];
+    }
+  }
+  
+  return NULL;
+}
+#endif
+#endif
+
 // -----------------------------------------------------------------------------
 /**
  *  Test stub - test functionality of physical addressing.
@@ -255,24 +619,19 @@ void PhyAddressLinkDestroy()
 
 // -----------------------------------------------------------------------------
 
-// Empty backup
-static struct sPhyAddressLocal gBackupStorage = {
-  #if defined( PROTOCOL_ENDPOINT )
-  // Fixed PAN identifier flag
-  0xFF,
-  #endif
-  // Local PAN identifier
-  { 0xFF, 0xFF },
-  // Local address
-  { 0xFF, 0xFF },
-  #if defined( PROTOCOL_ENDPOINT )
-  // Remote address
-  { 0xFF, 0xFF }
-  #endif
-};
+// Fixed flag, PAN identifier, local and remote addresses
+#define TEST_BACKUP_SIZE  (1 + PHY_ADDRESS_PANID_SIZE + (2 * PHY_ADDRESS_ADDRESS_SIZE))
+
+// Backup storage (erased by main)
+static unsigned char gBackupStorage[TEST_BACKUP_SIZE];
 
-bool Backup(bool read, struct sPhyAddressLocal *local)
+bool Backup(bool read, unsigned char *data, unsigned char size)
 {
+  if (size > sizeof(gBackupStorage))
+  {
+    return false;
+  }
+  
   if (read)
   {
     /**
@@ -280,10 +639,10 @@ bool Backup(bool read, struct sPhyAddressLocal *local)
      *  mechanism. Check for erased flash to determine if data is backed up. The
      *  PAN identifier should never be 0xFFFF.
      */
-    if (gBackupStorage.panId[0] != 0xFF)
+    if (gBackupStorage[1] != 0xFF)
     {
       // Read in the information.
-      *local = gBackupStorage;
+      memcpy(data, gBackupStorage, size);
 
       return true;
     }
@@ -294,20 +653,11 @@ bool Backup(bool read, struct sPhyAddressLocal *local)
   }
   else
   {
-    unsigned int i;
-    
     // Erase entire backup.
-    for (i = 0; i < PHYADDRESS_PANID_SIZE; i++)
-    {
-      gBackupStorage.panId[i] = 0xFF;
-    }
-    for (i = 0; i < PHYADDRESS_ADDRESS_SIZE; i++)
-    {
-      gBackupStorage.address[i] = 0xFF;
-    }
+    memset(gBackupStorage, 0xFF, sizeof(gBackupStorage));
     
     // Write to the backup device.   
-    gBackupStorage = *local;
+    memcpy(gBackupStorage, data, size);
   }
   
   return true;
@@ -318,34 +668,23 @@ struct sProtocolSetupInfo
   // Physical addressing setup
   unsigned char panId[PROTOCOL_PHYADDRESS_PANID_SIZE];
   unsigned char address[PROTOCOL_PHYADDRESS_ADDRESS_SIZE];
-  bool(*Backup)(bool read, struct sPhyAddressLocal *local);
-  #if defined( PROTOCOL_GATEWAY )
-  bool(*LinkRequest)(unsigned char *payload, unsigned char length);
-  #endif
+  bool(*Backup)(bool read, unsigned char *data, unsigned char size);
 };
 
 const struct sProtocolSetupInfo gProtocolSetupInfo = {
-  #if defined( PROTOCOL_ENDPOINT )
   { 0x00, 0x01 },
   { 0x00, 0x01 },
-  #elif defined( PROTOCOL_GATEWAY )
-  { 0x12, 0x34 },
-  { 0xBB, 0xBB },
-  #endif
-  Backup,
-  #if defined( PROTOCOL_GATEWAY )
-  NULL
-  #endif
+  Backup
 };
 
+// Physical device and addressing information under test
+static struct sPhyDevice gPhy;
+static struct sPhyAddressInfo gPhyAddress;
+
 void ProtocolInit(const struct sProtocolSetupInfo *setup)
 {
-  PhyInit(setup->panId[0], NULL, NULL);
-  #if defined( PROTOCOL_ENDPOINT )
-  PhyAddressInit(setup->panId, setup->address, setup->Backup);
-  #elif defined( PROTOCOL_GATEWAY )
-  PhyAddressInit(setup->panId, setup->address, setup->Backup, setup->LinkRequest);
-  #endif
+  PhyInit(&gPhy, NULL, NULL, NULL, NULL);
+  PhyAddressInit(&gPhyAddress, &gPhy, setup->panId, setup->address, setup->Backup);
 }
 
 int main(void)
@@ -359,15 +698,13 @@ int main(void)
     { 0x00, 0x01 }
   };
   WDTCTL = WDTPW | WDTHOLD;
+  memset(gBackupStorage, 0xFF, sizeof(gBackupStorage));
   ProtocolInit(&gProtocolSetupInfo);
   
-  PhyAddressLinkEstablish(panId[0], remote[0]);
-  #if defined( PROTOCOL_GATEWAY )
-  PhyAddressSetFilter(remote[1]);
-  #endif
-  PhyAddressLinkDestroy();
+  PhyAddressLinkEstablish(&gPhyAddress, panId[0], remote[0]);
+  PhyAddressLinkDestroy(&gPhyAddress);
   
   return 0;
 }
 
-#endif  /* TEST_PHYSICAL_ADDRESS */
+#endif  /* TEST_PHY_ADDRESS */
@@ -11,8 +11,8 @@
  *
  *  PhyAddress.h - Data Link layer physical addressing.
  *
- *  @version  1.0.00
- *  @date     17 Sep 2012
+ *  @version  1.1.00
+ *  @date     16 Oct 2026
  *  @author   BPB, air@anaren.com
  *
  *  Physical addressing provides a filter mechanism for nodes in a network.
@@ -31,10 +31,31 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - every operation takes the addressing information (sPhyAddressInfo) it 
+ *  applies to; the physical device used for filtering is part of it
+ *  - the End Point fields (fixed, remote, Backup) are always present so that
+ *  both roles share one build
+ *  - added the Gateway endpoint table; per End Point link state, last seen 
+ *  time, RSSI/LQI averages and sequence numbers with hashed lookup and least 
+ *  recently seen eviction (PROTOCOL_USE_ENDPOINT_TABLE)
+ *  - added PhyAddressEndPointAdd; an End Point with an established link or 
+ *  holding downlink messages (sPhyAddressEndPoint.mailbox) is never replaced
+ *  - added link identifiers for compressed frame headers; a Gateway assigns 
+ *  one to each linked End Point (PROTOCOL_USE_COMPRESSED_HEADER, 
+ *  PhyAddressEndPointLink, PhyAddressEndPointFindLink); an identifier names 
+ *  its entry (PHY_ADDRESS_LINK_GENERATIONS)
+ *  - added superframe slots; a Gateway assigns one to each linked End Point 
+ *  while slots are free (PROTOCOL_USE_TDMA, PhyAddressEndPointSlot, 
+ *  PhyAddressEndPointFindSlot)
+ *  - added the codec reference of each End Point (PROTOCOL_USE_CODEC); by 
+ *  default it is no longer than the longest message encoded
+ *  - added the link key and frame counter of each End Point 
+ *  (PROTOCOL_USE_SECURITY, PHY_ADDRESS_ENDPOINT_FLAG_SECURE)
  *  ver 1.0.00: 17 Sep 2012
  *  - initial release
  */
-#define PHY_ADDRESS_INFO "PHY_ADDRESS 1.0.00"
+#define PHY_ADDRESS_INFO "PHY_ADDRESS 1.1.00"
 
 #ifndef bool
 #define bool unsigned char
@@ -69,27 +90,155 @@
 #define PHY_ADDRESS_BACKUP_READ  true
 #define PHY_ADDRESS_BACKUP_WRITE false
 
+// Physical device (see PhyBridge.h)
+struct sPhyDevice;
+
+#if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#ifndef PROTOCOL_ENDPOINT_TABLE_SIZE
+#define PROTOCOL_ENDPOINT_TABLE_SIZE  8   // Default number of End Points known to a Gateway
+#endif
+
+#ifndef PROTOCOL_ENDPOINT_HASH_SIZE
+#define PROTOCOL_ENDPOINT_HASH_SIZE   8   // Default number of hash buckets
+#endif
+
+#if defined( PROTOCOL_USE_CODEC )
+#ifndef PROTOCOL_CODEC_MAX_LENGTH
+#define PROTOCOL_CODEC_MAX_LENGTH PROTOCOL_FRAME_MAX_PAYLOAD_LENGTH // Default longest message encoded
+#endif
+
+// Default bytes of the reference message: 16, or fewer if no longer message
+// is encoded
+#ifndef PROTOCOL_CODEC_REFERENCE_LENGTH
+#define PROTOCOL_CODEC_REFERENCE_LENGTH ((PROTOCOL_CODEC_MAX_LENGTH < 16) ? PROTOCOL_CODEC_MAX_LENGTH : 16)
+#endif
+#endif
+
+#if (PROTOCOL_ENDPOINT_TABLE_SIZE < 1) || (PROTOCOL_ENDPOINT_TABLE_SIZE > 254)
+#error "PhyAddress Error: PROTOCOL_ENDPOINT_TABLE_SIZE must be from 1 to 254."
+#endif
+
+#if (PROTOCOL_ENDPOINT_HASH_SIZE < 1) || (PROTOCOL_ENDPOINT_HASH_SIZE > 128) \
+    || (PROTOCOL_ENDPOINT_HASH_SIZE & (PROTOCOL_ENDPOINT_HASH_SIZE - 1))
+#error "PhyAddress Error: PROTOCOL_ENDPOINT_HASH_SIZE must be a power of two from 1 to 128."
+#endif
+
+// End of an endpoint table list
+#define PHY_ADDRESS_ENDPOINT_NONE       0xFFu
+
+// No link identifier assigned
+#define PHY_ADDRESS_LINK_NONE           0x00u
+
+// Link identifiers given out by each entry before its first is reused. An 
+// identifier is 1 + entry index + PROTOCOL_ENDPOINT_TABLE_SIZE x generation, 
+// so the entry holding it is known without a search.
+#define PHY_ADDRESS_LINK_GENERATIONS    (255u / PROTOCOL_ENDPOINT_TABLE_SIZE)
+
+// No superframe slot assigned
+#define PHY_ADDRESS_SLOT_NONE           0xFFu
+
+// Endpoint link flags
+#define PHY_ADDRESS_ENDPOINT_FLAG_ACK   0x01u // The End Point requests acknowledgements
+#define PHY_ADDRESS_ENDPOINT_FLAG_COMPRESSED 0x02u // The End Point sends compressed headers
+#define PHY_ADDRESS_ENDPOINT_FLAG_SECURE 0x04u // The link has a key
+
+#if defined( PROTOCOL_USE_SECURITY )
+#define PHY_ADDRESS_KEY_LENGTH          16    // AES-128 link key
+#endif
+
+// RSSI and LQI averages (exponentially weighted, weight 1/8, scaled by 16)
+#define PHY_ADDRESS_EWMA_SCALE          16
+#define PHY_ADDRESS_EWMA_WEIGHT         8
+
+/**
+ *  ePhyAddressLinkState - link state of an End Point known to a Gateway.
+ */
+enum ePhyAddressLinkState
+{
+  ePhyAddressLinkNone = 0,    // Entry not in use
+  ePhyAddressLinkAdded,       // Added by the local node; no frame received
+  ePhyAddressLinkSeen,        // Frames received; no link request accepted
+  ePhyAddressLinkEstablished  // Link request accepted
+};
+
+/**
+ *  sPhyAddressEndPoint - End Point known to a Gateway.
+ */
+struct sPhyAddressEndPoint
+{
+  unsigned char address[PHY_ADDRESS_ADDRESS_SIZE];  // End Point address
+  unsigned char state;        // Link state (ePhyAddressLinkState)
+  unsigned char flags;        // Link flags (PHY_ADDRESS_ENDPOINT_FLAG_x)
+  unsigned char rxSeqNumber;  // Sequence number of the last frame received
+  unsigned char txSeqNumber;  // Next sequence number sent to the End Point
+  unsigned int lastSeen;      // Time of the last frame received (PROTOCOL_TIMESTAMP)
+  int rssi;                   // RSSI average (raw value, x PHY_ADDRESS_EWMA_SCALE)
+  int lqi;                    // LQI average (x PHY_ADDRESS_EWMA_SCALE)
+  unsigned char mailbox;      // First downlink message queued for the End Point 
+                              // (PHY_ADDRESS_ENDPOINT_NONE if none)
+  #if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+  unsigned char link;         // Link identifier (PHY_ADDRESS_LINK_NONE if none)
+  unsigned char linkGeneration;  // Generation of the entry's last link identifier
+                              // (kept while the entry is free)
+  #endif
+  #if defined( PROTOCOL_USE_TDMA )
+  unsigned char slot;         // Superframe slot (PHY_ADDRESS_SLOT_NONE if none)
+  #endif
+  #if defined( PROTOCOL_USE_CODEC )
+  unsigned char codecGeneration;  // Generation of the codec reference
+  unsigned char codecLength;  // Number of codec reference bytes (0 if none)
+  unsigned char codecReference[PROTOCOL_CODEC_REFERENCE_LENGTH];
+                              // Last reference message received
+  #endif
+  #if defined( PROTOCOL_USE_SECURITY )
+  unsigned char securityKey[PHY_ADDRESS_KEY_LENGTH];  // Link key
+  unsigned long securityCounter;  // Lowest new frame counter of the End Point
+  #endif
+  unsigned char next;         // Next entry of the hash bucket (or free list)
+  unsigned char newer;        // Entry seen more recently
+  unsigned char older;        // Entry seen less recently
+};
+
+/**
+ *  sPhyAddressEndPointTable - End Points known to a Gateway. Entries are 
+ *  looked up through hash buckets of the End Point address and kept in order
+ *  of last frame received; the least recently seen End Point is replaced when
+ *  the table is full. An End Point with an established link or holding 
+ *  downlink messages is never replaced.
+ */
+struct sPhyAddressEndPointTable
+{
+  struct sPhyAddressEndPoint entry[PROTOCOL_ENDPOINT_TABLE_SIZE]; // End Points
+  unsigned char bucket[PROTOCOL_ENDPOINT_HASH_SIZE];  // First entry of each bucket
+  unsigned char free;         // First entry not in use
+  unsigned char newest;       // Entry seen most recently
+  unsigned char oldest;       // Entry seen least recently (replaced first)
+  #if defined( PROTOCOL_USE_TDMA )
+  unsigned char lastSlot;     // Superframe slot assigned last
+  #endif
+};
+#endif
+
 /**
  *  sPhyAddressInfo - addressing information required to create links between
  *  two (or many) nodes.
  */
 struct sPhyAddressInfo
 {
+  struct sPhyDevice *phy;   // Physical device performing address filtering
+  
   /**
    *  sPhyAddressLocal - local node addressing information.
    */
   struct sPhyAddressLocal
   {
-    #if defined( PROTOCOL_ENDPOINT )
     bool fixed; // Local PAN identifier fixed flag (not broadcast address indicator)
-    #endif
     unsigned char panId[PHY_ADDRESS_PANID_SIZE];      // Personal Area Network (PAN) identifier
     unsigned char address[PHY_ADDRESS_ADDRESS_SIZE];  // Local unique physical address
-    #if defined( PROTOCOL_ENDPOINT )
     // Note: The remote address corresponds to a Gateway node address. An End
-    // Point may only communicate with one Gateway at any time.
+    // Point may only communicate with one Gateway at any time. It remains the
+    // broadcast address on a Gateway.
     unsigned char remote[PHY_ADDRESS_ADDRESS_SIZE];   // Remote unique physical address
-    #endif
   } local;
 
   /**
@@ -121,8 +270,10 @@ struct sPhyAddressInfo
    *
    *    @return Success of the operation.
    */
-  #if defined( PROTOCOL_ENDPOINT )
   bool(*Backup)(bool read, unsigned char *data, unsigned char size);
+  
+  #if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+  struct sPhyAddressEndPointTable endPoints;  // End Points known to a Gateway
   #endif
 };
 
@@ -147,6 +298,8 @@ struct sPhyAddressInfo
  *
  *  Note: It is assumed that the address provided is a unique identifier.
  *
+ *    @param  info    Addressing information being initialized.
+ *    @param  phy     Physical device used for hardware address filtering.
  *    @param  panId   Local node Personal Area Network (PAN) identifier. This is
  *                    used to differentiate co-existing networks. This value
  *                    must be set to a value other than the broadcast address on
@@ -158,7 +311,9 @@ struct sPhyAddressInfo
  *                    non-volatile storage. The backup is only used on End Point
  *                    nodes.
  */
-void PhyAddressInit(const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
+void PhyAddressInit(struct sPhyAddressInfo *info,
+                    struct sPhyDevice *phy,
+                    const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
                     const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE],
                     bool(*Backup)(bool read, unsigned char *data, unsigned char size));
 
@@ -168,9 +323,11 @@ void PhyAddressInit(const unsigned char panId[PHY_ADDRESS_PANID_SIZE],
 /**
  *  PhyAddressGetLocalInfo - get local node's addressing information.
  *
+ *    @param  info  Addressing information.
+ *
  *    @return Physical addressing information for the local node.
  */
-const struct sPhyAddressLocal* PhyAddressGetLocalInfo(void);
+const struct sPhyAddressLocal* PhyAddressGetLocalInfo(const struct sPhyAddressInfo *info);
 
 /**
  *  PhyAddressIsBroadcast - perform a comparison of an address to the broadcast
@@ -190,9 +347,11 @@ bool PhyAddressIsBroadcast(const unsigned char *addr, unsigned char size);
  *
  *  Note: This function should only be used on an End Point node.
  *
+ *    @param  info  Addressing information.
+ *
  *    @return Success if the local node is linked to a remote node.
  */
-bool PhyAddressLinkExists(void);
+bool PhyAddressLinkExists(const struct sPhyAddressInfo *info);
 
 // -----------------------------------------------------------------------------
 // Physical addressing utilities
@@ -241,17 +400,155 @@ bool PhyAddressLinkExists(void);
  *
  *  Note: This function should only be used on an End Point node.
  *
+ *    @param  info    Addressing information.
  *    @param  panId   Remote node PAN identifier.
  *    @param  remote  Remote node address.
  */
-void PhyAddressLinkEstablish(unsigned char panId[PHY_ADDRESS_PANID_SIZE],
+void PhyAddressLinkEstablish(struct sPhyAddressInfo *info,
+                             unsigned char panId[PHY_ADDRESS_PANID_SIZE],
                              unsigned char remote[PHY_ADDRESS_ADDRESS_SIZE]);
 
 /**
  *  PhyAddressLinkDestroy - remove a link between the local and a remote node.
  *
  *  Note: This function should only be used on an End Point node.
+ *
+ *    @param  info  Addressing information.
  */
-void PhyAddressLinkDestroy(void);
+void PhyAddressLinkDestroy(struct sPhyAddressInfo *info);
+
+#if defined( PROTOCOL_USE_ENDPOINT_TABLE )
+// -----------------------------------------------------------------------------
+// Gateway endpoint table operations
+
+/**
+ *  PhyAddressEndPointFind - find an End Point in the endpoint table.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info    Addressing information.
+ *    @param  address End Point address.
+ *
+ *    @return Location of the End Point, or NULL if it is not in the table.
+ */
+struct sPhyAddressEndPoint* PhyAddressEndPointFind(struct sPhyAddressInfo *info,
+                                                   const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE]);
+
+/**
+ *  PhyAddressEndPointAdd - add an End Point to the endpoint table, if it is 
+ *  not already in it. The least recently seen End Point that has no 
+ *  established link and holds no downlink messages is replaced if the table 
+ *  is full.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info    Addressing information.
+ *    @param  address End Point address.
+ *
+ *    @return Location of the End Point, or NULL if every End Point in the full
+ *            table is linked or holds downlink messages.
+ */
+struct sPhyAddressEndPoint* PhyAddressEndPointAdd(struct sPhyAddressInfo *info,
+                                                  const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE]);
+
+/**
+ *  PhyAddressEndPointUpdate - record a frame received from an End Point. The 
+ *  last seen time and the RSSI/LQI averages are taken from the last data 
+ *  stream received by the physical device. An End Point that is not in the 
+ *  table is added (see PhyAddressEndPointAdd).
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info    Addressing information.
+ *    @param  address End Point address.
+ *
+ *    @return Location of the End Point, or NULL if it could not be added.
+ */
+struct sPhyAddressEndPoint* PhyAddressEndPointUpdate(struct sPhyAddressInfo *info,
+                                                     const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE]);
+
+/**
+ *  PhyAddressEndPointRemove - remove an End Point from the endpoint table.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info    Addressing information.
+ *    @param  address End Point address.
+ *
+ *    @return Success if the End Point was in the table. An End Point holding 
+ *            downlink messages is not removed.
+ */
+bool PhyAddressEndPointRemove(struct sPhyAddressInfo *info,
+                              const unsigned char address[PHY_ADDRESS_ADDRESS_SIZE]);
+
+#if defined( PROTOCOL_USE_COMPRESSED_HEADER )
+/**
+ *  PhyAddressEndPointLink - get the link identifier of an End Point, 
+ *  assigning one if it has none. An identifier is derived from the End 
+ *  Point's entry and the entry's generation, which advances on each 
+ *  assignment, so identifiers are unique within the table; an End Point keeps
+ *  its identifier until it leaves the table.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info      Addressing information.
+ *    @param  endPoint  End Point in the endpoint table.
+ *
+ *    @return Link identifier of the End Point.
+ */
+unsigned char PhyAddressEndPointLink(struct sPhyAddressInfo *info,
+                                     struct sPhyAddressEndPoint *endPoint);
+
+/**
+ *  PhyAddressEndPointFindLink - find the End Point a link identifier was 
+ *  assigned to. The identifier names the only entry that may hold it.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info  Addressing information.
+ *    @param  link  Link identifier.
+ *
+ *    @return Location of the End Point, or NULL if no End Point in the table 
+ *            holds the link identifier.
+ */
+struct sPhyAddressEndPoint* PhyAddressEndPointFindLink(struct sPhyAddressInfo *info,
+                                                       unsigned char link);
+#endif
+
+#if defined( PROTOCOL_USE_TDMA )
+/**
+ *  PhyAddressEndPointSlot - get the superframe slot of an End Point, 
+ *  assigning a free one if it has none. Slots are assigned in turn; an End 
+ *  Point keeps its slot until it leaves the table.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info      Addressing information.
+ *    @param  endPoint  End Point in the endpoint table.
+ *    @param  slots     Number of slots in the superframe.
+ *
+ *    @return Slot of the End Point, or PHY_ADDRESS_SLOT_NONE if every slot is
+ *            in use.
+ */
+unsigned char PhyAddressEndPointSlot(struct sPhyAddressInfo *info,
+                                     struct sPhyAddressEndPoint *endPoint,
+                                     unsigned char slots);
+
+/**
+ *  PhyAddressEndPointFindSlot - find the End Point a superframe slot was 
+ *  assigned to.
+ *
+ *  Note: This function should only be used on a Gateway node.
+ *
+ *    @param  info  Addressing information.
+ *    @param  slot  Superframe slot.
+ *
+ *    @return Location of the End Point, or NULL if no End Point in the table 
+ *            holds the slot.
+ */
+struct sPhyAddressEndPoint* PhyAddressEndPointFindSlot(struct sPhyAddressInfo *info,
+                                                       unsigned char slot);
+#endif
+#endif
 
 #endif  /* PHY_ADDRESS_H */
@@ -0,0 +1,556 @@
+/**
+ *  ----------------------------------------------------------------------------
+ *  Copyright (c) 2012-13, Anaren Microwave, Inc.
+ *
+ *  For more information on licensing, please see Anaren Microwave, Inc's
+ *  end user software licensing agreement: EULA.txt.
+ *
+ *  ----------------------------------------------------------------------------
+ *
+ *  Security.c - Data Link layer AES-128 block cipher and CCM* authenticated
+ *  encryption.
+ *
+ *  @version    1.0.00
+ *  @date       16 Oct 2026
+ *  @author     BPB, air@anaren.com
+ *
+ *  For details on the interface, please see Security.h.
+ *
+ *  assumptions
+ *  ===========
+ *  Same as Security.h assumptions
+ *
+ *  file dependency
+ *  ===============
+ *  string.h : defines the function "memcpy" that is used for copying blocks
+ *  Security.h : provides interface function prototypes and global definitions
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#include <string.h>   // memcpy
+#include "Security.h"
+
+// -----------------------------------------------------------------------------
+/**
+ *  Defines, enumerations, and structure definitions
+ */
+
+// CCM* flags of the first authentication block and of the counter blocks 
+// (RFC 3610, section 2.2)
+#define SECURITY_CCM_ADATA      0x40u   // Additional data is present
+#define SECURITY_CCM_MIC_SHIFT  3       // (MIC length - 2) / 2
+#define SECURITY_CCM_L          2       // Bytes of the length field
+#define SECURITY_CCM_FLAGS_L    (SECURITY_CCM_L - 1)
+
+// -----------------------------------------------------------------------------
+/**
+ *  Global data
+ */
+
+// AES S-box
+static const unsigned char gSecuritySbox[256] = {
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+// Multiplication by 2 in GF(2^8) (MixColumns and the round constants)
+static const unsigned char gSecurityXtime[256] = {
+  0x00, 0x02, 0x04, 0x06, 0x08, 0x0A, 0x0C, 0x0E, 0x10, 0x12, 0x14, 0x16, 0x18, 0x1A, 0x1C, 0x1E,
+  0x20, 0x22, 0x24, 0x26, 0x28, 0x2A, 0x2C, 0x2E, 0x30, 0x32, 0x34, 0x36, 0x38, 0x3A, 0x3C, 0x3E,
+  0x40, 0x42, 0x44, 0x46, 0x48, 0x4A, 0x4C, 0x4E, 0x50, 0x52, 0x54, 0x56, 0x58, 0x5A, 0x5C, 0x5E,
+  0x60, 0x62, 0x64, 0x66, 0x68, 0x6A, 0x6C, 0x6E, 0x70, 0x72, 0x74, 0x76, 0x78, 0x7A, 0x7C, 0x7E,
+  0x80, 0x82, 0x84, 0x86, 0x88, 0x8A, 0x8C, 0x8E, 0x90, 0x92, 0x94, 0x96, 0x98, 0x9A, 0x9C, 0x9E,
+  0xA0, 0xA2, 0xA4, 0xA6, 0xA8, 0xAA, 0xAC, 0xAE, 0xB0, 0xB2, 0xB4, 0xB6, 0xB8, 0xBA, 0xBC, 0xBE,
+  0xC0, 0xC2, 0xC4, 0xC6, 0xC8, 0xCA, 0xCC, 0xCE, 0xD0, 0xD2, 0xD4, 0xD6, 0xD8, 0xDA, 0xDC, 0xDE,
+  0xE0, 0xE2, 0xE4, 0xE6, 0xE8, 0xEA, 0xEC, 0xEE, 0xF0, 0xF2, 0xF4, 0xF6, 0xF8, 0xFA, 0xFC, 0xFE,
+  0x1B, 0x19, 0x1F, 0x1D, 0x13, 0x11, 0x17, 0x15, 0x0B, 0x09, 0x0F, 0x0D, 0x03, 0x01, 0x07, 0x05,
+  0x3B, 0x39, 0x3F, 0x3D, 0x33, 0x31, 0x37, 0x35, 0x2B, 0x29, 0x2F, 0x2D, 0x23, 0x21, 0x27, 0x25,
+  0x5B, 0x59, 0x5F, 0x5D, 0x53, 0x51, 0x57, 0x55, 0x4B, 0x49, 0x4F, 0x4D, 0x43, 0x41, 0x47, 0x45,
+  0x7B, 0x79, 0x7F, 0x7D, 0x73, 0x71, 0x77, 0x75, 0x6B, 0x69, 0x6F, 0x6D, 0x63, 0x61, 0x67, 0x65,
+  0x9B, 0x99, 0x9F, 0x9D, 0x93, 0x91, 0x97, 0x95, 0x8B, 0x89, 0x8F, 0x8D, 0x83, 0x81, 0x87, 0x85,
+  0xBB, 0xB9, 0xBF, 0xBD, 0xB3, 0xB1, 0xB7, 0xB5, 0xAB, 0xA9, 0xAF, 0xAD, 0xA3, 0xA1, 0xA7, 0xA5,
+  0xDB, 0xD9, 0xDF, 0xDD, 0xD3, 0xD1, 0xD7, 0xD5, 0xCB, 0xC9, 0xCF, 0xCD, 0xC3, 0xC1, 0xC7, 0xC5,
+  0xFB, 0xF9, 0xFF, 0xFD, 0xF3, 0xF1, 0xF7, 0xF5, 0xEB, 0xE9, 0xEF, 0xED, 0xE3, 0xE1, 0xE7, 0xE5
+};
+
+// -----------------------------------------------------------------------------
+/**
+ *  Private interface
+ */
+
+/**
+ *  SecurityMac - add bytes to the CBC-MAC. A block is encrypted every time it
+ *  is full.
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  x         CBC-MAC state (one block).
+ *    @param  n         Number of bytes of the current block already added.
+ *    @param  data      Bytes to add.
+ *    @param  length    Number of bytes to add.
+ *
+ *    @return Number of bytes of the current block added.
+ */
+unsigned char SecurityMac(const struct sSecurityKey *schedule,
+                          unsigned char *x,
+                          unsigned char n,
+                          const unsigned char *data,
+                          unsigned char length)
+{
+  while (length-- > 0)
+  {
+    x[n++] ^= *data++;
+    if (n == SECURITY_BLOCK_LENGTH)
+    {
+      SecurityEncryptBlock(schedule, x);
+      n = 0;
+    }
+  }
+  
+  return n;
+}
+
+/**
+ *  SecurityCounterBlock - build counter block A_i.
+ *
+ *    @param  block     Counter block.
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  i         Block counter.
+ */
+void SecurityCounterBlock(unsigned char *block,
+                          const unsigned char *nonce,
+                          unsigned char i)
+{
+  block[0] = SECURITY_CCM_FLAGS_L;
+  memcpy(&block[1], nonce, SECURITY_NONCE_LENGTH);
+  block[SECURITY_BLOCK_LENGTH - 2] = 0;
+  block[SECURITY_BLOCK_LENGTH - 1] = i;
+}
+
+/**
+ *  SecurityCtr - encrypt or decrypt a message in place with the key stream
+ *  S_1, S_2, ...
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  m         Message.
+ *    @param  mLength   Number of message bytes.
+ */
+void SecurityCtr(const struct sSecurityKey *schedule,
+                 const unsigned char *nonce,
+                 unsigned char *m,
+                 unsigned char mLength)
+{
+  unsigned char block[SECURITY_BLOCK_LENGTH];
+  unsigned char i = 1;
+  
+  while (mLength > 0)
+  {
+    unsigned char n = (mLength < SECURITY_BLOCK_LENGTH) ? mLength : SECURITY_BLOCK_LENGTH;
+    unsigned char j;
+    
+    SecurityCounterBlock(block, nonce, i++);
+    SecurityEncryptBlock(schedule, block);
+    for (j = 0; j < n; j++)
+    {
+      *m++ ^= block[j];
+    }
+    mLength -= n;
+  }
+}
+
+/**
+ *  SecurityTag - compute the encrypted authentication tag (CBC-MAC of the
+ *  additional data and the message, encrypted with S_0).
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  a         Additional data.
+ *    @param  aLength   Number of additional data bytes.
+ *    @param  m         Message (plain text).
+ *    @param  mLength   Number of message bytes.
+ *    @param  micLength Number of MIC bytes (4, 8 or 16).
+ *    @param  tag       Encrypted tag (one block; the MIC is its first 
+ *                      micLength bytes).
+ */
+void SecurityTag(const struct sSecurityKey *schedule,
+                 const unsigned char *nonce,
+                 const unsigned char *a,
+                 unsigned char aLength,
+                 const unsigned char *m,
+                 unsigned char mLength,
+                 unsigned char micLength,
+                 unsigned char *tag)
+{
+  unsigned char block[SECURITY_BLOCK_LENGTH];
+  unsigned char n;
+  unsigned char j;
+  
+  // B_0: flags, nonce and message length.
+  tag[0] = (((micLength - 2) / 2) << SECURITY_CCM_MIC_SHIFT) | SECURITY_CCM_FLAGS_L;
+  if (aLength > 0)
+  {
+    tag[0] |= SECURITY_CCM_ADATA;
+  }
+  memcpy(&tag[1], nonce, SECURITY_NONCE_LENGTH);
+  tag[SECURITY_BLOCK_LENGTH - 2] = 0;
+  tag[SECURITY_BLOCK_LENGTH - 1] = mLength;
+  SecurityEncryptBlock(schedule, tag);
+  
+  // The additional data is prefixed with its length; it and the message are 
+  // each padded with zeros to a whole block.
+  if (aLength > 0)
+  {
+    tag[1] ^= aLength;
+    n = SecurityMac(schedule, tag, 2, a, aLength);
+    if (n > 0)
+    {
+      SecurityEncryptBlock(schedule, tag);
+    }
+  }
+  if (SecurityMac(schedule, tag, 0, m, mLength) > 0)
+  {
+    SecurityEncryptBlock(schedule, tag);
+  }
+  
+  // T is encrypted with S_0.
+  SecurityCounterBlock(block, nonce, 0);
+  SecurityEncryptBlock(schedule, block);
+  for (j = 0; j < micLength; j++)
+  {
+    tag[j] ^= block[j];
+  }
+}
+
+// -----------------------------------------------------------------------------
+/**
+ *  Public interface
+ */
+
+void SecurityExpandKey(struct sSecurityKey *schedule,
+                       const unsigned char *key)
+{
+  unsigned char *w = schedule->round;
+  unsigned char rcon = 0x01;
+  unsigned char i;
+  
+  memcpy(w, key, SECURITY_KEY_LENGTH);
+  for (i = SECURITY_KEY_LENGTH; i < sizeof(schedule->round); i += 4)
+  {
+    unsigned char t0 = w[i - 4];
+    unsigned char t1 = w[i - 3];
+    unsigned char t2 = w[i - 2];
+    unsigned char t3 = w[i - 1];
+    
+    // The first word of every round key is rotated, substituted and mixed 
+    // with the round constant.
+    if ((i % SECURITY_KEY_LENGTH) == 0)
+    {
+      unsigned char t = t0;
+      
+      t0 = gSecuritySbox[t1] ^ rcon;
+      t1 = gSecuritySbox[t2];
+      t2 = gSecuritySbox[t3];
+      t3 = gSecuritySbox[t];
+      rcon = gSecurityXtime[rcon];
+    }
+    w[i] = w[i - SECURITY_KEY_LENGTH] ^ t0;
+    w[i + 1] = w[i + 1 - SECURITY_KEY_LENGTH] ^ t1;
+    w[i + 2] = w[i + 2 - SECURITY_KEY_LENGTH] ^ t2;
+    w[i + 3] = w[i + 3 - SECURITY_KEY_LENGTH] ^ t3;
+  }
+}
+
+void SecurityEncryptBlock(const struct sSecurityKey *schedule,
+                          unsigned char *block)
+{
+  const unsigned char *k = schedule->round;
+  unsigned char t[SECURITY_BLOCK_LENGTH];
+  unsigned char round;
+  unsigned char i;
+  
+  for (i = 0; i < SECURITY_BLOCK_LENGTH; i++)
+  {
+    block[i] ^= k[i];
+  }
+  
+  for (round = 1; round <= SECURITY_ROUNDS; round++)
+  {
+    k += SECURITY_BLOCK_LENGTH;
+    
+    // SubBytes and ShiftRows (the state is stored column by column).
+    t[0] = gSecuritySbox[block[0]];
+    t[1] = gSecuritySbox[block[5]];
+    t[2] = gSecuritySbox[block[10]];
+    t[3] = gSecuritySbox[block[15]];
+    t[4] = gSecuritySbox[block[4]];
+    t[5] = gSecuritySbox[block[9]];
+    t[6] = gSecuritySbox[block[14]];
+    t[7] = gSecuritySbox[block[3]];
+    t[8] = gSecuritySbox[block[8]];
+    t[9] = gSecuritySbox[block[13]];
+    t[10] = gSecuritySbox[block[2]];
+    t[11] = gSecuritySbox[block[7]];
+    t[12] = gSecuritySbox[block[12]];
+    t[13] = gSecuritySbox[block[1]];
+    t[14] = gSecuritySbox[block[6]];
+    t[15] = gSecuritySbox[block[11]];
+    
+    if (round < SECURITY_ROUNDS)
+    {
+      // MixColumns and AddRoundKey.
+      for (i = 0; i < SECURITY_BLOCK_LENGTH; i += 4)
+      {
+        unsigned char a0 = t[i];
+        unsigned char a1 = t[i + 1];
+        unsigned char a2 = t[i + 2];
+        unsigned char a3 = t[i + 3];
+        unsigned char x = a0 ^ a1 ^ a2 ^ a3;
+        
+        block[i] = a0 ^ x ^ gSecurityXtime[a0 ^ a1] ^ k[i];
+        block[i + 1] = a1 ^ x ^ gSecurityXtime[a1 ^ a2] ^ k[i + 1];
+        block[i + 2] = a2 ^ x ^ gSecurityXtime[a2 ^ a3] ^ k[i + 2];
+        block[i + 3] = a3 ^ x ^ gSecurityXtime[a3 ^ a0] ^ k[i + 3];
+      }
+    }
+    else
+    {
+      // The last round has no MixColumns.
+      for (i = 0; i < SECURITY_BLOCK_LENGTH; i++)
+      {
+        block[i] = t[i] ^ k[i];
+      }
+    }
+  }
+}
+
+void SecurityCcmEncrypt(const struct sSecurityKey *schedule,
+                        const unsigned char *nonce,
+                        const unsigned char *a,
+                        unsigned char aLength,
+                        unsigned char *m,
+                        unsigned char mLength,
+                        unsigned char *mic,
+                        unsigned char micLength)
+{
+  unsigned char tag[SECURITY_BLOCK_LENGTH];
+  
+  // The tag covers the plain text.
+  SecurityTag(schedule, nonce, a, aLength, m, mLength, micLength, tag);
+  memcpy(mic, tag, micLength);
+  SecurityCtr(schedule, nonce, m, mLength);
+}
+
+bool SecurityCcmDecrypt(const struct sSecurityKey *schedule,
+                        const unsigned char *nonce,
+                        const unsigned char *a,
+                        unsigned char aLength,
+                        unsigned char *m,
+                        unsigned char mLength,
+                        const unsigned char *mic,
+                        unsigned char micLength)
+{
+  unsigned char tag[SECURITY_BLOCK_LENGTH];
+  unsigned char diff = 0;
+  unsigned char i;
+  
+  SecurityCtr(schedule, nonce, m, mLength);
+  SecurityTag(schedule, nonce, a, aLength, m, mLength, micLength, tag);
+  
+  // Every byte is compared, so the time taken does not tell where the MIC 
+  // differs.
+  for (i = 0; i < micLength; i++)
+  {
+    diff |= tag[i] ^ mic[i];
+  }
+  
+  return (diff == 0);
+}
+
+// -----------------------------------------------------------------------------
+/**
+ *  Test stub - known answers and benchmark of the cipher.
+ */
+
+/**
+ *  To test this module, define the following in your compiler preprocessor
+ *  definitions: "TEST_SECURITY".
+ *
+ *  It is strongly suggested that you leave the test stub in this source file.
+ *  This stub will allow you to easily test your implementation using unit tests
+ *  defined and by adding more to suit your application needs.
+ */
+#ifdef TEST_SECURITY
+
+/**
+ *  Test Example - FIPS-197 and RFC 3610 known answers, a tampered message, and
+ *  the cost of a block and of a secured frame.
+ *
+ *  @version    1.0.00
+ *  @date       16 Oct 2026
+ *  @author     BPB, air@anaren.com
+ *  @platform   Host (any hosted C compiler); the source builds unchanged for
+ *              the MSP430 if SECURITY_TEST_CYCLES reads a timer clocked by 
+ *              MCLK
+ *
+ *  assumptions
+ *  ===========
+ *  - SECURITY_TEST_CYCLES() returns a free-running cycle count. The default
+ *  reads the time stamp counter on x86 and clock() elsewhere (in which case
+ *  the cost is reported in clock ticks rather than cycles).
+ *
+ *  file dependency
+ *  ===============
+ *  stdio.h : defines the function "printf" used to report the results
+ *  time.h : defines the function "clock" (default cycle count)
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#include <stdio.h>
+#include <time.h>
+
+#ifndef SECURITY_TEST_CYCLES
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#include <x86intrin.h>
+#define SECURITY_TEST_CYCLES()  ((unsigned long long)__rdtsc())
+#else
+#define SECURITY_TEST_CYCLES()  ((unsigned long long)clock())
+#endif
+#endif
+
+#define SECURITY_TEST_BLOCKS    10000   // Blocks encrypted by the benchmark
+#define SECURITY_TEST_FRAMES    1000    // Frames secured by the benchmark
+#define SECURITY_TEST_HEADER    12      // Frame header (additional data)
+#define SECURITY_TEST_PAYLOAD   16      // Frame payload
+#define SECURITY_TEST_MIC       4
+
+// FIPS-197, appendix C.1
+static const unsigned char gSecurityTestKey[SECURITY_KEY_LENGTH] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+};
+static const unsigned char gSecurityTestPlain[SECURITY_BLOCK_LENGTH] = {
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+static const unsigned char gSecurityTestCipher[SECURITY_BLOCK_LENGTH] = {
+  0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+};
+
+// RFC 3610, packet vector #1 (8-byte MIC)
+static const unsigned char gSecurityTestCcmKey[SECURITY_KEY_LENGTH] = {
+  0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF
+};
+static const unsigned char gSecurityTestNonce[SECURITY_NONCE_LENGTH] = {
+  0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5
+};
+static const unsigned char gSecurityTestCcmCipher[23 + 8] = {
+  0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80, 
+  0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0
+};
+
+int main(void)
+{
+  struct sSecurityKey schedule;
+  unsigned char block[SECURITY_BLOCK_LENGTH];
+  unsigned char a[SECURITY_TEST_HEADER];
+  unsigned char m[8 + 23 + 8];
+  unsigned long long start;
+  unsigned long long cycles;
+  unsigned int i;
+  int failures = 0;
+  
+  // Block cipher.
+  SecurityExpandKey(&schedule, gSecurityTestKey);
+  memcpy(block, gSecurityTestPlain, SECURITY_BLOCK_LENGTH);
+  SecurityEncryptBlock(&schedule, block);
+  if (memcmp(block, gSecurityTestCipher, SECURITY_BLOCK_LENGTH) != 0)
+  {
+    printf("FIPS-197 C.1 failed\n");
+    failures++;
+  }
+  
+  // CCM: additional data 00..07, message 08..1E.
+  SecurityExpandKey(&schedule, gSecurityTestCcmKey);
+  for (i = 0; i < sizeof(m); i++)
+  {
+    m[i] = (unsigned char)i;
+  }
+  SecurityCcmEncrypt(&schedule, gSecurityTestNonce, m, 8, &m[8], 23, &m[8 + 23], 8);
+  if (memcmp(&m[8], gSecurityTestCcmCipher, sizeof(gSecurityTestCcmCipher)) != 0)
+  {
+    printf("RFC 3610 packet vector #1 failed\n");
+    failures++;
+  }
+  if (!SecurityCcmDecrypt(&schedule, gSecurityTestNonce, m, 8, &m[8], 23, &m[8 + 23], 8)
+      || (m[8] != 8) || (m[30] != 30))
+  {
+    printf("RFC 3610 packet vector #1 does not decrypt\n");
+    failures++;
+  }
+  
+  // A changed bit of the additional data must be detected.
+  SecurityCcmEncrypt(&schedule, gSecurityTestNonce, m, 8, &m[8], 23, &m[8 + 23], 8);
+  m[3] ^= 0x10;
+  if (SecurityCcmDecrypt(&schedule, gSecurityTestNonce, m, 8, &m[8], 23, &m[8 + 23], 8))
+  {
+    printf("tampered message accepted\n");
+    failures++;
+  }
+  
+  // Cost of a key schedule, a block and a frame (header authenticated, 
+  // payload encrypted, 4-byte MIC).
+  start = SECURITY_TEST_CYCLES();
+  for (i = 0; i < SECURITY_TEST_FRAMES; i++)
+  {
+    SecurityExpandKey(&schedule, gSecurityTestKey);
+  }
+  cycles = SECURITY_TEST_CYCLES() - start;
+  printf("key schedule   %.0f cycles\n", (double)cycles / SECURITY_TEST_FRAMES);
+  
+  start = SECURITY_TEST_CYCLES();
+  for (i = 0; i < SECURITY_TEST_BLOCKS; i++)
+  {
+    SecurityEncryptBlock(&schedule, block);
+  }
+  cycles = SECURITY_TEST_CYCLES() - start;
+  printf("block          %.0f cycles (%.1f cycles/byte)\n", 
+         (double)cycles / SECURITY_TEST_BLOCKS, 
+         (double)cycles / (SECURITY_TEST_BLOCKS * SECURITY_BLOCK_LENGTH));
+  
+  memset(a, 0x5A, sizeof(a));
+  start = SECURITY_TEST_CYCLES();
+  for (i = 0; i < SECURITY_TEST_FRAMES; i++)
+  {
+    a[0] = (unsigned char)i;
+    SecurityCcmEncrypt(&schedule, gSecurityTestNonce, a, SECURITY_TEST_HEADER, 
+                       m, SECURITY_TEST_PAYLOAD, &m[SECURITY_TEST_PAYLOAD], SECURITY_TEST_MIC);
+  }
+  cycles = SECURITY_TEST_CYCLES() - start;
+  printf("frame          %.0f cycles (%u-byte header, %u-byte payload, %u-byte MIC)\n",
+         (double)cycles / SECURITY_TEST_FRAMES, 
+         SECURITY_TEST_HEADER, SECURITY_TEST_PAYLOAD, SECURITY_TEST_MIC);
+  
+  printf("%s (%d failures)\n", (failures == 0) ? "PASS" : "FAIL", failures);
+  
+  return (failures == 0) ? 0 : 1;
+}
+
+#endif  /* TEST_SECURITY */
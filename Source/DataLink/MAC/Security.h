@@ -0,0 +1,149 @@
+#ifndef SECURITY_H
+#define SECURITY_H
+/**
+ *  ----------------------------------------------------------------------------
+ *  Copyright (c) 2012-13, Anaren Microwave, Inc.
+ *
+ *  For more information on licensing, please see Anaren Microwave, Inc's
+ *  end user software licensing agreement: EULA.txt.
+ *
+ *  ----------------------------------------------------------------------------
+ *
+ *  Security.h - Data Link layer AES-128 block cipher and CCM* authenticated
+ *  encryption.
+ *
+ *  @version  1.0.00
+ *  @date     16 Oct 2026
+ *  @author   BPB, air@anaren.com
+ *
+ *  The block cipher only encrypts (CCM* never decrypts a block), so no inverse
+ *  tables are needed. It works on bytes: the S-box and the doubling in
+ *  GF(2^8) are 256-byte tables in flash, which suits a 16-bit MCU without
+ *  32-bit registers better than 32-bit T-tables. The key schedule is expanded
+ *  once (SecurityExpandKey) and reused for every block.
+ *
+ *  CCM* follows RFC 3610 (IEEE 802.15.4 nonce of 13 bytes, 2-byte length
+ *  field) with a MIC of 4, 8 or 16 bytes.
+ *
+ *  assumptions
+ *  ===========
+ *  - "NULL" is not a valid argument for pointer parameters unless the function
+ *  definition explicitly states that it is.
+ *  - A nonce is never used twice with the same key.
+ *
+ *  file dependency
+ *  ===============
+ *  none
+ *
+ *  revision history
+ *  ================
+ *  ver 1.0.00 : 16 Oct 2026
+ *  - initial release
+ */
+#define SECURITY_INFO "SECURITY 1.0.00"
+
+#ifndef bool
+#define bool unsigned char
+#endif
+
+#ifndef true
+#define true 1
+#endif
+
+#ifndef false
+#define false 0
+#endif
+
+// -----------------------------------------------------------------------------
+/**
+ *  Defines, enumerations, and structure definitions
+ */
+
+#ifndef NULL
+#define NULL  (void*)0
+#endif
+
+#define SECURITY_KEY_LENGTH     16      // AES-128 key
+#define SECURITY_BLOCK_LENGTH   16
+#define SECURITY_ROUNDS         10
+#define SECURITY_NONCE_LENGTH   13      // CCM* nonce (2-byte length field)
+
+/**
+ *  sSecurityKey - expanded key schedule (one round key per round and the
+ *  initial key).
+ */
+struct sSecurityKey
+{
+  unsigned char round[(SECURITY_ROUNDS + 1) * SECURITY_BLOCK_LENGTH];
+};
+
+// -----------------------------------------------------------------------------
+/**
+ *  Public interface
+ */
+
+/**
+ *  SecurityExpandKey - expand a key into its key schedule.
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  key       Key (SECURITY_KEY_LENGTH bytes).
+ */
+void SecurityExpandKey(struct sSecurityKey *schedule,
+                       const unsigned char *key);
+
+/**
+ *  SecurityEncryptBlock - encrypt one block in place.
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  block     Block (SECURITY_BLOCK_LENGTH bytes).
+ */
+void SecurityEncryptBlock(const struct sSecurityKey *schedule,
+                          unsigned char *block);
+
+/**
+ *  SecurityCcmEncrypt - authenticate a message and its additional data, then
+ *  encrypt the message in place.
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  a         Additional data (authenticated only).
+ *    @param  aLength   Number of additional data bytes.
+ *    @param  m         Message.
+ *    @param  mLength   Number of message bytes.
+ *    @param  mic       Message integrity code.
+ *    @param  micLength Number of MIC bytes (4, 8 or 16).
+ */
+void SecurityCcmEncrypt(const struct sSecurityKey *schedule,
+                        const unsigned char *nonce,
+                        const unsigned char *a,
+                        unsigned char aLength,
+                        unsigned char *m,
+                        unsigned char mLength,
+                        unsigned char *mic,
+                        unsigned char micLength);
+
+/**
+ *  SecurityCcmDecrypt - decrypt a message in place and check its MIC.
+ *
+ *    @param  schedule  Key schedule.
+ *    @param  nonce     Nonce (SECURITY_NONCE_LENGTH bytes).
+ *    @param  a         Additional data (authenticated only).
+ *    @param  aLength   Number of additional data bytes.
+ *    @param  m         Encrypted message.
+ *    @param  mLength   Number of message bytes.
+ *    @param  mic       Message integrity code received.
+ *    @param  micLength Number of MIC bytes (4, 8 or 16).
+ *
+ *    @return True if the message is authentic. Otherwise, the message is
+ *            garbage and must be dropped.
+ */
+bool SecurityCcmDecrypt(const struct sSecurityKey *schedule,
+                        const unsigned char *nonce,
+                        const unsigned char *a,
+                        unsigned char aLength,
+                        unsigned char *m,
+                        unsigned char mLength,
+                        const unsigned char *mic,
+                        unsigned char micLength);
+
+#endif  /* SECURITY_H */
@@ -13,8 +13,8 @@
  *  Provides the interface for the protocol and the implementation from the
  *  physical hardware.
  *
- *  @version  1.0.01
- *  @date     2 Jul 2012
+ *  @version  1.1.00
+ *  @date     16 Oct 2026
  *  @author   BPB, air@anaren.com
  *
  *  This interface contains all the necessary physical hardware operations for
@@ -33,12 +33,45 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added PhyTransmitv, a gather transmit of data field segments; segments 
+ *  refer to read-only data
+ *  - added PhyProcess, an optional deferred processing mode in which interrupt
+ *  service routines only record events (PROTOCOL_USE_DEFERRED_PROCESSING); 
+ *  pending Generic timer ticks are counted in an unsigned int that saturates 
+ *  instead of wrapping
+ *  - every operation takes the physical device (sPhyDevice) it applies to so
+ *  that several devices may be driven at the same time; callbacks receive the
+ *  upper layer context registered with PhyInit
+ *  - the Rx timeout no longer depends on the node role; it is used by devices 
+ *  that register a SyncTimeout callback
+ *  - added PhyGetDataStreamTimestamp, the time of the GDO0 edge ending the last
+ *  data stream (PROTOCOL_USE_LATENCY_COUNTERS)
+ *  - the Generic timer callback only ticks between PhyTimerStart and 
+ *  PhyTimerStop; the Rx timeout no longer starts or stops it
+ *  - a pending Rx timeout is cancelled by PhyIdle, PhyLowPowerMode and 
+ *  PhyTransmitv
+ *  - optional listen-before-talk; PhyTransmitv only transmits if the channel 
+ *  is clear (PROTOCOL_USE_CSMA) and PhyChannelBusy reports a refusal
+ *  - PROTOCOL_TIMESTAMP is available whenever the platform defines 
+ *  MCU_TIMESTAMP; it is required by PROTOCOL_USE_LATENCY_COUNTERS and 
+ *  PROTOCOL_USE_ENDPOINT_TABLE
+ *  - optional data streams larger than the physical hardware FIFO, up to 
+ *  PHY_MAX_DATASTREAM_SIZE bytes (PROTOCOL_USE_STREAMING)
+ *  - the end of a transmission is confirmed by a one-shot timer instead of 
+ *  polling the radio in the interrupt service routine
+ *  - a data stream ending while a callback turns the receiver on again is no
+ *  longer lost
+ *  - added PhySetTurnaround; the radio may enter RX on its own as soon as a
+ *  transmission ends and PhyReceiverOn then keeps it listening 
+ *  (PROTOCOL_USE_TURNAROUND)
+ *  - added PhyGetEntropy (PROTOCOL_USE_SECURITY)
  *  ver 1.0.01 : 16 Oct 2012
  *  - updated internal documentation; comments revised
  *  ver 1.0.00 : 2 Jul 2012
  *  - initial release
  */
-#define PHY_BRIDGE_INFO   "PHY_BRIDGE 1.0.01"
+#define PHY_BRIDGE_INFO   "PHY_BRIDGE 1.1.00"
 
 #ifndef bool
 #define bool unsigned char
@@ -52,10 +85,6 @@
 #define false 0
 #endif
 
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_GATEWAY )
-#error "PhyBridge Error: End Point and Gateway roles cannot be defined at the same time."
-#endif
-
 // -----------------------------------------------------------------------------
 /**
  *  Defines, enumerations, and structure definitions
@@ -66,9 +95,38 @@
 #define PROTOCOL_DISABLE_INTERRUPT()      MCU_DISABLE_INTERRUPT()
 #define PROTOCOL_CRITICAL_SECTION(code)   MCU_CRITICAL_SECTION(code)
 
+// Free running platform timer count (wraps around)
+#if defined( MCU_TIMESTAMP )
+#define PROTOCOL_TIMESTAMP()              MCU_TIMESTAMP()
+#elif defined( PROTOCOL_USE_LATENCY_COUNTERS )
+#error "PhyBridge Error: PROTOCOL_USE_LATENCY_COUNTERS requires MCU_TIMESTAMP() to read a free running timer."
+#elif defined( PROTOCOL_USE_ENDPOINT_TABLE )
+#error "PhyBridge Error: PROTOCOL_USE_ENDPOINT_TABLE requires MCU_TIMESTAMP() to read a free running timer."
+#endif
+
 // Maximum data stream size
+#if defined( PROTOCOL_USE_STREAMING )
+// Note: Data streams larger than the physical hardware FIFO are moved through
+// it while they are on air (PhySyncEopIsr services the FIFO threshold).
+#ifndef PHY_MAX_DATASTREAM_SIZE
+#define PHY_MAX_DATASTREAM_SIZE           255
+#endif
+
+#if (PHY_MAX_DATASTREAM_SIZE > 255)
+#error "PhyBridge Error: PHY_MAX_DATASTREAM_SIZE must not exceed 255 bytes (length field)."
+#endif
+
+#define PROTOCOL_DATASTREAM_MAX_SIZE      PHY_MAX_DATASTREAM_SIZE
+
+// Number of data field segments a data stream larger than the physical 
+// hardware FIFO may be made of
+#ifndef PHY_STREAM_MAX_SEGMENTS
+#define PHY_STREAM_MAX_SEGMENTS           8
+#endif
+#else
 // Note: Currently set to the maximum physical hardware TX FIFO size.
 #define PROTOCOL_DATASTREAM_MAX_SIZE      PHY_MAX_TXFIFO_SIZE
+#endif
 
 // Data stream overhead
 #define PROTOCOL_DATASTREAM_HEADER_LENGTH 1
@@ -76,6 +134,29 @@
 #define PROTOCOL_DATASTREAM_OVERHEAD      PROTOCOL_DATASTREAM_HEADER_LENGTH + PROTOCOL_DATASTREAM_FOOTER_LENGTH
 #define PROTOCOL_DATASTREAM_FOOTER_CRC    (0x0080u)
 #define PROTOCOL_DATASTREAM_FOOTER_LQI    (0x007Fu)
+
+// Number of physical devices (radio modules) that may be driven at the same
+// time
+#ifndef PROTOCOL_MAX_INSTANCES
+#define PROTOCOL_MAX_INSTANCES            1
+#endif
+   
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+// Number of events the interrupt service routines may record before they are
+// processed (must be a power of 2)
+#ifndef PROTOCOL_EVENT_RING_SIZE
+#define PROTOCOL_EVENT_RING_SIZE          4
+#endif
+
+#if (PROTOCOL_EVENT_RING_SIZE & (PROTOCOL_EVENT_RING_SIZE - 1)) != 0
+#error "PhyBridge Error: PROTOCOL_EVENT_RING_SIZE must be a power of 2."
+#endif
+
+// Events recorded by the interrupt service routines
+#define PHY_EVENT_SYNC_EOP                (0x01u)
+#define PHY_EVENT_RX_TIMEOUT              (0x02u)
+#define PHY_EVENT_TX_END                  (0x03u)
+#endif
    
 /**
  *  tPower - absolute power (dBm) representation.
@@ -87,6 +168,23 @@ typedef signed int tPower;
  */
 typedef unsigned long tTime;
 
+/**
+ *  sPhyDataSegment - a contiguous part of a data field. A data field may be
+ *  described by a list of segments so that it can be transmitted without first
+ *  being copied into a single buffer.
+ */
+struct sPhyDataSegment
+{
+  const unsigned char *data;    // Location of the segment (never written)
+  unsigned char length;         // Number of bytes in the segment
+};
+
+/**
+ *  sPhyBinding - hardware interfaces (SPI, GDOx, etc.) used by a physical 
+ *  device. Defined by the Physical bridge implementation.
+ */
+struct sPhyBinding;
+
 /**
  *  sPhyDevice - 
  */
@@ -94,6 +192,7 @@ struct sPhyDevice
 {
   
   void *phyInfo;                      // Physical information
+  void *context;                      // Upper layer context (passed to callbacks)
   
   /**
    *  sPhyDeviceStatus - 
@@ -101,23 +200,36 @@ struct sPhyDevice
   struct sPhyDeviceStatus
   {
     volatile bool transmitting;       // Device transmitting flag
+    bool listening;                   // Receiver on; no data stream ended since
+    #if defined( PROTOCOL_USE_CSMA )
+    bool channelBusy;                 // Last transmission refused; channel busy
+    #endif
+    #if defined( PROTOCOL_USE_TURNAROUND )
+    bool turnaround;                  // Next transmission ends in RX (requested)
+    bool txoffRx;                     // Transmissions end in RX (programmed)
+    bool turnedAround;                // Receiver on since the last transmission
+    #endif
     
     /**
      *  DataStreamSent - 
      *
+     *    @param  context
+     *
      *    @return
      */
-    unsigned char(*DataStreamSent)(void);
+    unsigned char(*DataStreamSent)(void *context);
     
     /**
      *  DataStreamAvailable - 
      *
+     *    @param  context
      *    @param  dataField
      *    @param  length
      *
      *    @return
      */
-    unsigned char(*DataStreamAvailable)(unsigned char *dataField, 
+    unsigned char(*DataStreamAvailable)(void *context,
+                                        unsigned char *dataField, 
                                         unsigned char length);
   } status;
   
@@ -126,16 +238,19 @@ struct sPhyDevice
    */
   struct sPhyTimer
   {
-    bool running;                         // Hardware timer running flag
+    bool running;                         // Device using the hardware timer
+    bool generic;                         // Generic timer started (PhyTimerStart)
     
     /**
      *  Generic - 
      *
+     *    @param  context
+     *
      *    @return
      */
-    unsigned char(*Generic)(void);        // Generic timer function
+    unsigned char(*Generic)(void *context); // Generic timer function
     
-    #if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+    #if defined( PROTOCOL_USE_RX_TIMEOUT )
     /**
      *  sPhyTimerRxTimeout - 
      */
@@ -148,11 +263,27 @@ struct sPhyDevice
       /**
        *  SyncTimeout - 
        *
+       *    @param  context
+       *
        *    @return
        */
-      unsigned char(*RxTimeout)(void);    // Rx timeout callback
+      unsigned char(*RxTimeout)(void *context); // Rx timeout callback
+      #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+      volatile bool expired;              // Rx timeout waiting to be processed
+      #endif
     } rxTimeout;
     #endif
+    
+    /**
+     *  sPhyTimerTxEnd - one-shot confirming the end of a transmission. The 
+     *  radio remains in TX_END for a few bit periods after the EOP.
+     */
+    struct sPhyTimerTxEnd
+    {
+      bool enable;                        // Transmission waiting to be confirmed
+      tTime compare;                      // Ticks the radio may remain in TX_END
+      tTime counter;                      // Ticks left
+    } txEnd;
   } timer;
   
   /**
@@ -196,8 +327,40 @@ struct sPhyDevice
 //      bool crc          : 1;      // Last received data stream CRC
       unsigned char status;      // Last received data stream [RSSI][LQI(7) + CRC(1)]
     } footer;
+    #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+    unsigned int timestamp;       // Time of the last GDO0 edge (PROTOCOL_TIMESTAMP)
+    #endif
+    #if defined( PROTOCOL_USE_STREAMING )
+    /**
+     *  sPhyDataStreamFifo - part of the data stream not moved through the 
+     *  physical hardware FIFO yet. Transmitting, the data field segments left
+     *  to write; receiving, the number of data field bytes read.
+     */
+    struct sPhyDataStreamFifo
+    {
+      struct sPhyDataSegment segment[PHY_STREAM_MAX_SEGMENTS];
+      unsigned char count;        // Number of segments (TX)
+      unsigned char index;        // Segment being written (TX)
+      unsigned char offset;       // Bytes of the segment written (TX) or data field bytes read (RX)
+      bool length;                // Length field read (RX)
+    } fifo;
+    #endif
   } stream;
   
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  /**
+   *  sPhyEventRing - single producer (interrupt service routines), single 
+   *  consumer (PhyProcess) ring of events. The producer only writes head and 
+   *  the consumer only writes tail; no locking is required.
+   */
+  struct sPhyEventRing
+  {
+    unsigned char event[PROTOCOL_EVENT_RING_SIZE];
+    volatile unsigned char head;      // Next event to be written (producer)
+    volatile unsigned char tail;      // Next event to be read (consumer)
+    volatile unsigned int ticks;      // Generic timer ticks not yet serviced
+  } events;
+  #endif
 };
 
 // -----------------------------------------------------------------------------
@@ -217,6 +380,15 @@ struct sPhyDevice
  *  Note: If either callback is not desired, they may be set to NULL. The
  *  implementation must check for NULL callback function pointers.
  *
+ *  Note: The device must be zero-initialized (e.g. static storage) before it
+ *  is initialized the first time. Up to PROTOCOL_MAX_INSTANCES devices may be
+ *  initialized.
+ *
+ *    @param  device              Physical device being initialized.
+ *    @param  binding             Hardware interfaces used by the device. If 
+ *                                NULL, the implementation's default binding is
+ *                                used.
+ *    @param  context             Upper layer context passed to every callback.
  *    @param  DataStreamSent      Callback invoked when a data stream has been
  *                                sent (EOP interrupt issued during TX).
  *    @param  DataStreamAvailable Callback invoked when a data stream has been
@@ -225,18 +397,25 @@ struct sPhyDevice
  *    @return Success of physical hardware and bridge setup. Will return true
  *            if initialization is successful, false otherwise.
  */
-bool PhyInit(unsigned char(*DataStreamSent)(void), 
-             unsigned char(*DataStreamAvailable)(unsigned char *dataField, unsigned char length));
+bool PhyInit(struct sPhyDevice *device,
+             const struct sPhyBinding *binding,
+             void *context,
+             unsigned char(*DataStreamSent)(void *context), 
+             unsigned char(*DataStreamAvailable)(void *context, unsigned char *dataField, unsigned char length));
 
 /**
  *  PhyEnable - enable communication at the Physical hardware.
+ *
+ *    @param  device  Physical device.
  */
-void PhyEnable(void);
+void PhyEnable(struct sPhyDevice *device);
 
 /**
  *  PhyDisable - disable communication at the Physical hardware.
+ *
+ *    @param  device  Physical device.
  */
-void PhyDisable(void);
+void PhyDisable(struct sPhyDevice *device);
 
 // -----------------------------------------------------------------------------
 // Physical configuration
@@ -248,13 +427,14 @@ void PhyDisable(void);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device  Physical device.
  *    @param  config  Index of the configuration desired from a lookup table.
  *
  *    @return Success of physical hardware configuration. Please refer to the
  *            associated hardware driver for more information on potential
  *            failure conditions.
  */
-bool PhyConfigure(unsigned char config);
+bool PhyConfigure(struct sPhyDevice *device, unsigned char config);
 
 /**
  *  PhyEnableAddressFilter - set the hardware device address to filter on and enable
@@ -264,14 +444,17 @@ bool PhyConfigure(unsigned char config);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device      Physical device.
  *    @param  deviceAddr  Desired physical device hardware address.
  */
-void PhyEnableAddressFilter(unsigned char deviceAddr);
+void PhyEnableAddressFilter(struct sPhyDevice *device, unsigned char deviceAddr);
 
 /**
  *  PhyDisableAddressFilter - disables hardware address filtering.
+ *
+ *    @param  device  Physical device.
  */
-void PhyDisableAddressFilter(void);
+void PhyDisableAddressFilter(struct sPhyDevice *device);
 
 /**
  *  PhySetChannel - set the physical hardware communication channel.
@@ -280,13 +463,14 @@ void PhyDisableAddressFilter(void);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device  Physical device.
  *    @param  channel Index of the channel desired from a lookup table.
  *
  *    @return Success of physical hardware channel change. Please refer to the
  *            associated hardware driver for more information on potential
  *            failure conditions.
  */
-bool PhySetChannel(unsigned char channel);
+bool PhySetChannel(struct sPhyDevice *device, unsigned char channel);
 
 /**
  *  PhySetOutputPower - set the physical hardware transmitter's output power.
@@ -295,9 +479,10 @@ bool PhySetChannel(unsigned char channel);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device  Physical device.
  *    @param  power Index of the power level desired from a lookup table.
  */
-void PhySetOutputPower(tPower power);
+void PhySetOutputPower(struct sPhyDevice *device, tPower power);
 
 // -----------------------------------------------------------------------------
 // Physical status
@@ -310,18 +495,81 @@ void PhySetOutputPower(tPower power);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device  Physical device.
+ *
  *    @return Sampled absolute power level.
  */
-tPower PhyGetInstantSignalStrength(void);
+tPower PhyGetInstantSignalStrength(struct sPhyDevice *device);
 
 /**
  *  PhyGetDataStreamStatus - retrieve the last received data stream's status
  *  information located in the data stream footer. This information includes
  *  the received signal strength indicator, link quality indicator, and CRC.
  *
+ *    @param  device  Physical device.
+ *
  *    @return Location of the data stream's status information.
  */
-struct sPhyDataStreamFooter* PhyGetDataStreamStatus(void);
+struct sPhyDataStreamFooter* PhyGetDataStreamStatus(struct sPhyDevice *device);
+
+#if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+/**
+ *  PhyGetDataStreamTimestamp - retrieve the time of the GDO0 edge that ended 
+ *  the last data stream (PROTOCOL_TIMESTAMP ticks). The time is recorded in the
+ *  interrupt service routine, before the data stream is read or processed.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return Timestamp of the last data stream.
+ */
+unsigned int PhyGetDataStreamTimestamp(struct sPhyDevice *device);
+#endif
+
+#if defined( PROTOCOL_USE_CSMA )
+/**
+ *  PhyChannelBusy - check if the last transmission was refused because the 
+ *  channel was busy (clear channel assessment failed).
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return True if the last call to PhyTransmitv failed on a busy channel.
+ */
+bool PhyChannelBusy(struct sPhyDevice *device);
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+/**
+ *  PhyGetEntropy - sample the receiver noise (RSSI) on the current channel. 
+ *  The receiver is turned on for the duration of the sampling unless it is 
+ *  already on, and the Physical hardware is left active.
+ *
+ *  Note: The value is meant to seed a counter or a generator; it carries far
+ *  fewer random bits than its width.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return Receiver noise folded into a 32-bit value.
+ */
+unsigned long PhyGetEntropy(struct sPhyDevice *device);
+#endif
+
+#if defined( PROTOCOL_USE_TURNAROUND )
+/**
+ *  PhySetTurnaround - select the state the Physical hardware enters once the 
+ *  next transmissions end. The setting applies from the next call to 
+ *  PhyTransmitv.
+ *
+ *  With turnaround, the hardware enters RX on its own as soon as the data 
+ *  stream is on air; a response sent right away is not missed while 
+ *  DataStreamSent is serviced. The receiver keeps listening when PhyReceiverOn
+ *  follows DataStreamSent (the RX FIFO is not flushed again). Otherwise, the 
+ *  hardware returns to idle.
+ *
+ *    @param  device  Physical device.
+ *    @param  enable  True to turn the receiver on when a transmission ends.
+ */
+void PhySetTurnaround(struct sPhyDevice *device, bool enable);
+#endif
 
 // -----------------------------------------------------------------------------
 // Physical operation
@@ -332,8 +580,12 @@ struct sPhyDataStreamFooter* PhyGetDataStreamStatus(void);
  *  Note: The implementation of this function should automatically handle 
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
+ *
+ *  Note: A pending Rx timeout is cancelled.
+ *
+ *    @param  device  Physical device.
  */
-void PhyIdle(void);
+void PhyIdle(struct sPhyDevice *device);
 
 /**
  *  PhyCalibrate - calibrate the Physical hardware.
@@ -341,8 +593,10 @@ void PhyIdle(void);
  *  Note: The implementation of this function should automatically handle 
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
+ *
+ *    @param  device  Physical device.
  */
-void PhyCalibrate(void);
+void PhyCalibrate(struct sPhyDevice *device);
 
 /**
  *  PhyReceiverOn - turn on the Physical receiver.
@@ -351,11 +605,16 @@ void PhyCalibrate(void);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *  Note: May be called from the DataStreamSent and DataStreamAvailable 
+ *  callbacks. A data stream that ends before the callback returns is still 
+ *  reported once it does.
+ *
+ *    @param  device      Physical device.
  *    @param  dataField   Buffer to store the received data field. This buffer 
  *                        is assumed to be large enough to store the largest
  *                        expected data field.
  */
-void PhyReceiverOn(unsigned char *dataField);
+void PhyReceiverOn(struct sPhyDevice *device, unsigned char *dataField);
 
 /**
  *  PhyTransmit -  Build a data stream from the data field provided and transmit 
@@ -365,6 +624,7 @@ void PhyReceiverOn(unsigned char *dataField);
  *  transitioning Physical hardware from a low power state to an active state
  *  before performing the operation.
  *
+ *    @param  device      Physical device.
  *    @param  dataField   Buffer that stores the data field to be encapsulated
  *                        into a data stream.
  *    @param  count       Number of bytes in the data field buffer.
@@ -373,13 +633,53 @@ void PhyReceiverOn(unsigned char *dataField);
  *            transmission, this operation will fail until the initial transmit
  *            completes.
  */
-bool PhyTransmit(unsigned char *dataField, 
+bool PhyTransmit(struct sPhyDevice *device, 
+                 unsigned char *dataField, 
                  unsigned char count);
 
+/**
+ *  PhyTransmitv - build a data stream from a list of data field segments and 
+ *  transmit the resulting data stream using the Physical hardware. Segments
+ *  are written to the hardware in order; they are never copied into an 
+ *  intermediate buffer.
+ * 
+ *  Note: The implementation of this function should automatically handle 
+ *  transitioning Physical hardware from a low power state to an active state
+ *  before performing the operation. A pending Rx timeout is cancelled.
+ *
+ *  Note: With PROTOCOL_USE_CSMA, the channel is assessed first (listen before
+ *  talk). The data stream is not sent if the channel is busy; this operation
+ *  fails and PhyChannelBusy reports it. Backing off is left to the caller.
+ *
+ *  Note: With PROTOCOL_USE_STREAMING, a data stream larger than the physical
+ *  hardware FIFO (up to PROTOCOL_DATASTREAM_MAX_SIZE) is written as the FIFO
+ *  drains. The segments must then remain valid until DataStreamSent.
+ *
+ *  Note: With PROTOCOL_USE_TURNAROUND, the hardware enters RX once the data 
+ *  stream is sent if turnaround was selected (PhySetTurnaround).
+ *
+ *    @param  device      Physical device.
+ *    @param  segment     List of segments that make up the data field. The 
+ *                        first segment must start with the address used for
+ *                        filtering.
+ *    @param  count       Number of segments in the list.
+ *
+ *    @return Success of the operation. If a device is already performing a
+ *            transmission, this operation will fail until the initial transmit
+ *            completes.
+ */
+bool PhyTransmitv(struct sPhyDevice *device, 
+                  const struct sPhyDataSegment *segment,
+                  unsigned char count);
+
 /**
  *  PhyLowPowerMode - put the Physical hardware into a low power state.
+ *
+ *  Note: A pending Rx timeout is cancelled.
+ *
+ *    @param  device  Physical device.
  */
-void PhyLowPowerMode(void);
+void PhyLowPowerMode(struct sPhyDevice *device);
 
 // -----------------------------------------------------------------------------
 // Physical timer
@@ -388,6 +688,7 @@ void PhyLowPowerMode(void);
  *  PhyTimerInit - initialize the physical timer. Setup callback function
  *  pointers to provide the Data Link layer with a millisecond tick.
  *
+ *    @param  device        Physical device.
  *    @param  SyncTimeout   Callback invoked when a SYNC timeout occurs with in
  *                          RX. This is used strictly for power savings as the
  *                          callback may then issue the Physical hardware to go
@@ -396,25 +697,33 @@ void PhyLowPowerMode(void);
  *                          to provide a millisecond tick to other Data Link
  *                          layer modules.
  */
-void PhyTimerInit(unsigned char(*GenericTimer)(void));
+void PhyTimerInit(struct sPhyDevice *device, 
+                  unsigned char(*GenericTimer)(void *context));
 
 /**
  *  PhyTimerStart - start the physical timer. 
+ *
+ *    @param  device  Physical device.
  */
-void PhyTimerStart(void);
+void PhyTimerStart(struct sPhyDevice *device);
 
 /**
  *  PhyTimerStop - stop the physical timer.
+ *
+ *    @param  device  Physical device.
  */
-void PhyTimerStop(void);
+void PhyTimerStop(struct sPhyDevice *device);
 
 /**
  *  PhySyncTimerInit - initialize the SYNC timeout timer.
  *  
+ *    @param  device      Physical device.
  *    @param  SyncTimeout Timeout callback issued when the SYNC timeout timer
- *                        expires.
+ *                        expires. If NULL, the receiver is never timed out 
+ *                        (e.g. on a Gateway).
  */
-void PhySyncTimerInit(unsigned char(*SyncTimeout)(void));
+void PhySyncTimerInit(struct sPhyDevice *device, 
+                      unsigned char(*SyncTimeout)(void *context));
 
 // -----------------------------------------------------------------------------
 // Physical interrupt service routines
@@ -428,8 +737,23 @@ void PhySyncTimerInit(unsigned char(*SyncTimeout)(void));
  *  DataStreamAvailable callback is invoked.
  *
  *  On transmission and EOP interrupt is set, a DataStreamSent callback is 
- *  invoked.
+ *  invoked once the radio has left TX_END: straight away if it already has,
+ *  otherwise from PhyTimerIsr a few bit periods later. The radio is never 
+ *  polled until it finishes.
+ *
+ *  Note: In deferred processing mode, the event is only recorded. The return
+ *  value is non-zero if PhyProcess needs to run.
+ *
+ *  Note: When several devices share an interrupt vector, this routine is 
+ *  called for each of them; only the device whose GDO0 caused the interrupt 
+ *  services it.
  *
+ *  Note: With PROTOCOL_USE_STREAMING, the FIFO threshold (GDO2) interrupt is 
+ *  serviced here as well, before the SYNC/EOP event. The physical hardware 
+ *  FIFO is written or drained straight away, even in deferred processing 
+ *  mode; no callback is invoked.
+ *
+ *    @param  device  Physical device.
  *    @param  event   SYNC/EOP event indicator. This is usually in the form of
  *                    a hardware peripheral flag indicating that the associated
  *                    hardware has been interrupted.
@@ -437,17 +761,52 @@ void PhySyncTimerInit(unsigned char(*SyncTimeout)(void));
  *    @return Status message from callee (currently not being used for physical
  *            bridge use).
  */
-unsigned char PhySyncEopIsr(volatile unsigned char event);
+unsigned char PhySyncEopIsr(struct sPhyDevice *device, 
+                            volatile unsigned char event);
 
 /**
  *  PhyTimerIsr - physical timer interrupt service routine.
  *
  *  Note: The Physical Bridge requires a 16-bit hardware timer with at least a 
  *  1ms tick rate. The tick rate should be calculated as 1ms + crystal error %.
+ *
+ *  Note: In deferred processing mode, the event is only recorded. The return
+ *  value is non-zero if PhyProcess needs to run.
+ *
+ *  Note: The hardware timer is shared by all devices. This routine is called
+ *  for each device on every tick.
+ *
+ *  Note: A transmission waiting for the radio to leave TX_END is confirmed 
+ *  here (see PhySyncEopIsr).
+ * 
+ *    @param  device  Physical device.
+ *
+ *    @return Status message from callee (currently not being used for physical
+ *            bridge use).
+ */
+unsigned char PhyTimerIsr(struct sPhyDevice *device);
+
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+// -----------------------------------------------------------------------------
+// Physical deferred processing
+
+/**
+ *  PhyProcess - process the events recorded by the interrupt service routines.
+ *
+ *  In deferred processing mode, PhySyncEopIsr and PhyTimerIsr only record an
+ *  event and return; they never re-enable global interrupts. All work that
+ *  follows (reading the RX FIFO, invoking the DataStreamSent, 
+ *  DataStreamAvailable, RxTimeout and Generic callbacks) is performed by this
+ *  function, outside of interrupt context.
+ *
+ *  Note: This function must not be called from an interrupt service routine.
  * 
+ *    @param  device  Physical device.
+ *
  *    @return Status message from callee (currently not being used for physical
  *            bridge use).
  */
-unsigned char PhyTimerIsr(void);
+unsigned char PhyProcess(struct sPhyDevice *device);
+#endif
 
 #endif  /* PHY_BRIDGE_H */
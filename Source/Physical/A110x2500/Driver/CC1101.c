@@ -9,8 +9,8 @@
  *
  *  CC1101.c - CC110x/2500 device driver.
  *
- *  @version    1.0.13
- *  @date       15 Jan 2013
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  For details on the interface, please see CC1101.h.
@@ -27,6 +27,11 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added CC1101Readv and CC1101ReadRxPacket; a received packet is drained 
+ *  with one RXBYTES read and one burst transaction
+ *  - added CC1101ReadRxFifoStream and CC1101ReadRxPacketTail
+ *  - CC1101WriteTxFifo takes a read-only buffer
  *  ver 1.0.13 : 15 Jan 2013
  *	- fixed an issue with the sleep flag so that it may be cleared prior to
  *	attempting to write the unretained registers in the wake up routine.
@@ -226,6 +231,58 @@ void CC1101Write(struct sCC1101PhyInfo *phyInfo,
   #endif
 }
 
+/**
+ *  CC1101Readv - burst read from the internal radio registers or the RX FIFO 
+ *  into several buffers. When the SPI interface provides a scatter read, all 
+ *  buffers are read in one transaction; otherwise one burst read is issued 
+ *  per buffer (the RX FIFO is read in order either way).
+ *
+ *  Note: If the CC1101 is asleep, it can only be woken up by the CC1101Wakeup
+ *  routine. If this is not used to wake up the chip, all read and write
+ *  operations will be blocked.
+ *
+ *    @param  phyInfo CC1101 interface state information used by the interface
+ *                    for all chip interaction.
+ *    @param  address The radio register address to start reading from.
+ *    @param  segment Buffers to read into, in order.
+ *    @param  count   Number of buffers.
+ *
+ *    @return Chip status byte of the transaction (CC1101_STATUS_x). Without a 
+ *            scatter read, the status is unknown and reported as IDLE.
+ */
+unsigned char CC1101Readv(struct sCC1101PhyInfo *phyInfo, 
+                          unsigned char address, 
+                          const struct sCC1101Segment *segment, 
+                          unsigned char count)
+{
+  if (phyInfo->spi->Readv != NULL)
+  {
+    if (!phyInfo->sleep)
+    {
+      return phyInfo->spi->Readv(address | CC1101_READ_BURST, segment, count);
+    }
+    #ifdef CC1101_ERROR_HANDLING
+    else
+    {
+      CC1101ErrorHandler(eCC1101ErrorSleep);
+    }
+    #endif
+  }
+  else
+  {
+    while (count--)
+    {
+      if (segment->length > 0)
+      {
+        CC1101Read(phyInfo, address, segment->data, segment->length);
+      }
+      segment++;
+    }
+  }
+  
+  return CC1101_STATUS_STATE_IDLE;
+}
+
 /**
  *  CC1101GetChipPartnum - get the hardware part number.
  *
@@ -574,8 +631,93 @@ unsigned char CC1101ReadRxFifo(struct sCC1101PhyInfo *phyInfo,
   }
 }
 
+bool CC1101ReadRxPacket(struct sCC1101PhyInfo *phyInfo,
+                        unsigned char *length,
+                        unsigned char *dataField,
+                        unsigned char size,
+                        unsigned char *appended)
+{
+  struct sCC1101Segment segment[3];
+  unsigned char rxBytes;
+  unsigned char status;
+  
+  // The RX FIFO no longer changes; a single read of RXBYTES is valid.
+  CC1101Read(phyInfo, CC1101_RXBYTES, &rxBytes, 1);
+  if ((rxBytes & CC1101_RXFIFO_OVERFLOW)
+      || (rxBytes < CC1101_RX_PACKET_OVERHEAD)
+      || ((rxBytes - CC1101_RX_PACKET_OVERHEAD) > size))
+  {
+    return false;
+  }
+  
+  // Drain the whole RX FIFO: length field, address and data field, and 
+  // appended status.
+  segment[0].data = length;
+  segment[0].length = 1;
+  segment[1].data = dataField;
+  segment[1].length = rxBytes - CC1101_RX_PACKET_OVERHEAD;
+  segment[2].data = appended;
+  segment[2].length = CC1101_RX_PACKET_APPENDED;
+  status = CC1101Readv(phyInfo, CC1101_RXFIFO, segment, 3);
+  
+  // The chip status byte tells whether the RX FIFO overflowed meanwhile (no 
+  // register poll is needed); the length field must account for every byte 
+  // drained.
+  return ((status & CC1101_STATUS_STATE) != CC1101_STATUS_STATE_RXFIFO_OVERFLOW)
+         && (*length == segment[1].length);
+}
+
+unsigned char CC1101ReadRxFifoStream(struct sCC1101PhyInfo *phyInfo, 
+                                     unsigned char *buffer, 
+                                     unsigned char count)
+{
+  unsigned char rxBytes = CC1101GetRxFifoCount(phyInfo);
+  
+  if ((rxBytes & CC1101_RXFIFO_OVERFLOW) || (rxBytes < 2))
+  {
+    return 0;
+  }
+  
+  // Leave the last byte; it may not have been completely written yet.
+  if (--rxBytes < count)
+  {
+    count = rxBytes;
+  }
+  if (count > 0)
+  {
+    CC1101Read(phyInfo, CC1101_RXFIFO, buffer, count);
+  }
+  
+  return count;
+}
+
+bool CC1101ReadRxPacketTail(struct sCC1101PhyInfo *phyInfo,
+                            unsigned char *dataField,
+                            unsigned char count,
+                            unsigned char *appended)
+{
+  struct sCC1101Segment segment[2];
+  unsigned char rxBytes;
+  unsigned char status;
+  
+  // The RX FIFO no longer changes; a single read of RXBYTES is valid.
+  CC1101Read(phyInfo, CC1101_RXBYTES, &rxBytes, 1);
+  if (rxBytes != (unsigned char)(count + CC1101_RX_PACKET_APPENDED))
+  {
+    return false;
+  }
+  
+  segment[0].data = dataField;
+  segment[0].length = count;
+  segment[1].data = appended;
+  segment[1].length = CC1101_RX_PACKET_APPENDED;
+  status = CC1101Readv(phyInfo, CC1101_RXFIFO, segment, 2);
+  
+  return (status & CC1101_STATUS_STATE) != CC1101_STATUS_STATE_RXFIFO_OVERFLOW;
+}
+
 void CC1101WriteTxFifo(struct sCC1101PhyInfo *phyInfo,
-                       unsigned char *buffer,
+                       const unsigned char *buffer,
                        unsigned char count)
 {
   CC1101Write(phyInfo, CC1101_TXFIFO, buffer, count);
@@ -11,8 +11,8 @@
  *
  *  CC1101.h - CC110x/2500 device driver.
  *
- *  @version    1.0.12
- *  @date       27 Sep 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     BPB, air@anaren.com
  *
  *  The CC1101/110L is a transceiver intended for use in the Industrial, 
@@ -57,6 +57,13 @@
  *        SpiWrite(unsigned char address, unsigned char *pBuffer, unsigned char count)
  *          - write to a SPI device, must use a buffer
  *
+ *      The following routine is optional (NULL if not provided),
+ *
+ *        SpiReadv(unsigned char address, const struct sCC1101Segment *segment, unsigned char count)
+ *          - read from a SPI device into several buffers in one transaction 
+ *          (CSn held low throughout); returns the chip status byte clocked 
+ *          out with the address byte
+ *
  *      The above routines MUST BE functions as they are required to have an
  *      address associated with them. MACROS WILL NOT WORK.
  *
@@ -139,6 +146,16 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added the optional SPI scatter read (sCC1101Spi.Readv) and 
+ *  CC1101ReadRxPacket; a received packet is drained from the RX FIFO in one 
+ *  burst transaction
+ *  - added the chip status byte field masks
+ *  - added CC1101ReadRxFifoStream and CC1101ReadRxPacketTail; a packet longer
+ *  than the RX FIFO is read while it is being received
+ *  - added the GDOx_CFG FIFO threshold signals
+ *  - added the MCSM1 TXOFF_MODE values
+ *  - CC1101WriteTxFifo takes a read-only buffer
  *	ver 1.0.12 : 27 Sep 2012
  *	- split CC1101Init into CC1101SpiInit and CC1101GdoInit. The GDO interface
  *	may not be desired in some circumstances (e.g. test).
@@ -356,6 +373,10 @@
 #define CC1101_GDO0_TEMP_SENSOR_ENABLE    0x80u
 #define CC1101_GDO0_INV                   0x40u
 #define CC1101_GDO0_CFG                   0x3Fu
+// GDOx_CFG signals
+#define CC1101_GDOx_RXFIFO_THR            0x00u // RX FIFO at or above threshold
+#define CC1101_GDOx_TXFIFO_THR            0x02u // TX FIFO at or above threshold
+#define CC1101_GDOx_SYNC_EOP              0x06u // Sync word sent/received until end of packet
 // FIFOTHR
 #define CC1101_ADC_RETENTION              0x40u
 #define CC1101_CLOSE_IN_RX                0x30u
@@ -419,6 +440,8 @@
 #define CC1101_CCA_MODE                   0x30u
 #define CC1101_RXOFF_MODE                 0x0Cu
 #define CC1101_TXOFF_MODE                 0x03u
+#define CC1101_TXOFF_MODE_IDLE            0x00u // TX to IDLE when a packet has been sent
+#define CC1101_TXOFF_MODE_RX              0x03u // TX to RX when a packet has been sent
 // MCSM0
 #define CC1101_FS_AUTOCAL                 0x30u
 #define CC1101_PO_TIMEOUT                 0x0Cu
@@ -534,6 +557,19 @@
 // RCCTRL0_STATUS
 #define CC1101_RCCTRL0_STATUS_7_0         0xFFu
 
+// Chip status byte
+#define CC1101_STATUS_CHIP_RDYN           0x80u
+#define CC1101_STATUS_STATE               0x70u
+#define CC1101_STATUS_FIFO_BYTES          0x0Fu
+#define CC1101_STATUS_STATE_IDLE          0x00u
+#define CC1101_STATUS_STATE_RX            0x10u
+#define CC1101_STATUS_STATE_TX            0x20u
+#define CC1101_STATUS_STATE_FSTXON        0x30u
+#define CC1101_STATUS_STATE_CALIBRATE     0x40u
+#define CC1101_STATUS_STATE_SETTLING      0x50u
+#define CC1101_STATUS_STATE_RXFIFO_OVERFLOW   0x60u
+#define CC1101_STATUS_STATE_TXFIFO_UNDERFLOW  0x70u
+
 // Burst/single access masks
 #define CC1101_WRITE_SINGLE               0x00u
 #define CC1101_WRITE_BURST                0x40u
@@ -546,6 +582,11 @@
 #define CC1101_RXFIFO_SIZE        64 // Receive hardware FIFO absolute size
 #define CC1101_TXFIFO_SIZE        64 // Transmit hardware FIFO absolute size
 
+// Bytes of a received packet besides its address and data field: length field
+// and appended status (RSSI, LQI and CRC_OK)
+#define CC1101_RX_PACKET_OVERHEAD 3
+#define CC1101_RX_PACKET_APPENDED 2
+
 // Maximum timeout error ticks
 #define CC1101_MAX_TIMEOUT        2000
 
@@ -675,6 +716,15 @@ struct sCC1101
   unsigned char test0;    // Various test settings 0
 };
 
+/**
+ *  sCC1101Segment - one buffer of a SPI scatter read (sCC1101Spi.Readv).
+ */
+struct sCC1101Segment
+{
+  unsigned char *data;      // Buffer
+  unsigned char length;     // Number of bytes read into the buffer
+};
+
 /**
  *  sCC1101Spi - SPI implementation pointers. These function pointers, when
  *  initialized properly, will be pointing to the addresses of your SPI 
@@ -689,6 +739,7 @@ struct sCC1101Spi
   void(*const Init)(void);
   void(*const Read)(unsigned char, unsigned char*, unsigned char);
   void(*const Write)(unsigned char, const unsigned char*, unsigned char);
+  unsigned char(*const Readv)(unsigned char, const struct sCC1101Segment*, unsigned char);  // Optional
 };
 
 /**
@@ -921,6 +972,75 @@ unsigned char CC1101ReadRxFifo(struct sCC1101PhyInfo *phyInfo,
                                unsigned char *buffer, 
                                unsigned char count);
 
+/**
+ *  CC1101ReadRxPacket - read one received packet from the receive hardware 
+ *  FIFO: the length field, the address and data field, and the appended 
+ *  status (RSSI, LQI, and CRC_OK). RXBYTES is read once, then the packet is 
+ *  drained in one burst transaction when the SPI interface provides a scatter
+ *  read (sCC1101Spi.Readv); otherwise in one burst per part.
+ *
+ *  Note: RXBYTES is read without the Errata Notes workaround. It is only valid
+ *  once the packet has been received and the radio has left RX 
+ *  (MCSM1.RXOFF_MODE = IDLE), when the RX FIFO no longer changes.
+ *
+ *    @param  phyInfo   CC1101 interface state information used by the 
+ *                      interface for all chip interaction.
+ *    @param  length    Length field of the packet.
+ *    @param  dataField Buffer for the address and data field.
+ *    @param  size      Size of the data field buffer.
+ *    @param  appended  Buffer for the appended status (2 bytes).
+ *
+ *    @return True if one complete packet was read. False if the RX FIFO is 
+ *            empty or overflowed, does not hold exactly one packet or the 
+ *            packet does not fit in the buffer; the RX FIFO must then be 
+ *            flushed.
+ */
+bool CC1101ReadRxPacket(struct sCC1101PhyInfo *phyInfo,
+                        unsigned char *length,
+                        unsigned char *dataField,
+                        unsigned char size,
+                        unsigned char *appended);
+
+/**
+ *  CC1101ReadRxFifoStream - read from the receive hardware FIFO while a packet
+ *  is being received. Per the Errata Notes, the last byte in the RX FIFO is 
+ *  never read before the whole packet has been received.
+ *
+ *    @param  phyInfo CC1101 interface state information used by the interface
+ *                    for all chip interaction.
+ *    @param  buffer  Buffer to store the values read from the RX FIFO.
+ *    @param  count   Maximum number of bytes to read from the RX FIFO.
+ *
+ *    @return Number of bytes read from the RX FIFO. Nothing is read if the RX
+ *            FIFO overflowed.
+ */
+unsigned char CC1101ReadRxFifoStream(struct sCC1101PhyInfo *phyInfo, 
+                                     unsigned char *buffer, 
+                                     unsigned char count);
+
+/**
+ *  CC1101ReadRxPacketTail - read the end of a received packet whose beginning
+ *  was read while it was being received (CC1101ReadRxFifoStream): the rest of
+ *  the data field and the appended status, in one burst transaction when the 
+ *  SPI interface provides a scatter read (sCC1101Spi.Readv).
+ *
+ *  Note: Same RXBYTES restriction as CC1101ReadRxPacket.
+ *
+ *    @param  phyInfo   CC1101 interface state information used by the 
+ *                      interface for all chip interaction.
+ *    @param  dataField Buffer for the rest of the data field.
+ *    @param  count     Number of data field bytes not read yet.
+ *    @param  appended  Buffer for the appended status (2 bytes).
+ *
+ *    @return True if the rest of the packet was read. False if the RX FIFO
+ *            overflowed or does not hold exactly the rest of the packet; the
+ *            RX FIFO must then be flushed.
+ */
+bool CC1101ReadRxPacketTail(struct sCC1101PhyInfo *phyInfo,
+                            unsigned char *dataField,
+                            unsigned char count,
+                            unsigned char *appended);
+
 /**
  *  CC1101WriteTxFifo - write data to the transmit hardware FIFO. If data
  *  already exists in the FIFO, this data will be appended to it. A flush is
@@ -932,7 +1052,7 @@ unsigned char CC1101ReadRxFifo(struct sCC1101PhyInfo *phyInfo,
  *    @param  count   Number of bytes to write from the buffer into the TX FIFO.
  */
 void CC1101WriteTxFifo(struct sCC1101PhyInfo *phyInfo, 
-                       unsigned char *buffer, 
+                       const unsigned char *buffer, 
                        unsigned char count);
 
 /**
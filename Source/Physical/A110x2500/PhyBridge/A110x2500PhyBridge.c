@@ -10,8 +10,8 @@
  *  A110x2500PhyBridge.c - physical bridge implementation using A110x2500-based 
  *		modules.
  *
- *  @version    1.0.01
- *  @date       17 Oct 2012
+ *  @version    1.1.00
+ *  @date       16 Oct 2026
  *  @author     B Blincoe, bblincoe@anaren.com
  *
  *  assumptions
@@ -22,10 +22,43 @@
  *  ===============
  *  A110x2500PhyBridge : provides interface function prototypes and global 
  *		definitions.
- *		string.h : provides function for setting a block of memory (memset).
+ *		string.h : provides functions for setting and copying blocks of memory 
+ *		(memset, memcpy).
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - every operation takes the physical device it applies to; SPI/GDO bindings
+ *  are supplied per device and the hardware timer is shared between devices
+ *  - Rx timeout is cancelled as soon as a data stream is received
+ *  - added PhyTransmitv; data field segments are written straight to the TX FIFO
+ *  - added PhyProcess and the deferred processing event ring
+ *  - Rx timeout is built in for both node roles and only armed for devices 
+ *  that registered a SyncTimeout callback
+ *  - the GDO0 edge of every data stream may be timestamped 
+ *  (PROTOCOL_USE_LATENCY_COUNTERS)
+ *  - the hardware timer runs while the Generic timer is started or an Rx 
+ *  timeout is pending; each user is tracked separately
+ *  - a pending Rx timeout is cancelled once the receiver is turned off 
+ *  (PhyIdle, PhyLowPowerMode) or the device starts transmitting
+ *  - added listen-before-talk (PROTOCOL_USE_CSMA); the transmitter is strobed
+ *  from RX so that the radio's clear channel assessment gates it
+ *  - PhyGetDataStream drains a received data stream (length, data field and 
+ *  appended status) with one RXBYTES read and one burst transaction 
+ *  (CC1101ReadRxPacket); a data stream that does not fit is dropped
+ *  - data streams up to PHY_MAX_DATASTREAM_SIZE bytes are moved through the 
+ *  FIFOs while on air; GDO2 signals the FIFO thresholds (PROTOCOL_USE_STREAMING)
+ *  - the end of a transmission is confirmed by a one-shot timer (a few bit 
+ *  periods derived from the baud rate) instead of polling MARCSTATE in the 
+ *  interrupt service routine until the radio leaves TX_END; the default SPI 
+ *  binding is atomic in every configuration as the timer interrupt reads it
+ *  - a data stream that ends while GDO0 is disabled (the receiver was turned
+ *  on again from a callback) is serviced once GDO0 is enabled again
+ *  - optional TX to RX turnaround; MCSM1.TXOFF_MODE is programmed per 
+ *  transmission so that the radio enters RX on its own when a data request
+ *  has been sent, and PhyReceiverOn keeps it listening (PROTOCOL_USE_TURNAROUND)
+ *  - added PhyGetEntropy; receiver noise (RSSI) is sampled to seed security
+ *  keys once the RSSI is valid, one RSSI update apart (PROTOCOL_USE_SECURITY)
  *  ver 1.0.01 : 17 Oct 2012
  *  - updated internal documentation; comments revised
  *  - added a test example (stub) to perform various frame operations
@@ -33,7 +66,7 @@
  *  - initial release
  */
 #include "A110x2500PhyBridge.h"
-#include <string.h>         // memset
+#include <string.h>         // memset, memcpy
 
 // -----------------------------------------------------------------------------
 /**
@@ -51,7 +84,11 @@
 #define A1101Configure(phyInfo, config)\
   A1101R04Configure(phyInfo, config)
 #define A1101Wakeup(phyInfo)                A1101R04Wakeup(phyInfo)
+#define A1101SetIocfg2(phyInfo, iocfg2)     A1101R04SetIocfg2(phyInfo, iocfg2)
+#define A1101SetFifothr(phyInfo, fifothr)   A1101R04SetFifothr(phyInfo, fifothr)
+#define A1101SetPktlen(phyInfo, pktlen)     A1101R04SetPktlen(phyInfo, pktlen)
 #define A1101SetPktctrl1(phyInfo, pktctrl1) A1101R04SetPktctrl1(phyInfo, pktctrl1)
+#define A1101SetMcsm1(phyInfo, mcsm1)       A1101R04SetMcsm1(phyInfo, mcsm1)
 #define A1101SetMcsm0(phyInfo, mcsm0)       A1101R04SetMcsm0(phyInfo, mcsm0)
 #define A1101SetAddr(phyInfo, addr)         A1101R04SetAddr(phyInfo, addr)
 #define A1101SetChannr(phyInfo, channr)     A1101R04SetChannr(phyInfo, channr)
@@ -70,7 +107,11 @@
 #define A1101Configure(phyInfo, config)\
   A1101R08Configure(phyInfo, config)
 #define A1101Wakeup(phyInfo)                A1101R08Wakeup(phyInfo)
+#define A1101SetIocfg2(phyInfo, iocfg2)     A1101R08SetIocfg2(phyInfo, iocfg2)
+#define A1101SetFifothr(phyInfo, fifothr)   A1101R08SetFifothr(phyInfo, fifothr)
+#define A1101SetPktlen(phyInfo, pktlen)     A1101R08SetPktlen(phyInfo, pktlen)
 #define A1101SetPktctrl1(phyInfo, pktctrl1) A1101R08SetPktctrl1(phyInfo, pktctrl1)
+#define A1101SetMcsm1(phyInfo, mcsm1)       A1101R08SetMcsm1(phyInfo, mcsm1)
 #define A1101SetMcsm0(phyInfo, mcsm0)       A1101R08SetMcsm0(phyInfo, mcsm0)
 #define A1101SetAddr(phyInfo, addr)         A1101R08SetAddr(phyInfo, addr)
 #define A1101SetChannr(phyInfo, channr)     A1101R08SetChannr(phyInfo, channr)
@@ -89,7 +130,11 @@
 #define A1101Configure(phyInfo, config)\
   A1101R09Configure(phyInfo, config)
 #define A1101Wakeup(phyInfo)                A1101R09Wakeup(phyInfo)
+#define A1101SetIocfg2(phyInfo, iocfg2)     A1101R09SetIocfg2(phyInfo, iocfg2)
+#define A1101SetFifothr(phyInfo, fifothr)   A1101R09SetFifothr(phyInfo, fifothr)
+#define A1101SetPktlen(phyInfo, pktlen)     A1101R09SetPktlen(phyInfo, pktlen)
 #define A1101SetPktctrl1(phyInfo, pktctrl1) A1101R09SetPktctrl1(phyInfo, pktctrl1)
+#define A1101SetMcsm1(phyInfo, mcsm1)       A1101R09SetMcsm1(phyInfo, mcsm1)
 #define A1101SetMcsm0(phyInfo, mcsm0)       A1101R09SetMcsm0(phyInfo, mcsm0)
 #define A1101SetAddr(phyInfo, addr)         A1101R09SetAddr(phyInfo, addr)
 #define A1101SetChannr(phyInfo, channr)     A1101R09SetChannr(phyInfo, channr)
@@ -108,7 +153,11 @@
 #define A1101Configure(phyInfo, config)\
   A110LR09Configure(phyInfo, config)
 #define A1101Wakeup(phyInfo)                A110LR09Wakeup(phyInfo)
+#define A1101SetIocfg2(phyInfo, iocfg2)     A110LR09SetIocfg2(phyInfo, iocfg2)
+#define A1101SetFifothr(phyInfo, fifothr)   A110LR09SetFifothr(phyInfo, fifothr)
+#define A1101SetPktlen(phyInfo, pktlen)     A110LR09SetPktlen(phyInfo, pktlen)
 #define A1101SetPktctrl1(phyInfo, pktctrl1) A110LR09SetPktctrl1(phyInfo, pktctrl1)
+#define A1101SetMcsm1(phyInfo, mcsm1)       A110LR09SetMcsm1(phyInfo, mcsm1)
 #define A1101SetMcsm0(phyInfo, mcsm0)       A110LR09SetMcsm0(phyInfo, mcsm0)
 #define A1101SetAddr(phyInfo, addr)         A110LR09SetAddr(phyInfo, addr)
 #define A1101SetChannr(phyInfo, channr)     A110LR09SetChannr(phyInfo, channr)
@@ -127,7 +176,11 @@
 #define A1101Configure(phyInfo, config)\
   A2500R24Configure(phyInfo, config)
 #define A1101Wakeup(phyInfo)                A2500R24Wakeup(phyInfo)
+#define A1101SetIocfg2(phyInfo, iocfg2)     A2500R24SetIocfg2(phyInfo, iocfg2)
+#define A1101SetFifothr(phyInfo, fifothr)   A2500R24SetFifothr(phyInfo, fifothr)
+#define A1101SetPktlen(phyInfo, pktlen)     A2500R24SetPktlen(phyInfo, pktlen)
 #define A1101SetPktctrl1(phyInfo, pktctrl1) A2500R24SetPktctrl1(phyInfo, pktctrl1)
+#define A1101SetMcsm1(phyInfo, mcsm1)       A2500R24SetMcsm1(phyInfo, mcsm1)
 #define A1101SetMcsm0(phyInfo, mcsm0)       A2500R24SetMcsm0(phyInfo, mcsm0)
 #define A1101SetAddr(phyInfo, addr)         A2500R24SetAddr(phyInfo, addr)
 #define A1101SetChannr(phyInfo, channr)     A2500R24SetChannr(phyInfo, channr)
@@ -137,21 +190,56 @@
   A2500R24ConvertRssiToDbm(phyInfo, rssi)
 #endif
 
+// Interrupt service routines only re-enable global interrupts (to allow long
+// callbacks) when events are serviced inside of them.
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+#define PHY_ISR_ENABLE_INTERRUPT()
+#define PHY_ISR_DISABLE_INTERRUPT()
+#else
+#define PHY_ISR_ENABLE_INTERRUPT()          PROTOCOL_ENABLE_INTERRUPT()
+#define PHY_ISR_DISABLE_INTERRUPT()         PROTOCOL_DISABLE_INTERRUPT()
+#endif
+
 // Note: This is used to calculate SYNC word timeout. It is common for all
 // supported A110X/2500-based platforms.
 #define PHY_PREAMBLE_LENGTH   4             // Length of preamble in bytes
 #define PHY_SYNC_LENGTH       4             // Length of sync in bytes
 
+// Note: The radio remains in TX_END for a few bit periods after the EOP. The
+// end of a transmission is confirmed once this time has passed.
+#define PHY_TX_END_LENGTH     8             // Length of TX_END in bits
+
+#if defined( PROTOCOL_USE_STREAMING )
+// FIFO thresholds (FIFOTHR.FIFO_THR): GDO2 asserts once the RX FIFO holds 32 
+// bytes or the TX FIFO holds 33 bytes.
+#define PHY_STREAM_FIFO_THR   7
+
+// The radio filters data streams longer than PKTLEN; a length field may only 
+// exceed PROTOCOL_DATASTREAM_MAX_SIZE if that is below its range.
+#if (PROTOCOL_DATASTREAM_MAX_SIZE < 255)
+#define PhyStreamLengthValid(length)  ((length) <= PROTOCOL_DATASTREAM_MAX_SIZE)
+#else
+#define PhyStreamLengthValid(length)  (true)
+#endif
+#endif
+
 // -----------------------------------------------------------------------------
 /**
  *  Global data
  */
 
-// CC1101 SPI interface
+void PhySpiRead(unsigned char address, unsigned char *buffer, unsigned char count);
+void PhySpiWrite(unsigned char address, const unsigned char *buffer, unsigned char count);
+unsigned char PhySpiReadv(unsigned char address, const struct sCC1101Segment *segment, unsigned char count);
+
+// CC1101 SPI interface; transactions are atomic as interrupt service routines
+// (the timer confirming the end of a transmission and the FIFO threshold) 
+// access the radio.
 const struct sCC1101Spi gA1101Spi = {
   A110x2500SpiInit,     // Radio SPI initialization
-  A110x2500SpiRead,     // Radio SPI read
-  A110x2500SpiWrite     // Radio SPI write
+  PhySpiRead,           // Radio SPI read
+  PhySpiWrite,          // Radio SPI write
+  PhySpiReadv           // Radio SPI scatter read
 };
 
 // CC1101 GDO0 interface
@@ -164,39 +252,228 @@ const struct sCC1101Gdo gA1101Gdo0 = {
   A110x2500Gdo0Enable           // Radio GDO0 interrupt enable
 };
 
-// CC1101 GDOx interface
-const struct sCC1101Gdo *gA1101Gdo[3] = { 
-  &gA1101Gdo0,  // Uses GDO0 exclusively
-  NULL,         // Does not use GDO1
-  NULL          // Does not use GDO2
+#if defined( PROTOCOL_USE_STREAMING )
+// CC1101 GDO2 interface
+const struct sCC1101Gdo gA1101Gdo2 = {
+  A110x2500Gdo2Init,            // Radio GDO2 interrupt initialization
+  A110x2500Gdo2Event,           // Radio GDO2 interrupt event
+  A110x2500Gdo2WaitForAssert,   // Radio GDO2 interrupt set polarity: assert
+  A110x2500Gdo2WaitForDeassert, // Radio GDO2 interrupt set polarity: deassert
+  A110x2500Gdo2GetState,        // Radio GDO2 interrupt get current polarity (assert, deassert)
+  A110x2500Gdo2Enable           // Radio GDO2 interrupt enable
+};
+#endif
+
+// Default binding: CC1101 SPI and GDOx interfaces
+const struct sPhyBinding gA1101Binding = {
+  &gA1101Spi,       // Radio SPI interface
+  { 
+    &gA1101Gdo0,    // Uses GDO0 for SYNC/EOP
+    NULL,           // Does not use GDO1 (shared with SPI MISO)
+    #if defined( PROTOCOL_USE_STREAMING )
+    &gA1101Gdo2     // Uses GDO2 for the FIFO thresholds
+    #else
+    NULL            // Does not use GDO2
+    #endif
+  }
 };
 
+// Physical information, one per physical device (assigned by PhyInit)
 #if defined( A1101R04_MODULE )
-static struct sA1101R04PhyInfo gA1101r04PhyInfo;
-static struct sA1101R04PhyInfo *gPhyInfo = &gA1101r04PhyInfo;
+static struct sA1101R04PhyInfo gPhyInfo[PROTOCOL_MAX_INSTANCES];
 #elif defined( A1101R08_MODULE )
-static struct sA1101R08PhyInfo gA1101r08PhyInfo;
-static struct sA1101R08PhyInfo *gPhyInfo = &gA1101r08PhyInfo;
+static struct sA1101R08PhyInfo gPhyInfo[PROTOCOL_MAX_INSTANCES];
 #elif defined( A1101R09_MODULE )
-static struct sA1101R09PhyInfo gA1101r09PhyInfo;
-static struct sA1101R09PhyInfo *gPhyInfo = &gA1101r09PhyInfo;
+static struct sA1101R09PhyInfo gPhyInfo[PROTOCOL_MAX_INSTANCES];
 #elif defined( A110LR09_MODULE )
-static struct sA110LR09PhyInfo gA110Lr09PhyInfo;
-static struct sA110LR09PhyInfo *gPhyInfo = &gA110Lr09PhyInfo;
+static struct sA110LR09PhyInfo gPhyInfo[PROTOCOL_MAX_INSTANCES];
 #elif defined( A2500R24_MODULE )
-static struct sA2500R24PhyInfo gA2500r24PhyInfo;
-static struct sA2500R24PhyInfo *gPhyInfo = &gA2500r24PhyInfo;
+static struct sA2500R24PhyInfo gPhyInfo[PROTOCOL_MAX_INSTANCES];
 #endif
+static unsigned char gPhyInfoCount = 0;       // Physical information assigned
 
-// Physical device and associated data stream
-static struct sPhyDevice gPhyDevice;
+// Number of physical devices using the (shared) hardware timer
+static unsigned char gPhyTimerUsers = 0;
 
 // -----------------------------------------------------------------------------
 /**
  *  Private interface
  */
 
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+/**
+ *  PhySpiRead, PhySpiWrite, PhySpiReadv - SPI transactions that cannot be 
+ *  interrupted by an interrupt service routine accessing a radio on the same
+ *  bus (PhyTimerIsr, PhyFifoService).
+ */
+void PhySpiRead(unsigned char address, unsigned char *buffer, unsigned char count)
+{
+  PROTOCOL_CRITICAL_SECTION(A110x2500SpiRead(address, buffer, count));
+}
+
+void PhySpiWrite(unsigned char address, const unsigned char *buffer, unsigned char count)
+{
+  PROTOCOL_CRITICAL_SECTION(A110x2500SpiWrite(address, buffer, count));
+}
+
+unsigned char PhySpiReadv(unsigned char address, const struct sCC1101Segment *segment, unsigned char count)
+{
+  unsigned char status;
+  
+  PROTOCOL_CRITICAL_SECTION(status = A110x2500SpiReadv(address, segment, count));
+  
+  return status;
+}
+
+#if defined( PROTOCOL_USE_STREAMING )
+/**
+ *  PhyStreamConfigure - apply the settings data streams larger than the 
+ *  physical hardware FIFO require on top of the certified settings: the 
+ *  maximum packet length and the FIFO thresholds.
+ *
+ *    @param  device  Physical device.
+ */
+void PhyStreamConfigure(struct sPhyDevice *device)
+{
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  unsigned char fifothr = (phyInfo->module.lookup->certified.fifothr & ~CC1101_FIFO_THR) | PHY_STREAM_FIFO_THR;
+  
+  A1101SetPktlen(phyInfo, PROTOCOL_DATASTREAM_MAX_SIZE);
+  A1101SetFifothr(phyInfo, fifothr);
+}
+#endif
+
+#if defined( PROTOCOL_USE_TURNAROUND )
+/**
+ *  PhyTurnaroundConfigure - prepare the physical hardware for the state it 
+ *  enters once the next transmission ends. MCSM1.TXOFF_MODE is only written 
+ *  when the selection changes. With turnaround, the RX FIFO is flushed first 
+ *  so that a response is read from its start.
+ *
+ *    @param  device  Physical device.
+ */
+void PhyTurnaroundConfigure(struct sPhyDevice *device)
+{
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  
+  // The receiver may still be on since the last transmission ended; SFRX is 
+  // only accepted in IDLE.
+  if (device->status.turnaround || device->status.turnedAround)
+  {
+    CC1101Idle(&phyInfo->cc1101);
+    CC1101FlushRxFifo(&phyInfo->cc1101);
+    device->status.turnedAround = false;
+  }
+  
+  if (device->status.turnaround != device->status.txoffRx)
+  {
+    unsigned char mcsm1 = phyInfo->module.lookup->certified.mcsm1 & ~CC1101_TXOFF_MODE;
+    
+    mcsm1 |= device->status.turnaround ? CC1101_TXOFF_MODE_RX : CC1101_TXOFF_MODE_IDLE;
+    A1101SetMcsm1(phyInfo, mcsm1);
+    device->status.txoffRx = device->status.turnaround;
+  }
+}
+#endif
+
+#if defined( PROTOCOL_USE_CSMA )
+// Number of status reads spent waiting for the receiver (and its RSSI) to 
+// settle before the channel is assessed.
+#ifndef PHY_CCA_POLL_LIMIT
+#define PHY_CCA_POLL_LIMIT  200
+#endif
+
+/**
+ *  PhyTransmitIfClear - listen before talk. The transmitter is strobed from 
+ *  RX; the certified MCSM1 setting (CCA_MODE = 3: RSSI below threshold unless
+ *  currently receiving a packet) keeps the radio in RX if the channel is busy.
+ *
+ *  Note: The data stream must already be in the TX FIFO. It is flushed if the
+ *  channel is busy.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return True if the radio is transmitting; false if the channel is busy.
+ */
+bool PhyTransmitIfClear(struct sPhyDevice *device)
+{
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  unsigned char poll = PHY_CCA_POLL_LIMIT;
+  
+  // A packet ending while the channel is assessed must not be mistaken for the
+  // end of the transmission.
+  CC1101GdoDisable(phyInfo->cc1101.gdo[0]);
+  
+  // Turn on the receiver and wait for a valid assessment. The wait is bounded;
+  // the radio makes the final decision when the transmitter is strobed.
+  if (CC1101GetMarcState(&phyInfo->cc1101) != eCC1101MarcStateRx)
+  {
+    CC1101ReceiverOn(&phyInfo->cc1101);
+    while ((CC1101GetMarcState(&phyInfo->cc1101) != eCC1101MarcStateRx) && (--poll > 0));
+  }
+  while (!(CC1101GetRegister(&phyInfo->cc1101, CC1101_PKTSTATUS) & CC1101_PKTSTATUS_CCA) 
+         && (--poll > 0));
+  
+  device->status.transmitting = true;
+  CC1101Transmit(&phyInfo->cc1101);
+  
+  // The radio remains in RX if the channel is busy.
+  if (CC1101GetMarcState(&phyInfo->cc1101) == eCC1101MarcStateRx)
+  {
+    device->status.transmitting = false;
+    device->status.channelBusy = true;
+    #if defined( PROTOCOL_USE_STREAMING )
+    device->stream.fifo.count = 0;
+    #endif
+    CC1101Idle(&phyInfo->cc1101);
+    CC1101FlushTxFifo(&phyInfo->cc1101);
+    CC1101GdoEnable(phyInfo->cc1101.gdo[0]);
+    return false;
+  }
+  
+  CC1101GdoEnable(phyInfo->cc1101.gdo[0]);
+  return true;
+}
+#endif
+
+/**
+ *  PhyTimerUpdate - use the (shared) hardware timer while the device needs 
+ *  ticks: the Generic timer is started or an Rx timeout is pending.
+ *
+ *    @param  device  Physical device.
+ */
+void PhyTimerUpdate(struct sPhyDevice *device)
+{
+  bool required = device->timer.generic;
+  
+  required |= device->timer.txEnd.enable;
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
+  required |= device->timer.rxTimeout.enable;
+  #endif
+  
+  PROTOCOL_CRITICAL_SECTION
+  (
+    if (required && !device->timer.running)
+    {
+      if (gPhyTimerUsers++ == 0)
+      {
+        A110x2500HwTimerStart();
+      }
+      device->timer.running = true;
+    }
+    else if (!required && device->timer.running)
+    {
+      // Clear any currently pending timer interrupts and stop counting once
+      // the last device stops using the timer.
+      if (--gPhyTimerUsers == 0)
+      {
+        A110x2500HwTimerStop();
+      }
+      device->timer.running = false;
+    }
+  );
+}
+
+#if defined( PROTOCOL_USE_RX_TIMEOUT )
 /**
  *  PhyCalculateRxTimeout - calculate the number of ticks required to register
  *  as an Rx timeout. The value is calculated as follows,
@@ -208,125 +485,449 @@ static struct sPhyDevice gPhyDevice;
  *  baud rate. For instance, 1.2kBaud is stored as 12 with a scale factor of
  *  100.
  *
+ *    @param  device        Physical device.
  *    @param  baudRate      Scaled baud rate value.
  *    @param  scaleFactor   Baud rate scale factor to recover true baud rate.
  */
-void PhyCalculateRxTimeout(unsigned int baudRate, unsigned int scaleFactor)
+void PhyCalculateRxTimeout(struct sPhyDevice *device, 
+                           unsigned int baudRate, 
+                           unsigned int scaleFactor)
 {
-  gPhyDevice.timer.rxTimeout.compare = ((PHY_PREAMBLE_LENGTH + PHY_SYNC_LENGTH) * 8);
-  gPhyDevice.timer.rxTimeout.compare = (PHY_MAX_TXFIFO_SIZE * 8);
-  gPhyDevice.timer.rxTimeout.compare *= (1000 / baudRate);// Convert time to millisecond ticks
-  gPhyDevice.timer.rxTimeout.compare /= scaleFactor;      // Scale the result
-  gPhyDevice.timer.rxTimeout.compare += 1;                // Round up to the next timer tick
+  device->timer.rxTimeout.compare = ((PHY_PREAMBLE_LENGTH + PHY_SYNC_LENGTH) * 8);
+  device->timer.rxTimeout.compare = (PHY_MAX_TXFIFO_SIZE * 8);
+  device->timer.rxTimeout.compare *= (1000 / baudRate);// Convert time to millisecond ticks
+  device->timer.rxTimeout.compare /= scaleFactor;      // Scale the result
+  device->timer.rxTimeout.compare += 1;                // Round up to the next timer tick
   
   // Add an offset. Double the compare value and add processing overhead estimate.
   // TODO: Determine an appropriate processing overhead estimate value.
-  gPhyDevice.timer.rxTimeout.compare <<= 2;
+  device->timer.rxTimeout.compare <<= 2;
 }
 #endif
 
+/**
+ *  PhyCalculateTxEnd - calculate the number of ticks the radio may remain in
+ *  TX_END after the EOP. The value is calculated as follows,
+ *
+ *      TIME = (TX_END * (1 / BAUD)) rounded up to the next timer tick
+ *
+ *    @param  device        Physical device.
+ *    @param  baudRate      Scaled baud rate value.
+ *    @param  scaleFactor   Baud rate scale factor to recover true baud rate.
+ */
+void PhyCalculateTxEnd(struct sPhyDevice *device, 
+                       unsigned int baudRate, 
+                       unsigned int scaleFactor)
+{
+  device->timer.txEnd.compare = PHY_TX_END_LENGTH;
+  device->timer.txEnd.compare *= (1000 / baudRate); // Convert time to millisecond ticks
+  device->timer.txEnd.compare /= scaleFactor;       // Scale the result
+  device->timer.txEnd.compare += 1;                 // Round up to the next timer tick
+}
+
 
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+#if defined( PROTOCOL_USE_RX_TIMEOUT )
 /**
  *  PhyTimerEnableRxTimeout - enable and set the SYNC timeout counter.
+ *
+ *    @param  device  Physical device.
  */
-void PhyTimerEnableRxTimeout()
+void PhyTimerEnableRxTimeout(struct sPhyDevice *device)
 {
-  gPhyDevice.timer.rxTimeout.counter = gPhyDevice.timer.rxTimeout.compare;
-  gPhyDevice.timer.rxTimeout.enable = true;
-  PhyTimerStart();
+  device->timer.rxTimeout.counter = device->timer.rxTimeout.compare;
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  device->timer.rxTimeout.expired = false;
+  #endif
+  device->timer.rxTimeout.enable = true;
+  PhyTimerUpdate(device);
 }
 #endif
 
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+#if defined( PROTOCOL_USE_RX_TIMEOUT )
 /**
  *  PhyTimerDisableRxTimeout - disable and clear SYNC timeout counter.
+ *
+ *    @param  device  Physical device.
  */
-void PhyTimerDisableRxTimeout()
+void PhyTimerDisableRxTimeout(struct sPhyDevice *device)
 {
-  PhyTimerStop();
-  gPhyDevice.timer.rxTimeout.enable = false;
-  gPhyDevice.timer.rxTimeout.counter = 0;
+  device->timer.rxTimeout.enable = false;
+  PhyTimerUpdate(device);
+  device->timer.rxTimeout.counter = 0;
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  // An expired timeout that has not been processed yet no longer applies.
+  device->timer.rxTimeout.expired = false;
+  #endif
+}
+#endif
+
+#if defined( PROTOCOL_USE_STREAMING )
+/**
+ *  PhyFifoService - move the data stream through the physical hardware FIFO
+ *  while it is on air. Transmitting, the TX FIFO has drained below its 
+ *  threshold and is refilled; receiving, the RX FIFO has filled up to its 
+ *  threshold and is drained into the data field.
+ *
+ *    @param  device  Physical device.
+ */
+void PhyFifoService(struct sPhyDevice *device)
+{
+  struct sCC1101PhyInfo *phyInfo = &PHYINFO_CAST(device->phyInfo)->cc1101;
+  struct sPhyDataStreamFifo *fifo = &device->stream.fifo;
+  
+  if (device->status.transmitting)
+  {
+    unsigned char txBytes = CC1101GetTxFifoCount(phyInfo);
+    unsigned char space;
+    
+    if (txBytes & CC1101_TXFIFO_UNDERFLOW)
+    {
+      // Too late; the data stream is aborted and ends with an EOP.
+      fifo->index = fifo->count;
+    }
+    
+    // Fill the TX FIFO up so that it drains below the threshold again.
+    space = CC1101_TXFIFO_SIZE - (txBytes & CC1101_NUM_TXBYTES);
+    while ((fifo->index < fifo->count) && (space > 0))
+    {
+      const struct sPhyDataSegment *segment = &fifo->segment[fifo->index];
+      unsigned char n = segment->length - fifo->offset;
+      
+      if (n > space)
+      {
+        n = space;
+      }
+      CC1101WriteTxFifo(phyInfo, segment->data + fifo->offset, n);
+      space -= n;
+      fifo->offset += n;
+      if (fifo->offset == segment->length)
+      {
+        fifo->index++;
+        fifo->offset = 0;
+      }
+    }
+    
+    if (fifo->index == fifo->count)
+    {
+      // The whole data stream is in the TX FIFO.
+      CC1101GdoDisable(phyInfo->gdo[2]);
+    }
+  }
+  else
+  {
+    #if defined( PROTOCOL_USE_RX_TIMEOUT )
+    // A data stream is arriving; the Rx timeout no longer applies.
+    PhyTimerDisableRxTimeout(device);
+    #endif
+    
+    if (!fifo->length)
+    {
+      fifo->length = (CC1101ReadRxFifoStream(phyInfo, &device->stream.header.length, 1) == 1);
+    }
+    
+    // The radio filters data streams longer than PROTOCOL_DATASTREAM_MAX_SIZE 
+    // (PKTLEN); the data field buffer is never overrun.
+    if (fifo->length && PhyStreamLengthValid(device->stream.header.length))
+    {
+      fifo->offset += CC1101ReadRxFifoStream(phyInfo, 
+                                             device->stream.dataField + fifo->offset,
+                                             device->stream.header.length - fifo->offset);
+    }
+  }
 }
 #endif
 
 /**
  *  PhyActiveMode - put the Physical hardware into an active state.
+ *
+ *    @param  device  Physical device.
  */
-void PhyActiveMode(void)
+void PhyActiveMode(struct sPhyDevice *device)
 {
-  PROTOCOL_CRITICAL_SECTION(A1101Wakeup(PHYINFO_CAST(gPhyDevice.phyInfo)));
+  PROTOCOL_CRITICAL_SECTION(A1101Wakeup(PHYINFO_CAST(device->phyInfo)));
 }
 
 /**
  *  PhyDataStreamBuild - build a data stream. Populate header, data field, and
  *  footer information. Write to the TX FIFO of the physical hardware.
  *
- *    @param  phyInfo     Physical information structure.
- *    @param  dataField   Datafield being encapsulated inside a data stream.
+ *    @param  device      Physical device.
+ *    @param  segment     Data field segments being encapsulated inside a data 
+ *                        stream.
+ *    @param  count       Number of data field segments.
  *    @param  length      Length of the datafield in bytes.
  */
-void PhyDataStreamBuild(struct sCC1101PhyInfo *phyInfo, 
-                        unsigned char *dataField, 
+void PhyDataStreamBuild(struct sPhyDevice *device, 
+                        const struct sPhyDataSegment *segment,
+                        unsigned char count,
                         unsigned char length)
 {       
+  struct sCC1101PhyInfo *phyInfo = &PHYINFO_CAST(device->phyInfo)->cc1101;
+  
   /**
    *  Note: The length of the data stream is the address and the data field. 
    *  Length does not include itself into the total! The address is required
    *  as this physical implementation uses this for filtering. Broadcast
    *  addresses may be used at any time.
    */
-  gPhyDevice.stream.header.length = length;
-  gPhyDevice.stream.dataField = dataField;
+  device->stream.header.length = length;
 
   // Flush the TX FIFO before writing any new data to it.
   CC1101FlushTxFifo(phyInfo);  
       
   // Write the length field to the TX FIFO.
   CC1101WriteTxFifo(phyInfo, 
-                    &gPhyDevice.stream.header.length,
+                    &device->stream.header.length,
                     1);
-  // Write the address and data field to the TX FIFO.
-  CC1101WriteTxFifo(phyInfo,
-                    gPhyDevice.stream.dataField,
-                    gPhyDevice.stream.header.length);
+  #if defined( PROTOCOL_USE_STREAMING )
+  // Write as much of the address and data field as the TX FIFO holds, one 
+  // segment at a time. The segments left are written as the TX FIFO drains
+  // (PhyFifoService).
+  {
+    unsigned char space = CC1101_TXFIFO_SIZE - 1;
+    
+    device->stream.fifo.count = 0;
+    device->stream.fifo.index = 0;
+    device->stream.fifo.offset = 0;
+    for (; count > 0; count--, segment++)
+    {
+      unsigned char n = (segment->length < space) ? segment->length : space;
+      
+      if (n > 0)
+      {
+        CC1101WriteTxFifo(phyInfo, segment->data, n);
+        space -= n;
+      }
+      if (n < segment->length)
+      {
+        memcpy(device->stream.fifo.segment, segment, count * sizeof(*segment));
+        device->stream.fifo.count = count;
+        device->stream.fifo.offset = n;
+        break;
+      }
+    }
+  }
+  #else
+  // Write the address and data field to the TX FIFO, one segment at a time.
+  while (count--)
+  {
+    if (segment->length > 0)
+    {
+      CC1101WriteTxFifo(phyInfo, segment->data, segment->length);
+    }
+    segment++;
+  }
+  #endif
 }
 
 /**
  *  PhyGetDataStream - strip off the Physical header/footer information and
  *  retrieve the data field.
+ *
+ *    @param  device  Physical device.
  */
-void PhyGetDataStream(void)
+void PhyGetDataStream(struct sPhyDevice *device)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
-  volatile unsigned char rxBytes = CC1101ReadRxFifo(&phyInfo->cc1101, 
-                                                    &gPhyDevice.stream.header.length, 
-                                                    1);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  
+  bool received;
   
-  // Check if the RX FIFO has any data in it. If not, exit early as the RX FIFO
-  // does not have any useful data in it. A bogus interrupt has occurred.
-  if (rxBytes)
+  #if defined( PROTOCOL_USE_STREAMING )
+  if (device->stream.fifo.length)
+  {
+    // The beginning of the data stream was read while it was received; read
+    // the rest of the data field and the appended status.
+    received = PhyStreamLengthValid(device->stream.header.length)
+               && CC1101ReadRxPacketTail(&phyInfo->cc1101, 
+                                         device->stream.dataField + device->stream.fifo.offset, 
+                                         device->stream.header.length - device->stream.fifo.offset, 
+                                         (unsigned char*)&device->stream.footer.rssi);
+    device->stream.fifo.length = false;
+    device->stream.fifo.offset = 0;
+  }
+  else
+  #endif
+  // Read the length, the data field and the appended status (RSSI, LQI, and 
+  // CRC_OK) in one SPI transaction. If the RX FIFO does not hold exactly one 
+  // data stream that fits, a bogus interrupt has occurred or the RX FIFO 
+  // overflowed; it is flushed when the receiver is turned on again.
+  received = CC1101ReadRxPacket(&phyInfo->cc1101, 
+                                &device->stream.header.length, 
+                                device->stream.dataField, 
+                                PROTOCOL_DATASTREAM_MAX_SIZE, 
+                                (unsigned char*)&device->stream.footer.rssi);
+  
+  if (received)
   {
-    // Read the data field.
-    CC1101ReadRxFifo(&phyInfo->cc1101, 
-                     gPhyDevice.stream.dataField, 
-                     gPhyDevice.stream.header.length);
-
-    // Read the appended status (RSSI, LQI, and CRC_OK).
-    CC1101ReadRxFifo(&phyInfo->cc1101, 
-                     (unsigned char*)&gPhyDevice.stream.footer.rssi, 
-                     2);
-
     // Convert the RSSI value to an absolute power level.
     {
-      signed char rssi = gPhyDevice.stream.footer.rssi;
-      gPhyDevice.stream.footer.rssi = (signed int)(A1101ConvertRssiToDbm(phyInfo, rssi) + 1) >> 1;                                                   
+      signed char rssi = device->stream.footer.rssi;
+      device->stream.footer.rssi = (signed int)(A1101ConvertRssiToDbm(phyInfo, rssi) + 1) >> 1;                                                   
     }
   }
   else
   {
-    gPhyDevice.stream.header.length = 0;
+    device->stream.header.length = 0;
+  }
+}
+
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+/**
+ *  PhyEventPush - record an event for PhyProcess. Only called from interrupt
+ *  service routines (the single producer).
+ *
+ *    @param  device  Physical device.
+ *    @param  event   Event being recorded (PHY_EVENT_x).
+ *
+ *    @return True if the event was recorded, false if the ring is full.
+ */
+bool PhyEventPush(struct sPhyDevice *device, unsigned char event)
+{
+  unsigned char head = device->events.head;
+  
+  if ((unsigned char)(head - device->events.tail) >= PROTOCOL_EVENT_RING_SIZE)
+  {
+    return false;
+  }
+  
+  device->events.event[head & (PROTOCOL_EVENT_RING_SIZE - 1)] = event;
+  device->events.head = head + 1;    // Publish the event
+  
+  return true;
+}
+#endif
+
+/**
+ *  PhyTxEndService - service the end of a transmission.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return Status message from callee (currently not being used for physical
+ *            bridge use).
+ */
+unsigned char PhyTxEndService(struct sPhyDevice *device)
+{
+  // Transmitting data stream has completed.
+  device->status.transmitting = false;
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  // The radio has left TX_END for RX on its own.
+  device->status.turnedAround = device->status.txoffRx;
+  #endif
+  PHY_ISR_ENABLE_INTERRUPT();
+  return device->status.DataStreamSent(device->context);
+}
+
+/**
+ *  PhyGdo0Rearm - enable the GDO0 interrupt again after a SYNC/End-Of-Packet
+ *  (EOP) event was serviced. Enabling GDO0 clears its pending edge; if the 
+ *  receiver was turned on during the callback and a data stream has already 
+ *  ended (the radio returned to IDLE), that edge was lost. GDO0 is then left
+ *  disabled and the data stream must be serviced as if the edge had occured.
+ *
+ *  Note: Must be called with interrupts disabled.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return True if a data stream ended while GDO0 was disabled.
+ */
+bool PhyGdo0Rearm(struct sPhyDevice *device)
+{
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  enum eCC1101MarcState state;
+  
+  CC1101GdoEnable(phyInfo->cc1101.gdo[0]);
+  
+  // The radio is only read if it was turned on; it may be asleep otherwise.
+  if (!device->status.listening || device->status.transmitting)
+  {
+    return false;
+  }
+  
+  state = CC1101GetMarcState(&phyInfo->cc1101);
+  if ((state != eCC1101MarcStateIdle) && (state != eCC1101MarcStateRxfifo_overflow))
+  {
+    // Still receiving; the edge ending the data stream is yet to come.
+    return false;
+  }
+  
+  #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+  device->stream.timestamp = PROTOCOL_TIMESTAMP();
+  #endif
+  CC1101GdoDisable(phyInfo->cc1101.gdo[0]);
+  #if defined( PROTOCOL_USE_STREAMING )
+  // The data stream has ended; the FIFO threshold no longer applies.
+  if (phyInfo->cc1101.gdo[2] != NULL)
+  {
+    CC1101GdoDisable(phyInfo->cc1101.gdo[2]);
   }
+  #endif
+  
+  return true;
+}
+
+/**
+ *  PhySyncEopService - service a SYNC/End-Of-Packet (EOP) event. The GDO0 
+ *  interrupt is expected to be disabled on entry; it is enabled on exit. A 
+ *  data stream that ends while GDO0 is disabled is serviced as well.
+ *
+ *    @param  device  Physical device.
+ *
+ *    @return Status message from callee (currently not being used for physical
+ *            bridge use).
+ */
+unsigned char PhySyncEopService(struct sPhyDevice *device)
+{
+  unsigned char statusMessage = 0;          // Message from callback routine
+  bool missed;                              // Data stream ended while disabled
+  
+  do
+  {
+    if (CC1101GdoGetState(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]) == eCC1101GdoStateWaitForDeassert)
+    {
+      // Is the RF event occuring due to reception or transmission completion?
+      if (device->status.transmitting)
+      {
+        /**
+         *  Note: GDO0 is issued prior to the transmitter being completely
+         *  finished. The state machine will remain in TX_END until transmission
+         *  completes. Rather than waiting for TX_END here, the end of the 
+         *  transmission is confirmed by the timer once TX_END has had time to 
+         *  complete (PhyTimerIsr).
+         */ 
+        if (CC1101GetMarcState(&PHYINFO_CAST(device->phyInfo)->cc1101) == eCC1101MarcStateTx_end)
+        {
+          device->timer.txEnd.counter = device->timer.txEnd.compare;
+          device->timer.txEnd.enable = true;
+          PhyTimerUpdate(device);
+        }
+        else
+        {
+          statusMessage = PhyTxEndService(device);
+        }
+      }
+      else
+      {
+        #if defined( PROTOCOL_USE_RX_TIMEOUT )
+        // A data stream has arrived; the Rx timeout no longer applies. It must
+        // not expire later and interrupt the next scheduler operation.
+        PhyTimerDisableRxTimeout(device);
+        #endif
+        
+        // Receiving data stream has completed; read it from the RX FIFO. The
+        // receiver is off until it is turned on again.
+        device->status.listening = false;
+        PHY_ISR_ENABLE_INTERRUPT();
+        PhyGetDataStream(device);
+        statusMessage = device->status.DataStreamAvailable(device->context,
+                                                          device->stream.dataField, 
+                                                          device->stream.header.length);
+      }
+    }
+    PHY_ISR_DISABLE_INTERRUPT();
+    PROTOCOL_CRITICAL_SECTION(missed = PhyGdo0Rearm(device));
+  } while (missed);
+  
+  return statusMessage;
 }
 
 // -----------------------------------------------------------------------------
@@ -334,27 +935,63 @@ void PhyGetDataStream(void)
  *  Public interface
  */
 
-bool PhyInit(unsigned char(*DataStreamSent)(void), 
-             unsigned char(*DataStreamAvailable)(unsigned char *dataField, unsigned char length))
+bool PhyInit(struct sPhyDevice *device,
+             const struct sPhyBinding *binding,
+             void *context,
+             unsigned char(*DataStreamSent)(void *context), 
+             unsigned char(*DataStreamAvailable)(void *context, unsigned char *dataField, unsigned char length))
 { 
   PHYINFO phyInfo;
   
+  if (binding == NULL)
+  {
+    binding = &gA1101Binding;
+  }
+  
+  // Assign physical information to the device the first time it is used. A
+  // device being re-initialized keeps its physical information.
+  if (device->phyInfo == NULL)
+  {
+    if (gPhyInfoCount >= PROTOCOL_MAX_INSTANCES)
+    {
+      return false;
+    }
+    device->phyInfo = (void*)&gPhyInfo[gPhyInfoCount++];
+  }
+  
   // Initialize the physical bridge device and data stream structures.
-  gPhyDevice.phyInfo = (void*)gPhyInfo;
-  gPhyDevice.status.transmitting = false;
-  gPhyDevice.timer.Generic = NULL;
+  device->context = context;
+  device->status.transmitting = false;
+  device->status.listening = false;
+  #if defined( PROTOCOL_USE_CSMA )
+  device->status.channelBusy = false;
+  #endif
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  // The certified settings end every transmission in IDLE.
+  device->status.turnaround = false;
+  device->status.txoffRx = false;
+  device->status.turnedAround = false;
+  #endif
+  device->timer.Generic = NULL;
+  device->timer.txEnd.enable = false;
 
-  gPhyDevice.stream.header.length = 0;
-  gPhyDevice.stream.dataField = NULL;
-  gPhyDevice.stream.footer.rssi = 0;
-  gPhyDevice.stream.footer.status = 0;
+  device->stream.header.length = 0;
+  device->stream.dataField = NULL;
+  device->stream.footer.rssi = 0;
+  device->stream.footer.status = 0;
+  
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  device->events.head = 0;
+  device->events.tail = 0;
+  device->events.ticks = 0;
+  #endif
   
   // Initialize the physical layer structures and hardware.
-  phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  phyInfo = PHYINFO_CAST(device->phyInfo);
   
-  #if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
   // Calculate SYNC timeout value.
-  PhyCalculateRxTimeout(phyInfo->module.lookup->baudRate.value,
+  PhyCalculateRxTimeout(device, phyInfo->module.lookup->baudRate.value,
                           phyInfo->module.lookup->baudRate.scaleFactor);
   #endif
   
@@ -362,20 +999,30 @@ bool PhyInit(unsigned char(*DataStreamSent)(void),
   // completes.
   if (DataStreamSent != NULL)
   {
-    gPhyDevice.status.DataStreamSent = DataStreamSent;
+    device->status.DataStreamSent = DataStreamSent;
   }
   
   // Register a callback routine for the upper layer when the data stream
   // becomes available.
   if (DataStreamAvailable != NULL)
   {
-    gPhyDevice.status.DataStreamAvailable = DataStreamAvailable;
+    device->status.DataStreamAvailable = DataStreamAvailable;
   }
   
-  if (!A1101Init(phyInfo, &gA1101Spi, gA1101Gdo))
+  if (!A1101Init(phyInfo, binding->spi, (const struct sCC1101Gdo**)binding->gdo))
   {
     return false;
   }
+  
+  PhyCalculateTxEnd(device, phyInfo->module.lookup->baudRate.value,
+                      phyInfo->module.lookup->baudRate.scaleFactor);
+  
+  #if defined( PROTOCOL_USE_STREAMING )
+  device->stream.fifo.count = 0;
+  device->stream.fifo.length = false;
+  device->stream.fifo.offset = 0;
+  PhyStreamConfigure(device);
+  #endif
 
   // Set the default local device address to broadcast.
   A1101SetAddr(phyInfo, 0x00);
@@ -383,78 +1030,105 @@ bool PhyInit(unsigned char(*DataStreamSent)(void),
   return true;
 }
 
-void PhyEnable()
+void PhyEnable(struct sPhyDevice *device)
 {
-  CC1101GdoEnable(PHYINFO_CAST(gPhyDevice.phyInfo)->cc1101.gdo[0]);
+  CC1101GdoEnable(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]);
 }
 
-void PhyDisable()
+void PhyDisable(struct sPhyDevice *device)
 {
-  CC1101GdoDisable(PHYINFO_CAST(gPhyDevice.phyInfo)->cc1101.gdo[0]);
+  CC1101GdoDisable(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]);
 }
 
 // -----------------------------------------------------------------------------
 // Physical configuration
 
-bool PhyConfigure(unsigned char config)
+bool PhyConfigure(struct sPhyDevice *device, unsigned char config)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
 
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
-  #if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
   // Recalculate Rx timeout value based on the new configuration.
-  PhyCalculateRxTimeout(phyInfo->module.lookup->baudRate.value,
+  PhyCalculateRxTimeout(device, phyInfo->module.lookup->baudRate.value,
                           phyInfo->module.lookup->baudRate.scaleFactor);
   #endif
   
   // Completely reconfigure all registers to the certified settings with the 
   // new desired lookup entry.
-  return A1101Configure(phyInfo, A1101GetLookup(config));
+  if (!A1101Configure(phyInfo, A1101GetLookup(config)))
+  {
+    return false;
+  }
+  
+  #if defined( PROTOCOL_USE_STREAMING )
+  PhyStreamConfigure(device);
+  #endif
+  
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  // MCSM1 is back to its certified setting (TX to IDLE).
+  device->status.txoffRx = false;
+  device->status.turnedAround = false;
+  #endif
+  
+  // Recalculate the TX_END time based on the new configuration.
+  PhyCalculateTxEnd(device, phyInfo->module.lookup->baudRate.value,
+                      phyInfo->module.lookup->baudRate.scaleFactor);
+  
+  return true;
 }
 
-void PhyEnableAddressFilter(unsigned char deviceAddr)
+void PhyEnableAddressFilter(struct sPhyDevice *device, unsigned char deviceAddr)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
 
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
   A1101SetAddr(phyInfo, deviceAddr);
   A1101SetPktctrl1(phyInfo, phyInfo->module.lookup->certified.pktctrl1 | CC1101_ADR_CHK);
 }
 
-void PhyDisableAddressFilter()
+void PhyDisableAddressFilter(struct sPhyDevice *device)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
 
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
   A1101SetPktctrl1(phyInfo, phyInfo->module.lookup->certified.pktctrl1 & ~(CC1101_ADR_CHK));
 }
 
-bool PhySetChannel(unsigned char channel)
+bool PhySetChannel(struct sPhyDevice *device, unsigned char channel)
 {
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
-  return A1101SetChannr(PHYINFO_CAST(gPhyDevice.phyInfo), channel);
+  return A1101SetChannr(PHYINFO_CAST(device->phyInfo), channel);
 }
 
-void PhySetOutputPower(tPower power)
+void PhySetOutputPower(struct sPhyDevice *device, tPower power)
 {
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
   //  TODO: Determine the appropriate implementation of this function.
-//  memset(PHYINFO_CAST(gPhyDevice.phyInfo)->module.paTable, 
+//  memset(PHYINFO_CAST(device->phyInfo)->module.paTable, 
 //         power, 
-//         sizeof(PHYINFO_CAST(gPhyDevice.phyInfo)->module.paTable));
-//  A1101SetPaTable(PHYINFO_CAST(gPhyDevice.phyInfo), PHYINFO_CAST(gPhyDevice.phyInfo)->module.paTable);
+//         sizeof(PHYINFO_CAST(device->phyInfo)->module.paTable));
+//  A1101SetPaTable(PHYINFO_CAST(device->phyInfo), PHYINFO_CAST(device->phyInfo)->module.paTable);
 }
 
+#if defined( PROTOCOL_USE_TURNAROUND )
+void PhySetTurnaround(struct sPhyDevice *device, bool enable)
+{
+  // Applied by PhyTransmitv; the radio may be receiving or asleep now.
+  device->status.turnaround = enable;
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Physical status
 
@@ -462,11 +1136,11 @@ void PhySetOutputPower(tPower power)
 // does not take into account issues with timing (when RSSI is valid).
 //tPower PhyGetInstantSignalStrength()
 //{
-//  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+//  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
 //  tPower dBm;
 //  
 //  // Set physical hardware to an active state.
-//  PhyActiveMode();
+//  PhyActiveMode(device);
 //  
 //  // Put the radio into receive and read the instantaneous RSSI value.
 //  CC1101ReceiverOn(&phyInfo->cc1101);
@@ -479,70 +1153,241 @@ void PhySetOutputPower(tPower power)
 //  return dBm;
 //}
 
-struct sPhyDataStreamFooter* PhyGetDataStreamStatus()
+struct sPhyDataStreamFooter* PhyGetDataStreamStatus(struct sPhyDevice *device)
+{
+  return &device->stream.footer;
+}
+
+#if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+unsigned int PhyGetDataStreamTimestamp(struct sPhyDevice *device)
+{
+  return device->stream.timestamp;
+}
+#endif
+
+#if defined( PROTOCOL_USE_CSMA )
+bool PhyChannelBusy(struct sPhyDevice *device)
 {
-  return &gPhyDevice.stream.footer;
+  return device->status.channelBusy;
 }
+#endif
+
+#if defined( PROTOCOL_USE_SECURITY )
+// Number of RSSI samples folded into an entropy value.
+#ifndef PHY_ENTROPY_SAMPLES
+#define PHY_ENTROPY_SAMPLES     64
+#endif
+
+// Number of status reads spent waiting for the receiver and its RSSI to 
+// settle.
+#define PHY_ENTROPY_POLL_LIMIT  200
+
+// Number of RSSI reads spent waiting for the next RSSI update. The reads take
+// longer than one update at the data rates of the supported modules.
+#ifndef PHY_ENTROPY_SPACING
+#define PHY_ENTROPY_SPACING     32
+#endif
+
+unsigned long PhyGetEntropy(struct sPhyDevice *device)
+{
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+  unsigned long entropy = 0;
+  unsigned char poll = PHY_ENTROPY_POLL_LIMIT;
+  unsigned char sample;
+  unsigned char rssi;
+  bool receiving;
+  
+  // Set physical hardware to an active state.
+  PhyActiveMode(device);
+  
+  // A receiver turned on only to sample the channel must not report a data
+  // stream; one that is already on is left as it is.
+  receiving = (CC1101GetMarcState(&phyInfo->cc1101) == eCC1101MarcStateRx);
+  if (!receiving)
+  {
+    CC1101GdoDisable(phyInfo->cc1101.gdo[0]);
+    CC1101ReceiverOn(&phyInfo->cc1101);
+    while ((CC1101GetMarcState(&phyInfo->cc1101) != eCC1101MarcStateRx) && (--poll > 0));
+  }
+  
+  // The RSSI is valid once the radio either senses a carrier or reports a 
+  // clear channel. The wait is bounded.
+  while (!(CC1101GetRegister(&phyInfo->cc1101, CC1101_PKTSTATUS) 
+           & (CC1101_PKSTATUS_CS | CC1101_PKTSTATUS_CCA)) 
+         && (--poll > 0));
+  
+  // The least significant bits of the RSSI follow the receiver noise. Each 
+  // sample is taken once the RSSI has been updated (it changes, or the reads
+  // outlast an update) and is folded into the rotated value along with the 
+  // number of reads it took.
+  rssi = CC1101GetRssi(&phyInfo->cc1101);
+  for (sample = 0; sample < PHY_ENTROPY_SAMPLES; sample++)
+  {
+    unsigned char last = rssi;
+    unsigned char reads = 0;
+    
+    do
+    {
+      rssi = CC1101GetRssi(&phyInfo->cc1101);
+    } while ((rssi == last) && (++reads < PHY_ENTROPY_SPACING));
+    
+    entropy = ((entropy << 5) | (entropy >> 27)) ^ rssi ^ ((unsigned long)reads << 8);
+  }
+  
+  if (!receiving)
+  {
+    CC1101Idle(&phyInfo->cc1101);
+    CC1101FlushRxFifo(&phyInfo->cc1101);
+    CC1101GdoEnable(phyInfo->cc1101.gdo[0]);
+  }
+  
+  return entropy;
+}
+#endif
 
 // -----------------------------------------------------------------------------
 // Physical operation
                
-void PhyIdle()
+void PhyIdle(struct sPhyDevice *device)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
   
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
   CC1101Idle(&phyInfo->cc1101);
+  device->status.listening = false;
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  device->status.turnedAround = false;
+  #endif
+  
+  #if defined( PROTOCOL_USE_STREAMING )
+  if (phyInfo->cc1101.gdo[2] != NULL)
+  {
+    CC1101GdoDisable(phyInfo->cc1101.gdo[2]);
+  }
+  #endif
+  
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
+  // The receiver is off; the Rx timeout no longer applies.
+  PhyTimerDisableRxTimeout(device);
+  #endif
 }
 
-void PhyCalibrate()
+void PhyCalibrate(struct sPhyDevice *device)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
   
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
   
   // Set FS_AUTOCAL to calibrate on the next IDLE to RX/TX (or FSTXON).
   A1101SetMcsm0(phyInfo, phyInfo->module.lookup->certified.mcsm0 | 0x10);
 }
 
-void PhyReceiverOn(unsigned char *dataField)
+void PhyReceiverOn(struct sPhyDevice *device, unsigned char *dataField)
 {
-  PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+  PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
       
 //  // Begin looking for SYNC word (low-to-high transition).
-//  CC1101GdoWaitForAssert(gPhyInfo->cc1101.gdo[0]);
+//  CC1101GdoWaitForAssert(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]);
   // Begin looking for End-of-Packet (EOP) (high-to-low transition).
   CC1101GdoWaitForDeassert(phyInfo->cc1101.gdo[0]);
   
   // Set the data buffer being used for received data.
-  gPhyDevice.stream.dataField = dataField;
+  device->stream.dataField = dataField;
 
   // Set physical hardware to an active state.
-  PhyActiveMode();
+  PhyActiveMode(device);
+
+  #if defined( PROTOCOL_USE_STREAMING )
+  // Drain the RX FIFO each time it fills up to its threshold.
+  device->stream.fifo.length = false;
+  device->stream.fifo.offset = 0;
+  if (phyInfo->cc1101.gdo[2] != NULL)
+  {
+    A1101SetIocfg2(phyInfo, CC1101_GDOx_RXFIFO_THR);
+    CC1101GdoWaitForAssert(phyInfo->cc1101.gdo[2]);
+    CC1101GdoEnable(phyInfo->cc1101.gdo[2]);
+  }
+  #endif
 
-  // Flush the RX FIFO to prepare it for the next RF packet and turn on the
-  // receiver.
-  CC1101FlushRxFifo(&phyInfo->cc1101);
-  CC1101ReceiverOn(&phyInfo->cc1101);
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  // The radio entered RX when the last transmission ended; a response may 
+  // already be arriving and must not be flushed.
+  if (device->status.turnedAround)
+  {
+    device->status.turnedAround = false;
+  }
+  else
+  #endif
+  {
+    // Flush the RX FIFO to prepare it for the next RF packet and turn on the
+    // receiver.
+    CC1101FlushRxFifo(&phyInfo->cc1101);
+    CC1101ReceiverOn(&phyInfo->cc1101);
+  }
+  device->status.listening = true;
   
-  #if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
   // Start the timeout timer.
   /**
    *  Timeout = ((preamble length + sync length) * 8) * (1 / baud)
    *  Note: The preamble and sync lengths are in bytes. They must be converted 
    *  to bits (by multiplying by 8).
+   *
+   *  Note: Only devices with a SyncTimeout callback (End Points) time out.
    */
-  PhyTimerEnableRxTimeout();
+  if (device->timer.rxTimeout.RxTimeout != NULL)
+  {
+    PhyTimerEnableRxTimeout(device);
+  }
   #endif
 }
 
-bool PhyTransmit(unsigned char *dataField, 
+bool PhyTransmit(struct sPhyDevice *device, 
+                 unsigned char *dataField, 
                  unsigned char count)
 {
-  if (count > CC1101_TXFIFO_SIZE)
+  struct sPhyDataSegment segment;
+  
+  segment.data = dataField;
+  segment.length = count;
+  
+  return PhyTransmitv(device, &segment, 1);
+}
+
+bool PhyTransmitv(struct sPhyDevice *device, 
+                  const struct sPhyDataSegment *segment,
+                  unsigned char count)
+{
+  unsigned int length = 0;
+  unsigned char i;
+  
+  #if defined( PROTOCOL_USE_CSMA )
+  device->status.channelBusy = false;
+  #endif
+  
+  for (i = 0; i < count; i++)
+  {
+    length += segment[i].length;
+  }
+  
+  #if defined( PROTOCOL_USE_STREAMING )
+  if ((length > PROTOCOL_DATASTREAM_MAX_SIZE)
+      || ((length >= CC1101_TXFIFO_SIZE) 
+          && ((count > PHY_STREAM_MAX_SEGMENTS) 
+              || (PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2] == NULL))))
+  {
+    /**
+     *  Error: data stream is too large to transmit. The part that does not fit
+     *  in the physical hardware TX FIFO is written as it drains; it may be 
+     *  made of up to PHY_STREAM_MAX_SEGMENTS segments and requires GDO2.
+     */
+    return false;
+  }
+  #else
+  if (length > CC1101_TXFIFO_SIZE)
   {
     /**
      *  Error: data stream is too large to transmit. This implementation does 
@@ -551,29 +1396,68 @@ bool PhyTransmit(unsigned char *dataField,
      */
     return false;
   }
+  #endif
 
-  if (!gPhyDevice.status.transmitting)
+  if (!device->status.transmitting)
   {
-    PHYINFO phyInfo = PHYINFO_CAST(gPhyDevice.phyInfo);
+    PHYINFO phyInfo = PHYINFO_CAST(device->phyInfo);
+    
+    device->status.listening = false;
   
 //    // Begin looking for SYNC word (low-to-high transition).
-//    CC1101GdoWaitForAssert(gPhyInfo->cc1101.gdo[0]);
+//    CC1101GdoWaitForAssert(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]);
     // Begin looking for End-of-Packet (EOP) (high-to-low transition).
     CC1101GdoWaitForDeassert(phyInfo->cc1101.gdo[0]);
     
     // Set physical hardware to an active state.
-    PhyActiveMode();
+    PhyActiveMode(device);
+    
+    #if defined( PROTOCOL_USE_TURNAROUND )
+    // Select the state entered once the data stream is sent.
+    PhyTurnaroundConfigure(device);
+    #endif
+    
+    #if defined( PROTOCOL_USE_STREAMING )
+    // The receive FIFO threshold no longer applies.
+    if (phyInfo->cc1101.gdo[2] != NULL)
+    {
+      CC1101GdoDisable(phyInfo->cc1101.gdo[2]);
+    }
+    #endif
 
     // Build the data stream and write to the TX FIFO.
-    PhyDataStreamBuild(&phyInfo->cc1101, dataField, count);
+    PhyDataStreamBuild(device, segment, count, (unsigned char)length);
 
+    #if defined( PROTOCOL_USE_CSMA )
+    // Only transmit if the channel is clear.
+    if (!PhyTransmitIfClear(device))
+    {
+      return false;
+    }
+    #else
     /**
      *  Set the flag before strobing the radio to transmit. This will prevent 
      *  any state issues from occurring if short data streams are being sent and 
      *  the radio finishes prior to setting this flag.
      */
-    gPhyDevice.status.transmitting = true;
+    device->status.transmitting = true;
     CC1101Transmit(&phyInfo->cc1101);
+    #endif
+    
+    #if defined( PROTOCOL_USE_STREAMING )
+    // Refill the TX FIFO each time it drains below its threshold.
+    if (device->stream.fifo.count > 0)
+    {
+      A1101SetIocfg2(phyInfo, CC1101_GDOx_TXFIFO_THR);
+      CC1101GdoWaitForDeassert(phyInfo->cc1101.gdo[2]);
+      CC1101GdoEnable(phyInfo->cc1101.gdo[2]);
+    }
+    #endif
+    
+    #if defined( PROTOCOL_USE_RX_TIMEOUT )
+    // The receiver is off; the Rx timeout no longer applies.
+    PhyTimerDisableRxTimeout(device);
+    #endif
     
     return true;
   }
@@ -583,127 +1467,225 @@ bool PhyTransmit(unsigned char *dataField,
   return false;
 }
 
-void PhyLowPowerMode()
+void PhyLowPowerMode(struct sPhyDevice *device)
 {
-  PROTOCOL_CRITICAL_SECTION(CC1101Sleep(&PHYINFO_CAST(gPhyDevice.phyInfo)->cc1101));
+  #if defined( PROTOCOL_USE_STREAMING )
+  if (PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2] != NULL)
+  {
+    CC1101GdoDisable(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2]);
+  }
+  #endif
+  PROTOCOL_CRITICAL_SECTION(CC1101Sleep(&PHYINFO_CAST(device->phyInfo)->cc1101));
+  device->status.listening = false;
+  #if defined( PROTOCOL_USE_TURNAROUND )
+  device->status.turnedAround = false;
+  #endif
+  
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
+  // The receiver is off; the Rx timeout no longer applies.
+  PhyTimerDisableRxTimeout(device);
+  #endif
 }
 
-void PhyTimerInit(unsigned char(*GenericTimer)(void))
+void PhyTimerInit(struct sPhyDevice *device, 
+                  unsigned char(*GenericTimer)(void *context))
 {
-  gPhyDevice.timer.running = false;
-  gPhyDevice.timer.Generic = GenericTimer;
+  PhyTimerStop(device);
+  device->timer.Generic = GenericTimer;
   
-  A110x2500HwTimerInit();
+  // The hardware timer is shared; only initialize it while no device uses it.
+  if (gPhyTimerUsers == 0)
+  {
+    A110x2500HwTimerInit();
+  }
 }
 
-void PhyTimerStart()
+void PhyTimerStart(struct sPhyDevice *device)
 {
-  if (!gPhyDevice.timer.running)
-  {
-    PROTOCOL_CRITICAL_SECTION
-    (
-      A110x2500HwTimerStart();
-      gPhyDevice.timer.running = true;
-    );
-  }
+  device->timer.generic = true;
+  PhyTimerUpdate(device);
 }
 
-void PhyTimerStop()
+void PhyTimerStop(struct sPhyDevice *device)
 {
-  if (gPhyDevice.timer.running)
-  {
-    PROTOCOL_CRITICAL_SECTION
-    (
-      // Clear any currently pending timer interrupts and stop counting.
-      A110x2500HwTimerStop();
-      gPhyDevice.timer.running = false;
-    );
-  }
+  device->timer.generic = false;
+  PhyTimerUpdate(device);
 }
 
-#if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
-void PhySyncTimerInit(unsigned char(*RxTimeout)(void))
+#if defined( PROTOCOL_USE_RX_TIMEOUT )
+void PhySyncTimerInit(struct sPhyDevice *device, 
+                      unsigned char(*RxTimeout)(void *context))
 {
-  gPhyDevice.timer.rxTimeout.enable = false;
-  gPhyDevice.timer.rxTimeout.counter = 0;
-  gPhyDevice.timer.rxTimeout.RxTimeout = RxTimeout;
+  device->timer.rxTimeout.enable = false;
+  device->timer.rxTimeout.counter = 0;
+  device->timer.rxTimeout.RxTimeout = RxTimeout;
+  PhyTimerUpdate(device);
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  device->timer.rxTimeout.expired = false;
+  #endif
 }
 #endif
 
-unsigned char PhySyncEopIsr(volatile unsigned char event)
+unsigned char PhySyncEopIsr(struct sPhyDevice *device, 
+                            volatile unsigned char event)
 {
-  unsigned char statusMessage = 0;          // Message from callback routine
-        
+  #if defined( PROTOCOL_USE_STREAMING )
+  // Service the FIFO threshold first; it may end the same data stream.
+  if ((PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2] != NULL)
+      && CC1101GdoEvent(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2], event))
+  {
+    PhyFifoService(device);
+  }
+  #endif
+  
   // Verify that an RF event has triggered an interrupt.
-  if (CC1101GdoEvent(gPhyInfo->cc1101.gdo[0], event))
+  if (CC1101GdoEvent(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0], event))
   {
-    CC1101GdoDisable(gPhyInfo->cc1101.gdo[0]);
-    
-    if (CC1101GdoGetState(gPhyInfo->cc1101.gdo[0]) == eCC1101GdoStateWaitForDeassert)
+    #if defined( PROTOCOL_USE_LATENCY_COUNTERS )
+    device->stream.timestamp = PROTOCOL_TIMESTAMP();
+    #endif
+    CC1101GdoDisable(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[0]);
+    #if defined( PROTOCOL_USE_STREAMING )
+    // The data stream has ended; the FIFO threshold no longer applies.
+    if (PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2] != NULL)
     {
-      // Is the RF event occuring due to reception or transmission completion?
-      if (gPhyDevice.status.transmitting)
-      {
-        /**
-         *  Note: GDO0 is issued prior to the transmitter being completely
-         *  finished. The state machine will remain in TX_END until transmission
-         *  completes. The following waits for TX_END to correct the hardware
-         *  behavior.
-         */ 
-        while (CC1101GetMarcState(&gPhyInfo->cc1101) == eCC1101MarcStateTx_end);
-        
-        // Transmitting data stream has completed.
-        gPhyDevice.status.transmitting = false;
-        PROTOCOL_ENABLE_INTERRUPT();
-        statusMessage = gPhyDevice.status.DataStreamSent();
-      }
-      else
-      {
-        // Receiving data stream has completed; read it from the RX FIFO.
-        PROTOCOL_ENABLE_INTERRUPT();
-        PhyGetDataStream();
-        statusMessage = gPhyDevice.status.DataStreamAvailable(gPhyDevice.stream.dataField, 
-                                                              gPhyDevice.stream.header.length);
-      }
+      CC1101GdoDisable(PHYINFO_CAST(device->phyInfo)->cc1101.gdo[2]);
     }
-    PROTOCOL_DISABLE_INTERRUPT();
-    CC1101GdoEnable(gPhyInfo->cc1101.gdo[0]);
+    #endif
+    
+    #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+    // Record the event. GDO0 remains disabled until PhyProcess services it.
+    return PhyEventPush(device, PHY_EVENT_SYNC_EOP);
+    #else
+    return PhySyncEopService(device);
+    #endif
   }
 
-  return statusMessage;
+  return 0;
 }
 
-unsigned char PhyTimerIsr()
+unsigned char PhyTimerIsr(struct sPhyDevice *device)
 {
-  #if defined( PROTOCOL_ENDPOINT ) && defined( PROTOCOL_USE_RX_TIMEOUT )
+  // If enabled, confirm the end of a transmission.
+  if (device->timer.txEnd.enable && (--device->timer.txEnd.counter == 0))
+  {
+    // The radio is only polled once TX_END should be over; if it is not, 
+    // check again on the next tick.
+    if (CC1101GetMarcState(&PHYINFO_CAST(device->phyInfo)->cc1101) == eCC1101MarcStateTx_end)
+    {
+      device->timer.txEnd.counter = 1;
+    }
+    else
+    {
+      device->timer.txEnd.enable = false;
+      PhyTimerUpdate(device);
+      #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+      return PhyEventPush(device, PHY_EVENT_TX_END);
+      #else
+      return PhyTxEndService(device);
+      #endif
+    }
+  }
+  
+  #if defined( PROTOCOL_USE_RX_TIMEOUT )
   // If enabled, service the sync timeout timer.
-  if (gPhyDevice.timer.rxTimeout.enable)
+  if (device->timer.rxTimeout.enable)
   {
-    if (--gPhyDevice.timer.rxTimeout.counter == 0)
+    if (--device->timer.rxTimeout.counter == 0)
     {
       // Disable sync timeout counter.
-      PhyTimerDisableRxTimeout();
-      if (gPhyDevice.timer.rxTimeout.RxTimeout != NULL)
+      PhyTimerDisableRxTimeout(device);
+      #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+      device->timer.rxTimeout.expired = true;
+      return PhyEventPush(device, PHY_EVENT_RX_TIMEOUT);
+      #else
+      if (device->timer.rxTimeout.RxTimeout != NULL)
       {
-        return gPhyDevice.timer.rxTimeout.RxTimeout();
+        return device->timer.rxTimeout.RxTimeout(device->context);
       }
+      #endif
     }
   }
   #endif
   
+  #if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+  // Count the tick; the generic timer is serviced by PhyProcess. The count
+  // saturates rather than wrap and lose the ticks already recorded.
+  if (device->timer.generic && (device->timer.Generic != NULL))
+  {
+    if (device->events.ticks != 0xFFFFu)
+    {
+      device->events.ticks++;
+    }
+    return 1;
+  }
+  #else
   // TODO: Determine if this is the correct location for this call. Can we
   // enable global interrupts earlier? Should we enable them later?
   PROTOCOL_ENABLE_INTERRUPT();
   
   // Service the generic timer.
-  if (gPhyDevice.timer.Generic != NULL)
+  if (device->timer.generic && (device->timer.Generic != NULL))
   {
-    return gPhyDevice.timer.Generic();
+    return device->timer.Generic(device->context);
   }
+  #endif
   
   return 0;
 }
 
+#if defined( PROTOCOL_USE_DEFERRED_PROCESSING )
+unsigned char PhyProcess(struct sPhyDevice *device)
+{
+  unsigned char statusMessage = 0;
+  
+  while (device->events.tail != device->events.head)
+  {
+    unsigned char tail = device->events.tail;
+    unsigned char event = device->events.event[tail & (PROTOCOL_EVENT_RING_SIZE - 1)];
+    
+    device->events.tail = tail + 1;  // Release the slot to the producer
+    
+    switch (event)
+    {
+    case PHY_EVENT_SYNC_EOP:
+      statusMessage = PhySyncEopService(device);
+      break;
+    case PHY_EVENT_TX_END:
+      statusMessage = PhyTxEndService(device);
+      break;
+    #if defined( PROTOCOL_USE_RX_TIMEOUT )
+    case PHY_EVENT_RX_TIMEOUT:
+      // Ignore the timeout if a data stream was received in the meantime.
+      if (device->timer.rxTimeout.expired)
+      {
+        device->timer.rxTimeout.expired = false;
+        if (device->timer.rxTimeout.RxTimeout != NULL)
+        {
+          statusMessage = device->timer.rxTimeout.RxTimeout(device->context);
+        }
+      }
+      break;
+    #endif
+    default:
+      break;
+    }
+  }
+  
+  // Service the generic timer once per recorded tick.
+  while (device->events.ticks > 0)
+  {
+    PROTOCOL_CRITICAL_SECTION(device->events.ticks--);
+    if (device->timer.Generic != NULL)
+    {
+      statusMessage = device->timer.Generic(device->context);
+    }
+  }
+  
+  return statusMessage;
+}
+#endif
+
 // -----------------------------------------------------------------------------
 /**
  *  Test stub - test functionality of A1101-based physical bridge.
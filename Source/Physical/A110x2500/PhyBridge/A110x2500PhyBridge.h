@@ -12,8 +12,8 @@
  *  A110x2500PhyBridge.h - physical bridge implementation using A110x2500-based 
  *		modules.
  *
- *  @version  1.0.01
- *  @date     16 Oct 2012
+ *  @version  1.1.00
+ *  @date     16 Oct 2026
  *  @author   BPB, air@anaren.com
  *
  *  assumptions
@@ -31,12 +31,20 @@
  *
  *  revision history
  *  ================
+ *  ver 1.1.00 : 16 Oct 2026
+ *  - added sPhyBinding so that each physical device uses its own SPI and GDOx
+ *  interfaces
+ *  - added A110x2500SpiReadv (SPI scatter read)
+ *  - added the A110x2500Gdo2* interface; the default binding uses GDO2 for 
+ *  the FIFO thresholds (PROTOCOL_USE_STREAMING)
+ *  - SPI transactions of the default binding are atomic in every 
+ *  configuration
  *  ver 1.0.01 : 16 Oct 2012
  *  - updated internal documentation; comments revised
  *  ver 1.0.00 : 24 Jul 2012 
  *  - initial release
  */
-#define A110X2500_PHY_BRIDGE_INFO  "A110X2500_PHY_BRIDGE 1.0.01"
+#define A110X2500_PHY_BRIDGE_INFO  "A110X2500_PHY_BRIDGE 1.1.00"
    
 #include "PhyBridge.h" 
 
@@ -59,11 +67,30 @@
  *  Defines, enumerations, and structure definitions
  */
 
+/**
+ *  sPhyBinding - hardware interfaces used by one physical device. Each radio
+ *  module requires its own SPI interface (at least its own chip select) and
+ *  GDOx interfaces.
+ *
+ *  Note: Interrupt service routines access the radio (PhyTimerIsr confirms 
+ *  the end of a transmission). Each SPI transaction must be atomic with 
+ *  respect to them, as in the default binding.
+ */
+struct sPhyBinding
+{
+  const struct sCC1101Spi *spi;       // Radio SPI interface
+  const struct sCC1101Gdo *gdo[3];    // Radio GDOx interfaces (GDO0 required)
+};
+
 // -----------------------------------------------------------------------------
 /**
  *  Global data
  */
 
+// Default binding (A110x2500Spi*, A110x2500Gdo0*, and A110x2500Gdo2* with
+// PROTOCOL_USE_STREAMING); used when PhyInit is given a NULL binding.
+extern const struct sPhyBinding gA1101Binding;
+
 // -----------------------------------------------------------------------------
 /**
  *  Public interface
@@ -87,6 +114,20 @@ void A110x2500SpiRead(unsigned char address,
 																				  unsigned char *buffer,
 																						unsigned char count);
 
+/**
+ *  A110x2500SpiReadv - read from a CC1101-based module into several buffers 
+ *  in one transaction (CSn is held low throughout).
+ *
+ *    @param  address The register address to start reading from (burst).
+ *    @param  segment Buffers to read into, in order.
+ *    @param  count   Number of buffers.
+ *
+ *    @return Chip status byte clocked out with the address byte.
+ */
+unsigned char A110x2500SpiReadv(unsigned char address,
+                                const struct sCC1101Segment *segment,
+                                unsigned char count);
+
 /**
  *  A110x2500SpiWrite - write to a CC1101-based module.
  *
@@ -140,6 +181,49 @@ enum eCC1101GdoState A110x2500Gdo0GetState(void);
  */
 void A110x2500Gdo0Enable(bool en);
 
+#if defined( PROTOCOL_USE_STREAMING )
+/**
+ *  A110x2500Gdo2Init - initialize the GDO2 port.
+ */
+void A110x2500Gdo2Init(void);
+
+/**
+ *  A110x2500Gdo2Event - determine if the GDO2 port has caused an interrupt.
+ *
+ *    @param  event Bit field (or register) with current interrupt flags values.
+ *
+ *    @return True if a GDO2 event has occurred (interrupt), otherwise false
+ *            (the interrupt was due to another source).
+ */
+bool A110x2500Gdo2Event(unsigned char event);
+
+/**
+ *  A110x2500Gdo2WaitForAssert - change the polarity of the GDO2 interrupt to wait
+ *  for an assertion.
+ */
+void A110x2500Gdo2WaitForAssert(void);
+
+/**
+ *  A110x2500Gdo2WaitForDeassert - change the polarity of the GDO2 interrupt to wait
+ *  for a deassertion.
+ */
+void A110x2500Gdo2WaitForDeassert(void);
+
+/**
+ *  A110x2500Gdo2GetState - get the current GDO2 interrupt polarity.
+ *
+ *    @return Current polarity state (waiting for assert or deassert).
+ */
+enum eCC1101GdoState A110x2500Gdo2GetState(void);
+
+/**
+ *  A110x2500Gdo2Enable - enable/disable the GDO2 interrupt.
+ *
+ *    @param  en  Enable flag.
+ */
+void A110x2500Gdo2Enable(bool en);
+#endif
+
 /**
  *  A110x2500HardwareTimerInit - initialize the hardware timer.
  *